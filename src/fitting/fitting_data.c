@@ -0,0 +1,183 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#define FITTING_DATA_C_
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fitting_data.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+#define FITTING_DATA_LINE_LENGTH        (256)           //!< Longest line of a data file
+
+
+
+//==============================================================================
+// File Scope Function Prototype
+//==============================================================================
+static BOOL appendPoint(FITTING_DATA *data, U32 *capacity, const F64 *point);
+
+
+
+
+
+//******************************************************************************
+//! \breif      Load an observed spectrum
+//! \remark     One point per line : energy flux lower upper, the format of
+//!             data/CrabNebula.dat. Blank lines and lines starting with
+//!             FITTING_DATA_COMMENT are ignored. lower <= flux <= upper is
+//!             required on every line.
+//! 
+//! \callgraph  
+//! 
+//! \param[out] data      : Observed spectrum to be loaded
+//! \param[in]  file_name : File name
+//! \return     TRUE on success, FALSE if the file is missing or invalid
+//******************************************************************************
+BOOL FittingData_Load(FITTING_DATA *data, const CHAR *file_name)
+{
+    FILE *fp;
+    CHAR line[FITTING_DATA_LINE_LENGTH], rest[2];
+    F64 point[4];
+    U32 capacity = 0;
+    size_t skip;
+    BOOL result = TRUE;
+
+    data->Count = 0;
+    data->Energy = data->Flux = data->Lower = data->Upper = NULL;
+
+    if ((fp = fopen(file_name, "r")) == NULL) {
+        return FALSE;
+    }
+
+    while ((result == TRUE) && (fgets(line, sizeof(line), fp) != NULL)) {
+        skip = strspn(line, " \t\r\n");
+        if ((line[skip] == '\0') || (line[skip] == FITTING_DATA_COMMENT)) {
+            continue;
+        }
+
+        if ((sscanf(line, "%lf %lf %lf %lf %1s", &point[0], &point[1], &point[2], &point[3], rest) != 4) ||
+            (!(point[0] > 0.0)) || (point[2] > point[1]) || (point[1] > point[3])) {
+            result = FALSE;
+        }
+        else {
+            result = appendPoint(data, &capacity, point);
+        }
+    }
+
+    if ((ferror(fp) != 0) || (data->Count == 0)) {
+        result = FALSE;
+    }
+    fclose(fp);
+
+    if (result == FALSE) {
+        FittingData_Release(data);
+    }
+
+    return result;
+}
+
+
+
+//******************************************************************************
+//! \breif      Release the arrays owned by an observed spectrum
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  data : Observed spectrum
+//! \return     None
+//******************************************************************************
+void FittingData_Release(FITTING_DATA *data)
+{
+    free(data->Energy);
+    free(data->Flux);
+    free(data->Lower);
+    free(data->Upper);
+
+    data->Count = 0;
+    data->Energy = data->Flux = data->Lower = data->Upper = NULL;
+
+    return;
+}
+
+
+
+
+
+//******************************************************************************
+//! \breif      Append one point to an observed spectrum
+//! \remark     The arrays grow by doubling.
+//! 
+//! \callgraph  
+//! 
+//! \param[in,out] data     : Observed spectrum
+//! \param[in,out] capacity : Allocated number of points
+//! \param[in]  point       : energy, flux, lower, upper
+//! \return     TRUE on success, FALSE if the arrays cannot be allocated
+//******************************************************************************
+static BOOL appendPoint(FITTING_DATA *data, U32 *capacity, const F64 *point)
+{
+    F64 **arrays[4];
+    F64 *grown;
+    U32 a, size;
+
+    arrays[0] = &data->Energy;
+    arrays[1] = &data->Flux;
+    arrays[2] = &data->Lower;
+    arrays[3] = &data->Upper;
+
+    if (data->Count == *capacity) {
+        size = (*capacity == 0) ? 16 : (2 * *capacity);
+        for (a = 0; a < 4; a++) {
+            if ((grown = (F64 *)realloc(*arrays[a], sizeof(F64) * size)) == NULL) {
+                return FALSE;
+            }
+            *arrays[a] = grown;
+        }
+        *capacity = size;
+    }
+
+    for (a = 0; a < 4; a++) {
+        (*arrays[a])[data->Count] = point[a];
+    }
+    data->Count++;
+
+    return TRUE;
+}
+
+
+
+
+//******************************************************************************
+// End of File
+//******************************************************************************
@@ -0,0 +1,94 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#ifndef FITTING_DATA_H_
+#define FITTING_DATA_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include "common_typedef.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+#define FITTING_DATA_COMMENT            '#'             //!< Comment line marker
+
+
+
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! Observed spectrum
+//----------------------------------------------------------
+typedef struct fitting_data_t {
+    U32         Count;                  //!< Number of points
+    F64         *Energy;                //!< Photon energy [eV]
+    F64         *Flux;                  //!< Flux
+    F64         *Lower;                 //!< Lower end of the flux error bar
+    F64         *Upper;                 //!< Upper end of the flux error bar
+}FITTING_DATA;
+
+
+
+//==============================================================================
+// Export Scope Function Prototype
+//==============================================================================
+/**
+ * @brief           Load an observed spectrum
+ * 
+ * One point per line : energy flux lower upper (data/CrabNebula.dat format).
+ * Blank lines and lines starting with FITTING_DATA_COMMENT are ignored.
+ * 
+ * @param data      Observed spectrum to be loaded
+ * @param file_name File name
+ * @return BOOL     TRUE on success, FALSE if the file is missing or invalid
+ */
+extern BOOL FittingData_Load(FITTING_DATA *data, const CHAR *file_name);
+
+/**
+ * @brief           Release the arrays owned by an observed spectrum
+ * 
+ * @param data      Observed spectrum
+ */
+extern void FittingData_Release(FITTING_DATA *data);
+
+
+
+#ifdef _cplusplus
+}
+#endif
+
+#endif
+
+//******************************************************************************
+// End of File
+//******************************************************************************
@@ -0,0 +1,538 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#define FITTING_MCMC_C_
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "io_chain.h"
+#include "io_table.h"
+#include "fitting_mcmc.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+#define MCMC_INITIAL_SPREAD             (1.0E-3)        //!< Half width of the initial ensemble in fitting coordinates
+#define MCMC_INITIAL_TRIALS             (100)           //!< Draws per walker to find a finite posterior
+#define MCMC_INITIAL_DRAW               (16)            //!< First draw index of the initial ensemble
+#define MCMC_STATE_COUNT                (6)             //!< step, seed, walkers, dimension, data checksum (upper and lower 32 bits)
+#define MCMC_SECTION_COUNT              (3)             //!< state, positions, log posteriors
+
+
+
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! Ensemble of walkers
+//----------------------------------------------------------
+typedef struct mcmc_ensemble_t {
+    U32         Walkers;                //!< Number of walkers
+    F64         *X;                     //!< Fitting coordinates [Walkers][FITTING_PARAMETERS]
+    F64         *LogPost;               //!< Log posterior [Walkers]
+    F64         *Model;                 //!< Model flux work arrays [Walkers][data->Count]
+    F64         *Record;                //!< Chain record [Walkers][FITTING_PARAMETERS + 1]
+}MCMC_ENSEMBLE;
+
+
+
+//==============================================================================
+// File Scope Function Prototype
+//==============================================================================
+static F64 drawUniform(const U32 seed, const U64 step, const U32 walker, const U32 draw);
+static F64 calcLogPosterior(const ICS_RESPONSE *response, const FITTING_DATA *data, const F64 *x, F64 *model);
+static BOOL createEnsemble(MCMC_ENSEMBLE *ensemble, const U32 walkers, const U32 data_count);
+static BOOL initEnsemble(MCMC_ENSEMBLE *ensemble, const ICS_RESPONSE *response, const FITTING_DATA *data,
+                         const FITTING_PARAMS *start, const U32 seed, const U32 data_count);
+static U64 calcDataChecksum(const FITTING_DATA *data);
+static void setCheckpointHeader(IO_TABLE_HEADER *header, const ICS_RESPONSE *response, const FITTING_DATA *data);
+static BOOL loadCheckpoint(MCMC_ENSEMBLE *ensemble, const ICS_RESPONSE *response, const FITTING_DATA *data,
+                           const FITTING_MCMC_CONFIG *config, U32 *step);
+static BOOL saveCheckpoint(const MCMC_ENSEMBLE *ensemble, const ICS_RESPONSE *response, const FITTING_DATA *data,
+                           const FITTING_MCMC_CONFIG *config, const U32 step);
+static void releaseEnsemble(MCMC_ENSEMBLE *ensemble);
+
+
+
+
+
+//******************************************************************************
+//! \breif      Sample the posterior of the electron spectrum parameters
+//! \remark     1) Affine-invariant ensemble sampler (Goodman & Weare 2010)
+//!                with the stretch move. The walkers are split in two halves
+//!                and each half is moved against the other, so the walkers
+//!                of a half are independent and run in parallel.
+//!             2) The posterior is exp(-chi^2 / 2) with flat priors inside
+//!                the bounds of FittingSpectrum_CalcObjective, evaluated from
+//!                the response matrix.
+//!             3) The random numbers are a hash of (seed, step, walker,
+//!                draw), so every walker has its own stream, the chain does
+//!                not depend on the number of threads and a resumed run
+//!                continues exactly where the checkpoint was taken.
+//!             4) One record per step is streamed to the chain file. Every
+//!                CheckpointInterval steps the chain is synced and the
+//!                ensemble is written to the checkpoint file (through a
+//!                temporary file and a rename). A run whose checkpoint
+//!                matches resumes from it.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  response : Response matrix built at the data energies
+//! \param[in]  data     : Observed spectrum
+//! \param[in]  start    : Centre of the initial ensemble (usually the best fit)
+//! \param[in]  config   : Sampler settings
+//! \param[out] result   : Sampler statistics
+//! \return     TRUE on success, FALSE on invalid settings, allocation failure
+//!             or a write error
+//******************************************************************************
+BOOL FittingMcmc_Run(const ICS_RESPONSE *response, const FITTING_DATA *data, const FITTING_PARAMS *start,
+                     const FITTING_MCMC_CONFIG *config, FITTING_MCMC_RESULT *result)
+{
+    MCMC_ENSEMBLE ensemble;
+    IO_CHAIN chain;
+    FITTING_PARAMS params;
+    const U32 walkers = config->Walkers, half = config->Walkers / 2;
+    F64 y[FITTING_PARAMETERS];
+    F64 z, log_post;
+    U64 accepted, evaluations;
+    U32 step, side, first, k, j, d;
+    S32 i;
+    BOOL resumed, written;
+
+    if ((walkers < 2 * FITTING_PARAMETERS) || ((walkers % 2) != 0) || (config->CheckpointInterval == 0) || (config->Scale <= 1.0)) {
+        return FALSE;
+    }
+    if (createEnsemble(&ensemble, walkers, data->Count) == FALSE) {
+        return FALSE;
+    }
+
+    //------------------------------------------------------
+    // Resume from the checkpoint or start a new chain
+    //------------------------------------------------------
+    resumed = ((loadCheckpoint(&ensemble, response, data, config, &step) == TRUE) &&
+               (IoChain_Open(&chain, config->ChainFile, walkers, FITTING_PARAMETERS, response->Mode, step) == TRUE)) ? TRUE : FALSE;
+    if (resumed == FALSE) {
+        step = 0;
+        if ((initEnsemble(&ensemble, response, data, start, config->Seed, data->Count) == FALSE) ||
+            (IoChain_Open(&chain, config->ChainFile, walkers, FITTING_PARAMETERS, response->Mode, 0) == FALSE)) {
+            releaseEnsemble(&ensemble);
+            return FALSE;
+        }
+    }
+    result->StartStep = step;
+
+    //------------------------------------------------------
+    // Stretch moves
+    //------------------------------------------------------
+    accepted = 0;
+    evaluations = 0;
+    written = TRUE;
+    for (; (step < config->Steps) && (written == TRUE); step++) {
+        for (side = 0; side < 2; side++) {
+            first = side * half;
+#ifdef _OPENMP
+            #pragma omp parallel for schedule(dynamic, 1) private(k, j, d, y, z, log_post) reduction(+:accepted, evaluations)
+#endif
+            for (i = 0; i < (S32)half; i++) {
+                k = first + (U32)i;
+                j = (half - first) + (U32)(drawUniform(config->Seed, step, k, 0) * (F64)half) % half;
+                z = (config->Scale - 1.0) * drawUniform(config->Seed, step, k, 1) + 1.0;
+                z = z * z / config->Scale;
+
+                for (d = 0; d < FITTING_PARAMETERS; d++) {
+                    y[d] = ensemble.X[j * FITTING_PARAMETERS + d] + z * (ensemble.X[k * FITTING_PARAMETERS + d] - ensemble.X[j * FITTING_PARAMETERS + d]);
+                }
+                log_post = calcLogPosterior(response, data, y, &ensemble.Model[(size_t)k * data->Count]);
+                evaluations++;
+
+                if (log(drawUniform(config->Seed, step, k, 2)) < (F64)(FITTING_PARAMETERS - 1) * log(z) + log_post - ensemble.LogPost[k]) {
+                    memcpy(&ensemble.X[k * FITTING_PARAMETERS], y, sizeof(y));
+                    ensemble.LogPost[k] = log_post;
+                    accepted++;
+                }
+            }
+        }
+
+        for (k = 0; k < walkers; k++) {
+            FittingSpectrum_ToParams(&ensemble.X[k * FITTING_PARAMETERS], &params);
+            ensemble.Record[k * (FITTING_PARAMETERS + 1) + 0] = params.Norm;
+            ensemble.Record[k * (FITTING_PARAMETERS + 1) + 1] = params.Power;
+            ensemble.Record[k * (FITTING_PARAMETERS + 1) + 2] = params.GammaMax;
+            ensemble.Record[k * (FITTING_PARAMETERS + 1) + 3] = ensemble.LogPost[k];
+        }
+        written = IoChain_Append(&chain, ensemble.Record);
+
+        if ((written == TRUE) && ((((step + 1) % config->CheckpointInterval) == 0) || (step + 1 == config->Steps))) {
+            written = ((IoChain_Sync(&chain) == TRUE) &&
+                       (saveCheckpoint(&ensemble, response, data, config, step + 1) == TRUE)) ? TRUE : FALSE;
+        }
+    }
+
+    result->Steps = (U32)chain.Header.Steps;
+    result->Evaluations = evaluations;
+    result->Acceptance = (evaluations > 0) ? (F64)accepted / (F64)evaluations : 0.0;
+
+    IoChain_Close(&chain);
+    releaseEnsemble(&ensemble);
+
+    return written;
+}
+
+
+
+
+
+//******************************************************************************
+//! \breif      Uniform random number of a walker
+//! \remark     SplitMix64 finalizer of the key (seed, step, walker, draw).
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  seed   : Random seed
+//! \param[in]  step   : Ensemble step
+//! \param[in]  walker : Walker index
+//! \param[in]  draw   : Draw index within the step
+//! \return     Uniform random number in (0, 1)
+//******************************************************************************
+static F64 drawUniform(const U32 seed, const U64 step, const U32 walker, const U32 draw)
+{
+    U64 z;
+
+    z = (((U64)seed << 32) | walker) ^ (step * 0x9E3779B97F4A7C15ULL) ^ ((U64)draw * 0xD1B54A32D192ED03ULL);
+    z += 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z = z ^ (z >> 31);
+
+    return ((F64)(z >> 11) + 0.5) / 9007199254740992.0;
+}
+
+
+
+//******************************************************************************
+//! \breif      Log posterior at fitting coordinates
+//! \remark     -chi^2 / 2, -HUGE_VAL outside the parameter bounds.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  response : Response matrix built at the data energies
+//! \param[in]  data     : Observed spectrum
+//! \param[in]  x        : log10(N0), p, log10(gamma_max)
+//! \param[out] model    : Model flux work array [data->Count]
+//! \return     Log posterior
+//******************************************************************************
+static F64 calcLogPosterior(const ICS_RESPONSE *response, const FITTING_DATA *data, const F64 *x, F64 *model)
+{
+    F64 chi_square;
+
+    chi_square = FittingSpectrum_CalcObjective(response, data, x, model);
+
+    return ((chi_square == HUGE_VAL) || isnan(chi_square)) ? -HUGE_VAL : -0.5 * chi_square;
+}
+
+
+
+//******************************************************************************
+//! \breif      Allocate the arrays of an ensemble
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[out] ensemble   : Ensemble
+//! \param[in]  walkers    : Number of walkers
+//! \param[in]  data_count : Number of data points
+//! \return     TRUE on success
+//******************************************************************************
+static BOOL createEnsemble(MCMC_ENSEMBLE *ensemble, const U32 walkers, const U32 data_count)
+{
+    ensemble->Walkers = walkers;
+    ensemble->X = (F64 *)calloc((size_t)walkers * FITTING_PARAMETERS, sizeof(F64));
+    ensemble->LogPost = (F64 *)calloc((size_t)walkers, sizeof(F64));
+    ensemble->Model = (F64 *)calloc((size_t)walkers * data_count + 1, sizeof(F64));
+    ensemble->Record = (F64 *)calloc((size_t)walkers * (FITTING_PARAMETERS + 1), sizeof(F64));
+
+    if ((ensemble->X == NULL) || (ensemble->LogPost == NULL) || (ensemble->Model == NULL) || (ensemble->Record == NULL)) {
+        releaseEnsemble(ensemble);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Place the walkers around the start point
+//! \remark     Each walker is drawn uniformly within MCMC_INITIAL_SPREAD of
+//!             the start point in every fitting coordinate, redrawn until its
+//!             posterior is finite.
+//! 
+//! \callgraph  
+//! 
+//! \param[in,out] ensemble   : Ensemble
+//! \param[in]     response   : Response matrix built at the data energies
+//! \param[in]     data       : Observed spectrum
+//! \param[in]     start      : Centre of the ensemble
+//! \param[in]     seed       : Random seed
+//! \param[in]     data_count : Number of data points
+//! \return     TRUE on success, FALSE if a walker has no finite posterior
+//******************************************************************************
+static BOOL initEnsemble(MCMC_ENSEMBLE *ensemble, const ICS_RESPONSE *response, const FITTING_DATA *data,
+                         const FITTING_PARAMS *start, const U32 seed, const U32 data_count)
+{
+    F64 centre[FITTING_PARAMETERS];
+    F64 *x;
+    U32 k, d, trial, draw;
+
+    FittingSpectrum_ToCoordinates(start, centre);
+
+    for (k = 0; k < ensemble->Walkers; k++) {
+        x = &ensemble->X[k * FITTING_PARAMETERS];
+        ensemble->LogPost[k] = -HUGE_VAL;
+        for (draw = MCMC_INITIAL_DRAW, trial = 0; (trial < MCMC_INITIAL_TRIALS) && (ensemble->LogPost[k] == -HUGE_VAL); trial++) {
+            for (d = 0; d < FITTING_PARAMETERS; d++) {
+                x[d] = centre[d] + MCMC_INITIAL_SPREAD * (2.0 * drawUniform(seed, 0, k, draw++) - 1.0);
+            }
+            ensemble->LogPost[k] = calcLogPosterior(response, data, x, &ensemble->Model[(size_t)k * data_count]);
+        }
+        if (ensemble->LogPost[k] == -HUGE_VAL) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Checksum of the observed spectrum
+//! \remark     FNV-1a over the bytes of the energy, flux, lower and upper
+//!             arrays.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  data : Observed spectrum
+//! \return     Checksum
+//******************************************************************************
+static U64 calcDataChecksum(const FITTING_DATA *data)
+{
+    const F64 *arrays[4];
+    const U8 *bytes;
+    U64 checksum = 0xCBF29CE484222325ULL;
+    size_t n, b;
+    U32 a;
+
+    arrays[0] = data->Energy;
+    arrays[1] = data->Flux;
+    arrays[2] = data->Lower;
+    arrays[3] = data->Upper;
+
+    n = sizeof(F64) * data->Count;
+    for (a = 0; a < 4; a++) {
+        bytes = (const U8 *)arrays[a];
+        for (b = 0; b < n; b++) {
+            checksum = (checksum ^ bytes[b]) * 0x100000001B3ULL;
+        }
+    }
+
+    return checksum;
+}
+
+
+
+//******************************************************************************
+//! \breif      Header fields that key a checkpoint
+//! \remark     The response matrix the posterior is evaluated from and the
+//!             data energies. Written by saveCheckpoint and compared by
+//!             loadCheckpoint.
+//! 
+//! \callgraph  
+//! 
+//! \param[out] header   : Checkpoint header
+//! \param[in]  response : Response matrix built at the data energies
+//! \param[in]  data     : Observed spectrum
+//! \return     None
+//******************************************************************************
+static void setCheckpointHeader(IO_TABLE_HEADER *header, const ICS_RESPONSE *response, const FITTING_DATA *data)
+{
+    IoTable_InitHeader(header, IO_TABLE_KIND_CHECKPOINT);
+    header->Mode = response->Mode;
+    header->Precision = response->Precision;
+    header->ThomsonLimit = response->ThomsonLimit;
+    header->TableTolerance = response->TableTolerance;
+    header->CmbTemperature = response->CmbTemperature;
+    header->EinitLower = response->EinitRange.Lower;
+    header->EinitUpper = response->EinitRange.Upper;
+    header->EinitIteration = response->EinitRange.Iteration;
+    header->GammaLower = response->GammaRange.Lower;
+    header->GammaUpper = response->GammaRange.Upper;
+    header->GammaIteration = response->GammaRange.Iteration;
+    header->EfinCount = data->Count;
+    header->EfinLower = (data->Count > 0) ? data->Energy[0] : 0.0;
+    header->EfinUpper = (data->Count > 0) ? data->Energy[data->Count - 1] : 0.0;
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Load the ensemble from the checkpoint file
+//! \remark     The checkpoint must have the same response matrix key (every
+//!             field of setCheckpointHeader), data checksum, seed and number
+//!             of walkers, otherwise its log posteriors would be stale.
+//! 
+//! \callgraph  
+//! 
+//! \param[out] ensemble : Ensemble
+//! \param[in]  response : Response matrix built at the data energies
+//! \param[in]  data     : Observed spectrum
+//! \param[in]  config   : Sampler settings
+//! \param[out] step     : Steps done at the checkpoint
+//! \return     TRUE if the checkpoint is loaded
+//******************************************************************************
+static BOOL loadCheckpoint(MCMC_ENSEMBLE *ensemble, const ICS_RESPONSE *response, const FITTING_DATA *data,
+                           const FITTING_MCMC_CONFIG *config, U32 *step)
+{
+    IO_TABLE table;
+    IO_TABLE_HEADER key;
+    const IO_TABLE_HEADER *header;
+    const F64 *state, *x, *log_post;
+    const U64 checksum = calcDataChecksum(data);
+    BOOL result;
+
+    if (IoTable_Open(&table, config->CheckpointFile) == FALSE) {
+        return FALSE;
+    }
+    setCheckpointHeader(&key, response, data);
+
+    header = table.Header;
+    state = IoTable_GetSection(&table, 0);
+    x = IoTable_GetSection(&table, 1);
+    log_post = IoTable_GetSection(&table, 2);
+
+    result = FALSE;
+    if ((header->Kind == key.Kind) && (header->Mode == key.Mode) && (header->Precision == key.Precision) &&
+        (header->ThomsonLimit == key.ThomsonLimit) && (header->TableTolerance == key.TableTolerance) && (header->CmbTemperature == key.CmbTemperature) &&
+        (header->EinitLower == key.EinitLower) && (header->EinitUpper == key.EinitUpper) && (header->EinitIteration == key.EinitIteration) &&
+        (header->GammaLower == key.GammaLower) && (header->GammaUpper == key.GammaUpper) && (header->GammaIteration == key.GammaIteration) &&
+        (header->EfinCount == key.EfinCount) && (header->EfinLower == key.EfinLower) && (header->EfinUpper == key.EfinUpper) &&
+        (header->SectionCount == MCMC_SECTION_COUNT) && (header->Section[0].Count == MCMC_STATE_COUNT) &&
+        (header->Section[1].Count == (U64)ensemble->Walkers * FITTING_PARAMETERS) && (header->Section[2].Count == ensemble->Walkers) &&
+        (state != NULL) && (x != NULL) && (log_post != NULL) &&
+        (state[1] == (F64)config->Seed) && (state[2] == (F64)ensemble->Walkers) && (state[3] == (F64)FITTING_PARAMETERS) &&
+        (state[4] == (F64)(checksum >> 32)) && (state[5] == (F64)(checksum & 0xFFFFFFFFULL))) {
+        *step = (U32)state[0];
+        memcpy(ensemble->X, x, sizeof(F64) * ensemble->Walkers * FITTING_PARAMETERS);
+        memcpy(ensemble->LogPost, log_post, sizeof(F64) * ensemble->Walkers);
+        result = TRUE;
+    }
+
+    IoTable_Close(&table);
+
+    return result;
+}
+
+
+
+//******************************************************************************
+//! \breif      Save the ensemble to the checkpoint file
+//! \remark     IoTable_Write renames a temporary file over the checkpoint,
+//!             so an interrupted write leaves the previous checkpoint intact.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  ensemble : Ensemble
+//! \param[in]  response : Response matrix built at the data energies
+//! \param[in]  data     : Observed spectrum
+//! \param[in]  config   : Sampler settings
+//! \param[in]  step     : Steps done
+//! \return     TRUE on success
+//******************************************************************************
+static BOOL saveCheckpoint(const MCMC_ENSEMBLE *ensemble, const ICS_RESPONSE *response, const FITTING_DATA *data,
+                           const FITTING_MCMC_CONFIG *config, const U32 step)
+{
+    IO_TABLE_HEADER header;
+    const F64 *sections[MCMC_SECTION_COUNT];
+    F64 state[MCMC_STATE_COUNT];
+    const U64 checksum = calcDataChecksum(data);
+
+    state[0] = (F64)step;
+    state[1] = (F64)config->Seed;
+    state[2] = (F64)ensemble->Walkers;
+    state[3] = (F64)FITTING_PARAMETERS;
+    state[4] = (F64)(checksum >> 32);
+    state[5] = (F64)(checksum & 0xFFFFFFFFULL);
+
+    setCheckpointHeader(&header, response, data);
+    header.SectionCount = MCMC_SECTION_COUNT;
+    header.Section[0].Count = MCMC_STATE_COUNT;
+    header.Section[1].Count = (U64)ensemble->Walkers * FITTING_PARAMETERS;
+    header.Section[2].Count = ensemble->Walkers;
+    sections[0] = state;
+    sections[1] = ensemble->X;
+    sections[2] = ensemble->LogPost;
+
+    return IoTable_Write(config->CheckpointFile, &header, sections);
+}
+
+
+
+//******************************************************************************
+//! \breif      Release the arrays of an ensemble
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in,out] ensemble : Ensemble
+//! \return     None
+//******************************************************************************
+static void releaseEnsemble(MCMC_ENSEMBLE *ensemble)
+{
+    free(ensemble->X);
+    free(ensemble->LogPost);
+    free(ensemble->Model);
+    free(ensemble->Record);
+    ensemble->X = NULL;
+    ensemble->LogPost = NULL;
+    ensemble->Model = NULL;
+    ensemble->Record = NULL;
+
+    return;
+}
+
+
+
+
+//******************************************************************************
+// End of File
+//******************************************************************************
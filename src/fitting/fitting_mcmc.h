@@ -0,0 +1,97 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#ifndef FITTING_MCMC_H_
+#define FITTING_MCMC_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include "common_typedef.h"
+#include "ics_response.h"
+#include "fitting_data.h"
+#include "fitting_spectrum.h"
+
+
+
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! Sampler settings
+//----------------------------------------------------------
+typedef struct fitting_mcmc_config_t {
+    U32         Walkers;                //!< Number of walkers (even, at least 2 x FITTING_PARAMETERS)
+    U32         Steps;                  //!< Ensemble steps of the whole run
+    U32         Seed;                   //!< Random seed
+    U32         CheckpointInterval;     //!< Steps between checkpoints
+    F64         Scale;                  //!< Stretch scale a of the proposal (2 is usual)
+    const CHAR  *ChainFile;             //!< Chain file (see IO_CHAIN)
+    const CHAR  *CheckpointFile;        //!< Checkpoint file (resumed when it matches)
+}FITTING_MCMC_CONFIG;
+
+//----------------------------------------------------------
+//! Sampler statistics
+//----------------------------------------------------------
+typedef struct fitting_mcmc_result_t {
+    U32         StartStep;              //!< Step the run started (or resumed) from
+    U32         Steps;                  //!< Steps in the chain file
+    U64         Evaluations;            //!< Likelihood evaluations of this run
+    F64         Acceptance;             //!< Accepted fraction of the proposals of this run
+}FITTING_MCMC_RESULT;
+
+
+
+//==============================================================================
+// Export Scope Function Prototype
+//==============================================================================
+/**
+ * @brief           Sample the posterior of the electron spectrum parameters
+ * 
+ * @param response  Response matrix built at the data energies
+ * @param data      Observed spectrum
+ * @param start     Centre of the initial ensemble (usually the best fit)
+ * @param config    Sampler settings
+ * @param result    Sampler statistics
+ * @return BOOL     TRUE on success, FALSE on invalid settings, allocation
+ *                  failure or a write error
+ */
+extern BOOL FittingMcmc_Run(const ICS_RESPONSE *response, const FITTING_DATA *data, const FITTING_PARAMS *start,
+                            const FITTING_MCMC_CONFIG *config, FITTING_MCMC_RESULT *result);
+
+
+
+#ifdef _cplusplus
+}
+#endif
+
+#endif
+
+//******************************************************************************
+// End of File
+//******************************************************************************
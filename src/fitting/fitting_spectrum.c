@@ -0,0 +1,439 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#define FITTING_SPECTRUM_C_
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "numerics_nelder_mead.h"
+#include "fitting_spectrum.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+#define FITTING_POWER_MIN               (0.0)           //!< Lower bound of the power
+#define FITTING_POWER_MAX               (10.0)          //!< Upper bound of the power
+#define FITTING_GAMMA_MAX_MARGIN        (10.0)          //!< gamma_max stays this far below the gamma range
+#define FITTING_RESTARTS                (2)             //!< Simplex runs, each from the previous best
+#define FITTING_STEP_LOG_NORM           (0.5)           //!< Initial step of log10(N0)
+#define FITTING_STEP_POWER              (0.2)           //!< Initial step of p
+#define FITTING_STEP_LOG_GAMMA_MAX      (0.5)           //!< Initial step of log10(gamma_max)
+#define FITTING_TOLERANCE_VALUE         (1.0E-10)       //!< Relative chi-square spread at convergence
+#define FITTING_TOLERANCE_STEP          (1.0E-7)        //!< Simplex size at convergence
+#define FITTING_MAX_EVALUATIONS         (10000)         //!< Model evaluations per simplex run
+
+
+
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! Context of the chi-square objective
+//----------------------------------------------------------
+typedef struct fitting_context_t {
+    const ICS_RESPONSE  *Response;      //!< Response matrix at the data energies
+    const FITTING_DATA  *Data;          //!< Observed spectrum
+    F64                 *Model;         //!< Work array [Data->Count]
+}FITTING_CONTEXT;
+
+
+
+//==============================================================================
+// File Scope Function Prototype
+//==============================================================================
+static F64 chiSquareObjective(const F64 *x, void *context);
+static F64 calcSigma(const FITTING_DATA *data, const U32 k, const F64 model);
+static BOOL invertMatrix(const F64 matrix[FITTING_PARAMETERS][FITTING_PARAMETERS], F64 inverse[FITTING_PARAMETERS][FITTING_PARAMETERS]);
+
+
+
+
+
+//******************************************************************************
+//! \breif      Calculates the chi-square of an electron spectrum
+//! \remark     The model is the response matrix contracted with the electron
+//!             spectrum, so no kernel is evaluated. The error bar is
+//!             asymmetric : (upper - flux) is used when the model is above
+//!             the data and (flux - lower) when it is below.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  response : Response matrix built at the data energies
+//! \param[in]  data     : Observed spectrum
+//! \param[in]  params   : Electron spectrum parameters
+//! \param[out] model    : Model flux at the data energies [data->Count]
+//! \return     Chi-square (NaN if the work array cannot be allocated)
+//******************************************************************************
+F64 FittingSpectrum_CalcChiSquare(const ICS_RESPONSE *response, const FITTING_DATA *data, const FITTING_PARAMS *params, F64 *model)
+{
+    U32 k;
+    F64 sigma, residual, chi_square;
+
+    if (IcsResponse_CalcFlux(response, params->Norm, params->Power, params->GammaMax, model) == FALSE) {
+        return NAN;
+    }
+
+    for (chi_square = 0.0, k = 0; k < data->Count; k++) {
+        residual = model[k] - data->Flux[k];
+        if ((sigma = calcSigma(data, k, model[k])) > 0.0) {
+            chi_square += (residual / sigma) * (residual / sigma);
+        }
+    }
+
+    return chi_square;
+}
+
+
+
+//******************************************************************************
+//! \breif      Calculates the parameter errors from the Fisher matrix
+//! \remark     F = J^T W J with the Jacobian of IcsResponse_CalcFluxJacobian
+//!             and the error bars of FittingSpectrum_CalcChiSquare. F is
+//!             inverted in (ln N0, p, ln gamma_max), where it is far better
+//!             conditioned than in (N0, p, gamma_max). The errors are
+//!             given in the fitting coordinates, since a symmetric error of
+//!             N0 or gamma_max misstates the interval once it is not small.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  response    : Response matrix built at the data energies
+//! \param[in]  data        : Observed spectrum
+//! \param[in]  params      : Electron spectrum parameters (usually the best fit)
+//! \param[out] errors      : 1 sigma errors of log10(N0), p, log10(gamma_max)
+//! \param[out] correlation : Correlation of (N0, p, gamma_max)
+//! \return     TRUE on success, FALSE if the Fisher matrix is singular or the
+//!             work arrays cannot be allocated
+//******************************************************************************
+BOOL FittingSpectrum_CalcErrors(const ICS_RESPONSE *response, const FITTING_DATA *data, const FITTING_PARAMS *params,
+                                F64 errors[FITTING_PARAMETERS], F64 correlation[FITTING_PARAMETERS][FITTING_PARAMETERS])
+{
+    F64 fisher[FITTING_PARAMETERS][FITTING_PARAMETERS], covariance[FITTING_PARAMETERS][FITTING_PARAMETERS];
+    F64 scale[FITTING_PARAMETERS], derivative[FITTING_PARAMETERS];
+    F64 *model, *jacobian, sigma;
+    U32 k, a, b;
+    BOOL result;
+
+    model = (F64 *)malloc(sizeof(F64) * data->Count);
+    jacobian = (F64 *)malloc(sizeof(F64) * FITTING_PARAMETERS * data->Count);
+    if ((model == NULL) || (jacobian == NULL) ||
+        (IcsResponse_CalcFluxJacobian(response, params->Norm, params->Power, params->GammaMax, model, jacobian) == FALSE)) {
+        free(model);
+        free(jacobian);
+        return FALSE;
+    }
+
+    // d/d(ln x) = x d/dx for N0 and gamma_max
+    scale[0] = params->Norm;
+    scale[1] = 1.0;
+    scale[2] = params->GammaMax;
+
+    memset(fisher, 0, sizeof(fisher));
+    for (k = 0; k < data->Count; k++) {
+        if ((sigma = calcSigma(data, k, model[k])) <= 0.0) {
+            continue;
+        }
+        for (a = 0; a < FITTING_PARAMETERS; a++) {
+            derivative[a] = scale[a] * jacobian[FITTING_PARAMETERS * k + a] / sigma;
+        }
+        for (a = 0; a < FITTING_PARAMETERS; a++) {
+            for (b = 0; b < FITTING_PARAMETERS; b++) {
+                fisher[a][b] += derivative[a] * derivative[b];
+            }
+        }
+    }
+
+    free(model);
+    free(jacobian);
+
+    if ((result = invertMatrix((const F64 (*)[FITTING_PARAMETERS])fisher, covariance)) == TRUE) {
+        for (a = 0; a < FITTING_PARAMETERS; a++) {
+            result = ((result == TRUE) && (covariance[a][a] > 0.0)) ? TRUE : FALSE;
+        }
+    }
+    if (result == FALSE) {
+        return FALSE;
+    }
+
+    // ln to log10 for N0 and gamma_max
+    errors[0] = sqrt(covariance[0][0]) / log(10.0);
+    errors[1] = sqrt(covariance[1][1]);
+    errors[2] = sqrt(covariance[2][2]) / log(10.0);
+    for (a = 0; a < FITTING_PARAMETERS; a++) {
+        for (b = 0; b < FITTING_PARAMETERS; b++) {
+            correlation[a][b] = covariance[a][b] / sqrt(covariance[a][a] * covariance[b][b]);
+        }
+    }
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Calculates the chi-square at fitting coordinates
+//! \remark     Points outside the parameter bounds get HUGE_VAL : p in
+//!             [FITTING_POWER_MIN, FITTING_POWER_MAX] and gamma_max inside
+//!             the gamma range of the response matrix, FITTING_GAMMA_MAX_MARGIN
+//!             below its upper end.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  response : Response matrix built at the data energies
+//! \param[in]  data     : Observed spectrum
+//! \param[in]  x        : log10(N0), p, log10(gamma_max)
+//! \param[out] model    : Model flux at the data energies [data->Count]
+//! \return     Chi-square
+//******************************************************************************
+F64 FittingSpectrum_CalcObjective(const ICS_RESPONSE *response, const FITTING_DATA *data, const F64 *x, F64 *model)
+{
+    const INTEGRATION_RANGE *gamma_range = &response->GammaRange;
+    FITTING_PARAMS params;
+
+    FittingSpectrum_ToParams(x, &params);
+
+    if ((params.Power < FITTING_POWER_MIN) || (params.Power > FITTING_POWER_MAX) ||
+        (params.GammaMax < gamma_range->Lower) || (params.GammaMax > gamma_range->Upper / FITTING_GAMMA_MAX_MARGIN)) {
+        return HUGE_VAL;
+    }
+
+    return FittingSpectrum_CalcChiSquare(response, data, &params, model);
+}
+
+
+
+//******************************************************************************
+//! \breif      Convert fitting coordinates to the parameters
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  x      : log10(N0), p, log10(gamma_max)
+//! \param[out] params : Electron spectrum parameters
+//! \return     None
+//******************************************************************************
+void FittingSpectrum_ToParams(const F64 *x, FITTING_PARAMS *params)
+{
+    params->Norm = pow(10.0, x[0]);
+    params->Power = x[1];
+    params->GammaMax = pow(10.0, x[2]);
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Convert the parameters to fitting coordinates
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  params : Electron spectrum parameters
+//! \param[out] x      : log10(N0), p, log10(gamma_max)
+//! \return     None
+//******************************************************************************
+void FittingSpectrum_ToCoordinates(const FITTING_PARAMS *params, F64 *x)
+{
+    x[0] = log10(params->Norm);
+    x[1] = params->Power;
+    x[2] = log10(params->GammaMax);
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Fit the electron spectrum to an observed spectrum
+//! \remark     1) Nelder-Mead on (log10 N0, p, log10 gamma_max), restarted
+//!                from the best point FITTING_RESTARTS times.
+//!             2) The parameters are bounded as in
+//!                FittingSpectrum_CalcObjective.
+//!             3) With start->Norm <= 0, N0 starts from the geometric mean
+//!                of data / model at N0 = 1.
+//!             4) The errors come from the Fisher matrix at the best fit.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  response : Response matrix built at the data energies
+//! \param[in]  data     : Observed spectrum
+//! \param[in]  start    : Start point (Norm <= 0 : scaled to the data)
+//! \param[out] result   : Best fit
+//! \return     TRUE on success, FALSE if the work array cannot be allocated
+//******************************************************************************
+BOOL FittingSpectrum_Fit(const ICS_RESPONSE *response, const FITTING_DATA *data, const FITTING_PARAMS *start, FITTING_RESULT *result)
+{
+    FITTING_CONTEXT context;
+    FITTING_PARAMS params;
+    NELDER_MEAD_TOLERANCE tolerance;
+    NELDER_MEAD_RESULT minimum;
+    F64 x[FITTING_PARAMETERS], step[FITTING_PARAMETERS];
+    F64 sum_log;
+    U32 k, n_log, run;
+
+    if ((context.Model = (F64 *)malloc(sizeof(F64) * data->Count)) == NULL) {
+        return FALSE;
+    }
+    context.Response = response;
+    context.Data = data;
+
+    //------------------------------------------------------
+    // Start point
+    //------------------------------------------------------
+    params = *start;
+    if (params.Norm <= 0.0) {
+        params.Norm = 1.0;
+        IcsResponse_CalcFlux(response, params.Norm, params.Power, params.GammaMax, context.Model);
+        for (sum_log = 0.0, n_log = 0, k = 0; k < data->Count; k++) {
+            if (context.Model[k] > 0.0) {
+                sum_log += log10(data->Flux[k] / context.Model[k]);
+                n_log++;
+            }
+        }
+        params.Norm = (n_log > 0) ? pow(10.0, sum_log / (F64)n_log) : 1.0;
+    }
+
+    FittingSpectrum_ToCoordinates(&params, x);
+    step[0] = FITTING_STEP_LOG_NORM;
+    step[1] = FITTING_STEP_POWER;
+    step[2] = FITTING_STEP_LOG_GAMMA_MAX;
+
+    tolerance.Value = FITTING_TOLERANCE_VALUE;
+    tolerance.Step = FITTING_TOLERANCE_STEP;
+    tolerance.MaxEvaluations = FITTING_MAX_EVALUATIONS;
+
+    //------------------------------------------------------
+    // Minimize
+    //------------------------------------------------------
+    result->Evaluations = 0;
+    result->Iterations = 0;
+    for (run = 0; run < FITTING_RESTARTS; run++) {
+        result->Converged = NumericsNelderMead_Minimize(chiSquareObjective, &context, FITTING_PARAMETERS, x, step, &tolerance, &minimum);
+        result->Evaluations += minimum.Evaluations;
+        result->Iterations += minimum.Iterations;
+    }
+
+    FittingSpectrum_ToParams(x, &result->Params);
+    result->ChiSquare = minimum.Minimum;
+    result->Dof = (data->Count > FITTING_PARAMETERS) ? (data->Count - FITTING_PARAMETERS) : 0;
+    result->HasErrors = FittingSpectrum_CalcErrors(response, data, &result->Params, result->Errors, result->Correlation);
+
+    free(context.Model);
+
+    return TRUE;
+}
+
+
+
+
+
+//******************************************************************************
+//! \breif      Chi-square objective of the simplex
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  x       : log10(N0), p, log10(gamma_max)
+//! \param[in]  context : FITTING_CONTEXT
+//! \return     Chi-square
+//******************************************************************************
+static F64 chiSquareObjective(const F64 *x, void *context)
+{
+    const FITTING_CONTEXT *fitting = (const FITTING_CONTEXT *)context;
+
+    return FittingSpectrum_CalcObjective(fitting->Response, fitting->Data, x, fitting->Model);
+}
+
+
+
+//******************************************************************************
+//! \breif      Error bar of a data point
+//! \remark     Asymmetric : (upper - flux) when the model is above the data
+//!             and (flux - lower) when it is below.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  data  : Observed spectrum
+//! \param[in]  k     : Data point
+//! \param[in]  model : Model flux at the data point
+//! \return     Error bar (<= 0 : the point has no error bar on that side)
+//******************************************************************************
+static F64 calcSigma(const FITTING_DATA *data, const U32 k, const F64 model)
+{
+    return (model > data->Flux[k]) ? (data->Upper[k] - data->Flux[k]) : (data->Flux[k] - data->Lower[k]);
+}
+
+
+
+//******************************************************************************
+//! \breif      Invert a symmetric FITTING_PARAMETERS x FITTING_PARAMETERS matrix
+//! \remark     Cofactor expansion of the 3 x 3 matrix.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  matrix  : Matrix
+//! \param[out] inverse : Inverse
+//! \return     TRUE on success, FALSE if the matrix is singular
+//******************************************************************************
+static BOOL invertMatrix(const F64 matrix[FITTING_PARAMETERS][FITTING_PARAMETERS], F64 inverse[FITTING_PARAMETERS][FITTING_PARAMETERS])
+{
+    F64 determinant;
+    U32 a, b;
+
+    inverse[0][0] = matrix[1][1] * matrix[2][2] - matrix[1][2] * matrix[2][1];
+    inverse[0][1] = matrix[0][2] * matrix[2][1] - matrix[0][1] * matrix[2][2];
+    inverse[0][2] = matrix[0][1] * matrix[1][2] - matrix[0][2] * matrix[1][1];
+    inverse[1][0] = matrix[1][2] * matrix[2][0] - matrix[1][0] * matrix[2][2];
+    inverse[1][1] = matrix[0][0] * matrix[2][2] - matrix[0][2] * matrix[2][0];
+    inverse[1][2] = matrix[0][2] * matrix[1][0] - matrix[0][0] * matrix[1][2];
+    inverse[2][0] = matrix[1][0] * matrix[2][1] - matrix[1][1] * matrix[2][0];
+    inverse[2][1] = matrix[0][1] * matrix[2][0] - matrix[0][0] * matrix[2][1];
+    inverse[2][2] = matrix[0][0] * matrix[1][1] - matrix[0][1] * matrix[1][0];
+
+    determinant = matrix[0][0] * inverse[0][0] + matrix[0][1] * inverse[1][0] + matrix[0][2] * inverse[2][0];
+    if (!(fabs(determinant) > 0.0)) {
+        return FALSE;
+    }
+
+    for (a = 0; a < FITTING_PARAMETERS; a++) {
+        for (b = 0; b < FITTING_PARAMETERS; b++) {
+            inverse[a][b] /= determinant;
+        }
+    }
+
+    return TRUE;
+}
+
+
+
+
+//******************************************************************************
+// End of File
+//******************************************************************************
@@ -0,0 +1,153 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#ifndef FITTING_SPECTRUM_H_
+#define FITTING_SPECTRUM_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include "common_typedef.h"
+#include "ics_response.h"
+#include "fitting_data.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+#define FITTING_PARAMETERS              (3)             //!< N0, p and gamma_max
+
+
+
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! Electron spectrum parameters
+//----------------------------------------------------------
+typedef struct fitting_params_t {
+    F64         Norm;                   //!< Normalization Factor
+    F64         Power;                  //!< Power
+    F64         GammaMax;               //!< Maximum Lorentz Factor (Cut-off)
+}FITTING_PARAMS;
+
+//----------------------------------------------------------
+//! Result of a fit
+//----------------------------------------------------------
+typedef struct fitting_result_t {
+    FITTING_PARAMS Params;              //!< Best-fit parameters
+    F64         ChiSquare;              //!< Chi-square at the best fit
+    U32         Dof;                    //!< Degrees of freedom
+    U32         Evaluations;            //!< Model evaluations
+    U32         Iterations;             //!< Simplex iterations
+    BOOL        Converged;              //!< The minimizer met its tolerance
+    BOOL        HasErrors;              //!< Errors and Correlation are valid
+    F64         Errors[FITTING_PARAMETERS];     //!< 1 sigma errors of log10(N0), p, log10(gamma_max) from the Fisher matrix
+    F64         Correlation[FITTING_PARAMETERS][FITTING_PARAMETERS];   //!< Correlation of (N0, p, gamma_max)
+}FITTING_RESULT;
+
+
+
+//==============================================================================
+// Export Scope Function Prototype
+//==============================================================================
+/**
+ * @brief           Calculates the chi-square of an electron spectrum
+ * 
+ * @param response  Response matrix built at the data energies
+ * @param data      Observed spectrum
+ * @param params    Electron spectrum parameters
+ * @param model     Model flux at the data energies [data->Count]
+ * @return F64      Chi-square (NaN if the work array cannot be allocated)
+ */
+extern F64 FittingSpectrum_CalcChiSquare(const ICS_RESPONSE *response, const FITTING_DATA *data, const FITTING_PARAMS *params, F64 *model);
+
+/**
+ * @brief           Calculates the parameter errors from the Fisher matrix
+ * 
+ * @param response  Response matrix built at the data energies
+ * @param data      Observed spectrum
+ * @param params    Electron spectrum parameters (usually the best fit)
+ * @param errors    1 sigma errors of log10(N0), p, log10(gamma_max)
+ * @param correlation Correlation of (N0, p, gamma_max)
+ * @return BOOL     TRUE on success, FALSE if the Fisher matrix is singular or
+ *                  the work arrays cannot be allocated
+ */
+extern BOOL FittingSpectrum_CalcErrors(const ICS_RESPONSE *response, const FITTING_DATA *data, const FITTING_PARAMS *params,
+                                       F64 errors[FITTING_PARAMETERS], F64 correlation[FITTING_PARAMETERS][FITTING_PARAMETERS]);
+
+/**
+ * @brief           Calculates the chi-square at fitting coordinates
+ * 
+ * @param response  Response matrix built at the data energies
+ * @param data      Observed spectrum
+ * @param x         log10(N0), p, log10(gamma_max)
+ * @param model     Model flux at the data energies [data->Count]
+ * @return F64      Chi-square (HUGE_VAL outside the parameter bounds)
+ */
+extern F64 FittingSpectrum_CalcObjective(const ICS_RESPONSE *response, const FITTING_DATA *data, const F64 *x, F64 *model);
+
+/**
+ * @brief           Convert fitting coordinates to the parameters
+ * 
+ * @param x         log10(N0), p, log10(gamma_max)
+ * @param params    Electron spectrum parameters
+ */
+extern void FittingSpectrum_ToParams(const F64 *x, FITTING_PARAMS *params);
+
+/**
+ * @brief           Convert the parameters to fitting coordinates
+ * 
+ * @param params    Electron spectrum parameters
+ * @param x         log10(N0), p, log10(gamma_max)
+ */
+extern void FittingSpectrum_ToCoordinates(const FITTING_PARAMS *params, F64 *x);
+
+/**
+ * @brief           Fit the electron spectrum to an observed spectrum
+ * 
+ * @param response  Response matrix built at the data energies
+ * @param data      Observed spectrum
+ * @param start     Start point (Norm <= 0 : scaled to the data)
+ * @param result    Best fit
+ * @return BOOL     TRUE on success, FALSE if the work array cannot be allocated
+ */
+extern BOOL FittingSpectrum_Fit(const ICS_RESPONSE *response, const FITTING_DATA *data, const FITTING_PARAMS *start, FITTING_RESULT *result);
+
+
+
+#ifdef _cplusplus
+}
+#endif
+
+#endif
+
+//******************************************************************************
+// End of File
+//******************************************************************************
@@ -0,0 +1,1418 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#define ICS_CMB_SPECTRUM_C_
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include <stdlib.h>
+#include <math.h>
+#include "common_physical_const.h"
+#include "ics_jones_approx.h"
+#include "ics_jones_batch.h"
+#include "ics_kak_approx.h"
+#include "ics_thomson_approx.h"
+#include "numerics_gauss_kronrod.h"
+#include "numerics_quadrature.h"
+#include "particles_cmb.h"
+#include "particles_electron.h"
+#include "ics_cmb_spectrum.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+//----------------------------------------------------------
+//! The gamma integrals of the adaptive rule use a tighter relative tolerance
+//----------------------------------------------------------
+#define ADAPTIVE_INNER_FACTOR           (0.1)
+
+//----------------------------------------------------------
+//! Relative margin added to the kinematic support of the single sweep
+//----------------------------------------------------------
+#define SWEEP_SUPPORT_MARGIN            (1.0E-6)
+
+//----------------------------------------------------------
+//! Most kernels contracted in one pass (Jones and Thomson)
+//----------------------------------------------------------
+#define KERNEL_LIST_MAX                 (2)
+
+
+
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! Context of the adaptive integration
+//----------------------------------------------------------
+typedef struct ics_adaptive_context_t {
+    const ICS_CMB_SPECTRUM  *Spectrum;      //!< ICS spectrum
+    F64                     Efin;           //!< Scattered Photon Energy [eV]
+    F64                     Einit;          //!< Current incident photon energy [eV]
+    GAUSS_KRONROD_TOLERANCE Tolerance;      //!< Tolerance of the gamma integral
+    F64                     MaxRelError;    //!< Largest relative error of the gamma integrals
+    U64                     Evaluations;    //!< Kernel evaluations
+    BOOL                    Converged;      //!< All gamma integrals met the tolerance
+}ICS_ADAPTIVE_CONTEXT;
+
+//----------------------------------------------------------
+//! Kernel factors of one einit row (only those of the mode and precision are set)
+//----------------------------------------------------------
+typedef struct ics_kernel_einit_t {
+    F64                     Einit;          //!< Incident Photon Energy [eV]
+    ICS_JONES_EINIT         Jones;          //!< Jones, double precision
+    ICS_JONES_EINIT_F128    JonesF128;      //!< Jones, quad precision
+    ICS_THOMSON_EINIT_F64   ThomsonF64;     //!< Thomson, double precision
+    ICS_THOMSON_EINIT       Thomson;        //!< Thomson, quad precision
+    U32                     ThomsonEnd;     //!< Jones : gamma nodes below this use the Thomson limit
+}ICS_KERNEL_EINIT;
+
+//----------------------------------------------------------
+//! Evaluator of a kernel on the gamma nodes of one einit row
+//----------------------------------------------------------
+typedef void (*ICS_KERNEL_EVALUATOR)(const ICS_CMB_SPECTRUM *spectrum, const F64 efin, const ICS_KERNEL_EINIT *einit, const U32 first, F64 *kernel);
+
+
+
+//==============================================================================
+// File Scope Function Prototype
+//==============================================================================
+static void initSpectrum(ICS_CMB_SPECTRUM *spectrum, const S32 mode, const INTEGRATION_RANGE *gamma_range);
+static BOOL createPlanckRule(ICS_CMB_SPECTRUM *spectrum);
+static BOOL createDensities(ICS_CMB_SPECTRUM *spectrum);
+static BOOL prepareGamma(ICS_CMB_SPECTRUM *spectrum);
+static void prepareEinit(const ICS_CMB_SPECTRUM *spectrum, const F64 einit, ICS_KERNEL_EINIT *prepared);
+static F64 calcGammaThreshold(const S32 mode, const F64 efin, const F64 einit);
+static U32 findFirstGamma(const ICS_CMB_SPECTRUM *spectrum, const F64 efin, const F64 einit);
+static U32 findThomsonLimitEnd(const ICS_CMB_SPECTRUM *spectrum, const F64 einit);
+static U32 findGammaNode(const ICS_CMB_SPECTRUM *spectrum, const F64 value);
+static void calcEfinSupport(const ICS_CMB_SPECTRUM *spectrum, const ICS_KERNEL_EINIT *einit, const U32 j, F64 *lower, F64 *upper);
+static U32 findFirstEfin(const F64 *efin, const U32 count, const F64 value);
+static BOOL contractKernels(const ICS_CMB_SPECTRUM *spectrum, const F64 efin, const ICS_KERNEL_EVALUATOR *evaluators, const U32 count, F64 *flux);
+static void evaluateKernel(const ICS_CMB_SPECTRUM *spectrum, const F64 efin, const ICS_KERNEL_EINIT *einit, const U32 first, F64 *kernel);
+static void evaluateJonesKernel(const ICS_CMB_SPECTRUM *spectrum, const F64 efin, const ICS_KERNEL_EINIT *einit, const U32 first, F64 *kernel);
+static void evaluateThomsonKernel(const ICS_CMB_SPECTRUM *spectrum, const F64 efin, const ICS_KERNEL_EINIT *einit, const U32 first, F64 *kernel);
+static F64 evaluateKernelNode(const ICS_CMB_SPECTRUM *spectrum, const F64 efin, const ICS_KERNEL_EINIT *einit, const U32 j);
+static F64 evaluateKernelAt(const ICS_CMB_SPECTRUM *spectrum, const F64 efin, const F64 einit, const F64 gamma);
+static F64 adaptiveGammaIntegrand(const F64 gamma, void *context);
+static F64 adaptiveEinitIntegrand(const F64 einit, void *context);
+
+
+
+
+
+//******************************************************************************
+//! \breif      Create the integration grids and the CMB density vector
+//! \remark     The CMB flux depends only on einit, so it is evaluated once
+//!             here and folded into the einit weights.
+//!             USE_KAK_APPROX has no einit integral and ignores einit_range.
+//! 
+//! \callgraph  
+//! 
+//! \param[out] spectrum    : ICS spectrum to be created
+//! \param[in]  mode        : USE_JONES_APPROX, USE_THOMSON_APPROX or USE_KAK_APPROX
+//! \param[in]  einit_range : Integration Range of incident photon energy [eV]
+//! \param[in]  gamma_range : Integration Range of Lorentz factor
+//! \return     TRUE on success, FALSE if the arrays cannot be allocated
+//******************************************************************************
+BOOL IcsCmbSpectrum_Create(ICS_CMB_SPECTRUM *spectrum, const S32 mode, const INTEGRATION_RANGE *einit_range, const INTEGRATION_RANGE *gamma_range)
+{
+    initSpectrum(spectrum, mode, gamma_range);
+    if (mode == USE_KAK_APPROX) {
+        return createPlanckRule(spectrum);
+    }
+    spectrum->EinitRange = *einit_range;
+
+    if (NumericsQuadrature_CreateLog(&spectrum->Einit, einit_range) == FALSE) {
+        IcsCmbSpectrum_Release(spectrum);
+        return FALSE;
+    }
+
+    return createDensities(spectrum);
+}
+
+
+
+//******************************************************************************
+//! \breif      Create the integration grids with the blackbody rule on einit
+//! \remark     einit uses the Gauss-Laguerre rule of the CMB spectrum
+//!             (PatriclesCmb_CreateQuadrature) instead of the log grid.
+//!             EinitRange records the first and last node and the number
+//!             of nodes, which keys the response matrix cache.
+//!             USE_KAK_APPROX has no einit integral and ignores count.
+//! 
+//! \callgraph  
+//! 
+//! \param[out] spectrum    : ICS spectrum to be created
+//! \param[in]  mode        : USE_JONES_APPROX, USE_THOMSON_APPROX or USE_KAK_APPROX
+//! \param[in]  count       : Number of einit nodes
+//! \param[in]  gamma_range : Integration Range of Lorentz factor
+//! \return     TRUE on success, FALSE otherwise
+//******************************************************************************
+BOOL IcsCmbSpectrum_CreateBlackbody(ICS_CMB_SPECTRUM *spectrum, const S32 mode, const U32 count, const INTEGRATION_RANGE *gamma_range)
+{
+    initSpectrum(spectrum, mode, gamma_range);
+    if (mode == USE_KAK_APPROX) {
+        return createPlanckRule(spectrum);
+    }
+
+    if (PatriclesCmb_CreateQuadrature(&spectrum->Einit, count) == FALSE) {
+        IcsCmbSpectrum_Release(spectrum);
+        return FALSE;
+    }
+
+    spectrum->EinitRange.Lower = spectrum->Einit.Node[0];
+    spectrum->EinitRange.Upper = spectrum->Einit.Node[count - 1];
+    spectrum->EinitRange.Iteration = count;
+
+    return createDensities(spectrum);
+}
+
+
+
+//******************************************************************************
+//! \breif      Evaluate the electron density vector on the gamma nodes
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in,out] spectrum  : ICS spectrum
+//! \param[in]  norm         : Normalization Factor
+//! \param[in]  power        : Power
+//! \param[in]  gamma_max    : Maximum Lorentz Factor (Cut-off)
+//! \return     None
+//******************************************************************************
+void IcsCmbSpectrum_SetElectron(ICS_CMB_SPECTRUM *spectrum, const F64 norm, const F64 power, const F64 gamma_max)
+{
+    U32 j;
+
+    spectrum->Norm = norm;
+    spectrum->Power = power;
+    spectrum->GammaMax = gamma_max;
+
+    for (j = 0; j < spectrum->Gamma.Count; j++) {
+        spectrum->ElectronDensity[j] = spectrum->Gamma.Weight[j] * ParticlesElectron_CalcFlux(spectrum->Gamma.Node[j], norm, power, gamma_max);
+    }
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Calculates the ICS flux at an emitted energy
+//! \remark     Weighted contraction of the ICS kernel with the cached CMB and
+//!             electron density vectors. Only reads the spectrum, so several
+//!             threads may call it at once.
+//!             Rows without CMB photons and the gamma nodes below the
+//!             kinematic threshold are skipped.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  spectrum : ICS spectrum (not USE_JONES_THOMSON_APPROX)
+//! \param[in]  efin     : Scattered Photon Energy [eV]
+//! \return     ICS flux (NaN for USE_JONES_THOMSON_APPROX or if the work
+//!             array cannot be allocated)
+//******************************************************************************
+F64 IcsCmbSpectrum_CalcFlux(const ICS_CMB_SPECTRUM *spectrum, const F64 efin)
+{
+    const ICS_KERNEL_EVALUATOR evaluator = evaluateKernel;
+    F64 flux;
+
+    if (spectrum->Mode == USE_JONES_THOMSON_APPROX) {
+        return NAN;
+    }
+
+    if (contractKernels(spectrum, efin, &evaluator, 1, &flux) == FALSE) {
+        return NAN;
+    }
+
+    return flux;
+}
+
+
+
+//******************************************************************************
+//! \breif      Calculates the Jones and Thomson ICS flux at an emitted energy
+//!             in one pass
+//! \remark     1) The einit rows, the pruning, the prepared factors and the
+//!                CMB and electron densities are shared, and both kernels
+//!                are contracted with them in the same pass (contractKernels).
+//!             2) The gamma nodes start at the lower of the two kinematic
+//!                thresholds (calcGammaThreshold).
+//!             3) Only reads the spectrum, so several threads may call it at
+//!                once, as IcsCmbSpectrum_CalcFlux.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  spectrum : ICS spectrum (USE_JONES_THOMSON_APPROX)
+//! \param[in]  efin     : Scattered Photon Energy [eV]
+//! \param[out] jones    : ICS flux of the Jones approximation (NaN for
+//!                        another mode or if the work array cannot be
+//!                        allocated)
+//! \param[out] thomson  : ICS flux of the Thomson approximation (same)
+//! \return     None
+//******************************************************************************
+void IcsCmbSpectrum_CalcFluxPair(const ICS_CMB_SPECTRUM *spectrum, const F64 efin, F64 *jones, F64 *thomson)
+{
+    const ICS_KERNEL_EVALUATOR evaluators[KERNEL_LIST_MAX] = { evaluateJonesKernel, evaluateThomsonKernel };
+    F64 flux[KERNEL_LIST_MAX];
+
+    if ((spectrum->Mode != USE_JONES_THOMSON_APPROX) || (contractKernels(spectrum, efin, evaluators, KERNEL_LIST_MAX, flux) == FALSE)) {
+        *jones = *thomson = NAN;
+        return;
+    }
+
+    *jones = flux[0];
+    *thomson = flux[1];
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Calculates the ICS flux at an emitted energy with the adaptive
+//!             Gauss-Kronrod rule
+//! \remark     Nested log-space integration, einit outside and gamma inside.
+//!             The gamma integral starts at the kinematic threshold, so the
+//!             kernel edge is an end point rather than a kink inside an
+//!             interval. The ranges' Iteration is the maximum number of
+//!             subintervals. The error estimate adds the largest relative
+//!             error of the gamma integrals to that of the einit integral.
+//!             einit runs over EinitRange, so the spectrum should come from
+//!             IcsCmbSpectrum_Create. USE_KAK_APPROX integrates gamma only.
+//!             USE_JONES_THOMSON_APPROX is rejected.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  spectrum  : ICS spectrum
+//! \param[in]  efin      : Scattered Photon Energy [eV]
+//! \param[in]  tolerance : Tolerance
+//! \param[out] result    : ICS flux, error estimate and kernel evaluations
+//!                         (NaN flux for USE_JONES_THOMSON_APPROX)
+//! \return     TRUE if the tolerance is met, otherwise FALSE
+//******************************************************************************
+BOOL IcsCmbSpectrum_CalcFluxAdaptive(const ICS_CMB_SPECTRUM *spectrum, const F64 efin, const GAUSS_KRONROD_TOLERANCE *tolerance, GAUSS_KRONROD_RESULT *result)
+{
+    ICS_ADAPTIVE_CONTEXT context;
+    INTEGRATION_RANGE range;
+    BOOL converged;
+
+    if (spectrum->Mode == USE_JONES_THOMSON_APPROX) {
+        result->Value = result->Error = NAN;
+        result->Evaluations = 0;
+        result->Intervals = 0;
+        return FALSE;
+    }
+
+    context.Spectrum = spectrum;
+    context.Efin = efin;
+    context.Einit = 0.0;
+    context.Tolerance = *tolerance;
+    context.Tolerance.Absolute = 0.0;
+    context.Tolerance.Relative = ADAPTIVE_INNER_FACTOR * tolerance->Relative;
+    context.MaxRelError = 0.0;
+    context.Evaluations = 0;
+    context.Converged = TRUE;
+
+    if (spectrum->Mode == USE_KAK_APPROX) {
+        range = spectrum->GammaRange;
+        range.Lower = fmax(range.Lower, calcGammaThreshold(spectrum->Mode, efin, 0.0));
+        if (range.Lower >= range.Upper) {
+            result->Value = result->Error = 0.0;
+            result->Evaluations = 0;
+            result->Intervals = 0;
+            return TRUE;
+        }
+        converged = NumericsGaussKronrod_IntegrateLog(adaptiveGammaIntegrand, &context, &range, tolerance, result);
+        result->Evaluations = context.Evaluations;
+        return converged;
+    }
+
+    converged = NumericsGaussKronrod_IntegrateLog(adaptiveEinitIntegrand, &context, &spectrum->EinitRange, tolerance, result);
+
+    result->Error += context.MaxRelError * fabs(result->Value);
+    result->Evaluations = context.Evaluations;
+
+    return ((converged == TRUE) && (context.Converged == TRUE)) ? TRUE : FALSE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Calculates the ICS flux at all emitted energies in one sweep
+//!             of the (einit, gamma) grid
+//! \remark     1) Each grid node scatters its contribution into the emitted
+//!                energies inside its kinematic support, so the cost scales
+//!                with the grid size times the support width instead of the
+//!                grid size times the number of emitted energies.
+//!             2) einit rows run in parallel and each row keeps its own
+//!                partial fluxes, which are added in row order, so the result
+//!                does not depend on the number of threads.
+//!             3) Accumulation is in double precision for every Precision.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  spectrum    : ICS spectrum
+//! \param[in]  efin        : Scattered Photon Energies [eV] (ascending)
+//! \param[in]  count       : Number of emitted energies
+//! \param[out] flux        : ICS flux [count]
+//! \param[out] evaluations : Kernel evaluations (NULL if not needed)
+//! \return     TRUE on success, FALSE for USE_JONES_THOMSON_APPROX or if the
+//!             work array cannot be allocated
+//******************************************************************************
+BOOL IcsCmbSpectrum_CalcFluxSweep(const ICS_CMB_SPECTRUM *spectrum, const F64 *efin, const U32 count, F64 *flux, U64 *evaluations)
+{
+    S32 i;
+    U32 j, k, first, last;
+    F64 electron, lower, upper;
+    ICS_KERNEL_EINIT einit;
+    F64 *partial, *row;
+    U64 n_evaluated = 0;
+    const S32 n_rows = (S32)spectrum->Einit.Count;
+
+    if (spectrum->Mode == USE_JONES_THOMSON_APPROX) {
+        return FALSE;
+    }
+
+    if ((partial = (F64 *)calloc((size_t)n_rows * (size_t)count + 1, sizeof(F64))) == NULL) {
+        return FALSE;
+    }
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, 1) private(j, k, first, last, einit, electron, lower, upper, row) reduction(+:n_evaluated)
+#endif
+    for (i = 0; i < n_rows; i++) {
+        if (spectrum->CmbDensity[i] == 0.0) {
+            continue;
+        }
+        prepareEinit(spectrum, spectrum->Einit.Node[i], &einit);
+        row = &partial[(size_t)i * count];
+
+        for (j = 0; j < spectrum->Gamma.Count; j++) {
+            if ((electron = spectrum->ElectronDensity[j]) == 0.0) {
+                continue;
+            }
+
+            calcEfinSupport(spectrum, &einit, j, &lower, &upper);
+            first = findFirstEfin(efin, count, lower);
+            last  = findFirstEfin(efin, count, upper);
+
+            for (k = first; k < last; k++) {
+                row[k] += electron * evaluateKernelNode(spectrum, efin[k], &einit, j);
+            }
+            n_evaluated += (U64)(last - first);
+        }
+    }
+
+    for (k = 0; k < count; k++) {
+        flux[k] = 0.0;
+    }
+    for (i = 0; i < n_rows; i++) {
+        row = &partial[(size_t)i * count];
+        for (k = 0; k < count; k++) {
+            flux[k] += spectrum->CmbDensity[i] * row[k];
+        }
+    }
+
+    free(partial);
+
+    if (evaluations != NULL) {
+        *evaluations = n_evaluated;
+    }
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Calculates the CMB-integrated ICS kernel on the gamma nodes
+//! \remark     row[j] = sum_i CmbDensity[i] * kernel(efin, einit[i], gamma[j]).
+//!             It does not depend on the electron spectrum.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  spectrum : ICS spectrum
+//! \param[in]  efin     : Scattered Photon Energy [eV]
+//! \param[out] row      : Kernel integrated over einit [Gamma.Count]
+//! \return     TRUE on success, FALSE for USE_JONES_THOMSON_APPROX or if the
+//!             work array cannot be allocated
+//******************************************************************************
+BOOL IcsCmbSpectrum_CalcKernelRow(const ICS_CMB_SPECTRUM *spectrum, const F64 efin, F64 *row)
+{
+    register U32 i, j, first;
+    register F64 cmb;
+    ICS_KERNEL_EINIT einit;
+    F64 *kernel;
+
+    if (spectrum->Mode == USE_JONES_THOMSON_APPROX) {
+        return FALSE;
+    }
+
+    if ((kernel = (F64 *)malloc(sizeof(F64) * spectrum->Gamma.Count)) == NULL) {
+        return FALSE;
+    }
+
+    for (j = 0; j < spectrum->Gamma.Count; j++) {
+        row[j] = 0.0;
+    }
+
+    for (i = 0; i < spectrum->Einit.Count; i++) {
+        if ((cmb = spectrum->CmbDensity[i]) == 0.0) {
+            continue;
+        }
+        first = findFirstGamma(spectrum, efin, spectrum->Einit.Node[i]);
+        prepareEinit(spectrum, spectrum->Einit.Node[i], &einit);
+        evaluateKernel(spectrum, efin, &einit, first, kernel);
+
+        for (j = first; j < spectrum->Gamma.Count; j++) {
+            row[j] += cmb * kernel[j];
+        }
+    }
+
+    free(kernel);
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Count the kernel evaluations of one emitted energy
+//! \remark     Uses the same pruning as IcsCmbSpectrum_CalcFlux, so the
+//!             pruned fraction is 1 - evaluated / total.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  spectrum  : ICS spectrum
+//! \param[in]  efin      : Scattered Photon Energy [eV]
+//! \param[out] evaluated : Kernel evaluations after pruning
+//! \param[out] total     : Kernel evaluations of the full grid
+//! \return     None
+//******************************************************************************
+void IcsCmbSpectrum_CountEvaluations(const ICS_CMB_SPECTRUM *spectrum, const F64 efin, U64 *evaluated, U64 *total)
+{
+    U32 i;
+
+    *evaluated = 0;
+    *total = (U64)spectrum->Einit.Count * (U64)spectrum->Gamma.Count;
+
+    for (i = 0; i < spectrum->Einit.Count; i++) {
+        if (spectrum->CmbDensity[i] != 0.0) {
+            *evaluated += (U64)(spectrum->Gamma.Count - findFirstGamma(spectrum, efin, spectrum->Einit.Node[i]));
+        }
+    }
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Count the kernel evaluations of one emitted energy in the
+//!             Thomson limit
+//! \remark     Uses the same pruning as IcsCmbSpectrum_CountEvaluations, so
+//!             the rest of its evaluated count uses the full Jones kernel.
+//!             Zero unless ThomsonLimit applies (see findThomsonLimitEnd).
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  spectrum : ICS spectrum
+//! \param[in]  efin     : Scattered Photon Energy [eV]
+//! \return     Kernel evaluations after pruning that use the Thomson limit
+//******************************************************************************
+U64 IcsCmbSpectrum_CountThomsonLimit(const ICS_CMB_SPECTRUM *spectrum, const F64 efin)
+{
+    U32 i, first, end;
+    U64 count = 0;
+
+    for (i = 0; i < spectrum->Einit.Count; i++) {
+        if (spectrum->CmbDensity[i] == 0.0) {
+            continue;
+        }
+        first = findFirstGamma(spectrum, efin, spectrum->Einit.Node[i]);
+        end = findThomsonLimitEnd(spectrum, spectrum->Einit.Node[i]);
+        if (end > first) {
+            count += (U64)(end - first);
+        }
+    }
+
+    return count;
+}
+
+
+
+//******************************************************************************
+//! \breif      Release the arrays owned by an ICS spectrum
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  spectrum : ICS spectrum
+//! \return     None
+//******************************************************************************
+void IcsCmbSpectrum_Release(ICS_CMB_SPECTRUM *spectrum)
+{
+    NumericsQuadrature_Release(&spectrum->Einit);
+    NumericsQuadrature_Release(&spectrum->Gamma);
+    free(spectrum->CmbDensity);
+    free(spectrum->ElectronDensity);
+    free(spectrum->JonesGamma);
+    free(spectrum->JonesGammaF128);
+    free(spectrum->ThomsonGammaF64);
+    free(spectrum->ThomsonGamma);
+
+    spectrum->CmbDensity = NULL;
+    spectrum->ElectronDensity = NULL;
+    spectrum->JonesGamma = NULL;
+    spectrum->JonesGammaF128 = NULL;
+    spectrum->ThomsonGammaF64 = NULL;
+    spectrum->ThomsonGamma = NULL;
+
+    return;
+}
+
+
+
+
+
+//******************************************************************************
+//! \breif      Initialize the fields of an ICS spectrum
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[out] spectrum    : ICS spectrum
+//! \param[in]  mode        : USE_JONES_APPROX, USE_THOMSON_APPROX or USE_KAK_APPROX
+//! \param[in]  gamma_range : Integration Range of Lorentz factor
+//! \return     None
+//******************************************************************************
+static void initSpectrum(ICS_CMB_SPECTRUM *spectrum, const S32 mode, const INTEGRATION_RANGE *gamma_range)
+{
+    spectrum->Mode = mode;
+    spectrum->Precision = ICS_PRECISION_F64;
+    spectrum->GammaRange = *gamma_range;
+    spectrum->Norm = 0.0;
+    spectrum->Power = 0.0;
+    spectrum->GammaMax = 0.0;
+    spectrum->CmbDensity = NULL;
+    spectrum->ElectronDensity = NULL;
+    spectrum->JonesGamma = NULL;
+    spectrum->JonesGammaF128 = NULL;
+    spectrum->ThomsonGammaF64 = NULL;
+    spectrum->ThomsonGamma = NULL;
+    spectrum->JonesTable = NULL;
+    spectrum->ThomsonLimit = 0.0;
+    spectrum->Einit.Node = spectrum->Einit.Weight = NULL;
+    spectrum->Gamma.Node = spectrum->Gamma.Weight = NULL;
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Create the one-node einit rule of USE_KAK_APPROX
+//! \remark     The analytic kernel is already integrated over the Planck
+//!             spectrum, so the einit sum collapses to a single row with
+//!             unit weight. The node (kT) only keys the response matrix cache.
+//! 
+//! \callgraph  
+//! 
+//! \param[in,out] spectrum : ICS spectrum
+//! \return     TRUE on success, FALSE if the arrays cannot be allocated
+//******************************************************************************
+static BOOL createPlanckRule(ICS_CMB_SPECTRUM *spectrum)
+{
+    spectrum->Einit.Count = 1;
+    spectrum->Einit.Node = (F64 *)malloc(sizeof(F64));
+    spectrum->Einit.Weight = (F64 *)malloc(sizeof(F64));
+
+    if ((spectrum->Einit.Node == NULL) || (spectrum->Einit.Weight == NULL)) {
+        IcsCmbSpectrum_Release(spectrum);
+        return FALSE;
+    }
+
+    spectrum->Einit.Node[0] = BOLTZMANN_CONST * PatriclesCmb_GetTemperature();
+    spectrum->Einit.Weight[0] = 1.0;
+
+    spectrum->EinitRange.Lower = spectrum->EinitRange.Upper = spectrum->Einit.Node[0];
+    spectrum->EinitRange.Iteration = 1;
+
+    return createDensities(spectrum);
+}
+
+
+
+//******************************************************************************
+//! \breif      Create the gamma rule and the density vectors
+//! \remark     Called once the einit rule exists.
+//! 
+//! \callgraph  
+//! 
+//! \param[in,out] spectrum : ICS spectrum
+//! \return     TRUE on success, FALSE if the arrays cannot be allocated
+//******************************************************************************
+static BOOL createDensities(ICS_CMB_SPECTRUM *spectrum)
+{
+    U32 i;
+
+    if (NumericsQuadrature_CreateLog(&spectrum->Gamma, &spectrum->GammaRange) == FALSE) {
+        IcsCmbSpectrum_Release(spectrum);
+        return FALSE;
+    }
+
+    spectrum->CmbDensity = (F64 *)malloc(sizeof(F64) * spectrum->Einit.Count);
+    spectrum->ElectronDensity = (F64 *)calloc(spectrum->Gamma.Count, sizeof(F64));
+
+    if ((spectrum->CmbDensity == NULL) || (spectrum->ElectronDensity == NULL)) {
+        IcsCmbSpectrum_Release(spectrum);
+        return FALSE;
+    }
+
+    for (i = 0; i < spectrum->Einit.Count; i++) {
+        if (spectrum->Mode == USE_KAK_APPROX) {
+            spectrum->CmbDensity[i] = spectrum->Einit.Weight[i];
+        }
+        else {
+            spectrum->CmbDensity[i] = spectrum->Einit.Weight[i] * PatriclesCmb_CalcFlux(spectrum->Einit.Node[i]);
+        }
+    }
+
+    return prepareGamma(spectrum);
+}
+
+
+
+//******************************************************************************
+//! \breif      Prepare the kernel factors of every gamma node
+//! \remark     Both precisions of the mode are prepared, since Precision is
+//!             chosen after creation. USE_KAK_APPROX has no prepared form.
+//!             USE_JONES_THOMSON_APPROX prepares both kernels.
+//! 
+//! \callgraph  
+//! 
+//! \param[in,out] spectrum : ICS spectrum
+//! \return     TRUE on success, FALSE if the arrays cannot be allocated
+//******************************************************************************
+static BOOL prepareGamma(ICS_CMB_SPECTRUM *spectrum)
+{
+    U32 j;
+    const U32 n = spectrum->Gamma.Count;
+
+    if ((spectrum->Mode == USE_JONES_APPROX) || (spectrum->Mode == USE_JONES_THOMSON_APPROX)) {
+        spectrum->JonesGamma = (ICS_JONES_GAMMA *)malloc(sizeof(ICS_JONES_GAMMA) * n);
+        spectrum->JonesGammaF128 = (ICS_JONES_GAMMA_F128 *)malloc(sizeof(ICS_JONES_GAMMA_F128) * n);
+
+        if ((spectrum->JonesGamma == NULL) || (spectrum->JonesGammaF128 == NULL)) {
+            IcsCmbSpectrum_Release(spectrum);
+            return FALSE;
+        }
+
+        for (j = 0; j < n; j++) {
+            IcsJones_PrepareGamma(&spectrum->JonesGamma[j], spectrum->Gamma.Node[j]);
+            IcsJones_PrepareGammaF128(&spectrum->JonesGammaF128[j], (F128)spectrum->Gamma.Node[j]);
+        }
+    }
+    if ((spectrum->Mode == USE_THOMSON_APPROX) || (spectrum->Mode == USE_JONES_THOMSON_APPROX)) {
+        spectrum->ThomsonGammaF64 = (ICS_THOMSON_GAMMA_F64 *)malloc(sizeof(ICS_THOMSON_GAMMA_F64) * n);
+        spectrum->ThomsonGamma = (ICS_THOMSON_GAMMA *)malloc(sizeof(ICS_THOMSON_GAMMA) * n);
+
+        if ((spectrum->ThomsonGammaF64 == NULL) || (spectrum->ThomsonGamma == NULL)) {
+            IcsCmbSpectrum_Release(spectrum);
+            return FALSE;
+        }
+
+        for (j = 0; j < n; j++) {
+            IcsThomson_PrepareGammaF64(&spectrum->ThomsonGammaF64[j], spectrum->Gamma.Node[j]);
+            IcsThomson_PrepareGamma(&spectrum->ThomsonGamma[j], (F128)spectrum->Gamma.Node[j]);
+        }
+    }
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Prepare the kernel factors of one einit row
+//! \remark     Only the factors of the mode and precision are set.
+//!             USE_JONES_THOMSON_APPROX sets those of both kernels.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  spectrum : ICS spectrum
+//! \param[in]  einit    : Incident Photon Energy [eV]
+//! \param[out] prepared : Einit factors
+//! \return     None
+//******************************************************************************
+static void prepareEinit(const ICS_CMB_SPECTRUM *spectrum, const F64 einit, ICS_KERNEL_EINIT *prepared)
+{
+    prepared->Einit = einit;
+    prepared->ThomsonEnd = findThomsonLimitEnd(spectrum, einit);
+
+    if ((spectrum->Mode == USE_JONES_APPROX) || (spectrum->Mode == USE_JONES_THOMSON_APPROX)) {
+        if (spectrum->Precision == ICS_PRECISION_F128) {
+            IcsJones_PrepareEinitF128(&prepared->JonesF128, (F128)einit);
+        }
+        else {
+            IcsJones_PrepareEinit(&prepared->Jones, einit);
+        }
+    }
+    if ((spectrum->Mode == USE_THOMSON_APPROX) || (spectrum->Mode == USE_JONES_THOMSON_APPROX)) {
+        if (spectrum->Precision == ICS_PRECISION_F128) {
+            IcsThomson_PrepareEinit(&prepared->Thomson, (F128)einit);
+        }
+        else {
+            IcsThomson_PrepareEinitF64(&prepared->ThomsonF64, einit);
+        }
+    }
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Lorentz factor below which the ICS kernel vanishes
+//! \remark     Both kernels are nonzero above the threshold:
+//!             Jones   efin < einit  : gamma > sqrt(einit / efin) / 2
+//!                     efin >= einit : gamma > (a efin + sqrt(a^2 efin^2 + einit efin)) / (2 einit),
+//!                                     a = einit / mc^2
+//!             Thomson               : gamma > (sqrt(r) + 1 / sqrt(r)) / 2,
+//!                                     r = max(efin / einit, einit / efin)
+//!             KAK                   : gamma > max(1, efin / mc^2)
+//!             Jones and Thomson     : the lower of the two
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  mode  : USE_JONES_APPROX, USE_THOMSON_APPROX, USE_KAK_APPROX or
+//!                     USE_JONES_THOMSON_APPROX
+//! \param[in]  efin  : Scattered Photon Energy [eV]
+//! \param[in]  einit : Incident Photon Energy [eV]
+//! \return     Threshold Lorentz factor
+//******************************************************************************
+static F64 calcGammaThreshold(const S32 mode, const F64 efin, const F64 einit)
+{
+    F64 alpha, ratio;
+
+    if (mode == USE_KAK_APPROX) {
+        return fmax(1.0, efin / ELECTRON_REST_ENERGY);
+    }
+
+    if (mode == USE_JONES_THOMSON_APPROX) {
+        return fmin(calcGammaThreshold(USE_JONES_APPROX, efin, einit), calcGammaThreshold(USE_THOMSON_APPROX, efin, einit));
+    }
+
+    if (mode == USE_JONES_APPROX) {
+        if (efin < einit) {
+            return 0.5 * sqrt(einit / efin);
+        }
+        alpha = einit / ELECTRON_REST_ENERGY;
+        return (alpha * efin + sqrt(alpha * alpha * efin * efin + einit * efin)) / (2.0 * einit);
+    }
+
+    ratio = (efin < einit) ? (einit / efin) : (efin / einit);
+    return 0.5 * (sqrt(ratio) + 1.0 / sqrt(ratio));
+}
+
+
+
+//******************************************************************************
+//! \breif      Find the first gamma node where the ICS kernel can be nonzero
+//! \remark     1) One node below calcGammaThreshold is kept so that rounding
+//!                at the edge never drops a nonzero value.
+//!             2) The nodes below findThomsonLimitEnd use the Thomson limit,
+//!                which reaches down to gamma = sqrt(r) / 2,
+//!                r = max(efin / einit, einit / efin), below the threshold of
+//!                the full kernel.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  spectrum : ICS spectrum
+//! \param[in]  efin     : Scattered Photon Energy [eV]
+//! \param[in]  einit    : Incident Photon Energy [eV]
+//! \return     Index of the first gamma node to evaluate
+//******************************************************************************
+static U32 findFirstGamma(const ICS_CMB_SPECTRUM *spectrum, const F64 efin, const F64 einit)
+{
+    const U32 end = findThomsonLimitEnd(spectrum, einit);
+    U32 node, limit;
+
+    node = findGammaNode(spectrum, calcGammaThreshold(spectrum->Mode, efin, einit));
+    if (end > 0) {
+        limit = findGammaNode(spectrum, 0.5 * sqrt((efin < einit) ? (einit / efin) : (efin / einit)));
+        if ((limit < end) && (limit < node)) {
+            node = limit;
+        }
+    }
+
+    return (node > 0) ? (node - 1) : 0;
+}
+
+
+
+//******************************************************************************
+//! \breif      Find the end of the gamma nodes where the Jones kernel is
+//!             evaluated in the Thomson limit
+//! \remark     1) The nodes with G = 4 einit gamma / mc^2 < ThomsonLimit,
+//!                where the Thomson limit deviates from the full kernel by
+//!                less than ThomsonLimit times its peak over efin. This
+//!                bounds each node, not the spectrum: near the cut-off the
+//!                flux deviates by up to about ThomsonLimit (relative).
+//!             2) G grows with gamma, so the nodes form one block from the
+//!                first node and each row switches kernel once.
+//!             3) Applies to Jones in double precision (ICS_PRECISION_F64
+//!                and ICS_PRECISION_TABLE). F32 and F128 runs keep the full
+//!                kernel.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  spectrum : ICS spectrum
+//! \param[in]  einit    : Incident Photon Energy [eV]
+//! \return     Index of the first gamma node of the full kernel
+//******************************************************************************
+static U32 findThomsonLimitEnd(const ICS_CMB_SPECTRUM *spectrum, const F64 einit)
+{
+    if (((spectrum->Mode != USE_JONES_APPROX) && (spectrum->Mode != USE_JONES_THOMSON_APPROX)) || !(spectrum->ThomsonLimit > 0.0) ||
+        ((spectrum->Precision != ICS_PRECISION_F64) && (spectrum->Precision != ICS_PRECISION_TABLE))) {
+        return 0;
+    }
+
+    return findGammaNode(spectrum, spectrum->ThomsonLimit * ELECTRON_REST_ENERGY / (4.0 * einit));
+}
+
+
+
+//******************************************************************************
+//! \breif      Find the first gamma node not below a value
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  spectrum : ICS spectrum
+//! \param[in]  value    : Lorentz factor to search for
+//! \return     Index of the first node >= value (Gamma.Count if none)
+//******************************************************************************
+static U32 findGammaNode(const ICS_CMB_SPECTRUM *spectrum, const F64 value)
+{
+    const F64 *gamma = spectrum->Gamma.Node;
+    U32 lower, upper, middle;
+
+    //------------------------------------------------------
+    // Nodes are ascending
+    //------------------------------------------------------
+    lower = 0;
+    upper = spectrum->Gamma.Count;
+    while (lower < upper) {
+        middle = lower + (upper - lower) / 2;
+        if (gamma[middle] < value) {
+            lower = middle + 1;
+        }
+        else {
+            upper = middle;
+        }
+    }
+
+    return lower;
+}
+
+
+
+//******************************************************************************
+//! \breif      Range of emitted energies where the ICS kernel can be nonzero
+//! \remark     Jones   : einit / (4 gamma^2) < efin < 4 einit gamma^2 / (1 + 4 a gamma)
+//!                       (efin < 4 einit gamma^2 below einit->ThomsonEnd)
+//!             Thomson : einit / ((1 + beta)^2 gamma^2) <= efin <= einit (1 + beta)^2 gamma^2
+//!             KAK     : efin < gamma mc^2
+//!             The range is widened by SWEEP_SUPPORT_MARGIN so that rounding
+//!             at the edges never drops a nonzero value. The gamma factors
+//!             come from the prepared kernel of the node.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  spectrum : ICS spectrum
+//! \param[in]  einit    : Einit factors (prepareEinit)
+//! \param[in]  j        : Gamma node
+//! \param[out] lower    : Lower end of the support [eV]
+//! \param[out] upper    : Upper end of the support [eV]
+//! \return     None
+//******************************************************************************
+static void calcEfinSupport(const ICS_CMB_SPECTRUM *spectrum, const ICS_KERNEL_EINIT *einit, const U32 j, F64 *lower, F64 *upper)
+{
+    const ICS_JONES_GAMMA *jones;
+
+    if (spectrum->Mode == USE_KAK_APPROX) {
+        *lower = 0.0;
+        *upper = spectrum->Gamma.Node[j] * ELECTRON_REST_ENERGY;
+    }
+    else if (spectrum->Mode == USE_JONES_APPROX) {
+        jones = &spectrum->JonesGamma[j];
+        *lower = 0.25 * einit->Einit * jones->InvGamma2;
+        *upper = 4.0 * einit->Einit * jones->Gamma2;
+        if (j >= einit->ThomsonEnd) {
+            *upper /= 1.0 + (4.0 * einit->Einit / ELECTRON_REST_ENERGY) * jones->Gamma;
+        }
+    }
+    else {
+        *lower = einit->Einit / spectrum->ThomsonGammaF64[j].Boost;
+        *upper = einit->Einit * spectrum->ThomsonGammaF64[j].Boost;
+    }
+
+    *lower *= 1.0 - SWEEP_SUPPORT_MARGIN;
+    *upper *= 1.0 + SWEEP_SUPPORT_MARGIN;
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Find the first emitted energy not below a value
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  efin  : Scattered Photon Energies [eV] (ascending)
+//! \param[in]  count : Number of emitted energies
+//! \param[in]  value : Energy to search for [eV]
+//! \return     Index of the first efin >= value (count if none)
+//******************************************************************************
+static U32 findFirstEfin(const F64 *efin, const U32 count, const F64 value)
+{
+    U32 lower, upper, middle;
+
+    lower = 0;
+    upper = count;
+    while (lower < upper) {
+        middle = lower + (upper - lower) / 2;
+        if (efin[middle] < value) {
+            lower = middle + 1;
+        }
+        else {
+            upper = middle;
+        }
+    }
+
+    return lower;
+}
+
+
+
+//******************************************************************************
+//! \breif      Contract a list of kernels with the CMB and electron densities
+//!             at an emitted energy
+//! \remark     The einit rows, the pruning and the prepared factors are
+//!             shared by the kernels. Rows without CMB photons and the gamma
+//!             nodes below the kinematic threshold (calcGammaThreshold) are
+//!             skipped. ICS_PRECISION_F128 accumulates in quad precision.
+//!             Only reads the spectrum, so several threads may call it at
+//!             once.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  spectrum   : ICS spectrum
+//! \param[in]  efin       : Scattered Photon Energy [eV]
+//! \param[in]  evaluators : Kernels [count]
+//! \param[in]  count      : Number of kernels (at most KERNEL_LIST_MAX)
+//! \param[out] flux       : ICS flux of each kernel [count]
+//! \return     TRUE on success, FALSE if the work array cannot be allocated
+//******************************************************************************
+static BOOL contractKernels(const ICS_CMB_SPECTRUM *spectrum, const F64 efin, const ICS_KERNEL_EVALUATOR *evaluators, const U32 count, F64 *flux)
+{
+    register U32 i, j, k, first;
+    register F64 sum;
+    F128 sum_q, flux_q[KERNEL_LIST_MAX];
+    const F64 *electron = spectrum->ElectronDensity;
+    const U32 n = spectrum->Gamma.Count;
+    ICS_KERNEL_EINIT einit;
+    F64 *kernel, *row;
+
+    if ((kernel = (F64 *)malloc(sizeof(F64) * count * n)) == NULL) {
+        return FALSE;
+    }
+
+    for (k = 0; k < count; k++) {
+        flux[k] = 0.0;
+        flux_q[k] = 0.0Q;
+    }
+
+    for (i = 0; i < spectrum->Einit.Count; i++) {
+        if (spectrum->CmbDensity[i] == 0.0) {
+            continue;
+        }
+        first = findFirstGamma(spectrum, efin, spectrum->Einit.Node[i]);
+        prepareEinit(spectrum, spectrum->Einit.Node[i], &einit);
+
+        for (k = 0; k < count; k++) {
+            row = &kernel[(size_t)k * n];
+            evaluators[k](spectrum, efin, &einit, first, row);
+
+            if (spectrum->Precision == ICS_PRECISION_F128) {
+                for (sum_q = 0.0Q, j = first; j < n; j++) {
+                    sum_q += (F128)electron[j] * (F128)row[j];
+                }
+                flux_q[k] += (F128)spectrum->CmbDensity[i] * sum_q;
+            }
+            else {
+                for (sum = 0.0, j = first; j < n; j++) {
+                    sum += electron[j] * row[j];
+                }
+                flux[k] += spectrum->CmbDensity[i] * sum;
+            }
+        }
+    }
+
+    if (spectrum->Precision == ICS_PRECISION_F128) {
+        for (k = 0; k < count; k++) {
+            flux[k] = (F64)flux_q[k];
+        }
+    }
+
+    free(kernel);
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Evaluate the ICS kernel on the gamma nodes of one einit row
+//! \remark     The mode and precision are resolved once per row, and the
+//!             einit and gamma factors come prepared, so each node only forms
+//!             the terms that depend on efin. Only the nodes from first on
+//!             are written. USE_KAK_APPROX ignores einit and is evaluated in
+//!             double precision only. USE_JONES_THOMSON_APPROX is rejected
+//!             by the public entry points before it gets here
+//!             (IcsCmbSpectrum_CalcFluxPair calls both kernels).
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  spectrum : ICS spectrum
+//! \param[in]  efin     : Scattered Photon Energy [eV]
+//! \param[in]  einit    : Einit factors (prepareEinit)
+//! \param[in]  first    : First gamma node to evaluate
+//! \param[out] kernel   : Kernel for each gamma node [Gamma.Count]
+//! \return     None
+//******************************************************************************
+static void evaluateKernel(const ICS_CMB_SPECTRUM *spectrum, const F64 efin, const ICS_KERNEL_EINIT *einit, const U32 first, F64 *kernel)
+{
+    register U32 j;
+    const F64 *gamma = spectrum->Gamma.Node;
+    const U32 n = spectrum->Gamma.Count;
+    F64 temperature;
+
+    if (spectrum->Mode == USE_KAK_APPROX) {
+        temperature = PatriclesCmb_GetTemperature();
+        for (j = first; j < n; j++) {
+            kernel[j] = IcsKak_CalcFluxPlanck(efin, gamma[j], temperature);
+        }
+    }
+    else if (spectrum->Mode == USE_JONES_APPROX) {
+        evaluateJonesKernel(spectrum, efin, einit, first, kernel);
+    }
+    else {
+        evaluateThomsonKernel(spectrum, efin, einit, first, kernel);
+    }
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Evaluate the Jones kernel on the gamma nodes of one einit row
+//! \remark     Jones in double precision stays on the vector evaluators where
+//!             the CPU has them. Nodes below einit->ThomsonEnd use the
+//!             Thomson limit.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  spectrum : ICS spectrum
+//! \param[in]  efin     : Scattered Photon Energy [eV]
+//! \param[in]  einit    : Einit factors (prepareEinit)
+//! \param[in]  first    : First gamma node to evaluate
+//! \param[out] kernel   : Kernel for each gamma node [Gamma.Count]
+//! \return     None
+//******************************************************************************
+static void evaluateJonesKernel(const ICS_CMB_SPECTRUM *spectrum, const F64 efin, const ICS_KERNEL_EINIT *einit, const U32 first, F64 *kernel)
+{
+    register U32 j;
+    const F64 *gamma = spectrum->Gamma.Node;
+    const U32 n = spectrum->Gamma.Count;
+    const U32 split = (einit->ThomsonEnd > first) ? einit->ThomsonEnd : first;
+
+    switch (spectrum->Precision) {
+    case ICS_PRECISION_F32:
+        for (j = first; j < n; j++) {
+            kernel[j] = (F64)IcsJones_CalcFluxIsoF32((F32)efin, (F32)einit->Einit, (F32)gamma[j]);
+        }
+        break;
+    case ICS_PRECISION_F128:
+        for (j = first; j < n; j++) {
+            kernel[j] = (F64)IcsJones_CalcFluxPreparedF128((F128)efin, &einit->JonesF128, &spectrum->JonesGammaF128[j]);
+        }
+        break;
+    case ICS_PRECISION_TABLE:
+        for (j = first; j < split; j++) {
+            kernel[j] = IcsJonesTable_CalcFluxThomsonLimit(spectrum->JonesTable, efin, &einit->Jones, &spectrum->JonesGamma[j]);
+        }
+        for (j = split; j < n; j++) {
+            kernel[j] = IcsJonesTable_CalcFlux(spectrum->JonesTable, efin, &einit->Jones, &spectrum->JonesGamma[j]);
+        }
+        break;
+    default:
+        if (IcsJonesBatch_GetIsa() != ICS_JONES_BATCH_ISA_SCALAR) {
+            if (split > first) {
+                IcsJonesBatch_CalcFluxThomsonLimitGamma(efin, einit->Einit, &gamma[first], split - first, &kernel[first]);
+            }
+            if (split < n) {
+                IcsJonesBatch_CalcFluxIsoGamma(efin, einit->Einit, &gamma[split], n - split, &kernel[split]);
+            }
+            break;
+        }
+        for (j = first; j < split; j++) {
+            kernel[j] = IcsJones_CalcFluxThomsonLimit(efin, &einit->Jones, &spectrum->JonesGamma[j]);
+        }
+        for (j = split; j < n; j++) {
+            kernel[j] = IcsJones_CalcFluxPrepared(efin, &einit->Jones, &spectrum->JonesGamma[j]);
+        }
+        break;
+    }
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Evaluate the Thomson kernel on the gamma nodes of one einit row
+//! \remark     ICS_PRECISION_TABLE only changes Jones; Thomson runs in double
+//!             precision.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  spectrum : ICS spectrum
+//! \param[in]  efin     : Scattered Photon Energy [eV]
+//! \param[in]  einit    : Einit factors (prepareEinit)
+//! \param[in]  first    : First gamma node to evaluate
+//! \param[out] kernel   : Kernel for each gamma node [Gamma.Count]
+//! \return     None
+//******************************************************************************
+static void evaluateThomsonKernel(const ICS_CMB_SPECTRUM *spectrum, const F64 efin, const ICS_KERNEL_EINIT *einit, const U32 first, F64 *kernel)
+{
+    register U32 j;
+    const F64 *gamma = spectrum->Gamma.Node;
+    const U32 n = spectrum->Gamma.Count;
+
+    switch (spectrum->Precision) {
+    case ICS_PRECISION_F32:
+        for (j = first; j < n; j++) {
+            kernel[j] = (F64)IcsThomson_CalcFluxIsoF32((F32)efin, (F32)einit->Einit, (F32)gamma[j]);
+        }
+        break;
+    case ICS_PRECISION_F128:
+        for (j = first; j < n; j++) {
+            kernel[j] = (F64)IcsThomson_CalcFluxPrepared((F128)efin, &einit->Thomson, &spectrum->ThomsonGamma[j]);
+        }
+        break;
+    default:
+        for (j = first; j < n; j++) {
+            kernel[j] = IcsThomson_CalcFluxPreparedF64(efin, &einit->ThomsonF64, &spectrum->ThomsonGammaF64[j]);
+        }
+        break;
+    }
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Evaluate the ICS kernel at one grid node
+//! \remark     Prepared counterpart of evaluateKernelAt for the single sweep.
+//!             Not for USE_JONES_THOMSON_APPROX (see evaluateKernel).
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  spectrum : ICS spectrum
+//! \param[in]  efin     : Scattered Photon Energy [eV]
+//! \param[in]  einit    : Einit factors (prepareEinit)
+//! \param[in]  j        : Gamma node
+//! \return     ICS kernel
+//******************************************************************************
+static F64 evaluateKernelNode(const ICS_CMB_SPECTRUM *spectrum, const F64 efin, const ICS_KERNEL_EINIT *einit, const U32 j)
+{
+    if (spectrum->Precision == ICS_PRECISION_F32) {
+        return evaluateKernelAt(spectrum, efin, einit->Einit, spectrum->Gamma.Node[j]);
+    }
+
+    if (spectrum->Mode == USE_KAK_APPROX) {
+        return IcsKak_CalcFluxPlanck(efin, spectrum->Gamma.Node[j], PatriclesCmb_GetTemperature());
+    }
+    else if (spectrum->Mode == USE_JONES_APPROX) {
+        if (spectrum->Precision == ICS_PRECISION_F128) {
+            return (F64)IcsJones_CalcFluxPreparedF128((F128)efin, &einit->JonesF128, &spectrum->JonesGammaF128[j]);
+        }
+        if (spectrum->Precision == ICS_PRECISION_TABLE) {
+            if (j < einit->ThomsonEnd) {
+                return IcsJonesTable_CalcFluxThomsonLimit(spectrum->JonesTable, efin, &einit->Jones, &spectrum->JonesGamma[j]);
+            }
+            return IcsJonesTable_CalcFlux(spectrum->JonesTable, efin, &einit->Jones, &spectrum->JonesGamma[j]);
+        }
+        if (j < einit->ThomsonEnd) {
+            return IcsJones_CalcFluxThomsonLimit(efin, &einit->Jones, &spectrum->JonesGamma[j]);
+        }
+        return IcsJones_CalcFluxPrepared(efin, &einit->Jones, &spectrum->JonesGamma[j]);
+    }
+    else {
+        if (spectrum->Precision == ICS_PRECISION_F128) {
+            return (F64)IcsThomson_CalcFluxPrepared((F128)efin, &einit->Thomson, &spectrum->ThomsonGamma[j]);
+        }
+        return IcsThomson_CalcFluxPreparedF64(efin, &einit->ThomsonF64, &spectrum->ThomsonGammaF64[j]);
+    }
+}
+
+
+
+//******************************************************************************
+//! \breif      Evaluate the ICS kernel at one point
+//! \remark     Not for USE_JONES_THOMSON_APPROX (see evaluateKernel).
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  spectrum : ICS spectrum
+//! \param[in]  efin     : Scattered Photon Energy [eV]
+//! \param[in]  einit    : Incident Photon Energy [eV]
+//! \param[in]  gamma    : Electron Lorentz Factor
+//! \return     ICS kernel
+//******************************************************************************
+static F64 evaluateKernelAt(const ICS_CMB_SPECTRUM *spectrum, const F64 efin, const F64 einit, const F64 gamma)
+{
+    ICS_JONES_EINIT jones_einit;
+    ICS_JONES_GAMMA jones_gamma;
+
+    if (spectrum->Mode == USE_KAK_APPROX) {
+        return IcsKak_CalcFluxPlanck(efin, gamma, PatriclesCmb_GetTemperature());
+    }
+    else if (spectrum->Mode == USE_JONES_APPROX) {
+        switch (spectrum->Precision) {
+        case ICS_PRECISION_F32:
+            return (F64)IcsJones_CalcFluxIsoF32((F32)efin, (F32)einit, (F32)gamma);
+        case ICS_PRECISION_F128:
+            return (F64)IcsJones_CalcFluxIsoF128((F128)efin, (F128)einit, (F128)gamma);
+        case ICS_PRECISION_TABLE:
+            IcsJones_PrepareEinit(&jones_einit, einit);
+            IcsJones_PrepareGamma(&jones_gamma, gamma);
+            return IcsJonesTable_CalcFlux(spectrum->JonesTable, efin, &jones_einit, &jones_gamma);
+        default:
+            return IcsJones_CalcFluxIso(efin, einit, gamma);
+        }
+    }
+    else {
+        switch (spectrum->Precision) {
+        case ICS_PRECISION_F32:
+            return (F64)IcsThomson_CalcFluxIsoF32((F32)efin, (F32)einit, (F32)gamma);
+        case ICS_PRECISION_F128:
+            return (F64)IcsThomson_CalcFluxIso((F128)efin, (F128)einit, (F128)gamma);
+        default:
+            return IcsThomson_CalcFluxIsoF64(efin, einit, gamma);
+        }
+    }
+}
+
+
+
+//******************************************************************************
+//! \breif      Integrand of the adaptive gamma integral
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  gamma   : Electron Lorentz Factor
+//! \param[in]  context : ICS_ADAPTIVE_CONTEXT
+//! \return     kernel * electron flux
+//******************************************************************************
+static F64 adaptiveGammaIntegrand(const F64 gamma, void *context)
+{
+    ICS_ADAPTIVE_CONTEXT *adaptive = (ICS_ADAPTIVE_CONTEXT *)context;
+    const ICS_CMB_SPECTRUM *spectrum = adaptive->Spectrum;
+
+    adaptive->Evaluations++;
+
+    return evaluateKernelAt(spectrum, adaptive->Efin, adaptive->Einit, gamma)
+         * ParticlesElectron_CalcFlux(gamma, spectrum->Norm, spectrum->Power, spectrum->GammaMax);
+}
+
+
+
+//******************************************************************************
+//! \breif      Integrand of the adaptive einit integral
+//! \remark     The gamma integral runs from the kinematic threshold.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  einit   : Incident Photon Energy [eV]
+//! \param[in]  context : ICS_ADAPTIVE_CONTEXT
+//! \return     CMB flux * gamma integral
+//******************************************************************************
+static F64 adaptiveEinitIntegrand(const F64 einit, void *context)
+{
+    ICS_ADAPTIVE_CONTEXT *adaptive = (ICS_ADAPTIVE_CONTEXT *)context;
+    const ICS_CMB_SPECTRUM *spectrum = adaptive->Spectrum;
+    GAUSS_KRONROD_RESULT inner;
+    INTEGRATION_RANGE range;
+    F64 cmb;
+
+    if ((cmb = PatriclesCmb_CalcFlux(einit)) == 0.0) {
+        return 0.0;
+    }
+
+    range = spectrum->GammaRange;
+    range.Lower = fmax(range.Lower, calcGammaThreshold(spectrum->Mode, adaptive->Efin, einit));
+    if (range.Lower >= range.Upper) {
+        return 0.0;
+    }
+
+    adaptive->Einit = einit;
+    if (NumericsGaussKronrod_IntegrateLog(adaptiveGammaIntegrand, adaptive, &range, &adaptive->Tolerance, &inner) == FALSE) {
+        adaptive->Converged = FALSE;
+    }
+    if (inner.Value != 0.0) {
+        adaptive->MaxRelError = fmax(adaptive->MaxRelError, inner.Error / fabs(inner.Value));
+    }
+
+    return cmb * inner.Value;
+}
+
+
+
+
+//******************************************************************************
+// End of File
+//******************************************************************************
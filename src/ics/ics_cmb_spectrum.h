@@ -0,0 +1,211 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#ifndef ICS_CMB_SPECTRUM_H_
+#define ICS_CMB_SPECTRUM_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include "common_typedef.h"
+#include "ics_jones_approx.h"
+#include "ics_jones_table.h"
+#include "ics_thomson_approx.h"
+#include "numerics_integration.h"
+#include "numerics_gauss_kronrod.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+#define USE_JONES_APPROX                    (1)
+#define USE_THOMSON_APPROX                  (2)
+#define USE_KAK_APPROX                      (3)     //!< Kernel integrated over the CMB analytically (Khangulyan et al.)
+#define USE_JONES_THOMSON_APPROX            (4)     //!< Jones and Thomson in one pass (IcsCmbSpectrum_CalcFluxPair)
+
+#define ICS_PRECISION_F32                   (32)    //!< Kernel in single precision
+#define ICS_PRECISION_F64                   (64)    //!< Kernel in double precision (default)
+#define ICS_PRECISION_F128                  (128)   //!< Kernel and accumulation in quad precision
+#define ICS_PRECISION_TABLE                 (1)     //!< Jones kernel from the Chebyshev table (IcsJonesTable), double precision otherwise
+
+
+
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! ICS spectrum on CMB with cached separable factors
+//----------------------------------------------------------
+typedef struct ics_cmb_spectrum_t {
+    S32             Mode;               //!< USE_JONES_APPROX, USE_THOMSON_APPROX, USE_KAK_APPROX or USE_JONES_THOMSON_APPROX
+    S32             Precision;          //!< ICS_PRECISION_xxx (ICS_PRECISION_F64 after creation)
+    INTEGRATION_RANGE EinitRange;       //!< Integration Range of incident photon energy [eV]
+    INTEGRATION_RANGE GammaRange;       //!< Integration Range of Lorentz factor
+    QUADRATURE_RULE Einit;              //!< Incident photon energy nodes [eV]
+    QUADRATURE_RULE Gamma;              //!< Lorentz factor nodes
+    F64             *CmbDensity;        //!< CMB flux multiplied by the einit weight
+    F64             *ElectronDensity;   //!< Electron flux multiplied by the gamma weight
+    ICS_JONES_GAMMA *JonesGamma;        //!< Prepared Jones kernel for each gamma node (USE_JONES_APPROX, USE_JONES_THOMSON_APPROX)
+    ICS_JONES_GAMMA_F128 *JonesGammaF128; //!< Same in quad precision (USE_JONES_APPROX, USE_JONES_THOMSON_APPROX)
+    ICS_THOMSON_GAMMA_F64 *ThomsonGammaF64; //!< Prepared Thomson kernel for each gamma node (USE_THOMSON_APPROX, USE_JONES_THOMSON_APPROX)
+    ICS_THOMSON_GAMMA *ThomsonGamma;    //!< Same in quad precision (USE_THOMSON_APPROX, USE_JONES_THOMSON_APPROX)
+    const ICS_JONES_TABLE *JonesTable;  //!< Jones kernel table of ICS_PRECISION_TABLE (not owned)
+    F64             ThomsonLimit;       //!< Jones : 4 einit gamma / mc^2 below which the Thomson limit is used (0 : never)
+    F64             Norm;               //!< Electron spectrum : Normalization Factor
+    F64             Power;              //!< Electron spectrum : Power
+    F64             GammaMax;           //!< Electron spectrum : Maximum Lorentz Factor (Cut-off)
+}ICS_CMB_SPECTRUM;
+
+
+
+//==============================================================================
+// Export Scope Function Prototype
+//==============================================================================
+/**
+ * @brief               Create the integration grids and the CMB density vector
+ * 
+ * @param spectrum      ICS spectrum to be created
+ * @param mode          USE_JONES_APPROX, USE_THOMSON_APPROX or USE_KAK_APPROX
+ * @param einit_range   Integration Range of incident photon energy [eV]
+ * @param gamma_range   Integration Range of Lorentz factor
+ * @return BOOL         TRUE on success, FALSE if the arrays cannot be allocated
+ */
+extern BOOL IcsCmbSpectrum_Create(ICS_CMB_SPECTRUM *spectrum, const S32 mode, const INTEGRATION_RANGE *einit_range, const INTEGRATION_RANGE *gamma_range);
+
+/**
+ * @brief               Create the integration grids with the blackbody rule on einit
+ * 
+ * @param spectrum      ICS spectrum to be created
+ * @param mode          USE_JONES_APPROX, USE_THOMSON_APPROX or USE_KAK_APPROX
+ * @param count         Number of einit nodes (Gauss-Laguerre in energy / kT)
+ * @param gamma_range   Integration Range of Lorentz factor
+ * @return BOOL         TRUE on success, FALSE otherwise
+ */
+extern BOOL IcsCmbSpectrum_CreateBlackbody(ICS_CMB_SPECTRUM *spectrum, const S32 mode, const U32 count, const INTEGRATION_RANGE *gamma_range);
+
+/**
+ * @brief               Evaluate the electron density vector on the gamma nodes
+ * 
+ * @param spectrum      ICS spectrum
+ * @param norm          Normalization Factor
+ * @param power         Power
+ * @param gamma_max     Maximum Lorentz Factor (Cut-off)
+ */
+extern void IcsCmbSpectrum_SetElectron(ICS_CMB_SPECTRUM *spectrum, const F64 norm, const F64 power, const F64 gamma_max);
+
+/**
+ * @brief               Calculates the ICS flux at an emitted energy
+ * 
+ * @param spectrum      ICS spectrum (not USE_JONES_THOMSON_APPROX)
+ * @param efin          Scattered Photon Energy [eV]
+ * @return F64          ICS flux (NaN for USE_JONES_THOMSON_APPROX or if the work array cannot be allocated)
+ */
+extern F64 IcsCmbSpectrum_CalcFlux(const ICS_CMB_SPECTRUM *spectrum, const F64 efin);
+
+/**
+ * @brief               Calculates the Jones and Thomson ICS flux at an emitted energy in one pass
+ * 
+ * @param spectrum      ICS spectrum (USE_JONES_THOMSON_APPROX)
+ * @param efin          Scattered Photon Energy [eV]
+ * @param jones         ICS flux of the Jones approximation (NaN for another mode or if the work array cannot be allocated)
+ * @param thomson       ICS flux of the Thomson approximation (same)
+ */
+extern void IcsCmbSpectrum_CalcFluxPair(const ICS_CMB_SPECTRUM *spectrum, const F64 efin, F64 *jones, F64 *thomson);
+
+/**
+ * @brief               Calculates the ICS flux at an emitted energy with the adaptive Gauss-Kronrod rule
+ * 
+ * @param spectrum      ICS spectrum
+ * @param efin          Scattered Photon Energy [eV]
+ * @param tolerance     Tolerance
+ * @param result        ICS flux, error estimate and kernel evaluations (NaN flux for USE_JONES_THOMSON_APPROX)
+ * @return BOOL         TRUE if the tolerance is met, otherwise FALSE
+ */
+extern BOOL IcsCmbSpectrum_CalcFluxAdaptive(const ICS_CMB_SPECTRUM *spectrum, const F64 efin, const GAUSS_KRONROD_TOLERANCE *tolerance, GAUSS_KRONROD_RESULT *result);
+
+/**
+ * @brief               Calculates the ICS flux at all emitted energies in one sweep
+ *                      of the (einit, gamma) grid
+ * 
+ * @param spectrum      ICS spectrum
+ * @param efin          Scattered Photon Energies [eV] (ascending)
+ * @param count         Number of emitted energies
+ * @param flux          ICS flux [count]
+ * @param evaluations   Kernel evaluations (NULL if not needed)
+ * @return BOOL         TRUE on success, FALSE for USE_JONES_THOMSON_APPROX or if the work array cannot be allocated
+ */
+extern BOOL IcsCmbSpectrum_CalcFluxSweep(const ICS_CMB_SPECTRUM *spectrum, const F64 *efin, const U32 count, F64 *flux, U64 *evaluations);
+
+/**
+ * @brief               Calculates the CMB-integrated ICS kernel on the gamma nodes
+ * 
+ * @param spectrum      ICS spectrum
+ * @param efin          Scattered Photon Energy [eV]
+ * @param row           Kernel integrated over einit for each gamma node [Gamma.Count]
+ * @return BOOL         TRUE on success, FALSE for USE_JONES_THOMSON_APPROX or if the work array cannot be allocated
+ */
+extern BOOL IcsCmbSpectrum_CalcKernelRow(const ICS_CMB_SPECTRUM *spectrum, const F64 efin, F64 *row);
+
+/**
+ * @brief               Count the kernel evaluations of one emitted energy
+ * 
+ * @param spectrum      ICS spectrum
+ * @param efin          Scattered Photon Energy [eV]
+ * @param evaluated     Kernel evaluations after pruning
+ * @param total         Kernel evaluations of the full grid
+ */
+extern void IcsCmbSpectrum_CountEvaluations(const ICS_CMB_SPECTRUM *spectrum, const F64 efin, U64 *evaluated, U64 *total);
+
+/**
+ * @brief               Count the kernel evaluations of one emitted energy in the Thomson limit
+ * 
+ * @param spectrum      ICS spectrum
+ * @param efin          Scattered Photon Energy [eV]
+ * @return U64          Kernel evaluations after pruning that use the Thomson limit
+ */
+extern U64 IcsCmbSpectrum_CountThomsonLimit(const ICS_CMB_SPECTRUM *spectrum, const F64 efin);
+
+/**
+ * @brief               Release the arrays owned by an ICS spectrum
+ * 
+ * @param spectrum      ICS spectrum
+ */
+extern void IcsCmbSpectrum_Release(ICS_CMB_SPECTRUM *spectrum);
+
+
+
+#ifdef _cplusplus
+}
+#endif
+
+#endif
+
+//******************************************************************************
+// End of File
+//******************************************************************************
@@ -101,6 +101,143 @@ F64 IcsJones_CalcFluxIso(const F64 efin, const F64 einit, const F64 gamma)
 
 
 
+//******************************************************************************
+//! \breif      Calculates the Jones approximation ICS spectrum in single
+//!             precision
+//! \remark     1) Same expression as IcsJones_CalcFluxIso
+//!             2) Written in terms of 1/gamma^2 so that gamma^4 never has to
+//!                be formed (it overflows F32 above gamma ~ 4E+9)
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  efin  : Scattered Photon Energy [eV]
+//! \param[in]  einit : Incident Photon Energy [eV]
+//! \param[in]  gamma : Electron Lorentz Factor
+//! \return     ICS flux on isotropic photon using Jones approximation
+//******************************************************************************
+F32 IcsJones_CalcFluxIsoF32(const F32 efin, const F32 einit, const F32 gamma)
+{
+    register F32 flux;
+    F32 tmp[4];
+    register F32 inv_gamma2;
+    register F32 q;
+    const F32 R0 = (F32)CLASIC_ELECTRON_RADIUS;
+    const F32 C = (F32)LIGHT_SPEED;
+    const F32 MC2 = (F32)ELECTRON_REST_ENERGY;
+
+    inv_gamma2 = 1.0F / (gamma * gamma);
+
+    //------------------------------------------------------
+    // In case of photon energy lossing after the scattering
+    //------------------------------------------------------
+    if ((efin > 0.25F * einit * inv_gamma2) && (efin < einit)) {
+        tmp[0]  = (4.0F * efin) / einit;
+        tmp[0] -= inv_gamma2;
+
+        flux  = (F32)MATH_PI * R0 * R0 * C * tmp[0];
+        flux *= inv_gamma2 / (2.0F * einit);
+    }
+    //------------------------------------------------------
+    // In case of photon energy increasing after the scattering
+    //------------------------------------------------------
+    else if ((einit <= efin) && (efin < (4.0F * einit * gamma * gamma) / (1.0F + 4.0F * (einit / MC2) * gamma))) {
+        q = efin / (gamma * MC2);
+        q = 1.0F - q;
+        q *= 4.0F * einit * gamma * gamma;
+        q  = efin / q;
+
+        tmp[0]  = 2.0F * q * logf(q);
+
+        tmp[1]  = 1.0F + (2.0F * q);
+        tmp[1] *= (1.0F - q);
+
+        tmp[2]  = (4.0F * einit * gamma * q) / MC2;
+
+        tmp[3]  = 0.5F * tmp[2] * tmp[2];
+        tmp[3] /= 1.0F + tmp[2];
+        tmp[3] *= 1.0F - q;
+
+        flux  = tmp[0] + tmp[1] + tmp[3];
+        flux *= 2.0F * (F32)MATH_PI * R0 * R0 * C;
+        flux *= inv_gamma2 / einit;
+    }
+    else {
+        flux = 0.0F;
+    }
+
+    return flux;
+}
+
+
+
+//******************************************************************************
+//! \breif      Calculates the Jones approximation ICS spectrum in quad
+//!             precision
+//! \remark     Reference for the lower precision versions
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  efin  : Scattered Photon Energy [eV]
+//! \param[in]  einit : Incident Photon Energy [eV]
+//! \param[in]  gamma : Electron Lorentz Factor
+//! \return     ICS flux on isotropic photon using Jones approximation
+//******************************************************************************
+F128 IcsJones_CalcFluxIsoF128(const F128 efin, const F128 einit, const F128 gamma)
+{
+    register F128 flux;
+    F128 tmp[4];
+    register F128 gamma2, gamma4;
+    register F128 q;
+    const F128 R0 = (F128)CLASIC_ELECTRON_RADIUS;
+    const F128 C = (F128)LIGHT_SPEED;
+    const F128 MC2 = (F128)ELECTRON_REST_ENERGY;
+
+    gamma2 = gamma * gamma;
+    gamma4 = gamma2 * gamma2;
+
+    //------------------------------------------------------
+    // In case of photon energy lossing after the scattering
+    //------------------------------------------------------
+    if ((efin > einit / (4.0Q * gamma2)) && (efin < einit)) {
+        tmp[0]  = (4.0Q * gamma2 * efin) / einit;
+        tmp[0] -=  1.0Q;
+
+        flux  = (F128)MATH_PI * R0 * R0 * C * tmp[0];
+        flux /= 2.0Q * gamma4 * einit;
+    }
+    //------------------------------------------------------
+    // In case of photon energy increasing after the scattering
+    //------------------------------------------------------
+    else if ((einit <= efin) && (efin < (4.0Q * einit * gamma2) / (1.0Q + 4.0Q * (einit / MC2) * gamma))) {
+        q = efin / (gamma * MC2);
+        q = 1.0Q - q;
+        q *= 4.0Q * einit * gamma2;
+        q  = efin / q;
+
+        tmp[0]  = 2.0Q * q * logq(q);
+
+        tmp[1]  = 1.0Q + (2.0Q * q);
+        tmp[1] *= (1.0Q - q);
+
+        tmp[2]  = (4.0Q * einit * gamma * q) / MC2;
+
+        tmp[3]  = 0.5Q * tmp[2] * tmp[2];
+        tmp[3] /= 1.0Q + tmp[2];
+        tmp[3] *= 1.0Q - q;
+
+        flux  = tmp[0] + tmp[1] + tmp[3];
+        flux *= 2.0Q * (F128)MATH_PI * R0 * R0 * C;
+        flux /= gamma2 * einit;
+    }
+    else {
+        flux = 0.0Q;
+    }
+
+    return flux;
+}
+
+
+
 //******************************************************************************
 //! \breif      Calaulates the minimum energy of scattered photon in case of
 //!             Jones approximation and isotropic photon
@@ -146,6 +283,289 @@ F64 IcsJones_MaxEnegyIso(const F64 einit, const F64 gamma)
 
 
 
+//******************************************************************************
+//! \breif      Prepare the gamma factors of the Jones kernel
+//! \remark     Evaluated once per gamma node and shared by every (efin, einit)
+//! 
+//! \callgraph  
+//! 
+//! \param[out] prepared : Gamma factors
+//! \param[in]  gamma    : Electron Lorentz Factor
+//! \return     None
+//******************************************************************************
+void IcsJones_PrepareGamma(ICS_JONES_GAMMA *prepared, const F64 gamma)
+{
+    prepared->Gamma = gamma;
+    prepared->Gamma2 = gamma * gamma;
+    prepared->InvGamma2 = 1.0 / prepared->Gamma2;
+    prepared->InvGamma4 = prepared->InvGamma2 * prepared->InvGamma2;
+    prepared->InvGammaMc2 = 1.0 / (gamma * ELECTRON_REST_ENERGY);
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Prepare the einit factors of the Jones kernel
+//! \remark     Evaluated once per einit row
+//! 
+//! \callgraph  
+//! 
+//! \param[out] prepared : Einit factors
+//! \param[in]  einit    : Incident Photon Energy [eV]
+//! \return     None
+//******************************************************************************
+void IcsJones_PrepareEinit(ICS_JONES_EINIT *prepared, const F64 einit)
+{
+    const F64 R0 = CLASIC_ELECTRON_RADIUS;
+    const F64 C = LIGHT_SPEED;
+
+    prepared->Einit = einit;
+    prepared->InvEinit = 1.0 / einit;
+    prepared->FourEinit = 4.0 * einit;
+    prepared->Alpha4 = (4.0 * einit) / ELECTRON_REST_ENERGY;
+    prepared->DownScale = (MATH_PI * R0 * R0 * C) / (2.0 * einit);
+    prepared->UpScale = (2.0 * MATH_PI * R0 * R0 * C) / einit;
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Calculates the Jones approximation ICS spectrum from prepared
+//!             factors
+//! \remark     1) Same expression as IcsJones_CalcFluxIso
+//!             2) Only q and its logarithm depend on all three energies, so
+//!                one division and one log remain per evaluation
+//!             3) The lower edge is tested on 4 gamma^2 efin / einit > 1,
+//!                which is the factor of the flux itself
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  efin  : Scattered Photon Energy [eV]
+//! \param[in]  einit : Einit factors (IcsJones_PrepareEinit)
+//! \param[in]  gamma : Gamma factors (IcsJones_PrepareGamma)
+//! \return     ICS flux on isotropic photon using Jones approximation
+//******************************************************************************
+F64 IcsJones_CalcFluxPrepared(const F64 efin, const ICS_JONES_EINIT *einit, const ICS_JONES_GAMMA *gamma)
+{
+    register F64 flux;
+    F64 tmp[4];
+    register F64 q;
+
+    //------------------------------------------------------
+    // In case of photon energy lossing after the scattering
+    //------------------------------------------------------
+    if (efin < einit->Einit) {
+        tmp[0] = 4.0 * gamma->Gamma2 * efin * einit->InvEinit;
+        if (tmp[0] <= 1.0) {
+            return 0.0;
+        }
+
+        flux  = (tmp[0] - 1.0) * einit->DownScale;
+        flux *= gamma->InvGamma4;
+    }
+    //------------------------------------------------------
+    // In case of photon energy increasing after the scattering
+    //------------------------------------------------------
+    else if (efin * (1.0 + einit->Alpha4 * gamma->Gamma) < einit->FourEinit * gamma->Gamma2) {
+        q  = 1.0 - efin * gamma->InvGammaMc2;
+        q *= einit->FourEinit * gamma->Gamma2;
+        q  = efin / q;
+
+        tmp[0]  = 2.0 * q * log(q);
+
+        tmp[1]  = 1.0 + (2.0 * q);
+        tmp[1] *= (1.0 - q);
+
+        tmp[2]  = einit->Alpha4 * gamma->Gamma * q;
+
+        tmp[3]  = 0.5 * tmp[2] * tmp[2];
+        tmp[3] /= 1.0 + tmp[2];
+        tmp[3] *= 1.0 - q;
+
+        flux  = tmp[0] + tmp[1] + tmp[3];
+        flux *= einit->UpScale * gamma->InvGamma2;
+    }
+    else {
+        flux = 0.0;
+    }
+
+    return flux;
+}
+
+
+
+//******************************************************************************
+//! \breif      Calculates the Thomson limit of the Jones approximation ICS
+//!             spectrum from prepared factors
+//! \remark     1) With G = 4 einit gamma / mc^2 -> 0 the recoil term of the
+//!                Jones kernel vanishes and q = efin / (4 gamma^2 einit), so
+//!                the up-scattering branch needs no division.
+//!             2) The down-scattering branch does not depend on G and is that
+//!                of IcsJones_CalcFluxPrepared.
+//!             3) The deviation from IcsJones_CalcFluxPrepared is below G
+//!                times the peak of the kernel over efin.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  efin  : Scattered Photon Energy [eV]
+//! \param[in]  einit : Einit factors (IcsJones_PrepareEinit)
+//! \param[in]  gamma : Gamma factors (IcsJones_PrepareGamma)
+//! \return     ICS flux on isotropic photon using the Thomson limit of Jones
+//!             approximation
+//******************************************************************************
+F64 IcsJones_CalcFluxThomsonLimit(const F64 efin, const ICS_JONES_EINIT *einit, const ICS_JONES_GAMMA *gamma)
+{
+    register F64 flux;
+    register F64 q;
+
+    //------------------------------------------------------
+    // In case of photon energy lossing after the scattering
+    //------------------------------------------------------
+    if (efin < einit->Einit) {
+        q = 4.0 * gamma->Gamma2 * efin * einit->InvEinit;
+        if (q <= 1.0) {
+            return 0.0;
+        }
+
+        flux  = (q - 1.0) * einit->DownScale;
+        flux *= gamma->InvGamma4;
+    }
+    //------------------------------------------------------
+    // In case of photon energy increasing after the scattering
+    //------------------------------------------------------
+    else {
+        q = 0.25 * efin * einit->InvEinit * gamma->InvGamma2;
+        if (q >= 1.0) {
+            return 0.0;
+        }
+
+        flux  = 2.0 * q * log(q) + (1.0 + 2.0 * q) * (1.0 - q);
+        flux *= einit->UpScale * gamma->InvGamma2;
+    }
+
+    return flux;
+}
+
+
+
+//******************************************************************************
+//! \breif      Prepare the gamma factors of the Jones kernel in quad precision
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[out] prepared : Gamma factors
+//! \param[in]  gamma    : Electron Lorentz Factor
+//! \return     None
+//******************************************************************************
+void IcsJones_PrepareGammaF128(ICS_JONES_GAMMA_F128 *prepared, const F128 gamma)
+{
+    prepared->Gamma = gamma;
+    prepared->Gamma2 = gamma * gamma;
+    prepared->InvGamma2 = 1.0Q / prepared->Gamma2;
+    prepared->InvGamma4 = prepared->InvGamma2 * prepared->InvGamma2;
+    prepared->InvGammaMc2 = 1.0Q / (gamma * (F128)ELECTRON_REST_ENERGY);
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Prepare the einit factors of the Jones kernel in quad precision
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[out] prepared : Einit factors
+//! \param[in]  einit    : Incident Photon Energy [eV]
+//! \return     None
+//******************************************************************************
+void IcsJones_PrepareEinitF128(ICS_JONES_EINIT_F128 *prepared, const F128 einit)
+{
+    const F128 R0 = (F128)CLASIC_ELECTRON_RADIUS;
+    const F128 C = (F128)LIGHT_SPEED;
+
+    prepared->Einit = einit;
+    prepared->InvEinit = 1.0Q / einit;
+    prepared->FourEinit = 4.0Q * einit;
+    prepared->Alpha4 = (4.0Q * einit) / (F128)ELECTRON_REST_ENERGY;
+    prepared->DownScale = ((F128)MATH_PI * R0 * R0 * C) / (2.0Q * einit);
+    prepared->UpScale = (2.0Q * (F128)MATH_PI * R0 * R0 * C) / einit;
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Calculates the Jones approximation ICS spectrum from prepared
+//!             factors in quad precision
+//! \remark     Same expression as IcsJones_CalcFluxPrepared. Quad precision
+//!             division is done in software, so removing all but one of them
+//!             dominates the saving.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  efin  : Scattered Photon Energy [eV]
+//! \param[in]  einit : Einit factors (IcsJones_PrepareEinitF128)
+//! \param[in]  gamma : Gamma factors (IcsJones_PrepareGammaF128)
+//! \return     ICS flux on isotropic photon using Jones approximation
+//******************************************************************************
+F128 IcsJones_CalcFluxPreparedF128(const F128 efin, const ICS_JONES_EINIT_F128 *einit, const ICS_JONES_GAMMA_F128 *gamma)
+{
+    register F128 flux;
+    F128 tmp[4];
+    register F128 q;
+
+    //------------------------------------------------------
+    // In case of photon energy lossing after the scattering
+    //------------------------------------------------------
+    if (efin < einit->Einit) {
+        tmp[0] = 4.0Q * gamma->Gamma2 * efin * einit->InvEinit;
+        if (tmp[0] <= 1.0Q) {
+            return 0.0Q;
+        }
+
+        flux  = (tmp[0] - 1.0Q) * einit->DownScale;
+        flux *= gamma->InvGamma4;
+    }
+    //------------------------------------------------------
+    // In case of photon energy increasing after the scattering
+    //------------------------------------------------------
+    else if (efin * (1.0Q + einit->Alpha4 * gamma->Gamma) < einit->FourEinit * gamma->Gamma2) {
+        q  = 1.0Q - efin * gamma->InvGammaMc2;
+        q *= einit->FourEinit * gamma->Gamma2;
+        q  = efin / q;
+
+        tmp[0]  = 2.0Q * q * logq(q);
+
+        tmp[1]  = 1.0Q + (2.0Q * q);
+        tmp[1] *= (1.0Q - q);
+
+        tmp[2]  = einit->Alpha4 * gamma->Gamma * q;
+
+        tmp[3]  = 0.5Q * tmp[2] * tmp[2];
+        tmp[3] /= 1.0Q + tmp[2];
+        tmp[3] *= 1.0Q - q;
+
+        flux  = tmp[0] + tmp[1] + tmp[3];
+        flux *= einit->UpScale * gamma->InvGamma2;
+    }
+    else {
+        flux = 0.0Q;
+    }
+
+    return flux;
+}
+
+
+
+
 
 //******************************************************************************
 // End of File
@@ -39,6 +39,51 @@ extern "C" {
 //==============================================================================
 // Type Definition
 //==============================================================================
+//----------------------------------------------------------
+//! Jones kernel factors that depend on gamma only
+//----------------------------------------------------------
+typedef struct ics_jones_gamma_t {
+    F64     Gamma;              //!< Electron Lorentz Factor
+    F64     Gamma2;             //!< gamma^2
+    F64     InvGamma2;          //!< 1 / gamma^2
+    F64     InvGamma4;          //!< 1 / gamma^4
+    F64     InvGammaMc2;        //!< 1 / (gamma mc^2) [1/eV]
+}ICS_JONES_GAMMA;
+
+//----------------------------------------------------------
+//! Jones kernel factors that depend on einit only
+//----------------------------------------------------------
+typedef struct ics_jones_einit_t {
+    F64     Einit;              //!< Incident Photon Energy [eV]
+    F64     InvEinit;           //!< 1 / einit [1/eV]
+    F64     FourEinit;          //!< 4 einit [eV]
+    F64     Alpha4;             //!< 4 einit / mc^2
+    F64     DownScale;          //!< pi r0^2 c / (2 einit)
+    F64     UpScale;            //!< 2 pi r0^2 c / einit
+}ICS_JONES_EINIT;
+
+//----------------------------------------------------------
+//! Jones kernel factors that depend on gamma only (quad precision)
+//----------------------------------------------------------
+typedef struct ics_jones_gamma_f128_t {
+    F128    Gamma;              //!< Electron Lorentz Factor
+    F128    Gamma2;             //!< gamma^2
+    F128    InvGamma2;          //!< 1 / gamma^2
+    F128    InvGamma4;          //!< 1 / gamma^4
+    F128    InvGammaMc2;        //!< 1 / (gamma mc^2) [1/eV]
+}ICS_JONES_GAMMA_F128;
+
+//----------------------------------------------------------
+//! Jones kernel factors that depend on einit only (quad precision)
+//----------------------------------------------------------
+typedef struct ics_jones_einit_f128_t {
+    F128    Einit;              //!< Incident Photon Energy [eV]
+    F128    InvEinit;           //!< 1 / einit [1/eV]
+    F128    FourEinit;          //!< 4 einit [eV]
+    F128    Alpha4;             //!< 4 einit / mc^2
+    F128    DownScale;          //!< pi r0^2 c / (2 einit)
+    F128    UpScale;            //!< 2 pi r0^2 c / einit
+}ICS_JONES_EINIT_F128;
 
 
 
@@ -55,6 +100,26 @@ extern "C" {
  */
 extern F64 IcsJones_CalcFluxIso(const F64 efin, const F64 einit, const F64 gamma);
 
+/**
+ * @brief       Calculates the Jones approximation ICS spectrum in single precision
+ * 
+ * @param efin  Scattered Photon Energy [eV]
+ * @param einit Incident Photon Energy [eV]
+ * @param gamma Electron Lorentz Factor
+ * @return F32  ICS flux on isotropic photon using Jones approximation
+ */
+extern F32 IcsJones_CalcFluxIsoF32(const F32 efin, const F32 einit, const F32 gamma);
+
+/**
+ * @brief       Calculates the Jones approximation ICS spectrum in quad precision
+ * 
+ * @param efin  Scattered Photon Energy [eV]
+ * @param einit Incident Photon Energy [eV]
+ * @param gamma Electron Lorentz Factor
+ * @return F128 ICS flux on isotropic photon using Jones approximation
+ */
+extern F128 IcsJones_CalcFluxIsoF128(const F128 efin, const F128 einit, const F128 gamma);
+
 /**
  * @brief       Calaulates the minimum energy of scattered photon in case of
  *              Jones approximation and isotropic photon
@@ -73,6 +138,70 @@ extern F64 IcsJones_MinEnegyIso(const F64 einit, const F64 gamma);
  */
 extern F64 IcsJones_MaxEnegyIso(const F64 einit, const F64 gamma);
 
+/**
+ * @brief           Prepare the gamma factors of the Jones kernel
+ * 
+ * @param prepared  Gamma factors
+ * @param gamma     Electron Lorentz Factor
+ */
+extern void IcsJones_PrepareGamma(ICS_JONES_GAMMA *prepared, const F64 gamma);
+
+/**
+ * @brief           Prepare the einit factors of the Jones kernel
+ * 
+ * @param prepared  Einit factors
+ * @param einit     Incident Photon Energy [eV]
+ */
+extern void IcsJones_PrepareEinit(ICS_JONES_EINIT *prepared, const F64 einit);
+
+/**
+ * @brief       Calculates the Jones approximation ICS spectrum from prepared factors
+ * 
+ * @param efin  Scattered Photon Energy [eV]
+ * @param einit Einit factors (IcsJones_PrepareEinit)
+ * @param gamma Gamma factors (IcsJones_PrepareGamma)
+ * @return F64  ICS flux on isotropic photon using Jones approximation
+ */
+extern F64 IcsJones_CalcFluxPrepared(const F64 efin, const ICS_JONES_EINIT *einit, const ICS_JONES_GAMMA *gamma);
+
+/**
+ * @brief       Calculates the Thomson limit (4 einit gamma / mc^2 -> 0) of the
+ *              Jones approximation ICS spectrum from prepared factors
+ * 
+ * @param efin  Scattered Photon Energy [eV]
+ * @param einit Einit factors (IcsJones_PrepareEinit)
+ * @param gamma Gamma factors (IcsJones_PrepareGamma)
+ * @return F64  ICS flux on isotropic photon using the Thomson limit of Jones approximation
+ */
+extern F64 IcsJones_CalcFluxThomsonLimit(const F64 efin, const ICS_JONES_EINIT *einit, const ICS_JONES_GAMMA *gamma);
+
+/**
+ * @brief           Prepare the gamma factors of the Jones kernel in quad precision
+ * 
+ * @param prepared  Gamma factors
+ * @param gamma     Electron Lorentz Factor
+ */
+extern void IcsJones_PrepareGammaF128(ICS_JONES_GAMMA_F128 *prepared, const F128 gamma);
+
+/**
+ * @brief           Prepare the einit factors of the Jones kernel in quad precision
+ * 
+ * @param prepared  Einit factors
+ * @param einit     Incident Photon Energy [eV]
+ */
+extern void IcsJones_PrepareEinitF128(ICS_JONES_EINIT_F128 *prepared, const F128 einit);
+
+/**
+ * @brief       Calculates the Jones approximation ICS spectrum from prepared factors
+ *              in quad precision
+ * 
+ * @param efin  Scattered Photon Energy [eV]
+ * @param einit Einit factors (IcsJones_PrepareEinitF128)
+ * @param gamma Gamma factors (IcsJones_PrepareGammaF128)
+ * @return F128 ICS flux on isotropic photon using Jones approximation
+ */
+extern F128 IcsJones_CalcFluxPreparedF128(const F128 efin, const ICS_JONES_EINIT_F128 *einit, const ICS_JONES_GAMMA_F128 *gamma);
+
 
 
 #ifdef _cplusplus
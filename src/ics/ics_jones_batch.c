@@ -0,0 +1,696 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#define ICS_JONES_BATCH_C_
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include "common_physical_const.h"
+#include "ics_jones_approx.h"
+#include "ics_jones_batch.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define JONES_BATCH_X86
+#include <immintrin.h>
+#endif
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+#ifdef JONES_BATCH_X86
+#define TARGET_AVX2                     __attribute__((target("avx2")))
+#define TARGET_AVX512                   __attribute__((target("avx512f")))
+#endif
+
+//----------------------------------------------------------
+// log(x) = k ln2 + log(1 + f), sqrt(2)/2 <= 1 + f < sqrt(2)
+// (polynomial and splitting of ln2 from fdlibm e_log.c)
+//----------------------------------------------------------
+#define LOG_LN2_HI                      (6.93147180369123816490E-01)
+#define LOG_LN2_LO                      (1.90821492927058770002E-10)
+#define LOG_SQRT2                       (1.41421356237309504880E+00)
+#define LOG_LG1                         (6.666666666666735130E-01)
+#define LOG_LG2                         (3.999999999940941908E-01)
+#define LOG_LG3                         (2.857142874366239149E-01)
+#define LOG_LG4                         (2.222219843214978396E-01)
+#define LOG_LG5                         (1.818357216161805012E-01)
+#define LOG_LG6                         (1.531383769920937332E-01)
+#define LOG_LG7                         (1.479819860511658591E-01)
+
+//----------------------------------------------------------
+// Exponent extraction : (bits >> 52) | bits(2^52) == 2^52 + biased exponent
+//----------------------------------------------------------
+#define LOG_MANTISSA_MASK               (0x000FFFFFFFFFFFFFLL)
+#define LOG_ONE_BITS                    (0x3FF0000000000000LL)
+#define LOG_MAGIC_BITS                  (0x4330000000000000LL)
+#define LOG_MAGIC_BIAS                  (4503599627370496.0 + 1023.0)
+
+
+
+#ifdef JONES_BATCH_X86
+//==============================================================================
+// File Scope Function Prototype
+//==============================================================================
+static inline __m256d logAvx2(const __m256d x) TARGET_AVX2;
+static inline __m256d jonesAvx2(const __m256d efin, const __m256d einit, const __m256d gamma, const BOOL limit) TARGET_AVX2;
+static void calcGammaAvx2(const F64 efin, const F64 einit, const F64 *gamma, const U32 count, const BOOL limit, F64 *flux) TARGET_AVX2;
+static void calcEinitAvx2(const F64 efin, const F64 *einit, const F64 gamma, const U32 count, F64 *flux) TARGET_AVX2;
+static inline __m512d logAvx512(const __m512d x) TARGET_AVX512;
+static inline __m512d jonesAvx512(const __m512d efin, const __m512d einit, const __m512d gamma, const BOOL limit) TARGET_AVX512;
+static void calcGammaAvx512(const F64 efin, const F64 einit, const F64 *gamma, const U32 count, const BOOL limit, F64 *flux) TARGET_AVX512;
+static void calcEinitAvx512(const F64 efin, const F64 *einit, const F64 gamma, const U32 count, F64 *flux) TARGET_AVX512;
+#endif
+static S32 detectIsa(void);
+static F64 calcFluxThomsonLimit(const F64 efin, const F64 einit, const F64 gamma);
+
+
+
+//==============================================================================
+// File Scope Variables
+//==============================================================================
+static S32 isa_limit = ICS_JONES_BATCH_ISA_AVX512;      //!< Widest instruction set allowed (IcsJonesBatch_SetIsa)
+
+
+
+
+
+//******************************************************************************
+//! \breif      Calculates the Jones approximation ICS spectrum for many
+//!             Lorentz factors
+//! \remark     Same expression as IcsJones_CalcFluxIso. Both scattering
+//!             regimes are evaluated in every lane and selected by masks.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  efin  : Scattered Photon Energy [eV]
+//! \param[in]  einit : Incident Photon Energy [eV]
+//! \param[in]  gamma : Electron Lorentz Factors
+//! \param[in]  count : Number of Lorentz factors
+//! \param[out] flux  : ICS flux for each Lorentz factor
+//! \return     None
+//******************************************************************************
+void IcsJonesBatch_CalcFluxIsoGamma(const F64 efin, const F64 einit, const F64 *gamma, const U32 count, F64 *flux)
+{
+    U32 j;
+
+    switch (IcsJonesBatch_GetIsa()) {
+#ifdef JONES_BATCH_X86
+    case ICS_JONES_BATCH_ISA_AVX512:
+        calcGammaAvx512(efin, einit, gamma, count, FALSE, flux);
+        break;
+    case ICS_JONES_BATCH_ISA_AVX2:
+        calcGammaAvx2(efin, einit, gamma, count, FALSE, flux);
+        break;
+#endif
+    default:
+        for (j = 0; j < count; j++) {
+            flux[j] = IcsJones_CalcFluxIso(efin, einit, gamma[j]);
+        }
+        break;
+    }
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Calculates the Thomson limit of the Jones approximation ICS
+//!             spectrum for many Lorentz factors
+//! \remark     Same expression as IcsJones_CalcFluxThomsonLimit. The lanes
+//!             skip the division of q and the recoil term.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  efin  : Scattered Photon Energy [eV]
+//! \param[in]  einit : Incident Photon Energy [eV]
+//! \param[in]  gamma : Electron Lorentz Factors
+//! \param[in]  count : Number of Lorentz factors
+//! \param[out] flux  : ICS flux for each Lorentz factor
+//! \return     None
+//******************************************************************************
+void IcsJonesBatch_CalcFluxThomsonLimitGamma(const F64 efin, const F64 einit, const F64 *gamma, const U32 count, F64 *flux)
+{
+    U32 j;
+
+    switch (IcsJonesBatch_GetIsa()) {
+#ifdef JONES_BATCH_X86
+    case ICS_JONES_BATCH_ISA_AVX512:
+        calcGammaAvx512(efin, einit, gamma, count, TRUE, flux);
+        break;
+    case ICS_JONES_BATCH_ISA_AVX2:
+        calcGammaAvx2(efin, einit, gamma, count, TRUE, flux);
+        break;
+#endif
+    default:
+        for (j = 0; j < count; j++) {
+            flux[j] = calcFluxThomsonLimit(efin, einit, gamma[j]);
+        }
+        break;
+    }
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Calculates the Jones approximation ICS spectrum for many
+//!             incident energies
+//! \remark     See IcsJonesBatch_CalcFluxIsoGamma
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  efin  : Scattered Photon Energy [eV]
+//! \param[in]  einit : Incident Photon Energies [eV]
+//! \param[in]  gamma : Electron Lorentz Factor
+//! \param[in]  count : Number of incident energies
+//! \param[out] flux  : ICS flux for each incident energy
+//! \return     None
+//******************************************************************************
+void IcsJonesBatch_CalcFluxIsoEinit(const F64 efin, const F64 *einit, const F64 gamma, const U32 count, F64 *flux)
+{
+    U32 i;
+
+    switch (IcsJonesBatch_GetIsa()) {
+#ifdef JONES_BATCH_X86
+    case ICS_JONES_BATCH_ISA_AVX512:
+        calcEinitAvx512(efin, einit, gamma, count, flux);
+        break;
+    case ICS_JONES_BATCH_ISA_AVX2:
+        calcEinitAvx2(efin, einit, gamma, count, flux);
+        break;
+#endif
+    default:
+        for (i = 0; i < count; i++) {
+            flux[i] = IcsJones_CalcFluxIso(efin, einit[i], gamma);
+        }
+        break;
+    }
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Get the instruction set used by the batch evaluators
+//! \remark     The widest one the CPU supports, capped by
+//!             IcsJonesBatch_SetIsa.
+//! 
+//! \callgraph  
+//! 
+//! \param      None
+//! \return     ICS_JONES_BATCH_ISA_xxx
+//******************************************************************************
+S32 IcsJonesBatch_GetIsa(void)
+{
+    const S32 isa = detectIsa();
+
+    return (isa < isa_limit) ? isa : isa_limit;
+}
+
+
+
+//******************************************************************************
+//! \breif      Cap the instruction set used by the batch evaluators
+//! \remark     Lets the tests run every code path the CPU supports. Not to
+//!             be called while an evaluation runs on another thread.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  isa : ICS_JONES_BATCH_ISA_xxx
+//! \return     TRUE on success, FALSE if the CPU does not support isa
+//******************************************************************************
+BOOL IcsJonesBatch_SetIsa(const S32 isa)
+{
+    if ((isa < ICS_JONES_BATCH_ISA_SCALAR) || (isa > detectIsa())) {
+        return FALSE;
+    }
+    isa_limit = isa;
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Detect the widest instruction set of the CPU
+//! \remark     Decided at run time from the CPU features, so one binary
+//!             runs on any x86-64 CPU. Other targets use the scalar loop.
+//! 
+//! \callgraph  
+//! 
+//! \param      None
+//! \return     ICS_JONES_BATCH_ISA_xxx
+//******************************************************************************
+static S32 detectIsa(void)
+{
+#ifdef JONES_BATCH_X86
+    if (__builtin_cpu_supports("avx512f")) {
+        return ICS_JONES_BATCH_ISA_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return ICS_JONES_BATCH_ISA_AVX2;
+    }
+#endif
+    return ICS_JONES_BATCH_ISA_SCALAR;
+}
+
+
+
+#ifdef JONES_BATCH_X86
+//******************************************************************************
+//! \breif      Natural logarithm of 4 lanes
+//! \remark     Valid for positive normal x. Lanes outside that domain give
+//!             garbage and must be masked out by the caller.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  x : Argument
+//! \return     log(x)
+//******************************************************************************
+static inline __m256d logAvx2(const __m256d x)
+{
+    __m256i bits;
+    __m256d m, k, f, s, z, w, t1, t2, r, hfsq, big;
+
+    //------------------------------------------------------
+    // x = 2^k * m, sqrt(2)/2 < m <= sqrt(2)
+    //------------------------------------------------------
+    bits = _mm256_castpd_si256(x);
+    m = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi64x(LOG_MANTISSA_MASK)), _mm256_set1_epi64x(LOG_ONE_BITS)));
+    k = _mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits, 52), _mm256_set1_epi64x(LOG_MAGIC_BITS)));
+    k = _mm256_sub_pd(k, _mm256_set1_pd(LOG_MAGIC_BIAS));
+
+    big = _mm256_cmp_pd(m, _mm256_set1_pd(LOG_SQRT2), _CMP_GT_OQ);
+    m = _mm256_blendv_pd(m, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), big);
+    k = _mm256_add_pd(k, _mm256_and_pd(big, _mm256_set1_pd(1.0)));
+
+    //------------------------------------------------------
+    // log(1 + f) = f - hfsq + s * (hfsq + R), s = f / (2 + f)
+    //------------------------------------------------------
+    f = _mm256_sub_pd(m, _mm256_set1_pd(1.0));
+    s = _mm256_div_pd(f, _mm256_add_pd(f, _mm256_set1_pd(2.0)));
+    z = _mm256_mul_pd(s, s);
+    w = _mm256_mul_pd(z, z);
+
+    t1 = _mm256_add_pd(_mm256_set1_pd(LOG_LG4), _mm256_mul_pd(w, _mm256_set1_pd(LOG_LG6)));
+    t1 = _mm256_mul_pd(w, _mm256_add_pd(_mm256_set1_pd(LOG_LG2), _mm256_mul_pd(w, t1)));
+    t2 = _mm256_add_pd(_mm256_set1_pd(LOG_LG5), _mm256_mul_pd(w, _mm256_set1_pd(LOG_LG7)));
+    t2 = _mm256_add_pd(_mm256_set1_pd(LOG_LG3), _mm256_mul_pd(w, t2));
+    t2 = _mm256_mul_pd(z, _mm256_add_pd(_mm256_set1_pd(LOG_LG1), _mm256_mul_pd(w, t2)));
+    r = _mm256_add_pd(t1, t2);
+
+    hfsq = _mm256_mul_pd(_mm256_set1_pd(0.5), _mm256_mul_pd(f, f));
+    r = _mm256_add_pd(_mm256_mul_pd(s, _mm256_add_pd(hfsq, r)), _mm256_mul_pd(k, _mm256_set1_pd(LOG_LN2_LO)));
+    r = _mm256_sub_pd(_mm256_sub_pd(hfsq, r), f);
+
+    return _mm256_sub_pd(_mm256_mul_pd(k, _mm256_set1_pd(LOG_LN2_HI)), r);
+}
+
+
+
+//******************************************************************************
+//! \breif      Jones approximation ICS spectrum of 4 lanes
+//! \remark     limit selects the Thomson limit (IcsJones_CalcFluxThomsonLimit).
+//!             It is a constant at every call, so the branches fold away.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  efin  : Scattered Photon Energy [eV]
+//! \param[in]  einit : Incident Photon Energy [eV]
+//! \param[in]  gamma : Electron Lorentz Factor
+//! \return     ICS flux on isotropic photon using Jones approximation
+//******************************************************************************
+static inline __m256d jonesAvx2(const __m256d efin, const __m256d einit, const __m256d gamma, const BOOL limit)
+{
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d four = _mm256_set1_pd(4.0);
+    const __m256d inv_mc2 = _mm256_set1_pd(1.0 / ELECTRON_REST_ENERGY);
+    const __m256d pi_r0_r0_c = _mm256_set1_pd(MATH_PI * CLASIC_ELECTRON_RADIUS * CLASIC_ELECTRON_RADIUS * LIGHT_SPEED);
+    __m256d inv_gamma, inv_gamma2, inv_einit, gamma2, alpha, emin, down, up, q, t0, t1, t2, t3, flux_down, flux_up;
+
+    //------------------------------------------------------
+    // Reciprocals are formed once, vector division is slow
+    //------------------------------------------------------
+    inv_gamma = _mm256_div_pd(one, gamma);
+    inv_gamma2 = _mm256_mul_pd(inv_gamma, inv_gamma);
+    inv_einit = _mm256_div_pd(one, einit);
+    gamma2 = _mm256_mul_pd(gamma, gamma);
+    alpha = _mm256_mul_pd(einit, inv_mc2);
+    emin = _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(0.25), einit), inv_gamma2);
+
+    //------------------------------------------------------
+    // efin < emax is tested as efin * (1 + 4 alpha gamma) < 4 einit gamma^2
+    //------------------------------------------------------
+    down = _mm256_and_pd(_mm256_cmp_pd(efin, emin, _CMP_GT_OQ), _mm256_cmp_pd(efin, einit, _CMP_LT_OQ));
+    t0 = (limit == TRUE) ? efin : _mm256_mul_pd(efin, _mm256_add_pd(one, _mm256_mul_pd(_mm256_mul_pd(four, alpha), gamma)));
+    t1 = _mm256_mul_pd(_mm256_mul_pd(four, einit), gamma2);
+    up = _mm256_and_pd(_mm256_cmp_pd(einit, efin, _CMP_LE_OQ), _mm256_cmp_pd(t0, t1, _CMP_LT_OQ));
+
+    //------------------------------------------------------
+    // In case of photon energy lossing after the scattering
+    //------------------------------------------------------
+    t0 = _mm256_sub_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(four, gamma2), efin), inv_einit), one);
+    flux_down = _mm256_mul_pd(_mm256_mul_pd(pi_r0_r0_c, t0), _mm256_mul_pd(_mm256_set1_pd(0.5), inv_einit));
+    flux_down = _mm256_mul_pd(flux_down, _mm256_mul_pd(inv_gamma2, inv_gamma2));
+
+    //------------------------------------------------------
+    // In case of photon energy increasing after the scattering
+    //------------------------------------------------------
+    if (limit == TRUE) {
+        q = _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(0.25), efin), inv_einit), inv_gamma2);
+    }
+    else {
+        q = _mm256_sub_pd(one, _mm256_mul_pd(_mm256_mul_pd(efin, inv_gamma), inv_mc2));
+        q = _mm256_div_pd(efin, _mm256_mul_pd(q, t1));
+    }
+    q = _mm256_blendv_pd(one, q, up);
+
+    t0 = _mm256_mul_pd(_mm256_mul_pd(two, q), logAvx2(q));
+    t1 = _mm256_mul_pd(_mm256_add_pd(one, _mm256_mul_pd(two, q)), _mm256_sub_pd(one, q));
+    flux_up = _mm256_add_pd(t0, t1);
+    if (limit == FALSE) {
+        t2 = _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(four, alpha), gamma), q);
+        t3 = _mm256_div_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(0.5), t2), t2), _mm256_add_pd(one, t2));
+        t3 = _mm256_mul_pd(t3, _mm256_sub_pd(one, q));
+        flux_up = _mm256_add_pd(flux_up, t3);
+    }
+    flux_up = _mm256_mul_pd(flux_up, _mm256_mul_pd(two, pi_r0_r0_c));
+    flux_up = _mm256_mul_pd(flux_up, _mm256_mul_pd(inv_gamma2, inv_einit));
+
+    return _mm256_or_pd(_mm256_and_pd(down, flux_down), _mm256_and_pd(up, flux_up));
+}
+
+
+
+//******************************************************************************
+//! \breif      AVX2 driver of IcsJonesBatch_CalcFluxIsoGamma
+//! \remark     The tail shorter than a vector uses the scalar kernel
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  efin  : Scattered Photon Energy [eV]
+//! \param[in]  einit : Incident Photon Energy [eV]
+//! \param[in]  gamma : Electron Lorentz Factors
+//! \param[in]  count : Number of Lorentz factors
+//! \param[out] flux  : ICS flux for each Lorentz factor
+//! \return     None
+//******************************************************************************
+static void calcGammaAvx2(const F64 efin, const F64 einit, const F64 *gamma, const U32 count, const BOOL limit, F64 *flux)
+{
+    U32 j;
+    const __m256d v_efin = _mm256_set1_pd(efin);
+    const __m256d v_einit = _mm256_set1_pd(einit);
+
+    for (j = 0; j + 4 <= count; j += 4) {
+        _mm256_storeu_pd(&flux[j], jonesAvx2(v_efin, v_einit, _mm256_loadu_pd(&gamma[j]), limit));
+    }
+    for (; j < count; j++) {
+        flux[j] = (limit == TRUE) ? calcFluxThomsonLimit(efin, einit, gamma[j]) : IcsJones_CalcFluxIso(efin, einit, gamma[j]);
+    }
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      AVX2 driver of IcsJonesBatch_CalcFluxIsoEinit
+//! \remark     The tail shorter than a vector uses the scalar kernel
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  efin  : Scattered Photon Energy [eV]
+//! \param[in]  einit : Incident Photon Energies [eV]
+//! \param[in]  gamma : Electron Lorentz Factor
+//! \param[in]  count : Number of incident energies
+//! \param[out] flux  : ICS flux for each incident energy
+//! \return     None
+//******************************************************************************
+static void calcEinitAvx2(const F64 efin, const F64 *einit, const F64 gamma, const U32 count, F64 *flux)
+{
+    U32 i;
+    const __m256d v_efin = _mm256_set1_pd(efin);
+    const __m256d v_gamma = _mm256_set1_pd(gamma);
+
+    for (i = 0; i + 4 <= count; i += 4) {
+        _mm256_storeu_pd(&flux[i], jonesAvx2(v_efin, _mm256_loadu_pd(&einit[i]), v_gamma, FALSE));
+    }
+    for (; i < count; i++) {
+        flux[i] = IcsJones_CalcFluxIso(efin, einit[i], gamma);
+    }
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Natural logarithm of 8 lanes
+//! \remark     Same algorithm as logAvx2
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  x : Argument
+//! \return     log(x)
+//******************************************************************************
+static inline __m512d logAvx512(const __m512d x)
+{
+    __m512i bits;
+    __m512d m, k, f, s, z, w, t1, t2, r, hfsq;
+    __mmask8 big;
+
+    //------------------------------------------------------
+    // x = 2^k * m, sqrt(2)/2 < m <= sqrt(2)
+    //------------------------------------------------------
+    bits = _mm512_castpd_si512(x);
+    m = _mm512_castsi512_pd(_mm512_or_si512(_mm512_and_si512(bits, _mm512_set1_epi64(LOG_MANTISSA_MASK)), _mm512_set1_epi64(LOG_ONE_BITS)));
+    k = _mm512_castsi512_pd(_mm512_or_si512(_mm512_srli_epi64(bits, 52), _mm512_set1_epi64(LOG_MAGIC_BITS)));
+    k = _mm512_sub_pd(k, _mm512_set1_pd(LOG_MAGIC_BIAS));
+
+    big = _mm512_cmp_pd_mask(m, _mm512_set1_pd(LOG_SQRT2), _CMP_GT_OQ);
+    m = _mm512_mask_mul_pd(m, big, m, _mm512_set1_pd(0.5));
+    k = _mm512_mask_add_pd(k, big, k, _mm512_set1_pd(1.0));
+
+    //------------------------------------------------------
+    // log(1 + f) = f - hfsq + s * (hfsq + R), s = f / (2 + f)
+    //------------------------------------------------------
+    f = _mm512_sub_pd(m, _mm512_set1_pd(1.0));
+    s = _mm512_div_pd(f, _mm512_add_pd(f, _mm512_set1_pd(2.0)));
+    z = _mm512_mul_pd(s, s);
+    w = _mm512_mul_pd(z, z);
+
+    t1 = _mm512_add_pd(_mm512_set1_pd(LOG_LG4), _mm512_mul_pd(w, _mm512_set1_pd(LOG_LG6)));
+    t1 = _mm512_mul_pd(w, _mm512_add_pd(_mm512_set1_pd(LOG_LG2), _mm512_mul_pd(w, t1)));
+    t2 = _mm512_add_pd(_mm512_set1_pd(LOG_LG5), _mm512_mul_pd(w, _mm512_set1_pd(LOG_LG7)));
+    t2 = _mm512_add_pd(_mm512_set1_pd(LOG_LG3), _mm512_mul_pd(w, t2));
+    t2 = _mm512_mul_pd(z, _mm512_add_pd(_mm512_set1_pd(LOG_LG1), _mm512_mul_pd(w, t2)));
+    r = _mm512_add_pd(t1, t2);
+
+    hfsq = _mm512_mul_pd(_mm512_set1_pd(0.5), _mm512_mul_pd(f, f));
+    r = _mm512_add_pd(_mm512_mul_pd(s, _mm512_add_pd(hfsq, r)), _mm512_mul_pd(k, _mm512_set1_pd(LOG_LN2_LO)));
+    r = _mm512_sub_pd(_mm512_sub_pd(hfsq, r), f);
+
+    return _mm512_sub_pd(_mm512_mul_pd(k, _mm512_set1_pd(LOG_LN2_HI)), r);
+}
+
+
+
+//******************************************************************************
+//! \breif      Jones approximation ICS spectrum of 8 lanes
+//! \remark     Same expression as jonesAvx2
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  efin  : Scattered Photon Energy [eV]
+//! \param[in]  einit : Incident Photon Energy [eV]
+//! \param[in]  gamma : Electron Lorentz Factor
+//! \return     ICS flux on isotropic photon using Jones approximation
+//******************************************************************************
+static inline __m512d jonesAvx512(const __m512d efin, const __m512d einit, const __m512d gamma, const BOOL limit)
+{
+    const __m512d one = _mm512_set1_pd(1.0);
+    const __m512d two = _mm512_set1_pd(2.0);
+    const __m512d four = _mm512_set1_pd(4.0);
+    const __m512d inv_mc2 = _mm512_set1_pd(1.0 / ELECTRON_REST_ENERGY);
+    const __m512d pi_r0_r0_c = _mm512_set1_pd(MATH_PI * CLASIC_ELECTRON_RADIUS * CLASIC_ELECTRON_RADIUS * LIGHT_SPEED);
+    __m512d inv_gamma, inv_gamma2, inv_einit, gamma2, alpha, emin, q, t0, t1, t2, t3, flux_down, flux_up;
+    __mmask8 down, up;
+
+    //------------------------------------------------------
+    // Reciprocals are formed once, vector division is slow
+    //------------------------------------------------------
+    inv_gamma = _mm512_div_pd(one, gamma);
+    inv_gamma2 = _mm512_mul_pd(inv_gamma, inv_gamma);
+    inv_einit = _mm512_div_pd(one, einit);
+    gamma2 = _mm512_mul_pd(gamma, gamma);
+    alpha = _mm512_mul_pd(einit, inv_mc2);
+    emin = _mm512_mul_pd(_mm512_mul_pd(_mm512_set1_pd(0.25), einit), inv_gamma2);
+
+    //------------------------------------------------------
+    // efin < emax is tested as efin * (1 + 4 alpha gamma) < 4 einit gamma^2
+    //------------------------------------------------------
+    down = _mm512_cmp_pd_mask(efin, emin, _CMP_GT_OQ) & _mm512_cmp_pd_mask(efin, einit, _CMP_LT_OQ);
+    t0 = (limit == TRUE) ? efin : _mm512_mul_pd(efin, _mm512_add_pd(one, _mm512_mul_pd(_mm512_mul_pd(four, alpha), gamma)));
+    t1 = _mm512_mul_pd(_mm512_mul_pd(four, einit), gamma2);
+    up = _mm512_cmp_pd_mask(einit, efin, _CMP_LE_OQ) & _mm512_cmp_pd_mask(t0, t1, _CMP_LT_OQ);
+
+    //------------------------------------------------------
+    // In case of photon energy lossing after the scattering
+    //------------------------------------------------------
+    t0 = _mm512_sub_pd(_mm512_mul_pd(_mm512_mul_pd(_mm512_mul_pd(four, gamma2), efin), inv_einit), one);
+    flux_down = _mm512_mul_pd(_mm512_mul_pd(pi_r0_r0_c, t0), _mm512_mul_pd(_mm512_set1_pd(0.5), inv_einit));
+    flux_down = _mm512_mul_pd(flux_down, _mm512_mul_pd(inv_gamma2, inv_gamma2));
+
+    //------------------------------------------------------
+    // In case of photon energy increasing after the scattering
+    //------------------------------------------------------
+    if (limit == TRUE) {
+        q = _mm512_mask_mul_pd(one, up, _mm512_mul_pd(_mm512_mul_pd(_mm512_set1_pd(0.25), efin), inv_einit), inv_gamma2);
+    }
+    else {
+        q = _mm512_sub_pd(one, _mm512_mul_pd(_mm512_mul_pd(efin, inv_gamma), inv_mc2));
+        q = _mm512_mask_div_pd(one, up, efin, _mm512_mul_pd(q, t1));
+    }
+
+    t0 = _mm512_mul_pd(_mm512_mul_pd(two, q), logAvx512(q));
+    t1 = _mm512_mul_pd(_mm512_add_pd(one, _mm512_mul_pd(two, q)), _mm512_sub_pd(one, q));
+    flux_up = _mm512_add_pd(t0, t1);
+    if (limit == FALSE) {
+        t2 = _mm512_mul_pd(_mm512_mul_pd(_mm512_mul_pd(four, alpha), gamma), q);
+        t3 = _mm512_div_pd(_mm512_mul_pd(_mm512_mul_pd(_mm512_set1_pd(0.5), t2), t2), _mm512_add_pd(one, t2));
+        t3 = _mm512_mul_pd(t3, _mm512_sub_pd(one, q));
+        flux_up = _mm512_add_pd(flux_up, t3);
+    }
+    flux_up = _mm512_mul_pd(flux_up, _mm512_mul_pd(two, pi_r0_r0_c));
+    flux_up = _mm512_mul_pd(flux_up, _mm512_mul_pd(inv_gamma2, inv_einit));
+
+    return _mm512_mask_mov_pd(_mm512_maskz_mov_pd(down, flux_down), up, flux_up);
+}
+
+
+
+//******************************************************************************
+//! \breif      AVX-512 driver of IcsJonesBatch_CalcFluxIsoGamma
+//! \remark     The tail shorter than a vector is evaluated with a lane mask
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  efin  : Scattered Photon Energy [eV]
+//! \param[in]  einit : Incident Photon Energy [eV]
+//! \param[in]  gamma : Electron Lorentz Factors
+//! \param[in]  count : Number of Lorentz factors
+//! \param[out] flux  : ICS flux for each Lorentz factor
+//! \return     None
+//******************************************************************************
+static void calcGammaAvx512(const F64 efin, const F64 einit, const F64 *gamma, const U32 count, const BOOL limit, F64 *flux)
+{
+    U32 j;
+    __mmask8 tail;
+    const __m512d v_efin = _mm512_set1_pd(efin);
+    const __m512d v_einit = _mm512_set1_pd(einit);
+
+    for (j = 0; j + 8 <= count; j += 8) {
+        _mm512_storeu_pd(&flux[j], jonesAvx512(v_efin, v_einit, _mm512_loadu_pd(&gamma[j]), limit));
+    }
+    if (j < count) {
+        tail = (__mmask8)((1U << (count - j)) - 1U);
+        _mm512_mask_storeu_pd(&flux[j], tail, jonesAvx512(v_efin, v_einit, _mm512_mask_loadu_pd(_mm512_set1_pd(1.0), tail, &gamma[j]), limit));
+    }
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      AVX-512 driver of IcsJonesBatch_CalcFluxIsoEinit
+//! \remark     The tail shorter than a vector is evaluated with a lane mask
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  efin  : Scattered Photon Energy [eV]
+//! \param[in]  einit : Incident Photon Energies [eV]
+//! \param[in]  gamma : Electron Lorentz Factor
+//! \param[in]  count : Number of incident energies
+//! \param[out] flux  : ICS flux for each incident energy
+//! \return     None
+//******************************************************************************
+static void calcEinitAvx512(const F64 efin, const F64 *einit, const F64 gamma, const U32 count, F64 *flux)
+{
+    U32 i;
+    __mmask8 tail;
+    const __m512d v_efin = _mm512_set1_pd(efin);
+    const __m512d v_gamma = _mm512_set1_pd(gamma);
+
+    for (i = 0; i + 8 <= count; i += 8) {
+        _mm512_storeu_pd(&flux[i], jonesAvx512(v_efin, _mm512_loadu_pd(&einit[i]), v_gamma, FALSE));
+    }
+    if (i < count) {
+        tail = (__mmask8)((1U << (count - i)) - 1U);
+        _mm512_mask_storeu_pd(&flux[i], tail, jonesAvx512(v_efin, _mm512_mask_loadu_pd(_mm512_set1_pd(1.0), tail, &einit[i]), v_gamma, FALSE));
+    }
+
+    return;
+}
+#endif
+
+
+
+//******************************************************************************
+//! \breif      Thomson limit of the Jones kernel at one point
+//! \remark     Scalar lanes and tails of IcsJonesBatch_CalcFluxThomsonLimitGamma
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  efin  : Scattered Photon Energy [eV]
+//! \param[in]  einit : Incident Photon Energy [eV]
+//! \param[in]  gamma : Electron Lorentz Factor
+//! \return     ICS flux on isotropic photon using the Thomson limit of Jones
+//!             approximation
+//******************************************************************************
+static F64 calcFluxThomsonLimit(const F64 efin, const F64 einit, const F64 gamma)
+{
+    ICS_JONES_EINIT prepared_einit;
+    ICS_JONES_GAMMA prepared_gamma;
+
+    IcsJones_PrepareEinit(&prepared_einit, einit);
+    IcsJones_PrepareGamma(&prepared_gamma, gamma);
+
+    return IcsJones_CalcFluxThomsonLimit(efin, &prepared_einit, &prepared_gamma);
+}
+
+
+
+
+
+//******************************************************************************
+// End of File
+//******************************************************************************
@@ -0,0 +1,111 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#ifndef ICS_JONES_BATCH_H_
+#define ICS_JONES_BATCH_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include "common_typedef.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+#define ICS_JONES_BATCH_ISA_SCALAR      (0)     //!< Scalar loop over IcsJones_CalcFluxIso
+#define ICS_JONES_BATCH_ISA_AVX2        (1)     //!< 4 lanes of F64
+#define ICS_JONES_BATCH_ISA_AVX512      (2)     //!< 8 lanes of F64
+
+
+
+//==============================================================================
+// Export Scope Function Prototype
+//==============================================================================
+/**
+ * @brief       Calculates the Jones approximation ICS spectrum for many Lorentz factors
+ * 
+ * @param efin  Scattered Photon Energy [eV]
+ * @param einit Incident Photon Energy [eV]
+ * @param gamma Electron Lorentz Factors
+ * @param count Number of Lorentz factors
+ * @param flux  ICS flux for each Lorentz factor
+ */
+extern void IcsJonesBatch_CalcFluxIsoGamma(const F64 efin, const F64 einit, const F64 *gamma, const U32 count, F64 *flux);
+
+/**
+ * @brief       Calculates the Thomson limit of the Jones approximation ICS spectrum for many Lorentz factors
+ * 
+ * @param efin  Scattered Photon Energy [eV]
+ * @param einit Incident Photon Energy [eV]
+ * @param gamma Electron Lorentz Factors
+ * @param count Number of Lorentz factors
+ * @param flux  ICS flux for each Lorentz factor
+ */
+extern void IcsJonesBatch_CalcFluxThomsonLimitGamma(const F64 efin, const F64 einit, const F64 *gamma, const U32 count, F64 *flux);
+
+/**
+ * @brief       Calculates the Jones approximation ICS spectrum for many incident energies
+ * 
+ * @param efin  Scattered Photon Energy [eV]
+ * @param einit Incident Photon Energies [eV]
+ * @param gamma Electron Lorentz Factor
+ * @param count Number of incident energies
+ * @param flux  ICS flux for each incident energy
+ */
+extern void IcsJonesBatch_CalcFluxIsoEinit(const F64 efin, const F64 *einit, const F64 gamma, const U32 count, F64 *flux);
+
+/**
+ * @brief       Get the instruction set used by the batch evaluators
+ * 
+ * @return S32  ICS_JONES_BATCH_ISA_xxx
+ */
+extern S32 IcsJonesBatch_GetIsa(void);
+
+/**
+ * @brief       Cap the instruction set used by the batch evaluators
+ * 
+ * Not to be called while an evaluation runs on another thread.
+ * 
+ * @param isa   ICS_JONES_BATCH_ISA_xxx
+ * @return BOOL TRUE on success, FALSE if the CPU does not support isa
+ */
+extern BOOL IcsJonesBatch_SetIsa(const S32 isa);
+
+
+
+#ifdef _cplusplus
+}
+#endif
+
+#endif
+
+//******************************************************************************
+// End of File
+//******************************************************************************
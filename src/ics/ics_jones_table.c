@@ -0,0 +1,547 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#define ICS_JONES_TABLE_C_
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ics_cmb_spectrum.h"
+#include "ics_jones_table.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+//----------------------------------------------------------
+//! Points per interval compared with the quad precision reference
+//----------------------------------------------------------
+#define JONES_TABLE_CHECK_POINTS        (64)
+
+//----------------------------------------------------------
+// Payloads of the table file
+//----------------------------------------------------------
+#define JONES_TABLE_SECTION_INFO        (0)
+#define JONES_TABLE_SECTION_G           (1)
+#define JONES_TABLE_SECTION_COUNT       (2)
+
+//----------------------------------------------------------
+// Elements of the info payload
+//----------------------------------------------------------
+#define JONES_TABLE_INFO_TOLERANCE      (0)
+#define JONES_TABLE_INFO_MAX_ERROR      (1)
+#define JONES_TABLE_INFO_DEGREE         (2)
+#define JONES_TABLE_INFO_SUBDIVISION    (3)
+#define JONES_TABLE_INFO_EXPONENT       (4)
+#define JONES_TABLE_INFO_BINADES        (5)
+#define JONES_TABLE_INFO_COUNT          (6)
+
+//----------------------------------------------------------
+// IEEE 754 double precision layout
+//----------------------------------------------------------
+#define F64_MANTISSA_BITS               (52)
+#define F64_MANTISSA_MASK               (0x000FFFFFFFFFFFFFULL)
+#define F64_EXPONENT_MASK               (0x7FFULL)
+#define F64_EXPONENT_BIAS               (1023)
+#define F64_ONE_BITS                    (0x3FF0000000000000ULL)
+
+
+
+//==============================================================================
+// File Scope Function Prototype
+//==============================================================================
+static void fitInterval(F64 *coefficients, const F128 lower, const F128 width);
+static F64 checkInterval(const F64 *coefficients, const F64 lower, const F64 width);
+static inline F64 evaluateG(const F64 *coefficients, const F64 q);
+static F128 calcG(const F128 q);
+static void clearTable(ICS_JONES_TABLE *table);
+
+
+
+
+
+//******************************************************************************
+//! \breif      Build the Chebyshev table of the Jones kernel
+//! \remark     1) The up-scattering branch of IcsJones_CalcFluxIso is
+//!                (1 - q) (G(q) + h(Gq)) with G = 4 einit gamma / mc^2 and
+//!                h(x) = x^2 / (2 (1 + x)). Only G(q), which holds the log,
+//!                is tabulated, so one table serves every einit and gamma.
+//!             2) Each binade of q is split into JONES_TABLE_SUBDIVISIONS
+//!                intervals, each with the Chebyshev interpolant of degree
+//!                JONES_TABLE_DEGREE, verified at JONES_TABLE_CHECK_POINTS
+//!                points against quad precision.
+//!             3) G lies in [0.6, 1] and h is not negative, so the relative
+//!                error of the kernel is bounded by MaxError plus a few ulp.
+//! 
+//! \callgraph  
+//! 
+//! \param[out] table     : Table to be built
+//! \param[in]  tolerance : Maximum relative error
+//! \return     TRUE on success, FALSE if the array cannot be allocated or
+//!             the tolerance cannot be met
+//******************************************************************************
+BOOL IcsJonesTable_Build(ICS_JONES_TABLE *table, const F64 tolerance)
+{
+    U32 i;
+    F64 lower, width, error;
+    F64 *interval;
+
+    clearTable(table);
+
+    table->G = (F64 *)malloc((size_t)JONES_TABLE_INTERVALS * JONES_TABLE_STRIDE * sizeof(F64));
+    if (table->G == NULL) {
+        return FALSE;
+    }
+
+    for (i = 0; i < JONES_TABLE_INTERVALS; i++) {
+        interval = &table->G[(size_t)i * JONES_TABLE_STRIDE];
+        width = ldexp(1.0, JONES_TABLE_EXPONENT_MIN + (S32)(i / JONES_TABLE_SUBDIVISIONS) - JONES_TABLE_SUBDIVISION_BITS);
+        lower = width * (F64)(JONES_TABLE_SUBDIVISIONS + i % JONES_TABLE_SUBDIVISIONS);
+
+        fitInterval(interval, (F128)lower, (F128)width);
+        error = checkInterval(table->G, lower, width);
+        if (!(error <= tolerance)) {
+            IcsJonesTable_Release(table);
+            return FALSE;
+        }
+
+        table->MaxError = fmax(table->MaxError, error);
+    }
+
+    table->Tolerance = tolerance;
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Save the table to a table file
+//! \remark     Payloads : info, coefficients of G.
+//!             The info payload records the layout macros, which Load checks.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  table     : Table
+//! \param[in]  file_name : File name
+//! \return     TRUE on success
+//******************************************************************************
+BOOL IcsJonesTable_Save(const ICS_JONES_TABLE *table, const CHAR *file_name)
+{
+    IO_TABLE_HEADER header;
+    F64 info[JONES_TABLE_INFO_COUNT];
+    const F64 *sections[JONES_TABLE_SECTION_COUNT];
+
+    info[JONES_TABLE_INFO_TOLERANCE] = table->Tolerance;
+    info[JONES_TABLE_INFO_MAX_ERROR] = table->MaxError;
+    info[JONES_TABLE_INFO_DEGREE] = (F64)JONES_TABLE_DEGREE;
+    info[JONES_TABLE_INFO_SUBDIVISION] = (F64)JONES_TABLE_SUBDIVISION_BITS;
+    info[JONES_TABLE_INFO_EXPONENT] = (F64)JONES_TABLE_EXPONENT_MIN;
+    info[JONES_TABLE_INFO_BINADES] = (F64)JONES_TABLE_BINADES;
+
+    IoTable_InitHeader(&header, IO_TABLE_KIND_JONES);
+    header.Mode = USE_JONES_APPROX;
+    header.Precision = ICS_PRECISION_TABLE;
+
+    header.SectionCount = JONES_TABLE_SECTION_COUNT;
+    header.Section[JONES_TABLE_SECTION_INFO].Count = JONES_TABLE_INFO_COUNT;
+    header.Section[JONES_TABLE_SECTION_G].Count = (U64)JONES_TABLE_INTERVALS * JONES_TABLE_STRIDE;
+    sections[JONES_TABLE_SECTION_INFO] = info;
+    sections[JONES_TABLE_SECTION_G] = table->G;
+
+    return IoTable_Write(file_name, &header, sections);
+}
+
+
+
+//******************************************************************************
+//! \breif      Load the table from a table file by mapping it
+//! \remark     Files with another layout are rejected. The coefficients point
+//!             into the mapped file and must not be written.
+//! 
+//! \callgraph  
+//! 
+//! \param[out] table     : Table to be loaded
+//! \param[in]  file_name : File name
+//! \return     TRUE on success, FALSE if the file is missing or invalid
+//******************************************************************************
+BOOL IcsJonesTable_Load(ICS_JONES_TABLE *table, const CHAR *file_name)
+{
+    const IO_TABLE_HEADER *header;
+    const F64 *info;
+
+    clearTable(table);
+
+    if (IoTable_Open(&table->Table, file_name) == FALSE) {
+        return FALSE;
+    }
+
+    header = table->Table.Header;
+    info = IoTable_GetSection(&table->Table, JONES_TABLE_SECTION_INFO);
+
+    if ((header->Kind != IO_TABLE_KIND_JONES) ||
+        (header->SectionCount != JONES_TABLE_SECTION_COUNT) ||
+        (header->Section[JONES_TABLE_SECTION_INFO].Count != JONES_TABLE_INFO_COUNT) ||
+        (header->Section[JONES_TABLE_SECTION_G].Count != (U64)JONES_TABLE_INTERVALS * JONES_TABLE_STRIDE) ||
+        (info == NULL) ||
+        (info[JONES_TABLE_INFO_DEGREE] != (F64)JONES_TABLE_DEGREE) ||
+        (info[JONES_TABLE_INFO_SUBDIVISION] != (F64)JONES_TABLE_SUBDIVISION_BITS) ||
+        (info[JONES_TABLE_INFO_EXPONENT] != (F64)JONES_TABLE_EXPONENT_MIN) ||
+        (info[JONES_TABLE_INFO_BINADES] != (F64)JONES_TABLE_BINADES)) {
+        IcsJonesTable_Release(table);
+        return FALSE;
+    }
+
+    table->Tolerance = info[JONES_TABLE_INFO_TOLERANCE];
+    table->MaxError = info[JONES_TABLE_INFO_MAX_ERROR];
+    table->G = (F64 *)IoTable_GetSection(&table->Table, JONES_TABLE_SECTION_G);
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Calculates the Jones approximation ICS spectrum from the table
+//! \remark     1) The down-scattering branch and the kinematic edges are
+//!                those of IcsJones_CalcFluxPrepared
+//!             2) Up-scattering replaces the log and its division by one
+//!                table lookup and a degree 5 polynomial. Forming q and h
+//!                still take one division each.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  table : Table
+//! \param[in]  efin  : Scattered Photon Energy [eV]
+//! \param[in]  einit : Einit factors (IcsJones_PrepareEinit)
+//! \param[in]  gamma : Gamma factors (IcsJones_PrepareGamma)
+//! \return     ICS flux on isotropic photon using Jones approximation
+//******************************************************************************
+F64 IcsJonesTable_CalcFlux(const ICS_JONES_TABLE *table, const F64 efin, const ICS_JONES_EINIT *einit, const ICS_JONES_GAMMA *gamma)
+{
+    register F64 flux;
+    register F64 q, x;
+
+    //------------------------------------------------------
+    // In case of photon energy lossing after the scattering
+    //------------------------------------------------------
+    if (efin < einit->Einit) {
+        x = 4.0 * gamma->Gamma2 * efin * einit->InvEinit;
+        if (x <= 1.0) {
+            return 0.0;
+        }
+
+        flux  = (x - 1.0) * einit->DownScale;
+        flux *= gamma->InvGamma4;
+    }
+    //------------------------------------------------------
+    // In case of photon energy increasing after the scattering
+    //------------------------------------------------------
+    else if (efin * (1.0 + einit->Alpha4 * gamma->Gamma) < einit->FourEinit * gamma->Gamma2) {
+        q  = 1.0 - efin * gamma->InvGammaMc2;
+        q *= einit->FourEinit * gamma->Gamma2;
+        q  = efin / q;
+        if (q >= 1.0) {
+            return 0.0;
+        }
+
+        x = einit->Alpha4 * gamma->Gamma * q;
+
+        flux  = (1.0 - q) * (evaluateG(table->G, q) + (0.5 * x * x) / (1.0 + x));
+        flux *= einit->UpScale * gamma->InvGamma2;
+    }
+    else {
+        flux = 0.0;
+    }
+
+    return flux;
+}
+
+
+
+//******************************************************************************
+//! \breif      Calculates the Thomson limit of the Jones approximation ICS
+//!             spectrum from the table
+//! \remark     Same as IcsJones_CalcFluxThomsonLimit, whose up-scattering
+//!             branch is (1 - q) G(q), so neither a log nor a division is left.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  table : Table
+//! \param[in]  efin  : Scattered Photon Energy [eV]
+//! \param[in]  einit : Einit factors (IcsJones_PrepareEinit)
+//! \param[in]  gamma : Gamma factors (IcsJones_PrepareGamma)
+//! \return     ICS flux on isotropic photon using the Thomson limit of Jones
+//!             approximation
+//******************************************************************************
+F64 IcsJonesTable_CalcFluxThomsonLimit(const ICS_JONES_TABLE *table, const F64 efin, const ICS_JONES_EINIT *einit, const ICS_JONES_GAMMA *gamma)
+{
+    register F64 flux;
+    register F64 q;
+
+    //------------------------------------------------------
+    // In case of photon energy lossing after the scattering
+    //------------------------------------------------------
+    if (efin < einit->Einit) {
+        q = 4.0 * gamma->Gamma2 * efin * einit->InvEinit;
+        if (q <= 1.0) {
+            return 0.0;
+        }
+
+        flux  = (q - 1.0) * einit->DownScale;
+        flux *= gamma->InvGamma4;
+    }
+    //------------------------------------------------------
+    // In case of photon energy increasing after the scattering
+    //------------------------------------------------------
+    else {
+        q = 0.25 * efin * einit->InvEinit * gamma->InvGamma2;
+        if (q >= 1.0) {
+            return 0.0;
+        }
+
+        flux  = (1.0 - q) * evaluateG(table->G, q);
+        flux *= einit->UpScale * gamma->InvGamma2;
+    }
+
+    return flux;
+}
+
+
+
+//******************************************************************************
+//! \breif      Release the arrays owned by a table
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  table : Table
+//! \return     None
+//******************************************************************************
+void IcsJonesTable_Release(ICS_JONES_TABLE *table)
+{
+    if (table->Table.Image != NULL) {
+        IoTable_Close(&table->Table);
+    }
+    else {
+        free(table->G);
+    }
+
+    clearTable(table);
+
+    return;
+}
+
+
+
+
+
+//******************************************************************************
+//! \breif      Chebyshev interpolant of G(q) on one interval
+//! \remark     Interpolates at the JONES_TABLE_STRIDE Chebyshev points in
+//!             quad precision and expands it in powers of t, where
+//!             q = lower + width (t + 1) / 2 and -1 <= t < 1.
+//! 
+//! \callgraph  
+//! 
+//! \param[out] coefficients : Coefficients of t^0 .. t^JONES_TABLE_DEGREE
+//! \param[in]  lower        : Lower end of the interval
+//! \param[in]  width        : Width of the interval
+//! \return     None
+//******************************************************************************
+static void fitInterval(F64 *coefficients, const F128 lower, const F128 width)
+{
+    U32 j, k, m;
+    F128 theta, chebyshev[JONES_TABLE_STRIDE], value[JONES_TABLE_STRIDE], power[JONES_TABLE_STRIDE];
+    F128 t_prev[JONES_TABLE_STRIDE], t_curr[JONES_TABLE_STRIDE], t_next[JONES_TABLE_STRIDE];
+    const U32 n = JONES_TABLE_STRIDE;
+
+    for (j = 0; j < n; j++) {
+        theta = M_PIq * ((F128)j + 0.5Q) / (F128)n;
+        value[j] = calcG(lower + width * (cosq(theta) + 1.0Q) * 0.5Q);
+    }
+    for (k = 0; k < n; k++) {
+        chebyshev[k] = 0.0Q;
+        for (j = 0; j < n; j++) {
+            chebyshev[k] += value[j] * cosq(M_PIq * (F128)k * ((F128)j + 0.5Q) / (F128)n);
+        }
+        chebyshev[k] *= ((k == 0) ? 1.0Q : 2.0Q) / (F128)n;
+    }
+
+    //------------------------------------------------------
+    // sum_k c_k T_k(t) in powers of t (T_k+1 = 2 t T_k - T_k-1)
+    //------------------------------------------------------
+    for (m = 0; m < n; m++) {
+        power[m] = t_prev[m] = t_curr[m] = 0.0Q;
+    }
+    t_prev[0] = 1.0Q;
+    t_curr[1] = 1.0Q;
+    power[0] = chebyshev[0];
+    power[1] = chebyshev[1];
+    for (k = 2; k < n; k++) {
+        for (m = 0; m < n; m++) {
+            t_next[m] = ((m > 0) ? 2.0Q * t_curr[m - 1] : 0.0Q) - t_prev[m];
+        }
+        for (m = 0; m < n; m++) {
+            t_prev[m] = t_curr[m];
+            t_curr[m] = t_next[m];
+            power[m] += chebyshev[k] * t_curr[m];
+        }
+    }
+
+    for (m = 0; m < n; m++) {
+        coefficients[m] = (F64)power[m];
+    }
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Largest relative error of one interval
+//! \remark     Evaluated through evaluateG, so the lookup is checked together
+//!             with the polynomial. The points are equally spaced from the
+//!             lower end and include the last double below the upper end.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  coefficients : Coefficients of the whole table
+//! \param[in]  lower        : Lower end of the interval
+//! \param[in]  width        : Width of the interval
+//! \return     Largest relative error
+//******************************************************************************
+static F64 checkInterval(const F64 *coefficients, const F64 lower, const F64 width)
+{
+    U32 k;
+    F64 q, error;
+    F128 reference;
+
+    for (error = 0.0, k = 0; k <= JONES_TABLE_CHECK_POINTS; k++) {
+        if (k < JONES_TABLE_CHECK_POINTS) {
+            q = lower + width * (F64)k / (F64)JONES_TABLE_CHECK_POINTS;
+        }
+        else {
+            q = nextafter(lower + width, 0.0);
+        }
+        reference = calcG((F128)q);
+        error = fmax(error, (F64)fabsq(((F128)evaluateG(coefficients, q) - reference) / reference));
+    }
+
+    return error;
+}
+
+
+
+//******************************************************************************
+//! \breif      G(q) = 2 q ln(q) / (1 - q) + 1 + 2 q from the table
+//! \remark     1) The exponent and the leading mantissa bits of q select the
+//!                interval, and the remaining mantissa bits give t exactly.
+//!             2) The polynomial is evaluated in Estrin form, which halves
+//!                the dependency chain of Horner's rule.
+//!             3) Below the table 2 q ln(q) is under 1E-17 and G = 1 + 2 q.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  coefficients : Coefficients of the table
+//! \param[in]  q            : 0 < q < 1
+//! \return     G(q)
+//******************************************************************************
+static inline F64 evaluateG(const F64 *coefficients, const F64 q)
+{
+    U64 bits;
+    U32 index, sub;
+    F64 mantissa, t, t2;
+    const F64 *c;
+
+    if (q < ldexp(1.0, JONES_TABLE_EXPONENT_MIN)) {
+        return 1.0 + 2.0 * q;
+    }
+
+    memcpy(&bits, &q, sizeof(bits));
+    sub = (U32)(bits >> (F64_MANTISSA_BITS - JONES_TABLE_SUBDIVISION_BITS)) & (JONES_TABLE_SUBDIVISIONS - 1);
+    index = (U32)((S32)((bits >> F64_MANTISSA_BITS) & F64_EXPONENT_MASK) - F64_EXPONENT_BIAS - JONES_TABLE_EXPONENT_MIN);
+    index = index * JONES_TABLE_SUBDIVISIONS + sub;
+
+    bits = (bits & F64_MANTISSA_MASK) | F64_ONE_BITS;
+    memcpy(&mantissa, &bits, sizeof(mantissa));
+    t = mantissa * (F64)(2 * JONES_TABLE_SUBDIVISIONS) - (F64)(2 * (JONES_TABLE_SUBDIVISIONS + sub) + 1);
+    t2 = t * t;
+
+    c = &coefficients[(size_t)index * JONES_TABLE_STRIDE];
+
+    return (c[0] + c[1] * t) + t2 * ((c[2] + c[3] * t) + t2 * (c[4] + c[5] * t));
+}
+
+
+
+//******************************************************************************
+//! \breif      Quad precision reference of G(q)
+//! \remark     1 - q is exact for 1/2 <= q < 1
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  q : 0 < q < 1
+//! \return     G(q)
+//******************************************************************************
+static F128 calcG(const F128 q)
+{
+    return (2.0Q * q * logq(q)) / (1.0Q - q) + 1.0Q + 2.0Q * q;
+}
+
+
+
+//******************************************************************************
+//! \breif      Clear the fields of a table
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[out] table : Table
+//! \return     None
+//******************************************************************************
+static void clearTable(ICS_JONES_TABLE *table)
+{
+    table->Tolerance = 0.0;
+    table->MaxError = 0.0;
+    table->G = NULL;
+    table->Table.Header = NULL;
+    table->Table.Image = NULL;
+    table->Table.Size = 0;
+    table->Table.Mapped = FALSE;
+
+    return;
+}
+
+
+
+
+
+//******************************************************************************
+// End of File
+//******************************************************************************
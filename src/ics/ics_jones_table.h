@@ -0,0 +1,142 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#ifndef ICS_JONES_TABLE_H_
+#define ICS_JONES_TABLE_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include "common_typedef.h"
+#include "io_table.h"
+#include "ics_jones_approx.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+#define JONES_TABLE_TOLERANCE           (1.0E-12)       //!< Default maximum relative error
+#define JONES_TABLE_DEGREE              (5)             //!< Polynomial degree of every interval
+#define JONES_TABLE_STRIDE              (JONES_TABLE_DEGREE + 1)        //!< Coefficients per interval
+#define JONES_TABLE_SUBDIVISION_BITS    (5)             //!< Leading mantissa bits that select the interval
+#define JONES_TABLE_SUBDIVISIONS        (1 << JONES_TABLE_SUBDIVISION_BITS)    //!< Intervals per binade
+
+#define JONES_TABLE_EXPONENT_MIN        (-64)           //!< G(q) is tabulated on 2^-64 <= q < 1
+#define JONES_TABLE_BINADES             (64)
+#define JONES_TABLE_INTERVALS           (JONES_TABLE_BINADES * JONES_TABLE_SUBDIVISIONS)
+
+
+
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! Chebyshev table of the up-scattering Jones kernel
+//----------------------------------------------------------
+typedef struct ics_jones_table_t {
+    F64             Tolerance;          //!< Requested maximum relative error
+    F64             MaxError;           //!< Verified maximum relative error
+    F64             *G;                 //!< Coefficients of G(q) [JONES_TABLE_INTERVALS][JONES_TABLE_STRIDE]
+    IO_TABLE        Table;              //!< Mapped table file (arrays are read-only when loaded)
+}ICS_JONES_TABLE;
+
+
+
+//==============================================================================
+// Export Scope Function Prototype
+//==============================================================================
+/**
+ * @brief           Build the Chebyshev table of the Jones kernel
+ * 
+ * @param table     Table to be built
+ * @param tolerance Maximum relative error
+ * @return BOOL     TRUE on success, FALSE if the arrays cannot be allocated or
+ *                  the tolerance cannot be met
+ */
+extern BOOL IcsJonesTable_Build(ICS_JONES_TABLE *table, const F64 tolerance);
+
+/**
+ * @brief           Save the table to a table file
+ * 
+ * @param table     Table
+ * @param file_name File name
+ * @return BOOL     TRUE on success
+ */
+extern BOOL IcsJonesTable_Save(const ICS_JONES_TABLE *table, const CHAR *file_name);
+
+/**
+ * @brief           Load the table from a table file by mapping it
+ * 
+ * @param table     Table to be loaded
+ * @param file_name File name
+ * @return BOOL     TRUE on success, FALSE if the file is missing or invalid
+ */
+extern BOOL IcsJonesTable_Load(ICS_JONES_TABLE *table, const CHAR *file_name);
+
+/**
+ * @brief           Calculates the Jones approximation ICS spectrum from the table
+ * 
+ * @param table     Table
+ * @param efin      Scattered Photon Energy [eV]
+ * @param einit     Einit factors (IcsJones_PrepareEinit)
+ * @param gamma     Gamma factors (IcsJones_PrepareGamma)
+ * @return F64      ICS flux on isotropic photon using Jones approximation
+ */
+extern F64 IcsJonesTable_CalcFlux(const ICS_JONES_TABLE *table, const F64 efin, const ICS_JONES_EINIT *einit, const ICS_JONES_GAMMA *gamma);
+
+/**
+ * @brief           Calculates the Thomson limit of the Jones approximation ICS
+ *                  spectrum from the table
+ * 
+ * @param table     Table
+ * @param efin      Scattered Photon Energy [eV]
+ * @param einit     Einit factors (IcsJones_PrepareEinit)
+ * @param gamma     Gamma factors (IcsJones_PrepareGamma)
+ * @return F64      ICS flux on isotropic photon using the Thomson limit of Jones approximation
+ */
+extern F64 IcsJonesTable_CalcFluxThomsonLimit(const ICS_JONES_TABLE *table, const F64 efin, const ICS_JONES_EINIT *einit, const ICS_JONES_GAMMA *gamma);
+
+/**
+ * @brief           Release the arrays owned by a table
+ * 
+ * @param table     Table
+ */
+extern void IcsJonesTable_Release(ICS_JONES_TABLE *table);
+
+
+
+#ifdef _cplusplus
+}
+#endif
+
+#endif
+
+//******************************************************************************
+// End of File
+//******************************************************************************
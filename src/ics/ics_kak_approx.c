@@ -0,0 +1,154 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#define ICS_KAK_APPROX_C_
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include <math.h>
+#include "common_physical_const.h"
+#include "ics_kak_approx.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+//----------------------------------------------------------
+//! pi^2 / 6
+//----------------------------------------------------------
+#define KAK_PI2_6                       (MATH_PI * MATH_PI / 6.0)
+
+
+
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! Fit parameters of G(x), refer to eq.(26) and (27) of [ApJ, 783, 100]
+//----------------------------------------------------------
+typedef struct kak_params_t {
+    F64         Alpha;          //!< alpha
+    F64         A;              //!< a
+    F64         Beta;           //!< beta
+    F64         B;              //!< b
+    F64         C;              //!< c
+}KAK_PARAMS;
+
+
+
+//==============================================================================
+// File Scope Function Prototype
+//==============================================================================
+static F64 calcG(const F64 x, const KAK_PARAMS *params);
+
+
+
+//==============================================================================
+// File Scope Variables
+//==============================================================================
+static const KAK_PARAMS KAK_PARAMS_G3 = { 0.606, 0.443, 1.481, 0.540, 0.319 };
+static const KAK_PARAMS KAK_PARAMS_G4 = { 0.461, 0.726, 1.457, 0.382, 6.620 };
+
+
+
+
+
+//******************************************************************************
+//! \breif      Calculates the ICS spectrum on an isotropic blackbody using
+//!             the Khangulyan-Aharonian-Kelner approximation
+//! \remark     1) Refer to eq.(14), (20), (24) and (25) of [ApJ, 783, 100]
+//!                dN/dt dE = 2 r0^2 (mc^2)^2 t^2 / (pi hbar^3 c^2 gamma^2)
+//!                         * (z^2 / (2 (1 - z)) G3(x0) + G4(x0)),
+//!                t = kT / mc^2, z = efin / (gamma mc^2),
+//!                x0 = z / ((1 - z) 4 gamma t)
+//!             2) The integral over the Planck spectrum is already done, so
+//!                it replaces the einit integral of the Jones kernel times
+//!                the CMB flux. The fit is accurate to better than 1 %.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  efin        : Scattered Photon Energy [eV]
+//! \param[in]  gamma       : Electron Lorentz Factor
+//! \param[in]  temperature : Blackbody Temperature [K]
+//! \return     ICS flux integrated over the blackbody [s^(-1) eV^(-1)]
+//******************************************************************************
+F64 IcsKak_CalcFluxPlanck(const F64 efin, const F64 gamma, const F64 temperature)
+{
+    register F64 flux;
+    register F64 t, z, x0;
+    const F64 R0 = CLASIC_ELECTRON_RADIUS;
+    const F64 C = LIGHT_SPEED;
+    const F64 HBAR = PLANK_CONST;
+    const F64 MC2 = ELECTRON_REST_ENERGY;
+
+    z = efin / (gamma * MC2);
+    if ((gamma <= 1.0) || (z >= 1.0)) {
+        return 0.0;
+    }
+
+    t  = BOLTZMANN_CONST * temperature / MC2;
+    x0 = z / ((1.0 - z) * 4.0 * gamma * t);
+
+    flux  = (z * z) / (2.0 * (1.0 - z)) * calcG(x0, &KAK_PARAMS_G3);
+    flux += calcG(x0, &KAK_PARAMS_G4);
+
+    flux *= 2.0 * R0 * R0 * MC2 * MC2 * t * t;
+    flux /= MATH_PI * HBAR * HBAR * HBAR * C * C * gamma * gamma;
+
+    return flux;
+}
+
+
+
+
+
+//******************************************************************************
+//! \breif      Fit function G(x) of the blackbody integral
+//! \remark     G(x) = pi^2/6 (1 + c x) / (1 + pi^2/6 c x) exp(-x)
+//!                  / (1 + a x^alpha / (1 + b x^beta))
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  x      : x0
+//! \param[in]  params : Fit parameters
+//! \return     G(x)
+//******************************************************************************
+static F64 calcG(const F64 x, const KAK_PARAMS *params)
+{
+    register F64 g;
+
+    g  = KAK_PI2_6 * (1.0 + params->C * x) / (1.0 + KAK_PI2_6 * params->C * x) * exp(-x);
+    g /= 1.0 + params->A * pow(x, params->Alpha) / (1.0 + params->B * pow(x, params->Beta));
+
+    return g;
+}
+
+
+
+
+//******************************************************************************
+// End of File
+//******************************************************************************
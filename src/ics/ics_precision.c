@@ -0,0 +1,419 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#define ICS_PRECISION_C_
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include <stdlib.h>
+#include <math.h>
+#include "ics_jones_approx.h"
+#include "ics_jones_batch.h"
+#include "ics_jones_table.h"
+#include "ics_thomson_approx.h"
+#include "ics_cmb_spectrum.h"
+#include "ics_precision.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+//----------------------------------------------------------
+// Sweep domain : Lorentz factors of the default gamma grid and incident
+// energies where the CMB density is not negligible
+//----------------------------------------------------------
+#define SWEEP_LOG_GAMMA_LOWER           (1.0)
+#define SWEEP_LOG_GAMMA_UPPER           (10.0)
+#define SWEEP_LOG_GAMMA_STEP            (0.25)
+#define SWEEP_LOG_EINIT_LOWER           (-6.0)
+#define SWEEP_LOG_EINIT_UPPER           (-1.0)
+#define SWEEP_LOG_EINIT_STEP            (0.5)
+#define SWEEP_LOG_EFIN_STEP             (0.05)
+
+//----------------------------------------------------------
+//! Points below this fraction of the peak are excluded from the point error
+//----------------------------------------------------------
+#define SWEEP_RELATIVE_FLOOR            (1.0E-6)
+
+//----------------------------------------------------------
+//! Lanes filled by the batch kernel (the widest vector, AVX-512)
+//----------------------------------------------------------
+#define PRECISION_BATCH_LANES           (8)
+
+
+
+//==============================================================================
+// File Scope Function Prototype
+//==============================================================================
+static F64 evaluateKernel(const S32 mode, const S32 precision, const S32 kernel, const ICS_JONES_TABLE *table,
+                          const F64 efin, const F64 einit, const F64 gamma);
+static const CHAR *getModeName(const S32 mode);
+static const CHAR *getPrecisionName(const S32 precision);
+static const CHAR *getKernelName(const S32 precision, const S32 kernel);
+
+
+
+
+
+//******************************************************************************
+//! \breif      Measure the error of a kernel precision against quad precision
+//! \remark     For every (gamma, einit) of the sweep, efin runs over the whole
+//!             kinematic range on a log grid. The point error ignores values
+//!             below SWEEP_RELATIVE_FLOOR of the peak of that sweep, where
+//!             only the exact position of the kinematic edge matters.
+//!             The reference is the unprepared quad precision kernel.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  mode      : USE_JONES_APPROX or USE_THOMSON_APPROX
+//! \param[in]  precision : ICS_PRECISION_xxx (ICS_PRECISION_TABLE : Jones only)
+//! \param[in]  kernel    : ICS_PRECISION_KERNEL_xxx (only ICS_PRECISION_F64
+//!                         has a prepared or batch kernel)
+//! \param[in]  table     : Jones kernel table of ICS_PRECISION_TABLE (NULL otherwise)
+//! \param[out] error     : Measured error
+//! \return     TRUE on success, FALSE if the kernel does not exist or the
+//!             work arrays cannot be allocated
+//******************************************************************************
+BOOL IcsPrecision_Measure(const S32 mode, const S32 precision, const S32 kernel, const ICS_JONES_TABLE *table, ICS_PRECISION_ERROR *error)
+{
+    S32 n_gamma, n_einit, n_efin_max, ig, ie, k, n_efin;
+    F64 gamma, einit, log_lower, log_upper, efin, peak, rel;
+    F64 sum_ref, sum_val, point_error, integrated_error, worst_efin, worst_einit;
+    F64 *reference, *value;
+    U64 evaluations;
+    S32 n_failed = 0;
+
+    error->MaxPointError = 0.0;
+    error->MaxIntegratedError = 0.0;
+    error->Efin = error->Einit = error->Gamma = 0.0;
+    error->Evaluations = 0;
+
+    if (((precision == ICS_PRECISION_TABLE) && ((mode != USE_JONES_APPROX) || (table == NULL))) ||
+        ((kernel != ICS_PRECISION_KERNEL_ISO) && (precision != ICS_PRECISION_F64)) ||
+        ((kernel == ICS_PRECISION_KERNEL_BATCH) && (mode != USE_JONES_APPROX))) {
+        return FALSE;
+    }
+
+    n_gamma = (S32)((SWEEP_LOG_GAMMA_UPPER - SWEEP_LOG_GAMMA_LOWER) / SWEEP_LOG_GAMMA_STEP + 0.5) + 1;
+    n_einit = (S32)((SWEEP_LOG_EINIT_UPPER - SWEEP_LOG_EINIT_LOWER) / SWEEP_LOG_EINIT_STEP + 0.5) + 1;
+    n_efin_max = (S32)((2.0 * (log10(4.0) + 2.0 * SWEEP_LOG_GAMMA_UPPER) + 0.2) / SWEEP_LOG_EFIN_STEP) + 2;
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, 1) reduction(+:n_failed) \
+        private(ie, k, n_efin, gamma, einit, log_lower, log_upper, efin, peak, rel, \
+                sum_ref, sum_val, point_error, integrated_error, worst_efin, worst_einit, reference, value, evaluations)
+#endif
+    for (ig = 0; ig < n_gamma; ig++) {
+        reference = (F64 *)malloc(sizeof(F64) * n_efin_max);
+        value = (F64 *)malloc(sizeof(F64) * n_efin_max);
+        if ((reference == NULL) || (value == NULL)) {
+            free(reference);
+            free(value);
+            n_failed++;
+            continue;
+        }
+
+        gamma = pow(10.0, SWEEP_LOG_GAMMA_LOWER + SWEEP_LOG_GAMMA_STEP * (F64)ig);
+        point_error = integrated_error = 0.0;
+        worst_efin = worst_einit = 0.0;
+        evaluations = 0;
+
+        for (ie = 0; ie < n_einit; ie++) {
+            einit = pow(10.0, SWEEP_LOG_EINIT_LOWER + SWEEP_LOG_EINIT_STEP * (F64)ie);
+            log_lower = log10(einit / (4.0 * gamma * gamma)) - 0.1;
+            log_upper = log10(4.0 * gamma * gamma * einit) + 0.1;
+            n_efin = (S32)((log_upper - log_lower) / SWEEP_LOG_EFIN_STEP) + 1;
+            if (n_efin > n_efin_max) {
+                n_efin = n_efin_max;
+            }
+
+            peak = sum_ref = sum_val = 0.0;
+            for (k = 0; k < n_efin; k++) {
+                efin = pow(10.0, log_lower + SWEEP_LOG_EFIN_STEP * (F64)k);
+                reference[k] = evaluateKernel(mode, ICS_PRECISION_F128, ICS_PRECISION_KERNEL_ISO, NULL, efin, einit, gamma);
+                value[k] = evaluateKernel(mode, precision, kernel, table, efin, einit, gamma);
+                peak = fmax(peak, fabs(reference[k]));
+                sum_ref += reference[k] * efin;
+                sum_val += value[k] * efin;
+            }
+            evaluations += (U64)n_efin;
+
+            for (k = 0; k < n_efin; k++) {
+                if (fabs(reference[k]) > SWEEP_RELATIVE_FLOOR * peak) {
+                    rel = fabs(value[k] - reference[k]) / fabs(reference[k]);
+                    if (rel > point_error) {
+                        point_error = rel;
+                        worst_efin = pow(10.0, log_lower + SWEEP_LOG_EFIN_STEP * (F64)k);
+                        worst_einit = einit;
+                    }
+                }
+            }
+
+            if (sum_ref != 0.0) {
+                integrated_error = fmax(integrated_error, fabs(sum_val - sum_ref) / fabs(sum_ref));
+            }
+        }
+
+#ifdef _OPENMP
+        #pragma omp critical (ics_precision_error)
+#endif
+        {
+            error->Evaluations += evaluations;
+            error->MaxIntegratedError = fmax(error->MaxIntegratedError, integrated_error);
+            if (point_error > error->MaxPointError) {
+                error->MaxPointError = point_error;
+                error->Efin = worst_efin;
+                error->Einit = worst_einit;
+                error->Gamma = gamma;
+            }
+        }
+
+        free(reference);
+        free(value);
+    }
+
+    return (n_failed == 0) ? TRUE : FALSE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Measure and print the error of every kernel precision
+//! \remark     Every kernel the engine runs is measured : the unprepared
+//!             kernels (F32 and the adaptive rule), the prepared kernels
+//!             (default F64 grid), the batch evaluator (F64 grid where the CPU
+//!             has AVX2 or AVX-512) and the Chebyshev table of -P table, which
+//!             is built here with JONES_TABLE_TOLERANCE.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  fp : Output stream
+//! \return     None
+//******************************************************************************
+void IcsPrecision_Report(FILE *fp)
+{
+    static const S32 cases[][3] = {
+        { USE_JONES_APPROX,   ICS_PRECISION_F32,   ICS_PRECISION_KERNEL_ISO      },
+        { USE_JONES_APPROX,   ICS_PRECISION_F64,   ICS_PRECISION_KERNEL_ISO      },
+        { USE_JONES_APPROX,   ICS_PRECISION_F64,   ICS_PRECISION_KERNEL_PREPARED },
+        { USE_JONES_APPROX,   ICS_PRECISION_F64,   ICS_PRECISION_KERNEL_BATCH    },
+        { USE_JONES_APPROX,   ICS_PRECISION_TABLE, ICS_PRECISION_KERNEL_ISO      },
+        { USE_THOMSON_APPROX, ICS_PRECISION_F32,   ICS_PRECISION_KERNEL_ISO      },
+        { USE_THOMSON_APPROX, ICS_PRECISION_F64,   ICS_PRECISION_KERNEL_ISO      },
+        { USE_THOMSON_APPROX, ICS_PRECISION_F64,   ICS_PRECISION_KERNEL_PREPARED },
+    };
+    ICS_PRECISION_ERROR error;
+    ICS_JONES_TABLE table;
+    BOOL has_table;
+    U32 c;
+
+    has_table = IcsJonesTable_Build(&table, JONES_TABLE_TOLERANCE);
+
+    fprintf(fp, "Kernel precision against quad precision\n");
+    fprintf(fp, "  gamma 1E+%.0f..1E+%.0f, einit 1E%.0f..1E%.0f eV, efin over the kinematic range\n",
+            SWEEP_LOG_GAMMA_LOWER, SWEEP_LOG_GAMMA_UPPER, SWEEP_LOG_EINIT_LOWER, SWEEP_LOG_EINIT_UPPER);
+    fprintf(fp, "  point error ignores values below %.0E of the peak\n\n", SWEEP_RELATIVE_FLOOR);
+    fprintf(fp, "  %-8s %-6s %-16s %-12s %-12s %s\n", "Mode", "Prec", "Kernel", "Point", "Integrated", "Worst (efin, einit, gamma)");
+
+    for (c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        fprintf(fp, "  %-8s %-6s %-16s ", getModeName(cases[c][0]), getPrecisionName(cases[c][1]), getKernelName(cases[c][1], cases[c][2]));
+        if ((cases[c][1] == ICS_PRECISION_TABLE) && (has_table == FALSE)) {
+            fprintf(fp, "[ERROR] Failed to build the Jones kernel table.\n");
+            continue;
+        }
+        if (IcsPrecision_Measure(cases[c][0], cases[c][1], cases[c][2], (has_table == TRUE) ? &table : NULL, &error) == FALSE) {
+            fprintf(fp, "[ERROR] Failed to allocate the work arrays.\n");
+            continue;
+        }
+        fprintf(fp, "%.4E   %.4E   (%.3E, %.3E, %.3E)\n",
+                error.MaxPointError, error.MaxIntegratedError, error.Efin, error.Einit, error.Gamma);
+    }
+    fprintf(fp, "\n");
+
+    if (has_table == TRUE) {
+        IcsJonesTable_Release(&table);
+    }
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Evaluate a kernel in the requested precision
+//! \remark     The prepared and table kernels prepare their factors on every
+//!             call. The batch kernel fills every lane with the same point, so
+//!             the vector path is the one measured.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  mode      : USE_JONES_APPROX or USE_THOMSON_APPROX
+//! \param[in]  precision : ICS_PRECISION_xxx
+//! \param[in]  kernel    : ICS_PRECISION_KERNEL_xxx
+//! \param[in]  table     : Jones kernel table of ICS_PRECISION_TABLE
+//! \param[in]  efin      : Scattered Photon Energy [eV]
+//! \param[in]  einit     : Incident Photon Energy [eV]
+//! \param[in]  gamma     : Electron Lorentz Factor
+//! \return     ICS flux
+//******************************************************************************
+static F64 evaluateKernel(const S32 mode, const S32 precision, const S32 kernel, const ICS_JONES_TABLE *table,
+                          const F64 efin, const F64 einit, const F64 gamma)
+{
+    ICS_JONES_EINIT jones_einit;
+    ICS_JONES_GAMMA jones_gamma;
+    ICS_THOMSON_EINIT_F64 thomson_einit;
+    ICS_THOMSON_GAMMA_F64 thomson_gamma;
+    F64 lanes_gamma[PRECISION_BATCH_LANES], lanes_flux[PRECISION_BATCH_LANES];
+    U32 j;
+
+    if (mode == USE_JONES_APPROX) {
+        switch (precision) {
+        case ICS_PRECISION_F32:
+            return (F64)IcsJones_CalcFluxIsoF32((F32)efin, (F32)einit, (F32)gamma);
+        case ICS_PRECISION_F128:
+            return (F64)IcsJones_CalcFluxIsoF128((F128)efin, (F128)einit, (F128)gamma);
+        case ICS_PRECISION_TABLE:
+            IcsJones_PrepareEinit(&jones_einit, einit);
+            IcsJones_PrepareGamma(&jones_gamma, gamma);
+            return IcsJonesTable_CalcFlux(table, efin, &jones_einit, &jones_gamma);
+        default:
+            break;
+        }
+        if (kernel == ICS_PRECISION_KERNEL_PREPARED) {
+            IcsJones_PrepareEinit(&jones_einit, einit);
+            IcsJones_PrepareGamma(&jones_gamma, gamma);
+            return IcsJones_CalcFluxPrepared(efin, &jones_einit, &jones_gamma);
+        }
+        if (kernel == ICS_PRECISION_KERNEL_BATCH) {
+            for (j = 0; j < PRECISION_BATCH_LANES; j++) {
+                lanes_gamma[j] = gamma;
+            }
+            IcsJonesBatch_CalcFluxIsoGamma(efin, einit, lanes_gamma, PRECISION_BATCH_LANES, lanes_flux);
+            return lanes_flux[0];
+        }
+        return IcsJones_CalcFluxIso(efin, einit, gamma);
+    }
+    else {
+        switch (precision) {
+        case ICS_PRECISION_F32:
+            return (F64)IcsThomson_CalcFluxIsoF32((F32)efin, (F32)einit, (F32)gamma);
+        case ICS_PRECISION_F128:
+            return (F64)IcsThomson_CalcFluxIso((F128)efin, (F128)einit, (F128)gamma);
+        default:
+            break;
+        }
+        if (kernel == ICS_PRECISION_KERNEL_PREPARED) {
+            IcsThomson_PrepareEinitF64(&thomson_einit, einit);
+            IcsThomson_PrepareGammaF64(&thomson_gamma, gamma);
+            return IcsThomson_CalcFluxPreparedF64(efin, &thomson_einit, &thomson_gamma);
+        }
+        return IcsThomson_CalcFluxIsoF64(efin, einit, gamma);
+    }
+}
+
+
+
+//******************************************************************************
+//! \breif      Get the display name of a mode
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  mode : USE_JONES_APPROX or USE_THOMSON_APPROX
+//! \return     Mode name
+//******************************************************************************
+static const CHAR *getModeName(const S32 mode)
+{
+    return (mode == USE_JONES_APPROX) ? "Jones" : "Thomson";
+}
+
+
+
+//******************************************************************************
+//! \breif      Get the display name of a precision
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  precision : ICS_PRECISION_xxx
+//! \return     Precision name
+//******************************************************************************
+static const CHAR *getPrecisionName(const S32 precision)
+{
+    switch (precision) {
+    case ICS_PRECISION_F32:
+        return "F32";
+    case ICS_PRECISION_F128:
+        return "F128";
+    case ICS_PRECISION_TABLE:
+        return "table";
+    default:
+        return "F64";
+    }
+}
+
+
+
+//******************************************************************************
+//! \breif      Get the display name of a kernel
+//! \remark     The batch kernel is named after the instruction set it runs on.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  precision : ICS_PRECISION_xxx
+//! \param[in]  kernel    : ICS_PRECISION_KERNEL_xxx
+//! \return     Kernel name
+//******************************************************************************
+static const CHAR *getKernelName(const S32 precision, const S32 kernel)
+{
+    if (precision == ICS_PRECISION_TABLE) {
+        return "Chebyshev table";
+    }
+
+    switch (kernel) {
+    case ICS_PRECISION_KERNEL_PREPARED:
+        return "prepared";
+    case ICS_PRECISION_KERNEL_BATCH:
+        switch (IcsJonesBatch_GetIsa()) {
+        case ICS_JONES_BATCH_ISA_AVX512:
+            return "batch (AVX-512)";
+        case ICS_JONES_BATCH_ISA_AVX2:
+            return "batch (AVX2)";
+        default:
+            return "batch (scalar)";
+        }
+    default:
+        return "unprepared";
+    }
+}
+
+
+
+
+
+//******************************************************************************
+// End of File
+//******************************************************************************
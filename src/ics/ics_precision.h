@@ -0,0 +1,99 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#ifndef ICS_PRECISION_H_
+#define ICS_PRECISION_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include <stdio.h>
+#include "common_typedef.h"
+#include "ics_jones_table.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+#define ICS_PRECISION_KERNEL_ISO        (0)     //!< Unprepared kernel (IcsXxx_CalcFluxIso)
+#define ICS_PRECISION_KERNEL_PREPARED   (1)     //!< Kernel from prepared gamma and einit factors
+#define ICS_PRECISION_KERNEL_BATCH      (2)     //!< Jones : batch evaluator (IcsJonesBatch)
+
+
+
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! Error of a kernel precision against the quad precision reference
+//----------------------------------------------------------
+typedef struct ics_precision_error_t {
+    F64         MaxPointError;          //!< Max relative error where the reference exceeds the floor
+    F64         MaxIntegratedError;     //!< Max relative error of the efin-integrated kernel
+    F64         Efin;                   //!< Scattered photon energy of MaxPointError [eV]
+    F64         Einit;                  //!< Incident photon energy of MaxPointError [eV]
+    F64         Gamma;                  //!< Lorentz factor of MaxPointError
+    U64         Evaluations;            //!< Number of compared kernel evaluations
+}ICS_PRECISION_ERROR;
+
+
+
+//==============================================================================
+// Export Scope Function Prototype
+//==============================================================================
+/**
+ * @brief           Measure the error of a kernel precision against quad precision
+ * 
+ * @param mode      USE_JONES_APPROX or USE_THOMSON_APPROX
+ * @param precision ICS_PRECISION_xxx (ICS_PRECISION_TABLE : Jones only)
+ * @param kernel    ICS_PRECISION_KERNEL_xxx (prepared and batch : ICS_PRECISION_F64 only)
+ * @param table     Jones kernel table of ICS_PRECISION_TABLE (NULL otherwise)
+ * @param error     Measured error
+ * @return BOOL     TRUE on success, FALSE if the kernel does not exist or the work arrays cannot be allocated
+ */
+extern BOOL IcsPrecision_Measure(const S32 mode, const S32 precision, const S32 kernel, const ICS_JONES_TABLE *table, ICS_PRECISION_ERROR *error);
+
+/**
+ * @brief           Measure and print the error of every kernel precision
+ * 
+ * @param fp        Output stream
+ */
+extern void IcsPrecision_Report(FILE *fp);
+
+
+
+#ifdef _cplusplus
+}
+#endif
+
+#endif
+
+//******************************************************************************
+// End of File
+//******************************************************************************
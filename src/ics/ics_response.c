@@ -0,0 +1,501 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#define ICS_RESPONSE_C_
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "particles_cmb.h"
+#include "particles_electron.h"
+#include "ics_response.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+#define RESPONSE_SECTION_EFIN           (0)
+#define RESPONSE_SECTION_GAMMA          (1)
+#define RESPONSE_SECTION_MATRIX         (2)
+#define RESPONSE_SECTION_COUNT          (3)
+#define RESPONSE_MATCH_TOLERANCE        (1.0E-9)
+#define RESPONSE_MAX_GAMMA_RATIO        (10.0)          //!< Largest built / requested gamma upper bound of a reused matrix
+
+
+
+//==============================================================================
+// File Scope Function Prototype
+//==============================================================================
+static BOOL allocateResponse(ICS_RESPONSE *response, const U32 efin_count, const U32 gamma_count);
+static BOOL isSameValue(const F64 a, const F64 b);
+static F64 getTableTolerance(const ICS_CMB_SPECTRUM *spectrum);
+static void clearResponse(ICS_RESPONSE *response);
+
+
+
+
+
+//******************************************************************************
+//! \breif      Build the response matrix from an ICS spectrum
+//! \remark     Matrix[k][j] = w[j] * sum_i n_CMB(einit[i]) w[i] K(efin[k], einit[i], gamma[j])
+//!             so that the flux of any electron spectrum is a matrix-vector
+//!             product with the electron flux on the gamma nodes.
+//! 
+//! \callgraph  
+//! 
+//! \param[out] response   : Response matrix to be built
+//! \param[in]  spectrum   : ICS spectrum providing the grids and the CMB density
+//! \param[in]  efin       : Scattered photon energies [eV]
+//! \param[in]  efin_count : Number of scattered photon energies
+//! \return     TRUE on success, FALSE if the arrays cannot be allocated
+//******************************************************************************
+BOOL IcsResponse_Build(ICS_RESPONSE *response, const ICS_CMB_SPECTRUM *spectrum, const F64 *efin, const U32 efin_count)
+{
+    S32 k;
+    U32 j, n_gamma;
+    F64 *row;
+    S32 n_failed = 0;
+
+    n_gamma = spectrum->Gamma.Count;
+
+    if (allocateResponse(response, efin_count, n_gamma) == FALSE) {
+        return FALSE;
+    }
+
+    response->Mode = spectrum->Mode;
+    response->Precision = spectrum->Precision;
+    response->ThomsonLimit = spectrum->ThomsonLimit;
+    response->TableTolerance = getTableTolerance(spectrum);
+    response->CmbTemperature = PatriclesCmb_GetTemperature();
+    response->EinitRange = spectrum->EinitRange;
+    response->GammaRange = spectrum->GammaRange;
+    memcpy(response->Efin, efin, sizeof(F64) * efin_count);
+    memcpy(response->Gamma, spectrum->Gamma.Node, sizeof(F64) * n_gamma);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, 1) private(j, row) reduction(+:n_failed)
+#endif
+    for (k = 0; k < (S32)efin_count; k++) {
+        row = &response->Matrix[(size_t)k * n_gamma];
+        if (IcsCmbSpectrum_CalcKernelRow(spectrum, efin[k], row) == FALSE) {
+            n_failed++;
+        }
+
+        for (j = 0; j < n_gamma; j++) {
+            row[j] *= spectrum->Gamma.Weight[j];
+        }
+    }
+
+    if (n_failed > 0) {
+        IcsResponse_Release(response);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check whether a response matrix can serve a calculation
+//! \remark     The gamma grid has to reach the requested upper bound, and
+//!             may exceed it by at most RESPONSE_MAX_GAMMA_RATIO. The node
+//!             count has to match, so a much higher ceiling would leave only
+//!             a few nodes below the cutoff and an unbounded error.
+//!             ICS_PRECISION_TABLE also needs a table of the same tolerance.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  response    : Response matrix
+//! \param[in]  spectrum    : ICS spectrum the calculation would build the matrix from
+//! \param[in]  efin        : Scattered photon energies [eV]
+//! \param[in]  efin_count  : Number of scattered photon energies
+//! \return     TRUE if the response matrix covers the calculation
+//******************************************************************************
+BOOL IcsResponse_IsCompatible(const ICS_RESPONSE *response, const ICS_CMB_SPECTRUM *spectrum, const F64 *efin, const U32 efin_count)
+{
+    U32 k;
+    const INTEGRATION_RANGE *einit_range = &spectrum->EinitRange;
+    const INTEGRATION_RANGE *gamma_range = &spectrum->GammaRange;
+
+    if ((response->Mode != spectrum->Mode) || (response->Precision != spectrum->Precision) || (response->EfinCount != efin_count) ||
+        (response->ThomsonLimit != spectrum->ThomsonLimit) || (response->TableTolerance != getTableTolerance(spectrum)) ||
+        (isSameValue(response->CmbTemperature, PatriclesCmb_GetTemperature()) == FALSE)) {
+        return FALSE;
+    }
+
+    if ((isSameValue(response->EinitRange.Lower, einit_range->Lower) == FALSE) ||
+        (isSameValue(response->EinitRange.Upper, einit_range->Upper) == FALSE) ||
+        (response->EinitRange.Iteration != einit_range->Iteration)) {
+        return FALSE;
+    }
+
+    if ((isSameValue(response->GammaRange.Lower, gamma_range->Lower) == FALSE) ||
+        (response->GammaRange.Iteration != gamma_range->Iteration) ||
+        (response->GammaRange.Upper < gamma_range->Upper * (1.0 - RESPONSE_MATCH_TOLERANCE)) ||
+        (response->GammaRange.Upper > gamma_range->Upper * RESPONSE_MAX_GAMMA_RATIO * (1.0 + RESPONSE_MATCH_TOLERANCE))) {
+        return FALSE;
+    }
+
+    for (k = 0; k < efin_count; k++) {
+        if (isSameValue(response->Efin[k], efin[k]) == FALSE) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Calculates the ICS flux for an electron spectrum
+//! \remark     One electron spectrum evaluation per gamma node followed by a
+//!             dense matrix-vector product.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  response  : Response matrix
+//! \param[in]  norm      : Normalization Factor
+//! \param[in]  power     : Power
+//! \param[in]  gamma_max : Maximum Lorentz Factor (Cut-off)
+//! \param[out] flux      : ICS flux for each scattered photon energy [EfinCount]
+//! \return     TRUE on success, FALSE if the work array cannot be allocated
+//******************************************************************************
+BOOL IcsResponse_CalcFlux(const ICS_RESPONSE *response, const F64 norm, const F64 power, const F64 gamma_max, F64 *flux)
+{
+    register U32 j, k;
+    register F64 sum;
+    const F64 *row;
+    F64 *electron;
+
+    if ((electron = (F64 *)malloc(sizeof(F64) * response->GammaCount)) == NULL) {
+        return FALSE;
+    }
+
+    for (j = 0; j < response->GammaCount; j++) {
+        electron[j] = ParticlesElectron_CalcFlux(response->Gamma[j], norm, power, gamma_max);
+    }
+
+    for (k = 0; k < response->EfinCount; k++) {
+        row = &response->Matrix[(size_t)k * response->GammaCount];
+
+        for (sum = 0.0, j = 0; j < response->GammaCount; j++) {
+            sum += row[j] * electron[j];
+        }
+        flux[k] = sum;
+    }
+
+    free(electron);
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Calculates the ICS flux and its parameter derivatives
+//! \remark     The electron spectrum and its three derivatives are evaluated
+//!             once per gamma node, then every matrix row is contracted with
+//!             all four vectors in the same pass. This replaces the 2 x 3
+//!             flux evaluations of central finite differences.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  response  : Response matrix
+//! \param[in]  norm      : Normalization Factor
+//! \param[in]  power     : Power
+//! \param[in]  gamma_max : Maximum Lorentz Factor (Cut-off)
+//! \param[out] flux      : ICS flux for each scattered photon energy [EfinCount]
+//! \param[out] jacobian  : d flux / d (norm, power, gamma_max) [EfinCount][3]
+//! \return     TRUE on success, FALSE if the work array cannot be allocated
+//******************************************************************************
+BOOL IcsResponse_CalcFluxJacobian(const ICS_RESPONSE *response, const F64 norm, const F64 power, const F64 gamma_max, F64 *flux, F64 *jacobian)
+{
+    register U32 j, k;
+    register F64 sum, sum_norm, sum_power, sum_gamma_max;
+    const F64 *row;
+    F64 *electron;
+
+    // [GammaCount][4] : flux, d/dnorm, d/dpower, d/dgamma_max
+    if ((electron = (F64 *)malloc(sizeof(F64) * 4 * response->GammaCount)) == NULL) {
+        return FALSE;
+    }
+
+    for (j = 0; j < response->GammaCount; j++) {
+        electron[4 * j] = ParticlesElectron_CalcFluxGradient(response->Gamma[j], norm, power, gamma_max, &electron[4 * j + 1]);
+    }
+
+    for (k = 0; k < response->EfinCount; k++) {
+        row = &response->Matrix[(size_t)k * response->GammaCount];
+
+        sum = sum_norm = sum_power = sum_gamma_max = 0.0;
+        for (j = 0; j < response->GammaCount; j++) {
+            sum += row[j] * electron[4 * j];
+            sum_norm += row[j] * electron[4 * j + 1];
+            sum_power += row[j] * electron[4 * j + 2];
+            sum_gamma_max += row[j] * electron[4 * j + 3];
+        }
+        flux[k] = sum;
+        jacobian[3 * k] = sum_norm;
+        jacobian[3 * k + 1] = sum_power;
+        jacobian[3 * k + 2] = sum_gamma_max;
+    }
+
+    free(electron);
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Save the response matrix to a table file
+//! \remark     Payloads : scattered photon energies, gamma nodes, matrix.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  response  : Response matrix
+//! \param[in]  file_name : File name
+//! \return     TRUE on success
+//******************************************************************************
+BOOL IcsResponse_Save(const ICS_RESPONSE *response, const CHAR *file_name)
+{
+    IO_TABLE_HEADER header;
+    const F64 *sections[RESPONSE_SECTION_COUNT];
+
+    IoTable_InitHeader(&header, IO_TABLE_KIND_KERNEL);
+    header.Mode = response->Mode;
+    header.Precision = response->Precision;
+    header.ThomsonLimit = response->ThomsonLimit;
+    header.TableTolerance = response->TableTolerance;
+    header.CmbTemperature = response->CmbTemperature;
+    header.EinitLower = response->EinitRange.Lower;
+    header.EinitUpper = response->EinitRange.Upper;
+    header.EinitIteration = response->EinitRange.Iteration;
+    header.GammaLower = response->GammaRange.Lower;
+    header.GammaUpper = response->GammaRange.Upper;
+    header.GammaIteration = response->GammaRange.Iteration;
+    header.EfinCount = response->EfinCount;
+    header.EfinLower = (response->EfinCount > 0) ? response->Efin[0] : 0.0;
+    header.EfinUpper = (response->EfinCount > 0) ? response->Efin[response->EfinCount - 1] : 0.0;
+
+    header.SectionCount = RESPONSE_SECTION_COUNT;
+    header.Section[RESPONSE_SECTION_EFIN].Count = response->EfinCount;
+    header.Section[RESPONSE_SECTION_GAMMA].Count = response->GammaCount;
+    header.Section[RESPONSE_SECTION_MATRIX].Count = (U64)response->EfinCount * response->GammaCount;
+    sections[RESPONSE_SECTION_EFIN] = response->Efin;
+    sections[RESPONSE_SECTION_GAMMA] = response->Gamma;
+    sections[RESPONSE_SECTION_MATRIX] = response->Matrix;
+
+    return IoTable_Write(file_name, &header, sections);
+}
+
+
+
+//******************************************************************************
+//! \breif      Load the response matrix from a table file by mapping it
+//! \remark     The arrays point into the mapped file and must not be written.
+//! 
+//! \callgraph  
+//! 
+//! \param[out] response  : Response matrix to be loaded
+//! \param[in]  file_name : File name
+//! \return     TRUE on success, FALSE if the file is missing or invalid
+//******************************************************************************
+BOOL IcsResponse_Load(ICS_RESPONSE *response, const CHAR *file_name)
+{
+    const IO_TABLE_HEADER *header;
+
+    clearResponse(response);
+
+    if (IoTable_Open(&response->Table, file_name) == FALSE) {
+        return FALSE;
+    }
+
+    header = response->Table.Header;
+
+    if ((header->Kind != IO_TABLE_KIND_KERNEL) ||
+        (header->SectionCount != RESPONSE_SECTION_COUNT) ||
+        (header->Section[RESPONSE_SECTION_EFIN].Count != header->EfinCount) ||
+        (header->Section[RESPONSE_SECTION_GAMMA].Count != (U64)header->GammaIteration + 1) ||
+        (header->Section[RESPONSE_SECTION_MATRIX].Count != header->Section[RESPONSE_SECTION_EFIN].Count * header->Section[RESPONSE_SECTION_GAMMA].Count)) {
+        IcsResponse_Release(response);
+        return FALSE;
+    }
+
+    response->Mode = header->Mode;
+    response->Precision = (header->Precision != 0) ? header->Precision : ICS_PRECISION_F64;
+    response->ThomsonLimit = header->ThomsonLimit;
+    response->TableTolerance = header->TableTolerance;
+    response->CmbTemperature = header->CmbTemperature;
+    response->EinitRange.Lower = header->EinitLower;
+    response->EinitRange.Upper = header->EinitUpper;
+    response->EinitRange.Iteration = header->EinitIteration;
+    response->GammaRange.Lower = header->GammaLower;
+    response->GammaRange.Upper = header->GammaUpper;
+    response->GammaRange.Iteration = header->GammaIteration;
+    response->EfinCount = header->EfinCount;
+    response->GammaCount = (U32)header->Section[RESPONSE_SECTION_GAMMA].Count;
+    response->Efin = (F64 *)IoTable_GetSection(&response->Table, RESPONSE_SECTION_EFIN);
+    response->Gamma = (F64 *)IoTable_GetSection(&response->Table, RESPONSE_SECTION_GAMMA);
+    response->Matrix = (F64 *)IoTable_GetSection(&response->Table, RESPONSE_SECTION_MATRIX);
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Release the arrays owned by a response matrix
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  response : Response matrix
+//! \return     None
+//******************************************************************************
+void IcsResponse_Release(ICS_RESPONSE *response)
+{
+    if (response->Table.Image != NULL) {
+        IoTable_Close(&response->Table);
+    }
+    else {
+        free(response->Efin);
+        free(response->Gamma);
+        free(response->Matrix);
+    }
+
+    clearResponse(response);
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Allocate the arrays of a response matrix
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[out] response    : Response matrix
+//! \param[in]  efin_count  : Number of scattered photon energies
+//! \param[in]  gamma_count : Number of gamma nodes
+//! \return     TRUE on success, FALSE if the arrays cannot be allocated
+//******************************************************************************
+static BOOL allocateResponse(ICS_RESPONSE *response, const U32 efin_count, const U32 gamma_count)
+{
+    clearResponse(response);
+    response->EfinCount  = efin_count;
+    response->GammaCount = gamma_count;
+    response->Efin   = (F64 *)malloc(sizeof(F64) * ((efin_count > 0) ? efin_count : 1));
+    response->Gamma  = (F64 *)malloc(sizeof(F64) * ((gamma_count > 0) ? gamma_count : 1));
+    response->Matrix = (F64 *)malloc(sizeof(F64) * (((size_t)efin_count * gamma_count > 0) ? (size_t)efin_count * gamma_count : 1));
+
+    if ((response->Efin == NULL) || (response->Gamma == NULL) || (response->Matrix == NULL)) {
+        IcsResponse_Release(response);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Compare two values within the matching tolerance
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  a : Value
+//! \param[in]  b : Value
+//! \return     TRUE if the relative difference is within the tolerance
+//******************************************************************************
+static BOOL isSameValue(const F64 a, const F64 b)
+{
+    return (fabs(a - b) <= RESPONSE_MATCH_TOLERANCE * fmax(fabs(a), fabs(b))) ? TRUE : FALSE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Tolerance of the Jones kernel table a spectrum evaluates from
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  spectrum : ICS spectrum
+//! \return     Requested maximum relative error of the table, 0 unless
+//!             ICS_PRECISION_TABLE
+//******************************************************************************
+static F64 getTableTolerance(const ICS_CMB_SPECTRUM *spectrum)
+{
+    if ((spectrum->Precision != ICS_PRECISION_TABLE) || (spectrum->JonesTable == NULL)) {
+        return 0.0;
+    }
+
+    return spectrum->JonesTable->Tolerance;
+}
+
+
+
+
+
+//******************************************************************************
+//! \breif      Reset a response matrix to the empty state
+//! \remark     Does not release anything.
+//! 
+//! \callgraph  
+//! 
+//! \param[out] response : Response matrix
+//! \return     None
+//******************************************************************************
+static void clearResponse(ICS_RESPONSE *response)
+{
+    response->Efin = NULL;
+    response->Gamma = NULL;
+    response->Matrix = NULL;
+    response->EfinCount = 0;
+    response->GammaCount = 0;
+    response->Table.Header = NULL;
+    response->Table.Image = NULL;
+    response->Table.Size = 0;
+    response->Table.Mapped = FALSE;
+
+    return;
+}
+
+
+
+
+
+//******************************************************************************
+// End of File
+//******************************************************************************
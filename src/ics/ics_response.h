@@ -0,0 +1,151 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#ifndef ICS_RESPONSE_H_
+#define ICS_RESPONSE_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include "common_typedef.h"
+#include "numerics_integration.h"
+#include "io_table.h"
+#include "ics_cmb_spectrum.h"
+
+
+
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! CMB-integrated ICS response matrix
+//----------------------------------------------------------
+typedef struct ics_response_t {
+    S32             Mode;               //!< Jones approximation or Thomson approximation
+    S32             Precision;          //!< ICS_PRECISION_xxx used to build the matrix
+    F64             ThomsonLimit;       //!< Thomson limit threshold used to build the matrix (0 : never)
+    F64             TableTolerance;     //!< Tolerance of the Jones kernel table of ICS_PRECISION_TABLE (0 : no table)
+    F64             CmbTemperature;     //!< CMB Temperature [K]
+    INTEGRATION_RANGE EinitRange;       //!< Integration Range of incident photon energy [eV]
+    INTEGRATION_RANGE GammaRange;       //!< Integration Range of Lorentz factor
+    U32             EfinCount;          //!< Number of scattered photon energies
+    U32             GammaCount;         //!< Number of gamma nodes
+    F64             *Efin;              //!< Scattered photon energies [eV] [EfinCount]
+    F64             *Gamma;             //!< Lorentz factor nodes [GammaCount]
+    F64             *Matrix;            //!< Kernel times gamma weight [EfinCount][GammaCount]
+    IO_TABLE        Table;              //!< Mapped cache file (arrays are read-only when loaded)
+}ICS_RESPONSE;
+
+
+
+//==============================================================================
+// Export Scope Function Prototype
+//==============================================================================
+/**
+ * @brief               Build the response matrix from an ICS spectrum
+ * 
+ * @param response      Response matrix to be built
+ * @param spectrum      ICS spectrum providing the grids and the CMB density
+ * @param efin          Scattered photon energies [eV]
+ * @param efin_count    Number of scattered photon energies
+ * @return BOOL         TRUE on success, FALSE if the arrays cannot be allocated
+ */
+extern BOOL IcsResponse_Build(ICS_RESPONSE *response, const ICS_CMB_SPECTRUM *spectrum, const F64 *efin, const U32 efin_count);
+
+/**
+ * @brief               Check whether a response matrix can serve a calculation
+ * 
+ * @param response      Response matrix
+ * @param spectrum      ICS spectrum the calculation would build the matrix from
+ * @param efin          Scattered photon energies [eV]
+ * @param efin_count    Number of scattered photon energies
+ * @return BOOL         TRUE if the response matrix covers the calculation
+ */
+extern BOOL IcsResponse_IsCompatible(const ICS_RESPONSE *response, const ICS_CMB_SPECTRUM *spectrum, const F64 *efin, const U32 efin_count);
+
+/**
+ * @brief               Calculates the ICS flux for an electron spectrum
+ * 
+ * @param response      Response matrix
+ * @param norm          Normalization Factor
+ * @param power         Power
+ * @param gamma_max     Maximum Lorentz Factor (Cut-off)
+ * @param flux          ICS flux for each scattered photon energy [EfinCount]
+ * @return BOOL         TRUE on success, FALSE if the work array cannot be allocated
+ */
+extern BOOL IcsResponse_CalcFlux(const ICS_RESPONSE *response, const F64 norm, const F64 power, const F64 gamma_max, F64 *flux);
+
+/**
+ * @brief               Calculates the ICS flux and its parameter derivatives
+ * 
+ * @param response      Response matrix
+ * @param norm          Normalization Factor
+ * @param power         Power
+ * @param gamma_max     Maximum Lorentz Factor (Cut-off)
+ * @param flux          ICS flux for each scattered photon energy [EfinCount]
+ * @param jacobian      d flux / d (norm, power, gamma_max) [EfinCount][3]
+ * @return BOOL         TRUE on success, FALSE if the work array cannot be allocated
+ */
+extern BOOL IcsResponse_CalcFluxJacobian(const ICS_RESPONSE *response, const F64 norm, const F64 power, const F64 gamma_max, F64 *flux, F64 *jacobian);
+
+/**
+ * @brief               Save the response matrix to a table file
+ * 
+ * @param response      Response matrix
+ * @param file_name     File name
+ * @return BOOL         TRUE on success
+ */
+extern BOOL IcsResponse_Save(const ICS_RESPONSE *response, const CHAR *file_name);
+
+/**
+ * @brief               Load the response matrix from a table file by mapping it
+ * 
+ * @param response      Response matrix to be loaded
+ * @param file_name     File name
+ * @return BOOL         TRUE on success, FALSE if the file is missing or invalid
+ */
+extern BOOL IcsResponse_Load(ICS_RESPONSE *response, const CHAR *file_name);
+
+/**
+ * @brief               Release the arrays owned by a response matrix
+ * 
+ * @param response      Response matrix
+ */
+extern void IcsResponse_Release(ICS_RESPONSE *response);
+
+
+
+#ifdef _cplusplus
+}
+#endif
+
+#endif
+
+//******************************************************************************
+// End of File
+//******************************************************************************
@@ -0,0 +1,290 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#define ICS_SWEEP_C_
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include <stdlib.h>
+#include "ics_cmb_spectrum.h"
+#include "ics_sweep.h"
+
+
+
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! One emitted energy of one configuration
+//----------------------------------------------------------
+typedef struct ics_sweep_task_t {
+    U32             Config;             //!< Configuration index
+    U32             Point;              //!< Emitted energy index
+    U64             Cost;               //!< Kernel evaluations
+}ICS_SWEEP_TASK;
+
+
+
+//==============================================================================
+// File Scope Function Prototype
+//==============================================================================
+static U32 findGroup(const ICS_CMB_SPECTRUM *groups, const U32 n_groups, const ICS_SWEEP_CONFIG *config);
+static BOOL createGroup(ICS_CMB_SPECTRUM *group, const ICS_SWEEP_CONFIG *config, const ICS_SWEEP_GRID *grid);
+static S32 compareTasks(const void *lhs, const void *rhs);
+static void releaseWork(ICS_CMB_SPECTRUM *groups, const U32 n_groups, ICS_CMB_SPECTRUM *views, const U32 n_views, U32 *group_of, ICS_SWEEP_TASK *tasks);
+
+
+
+
+
+//******************************************************************************
+//! \breif      Calculates the ICS flux of every configuration of a sweep
+//! \remark     1) Configurations with the same mode and gamma range share one
+//!                set of grids and CMB density. Each configuration gets a
+//!                view of them with its own electron density vector.
+//!             2) The sweep is flattened into (configuration, emitted energy)
+//!                tasks. The exact cost of each task is the pruned number of
+//!                kernel evaluations, and the tasks are handed out longest
+//!                first under a dynamic schedule, so no thread is left with a
+//!                long task at the end.
+//!             3) Every task writes its own flux, so the result does not
+//!                depend on the number of threads.
+//! 
+//! \callgraph  
+//! 
+//! \param[in,out] configs   : Configurations (Flux and Cost are written)
+//! \param[in]  count       : Number of configurations
+//! \param[in]  grid        : einit rule and precision
+//! \param[out] evaluations : Kernel evaluations of the whole sweep
+//! \return     TRUE on success, FALSE if the arrays cannot be allocated
+//******************************************************************************
+BOOL IcsSweep_Run(ICS_SWEEP_CONFIG *configs, const U32 count, const ICS_SWEEP_GRID *grid, U64 *evaluations)
+{
+    ICS_CMB_SPECTRUM *groups, *views;
+    ICS_SWEEP_TASK *tasks;
+    U32 *group_of;
+    U32 i, k, n_groups, n_views;
+    U64 n_tasks, evaluated, total;
+    S64 t;
+
+    *evaluations = 0;
+
+    groups   = (ICS_CMB_SPECTRUM *)malloc(sizeof(ICS_CMB_SPECTRUM) * ((size_t)count + 1));
+    views    = (ICS_CMB_SPECTRUM *)malloc(sizeof(ICS_CMB_SPECTRUM) * ((size_t)count + 1));
+    group_of = (U32 *)malloc(sizeof(U32) * ((size_t)count + 1));
+    tasks    = NULL;
+    n_groups = 0;
+    n_views  = 0;
+
+    if ((groups == NULL) || (views == NULL) || (group_of == NULL)) {
+        releaseWork(groups, n_groups, views, n_views, group_of, tasks);
+        return FALSE;
+    }
+
+    //------------------------------------------------------
+    // Shared grids, and one electron density per configuration
+    //------------------------------------------------------
+    for (n_tasks = 0, i = 0; i < count; i++) {
+        if ((group_of[i] = findGroup(groups, n_groups, &configs[i])) == n_groups) {
+            if (createGroup(&groups[n_groups], &configs[i], grid) == FALSE) {
+                releaseWork(groups, n_groups, views, n_views, group_of, tasks);
+                return FALSE;
+            }
+            n_groups++;
+        }
+
+        views[i] = groups[group_of[i]];
+        if ((views[i].ElectronDensity = (F64 *)malloc(sizeof(F64) * views[i].Gamma.Count)) == NULL) {
+            releaseWork(groups, n_groups, views, n_views, group_of, tasks);
+            return FALSE;
+        }
+        n_views++;
+        IcsCmbSpectrum_SetElectron(&views[i], configs[i].Norm, configs[i].Power, configs[i].GammaMax);
+
+        n_tasks += configs[i].EfinCount;
+    }
+
+    //------------------------------------------------------
+    // Tasks, longest first
+    //------------------------------------------------------
+    if ((tasks = (ICS_SWEEP_TASK *)malloc(sizeof(ICS_SWEEP_TASK) * ((size_t)n_tasks + 1))) == NULL) {
+        releaseWork(groups, n_groups, views, n_views, group_of, tasks);
+        return FALSE;
+    }
+    for (t = 0, i = 0; i < count; i++) {
+        configs[i].Cost = 0;
+        for (k = 0; k < configs[i].EfinCount; k++, t++) {
+            IcsCmbSpectrum_CountEvaluations(&views[i], configs[i].Efin[k], &evaluated, &total);
+            tasks[t].Config = i;
+            tasks[t].Point = k;
+            tasks[t].Cost = evaluated;
+            configs[i].Cost += evaluated;
+        }
+        *evaluations += configs[i].Cost;
+    }
+    qsort(tasks, (size_t)n_tasks, sizeof(ICS_SWEEP_TASK), compareTasks);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (t = 0; t < (S64)n_tasks; t++) {
+        configs[tasks[t].Config].Flux[tasks[t].Point] =
+            IcsCmbSpectrum_CalcFlux((const ICS_CMB_SPECTRUM *)&views[tasks[t].Config], configs[tasks[t].Config].Efin[tasks[t].Point]);
+    }
+
+    releaseWork(groups, n_groups, views, n_views, group_of, tasks);
+
+    return TRUE;
+}
+
+
+
+
+
+//******************************************************************************
+//! \breif      Find the group whose grids serve a configuration
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  groups   : Groups created so far
+//! \param[in]  n_groups : Number of groups
+//! \param[in]  config   : Configuration
+//! \return     Group index (n_groups if there is none)
+//******************************************************************************
+static U32 findGroup(const ICS_CMB_SPECTRUM *groups, const U32 n_groups, const ICS_SWEEP_CONFIG *config)
+{
+    U32 g;
+
+    for (g = 0; g < n_groups; g++) {
+        if ((groups[g].Mode == config->Mode) &&
+            (groups[g].GammaRange.Lower == config->GammaRange.Lower) &&
+            (groups[g].GammaRange.Upper == config->GammaRange.Upper) &&
+            (groups[g].GammaRange.Iteration == config->GammaRange.Iteration)) {
+            break;
+        }
+    }
+
+    return g;
+}
+
+
+
+//******************************************************************************
+//! \breif      Create the grids and CMB density of a group
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[out] group  : ICS spectrum of the group
+//! \param[in]  config : First configuration of the group
+//! \param[in]  grid   : einit rule and precision
+//! \return     TRUE on success, FALSE otherwise
+//******************************************************************************
+static BOOL createGroup(ICS_CMB_SPECTRUM *group, const ICS_SWEEP_CONFIG *config, const ICS_SWEEP_GRID *grid)
+{
+    BOOL created;
+
+    if (grid->CmbPoints > 0) {
+        created = IcsCmbSpectrum_CreateBlackbody(group, config->Mode, grid->CmbPoints, &config->GammaRange);
+    }
+    else {
+        created = IcsCmbSpectrum_Create(group, config->Mode, &grid->EinitRange, &config->GammaRange);
+    }
+    group->Precision = grid->Precision;
+    group->JonesTable = grid->JonesTable;
+    group->ThomsonLimit = grid->ThomsonLimit;
+
+    return created;
+}
+
+
+
+//******************************************************************************
+//! \breif      Order tasks by decreasing cost
+//! \remark     Ties keep the configuration and energy order, so the order
+//!             does not depend on qsort.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  lhs : ICS_SWEEP_TASK
+//! \param[in]  rhs : ICS_SWEEP_TASK
+//! \return     Negative if lhs runs first
+//******************************************************************************
+static S32 compareTasks(const void *lhs, const void *rhs)
+{
+    const ICS_SWEEP_TASK *a = (const ICS_SWEEP_TASK *)lhs;
+    const ICS_SWEEP_TASK *b = (const ICS_SWEEP_TASK *)rhs;
+
+    if (a->Cost != b->Cost) {
+        return (a->Cost > b->Cost) ? -1 : 1;
+    }
+    if (a->Config != b->Config) {
+        return (a->Config < b->Config) ? -1 : 1;
+    }
+    return (a->Point < b->Point) ? -1 : ((a->Point > b->Point) ? 1 : 0);
+}
+
+
+
+//******************************************************************************
+//! \breif      Release the work arrays of IcsSweep_Run
+//! \remark     Views share the grids of their group and only own the
+//!             electron density vector.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  groups   : Groups
+//! \param[in]  n_groups : Number of created groups
+//! \param[in]  views    : Views of the configurations
+//! \param[in]  n_views  : Number of views with an electron density vector
+//! \param[in]  group_of : Group of each configuration
+//! \param[in]  tasks    : Tasks
+//! \return     None
+//******************************************************************************
+static void releaseWork(ICS_CMB_SPECTRUM *groups, const U32 n_groups, ICS_CMB_SPECTRUM *views, const U32 n_views, U32 *group_of, ICS_SWEEP_TASK *tasks)
+{
+    U32 i;
+
+    for (i = 0; i < n_views; i++) {
+        free(views[i].ElectronDensity);
+    }
+    for (i = 0; i < n_groups; i++) {
+        IcsCmbSpectrum_Release(&groups[i]);
+    }
+    free(tasks);
+    free(group_of);
+    free(views);
+    free(groups);
+
+    return;
+}
+
+
+
+
+//******************************************************************************
+// End of File
+//******************************************************************************
@@ -0,0 +1,96 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#ifndef ICS_SWEEP_H_
+#define ICS_SWEEP_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include "common_typedef.h"
+#include "numerics_integration.h"
+#include "ics_jones_table.h"
+
+
+
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! One configuration of a parameter sweep
+//----------------------------------------------------------
+typedef struct ics_sweep_config_t {
+    S32             Mode;               //!< USE_JONES_APPROX, USE_THOMSON_APPROX or USE_KAK_APPROX
+    F64             Norm;               //!< Electron spectrum : Normalization Factor
+    F64             Power;              //!< Electron spectrum : Power
+    F64             GammaMax;           //!< Electron spectrum : Maximum Lorentz Factor (Cut-off)
+    INTEGRATION_RANGE GammaRange;       //!< Integration Range of Lorentz factor
+    U32             EfinCount;          //!< Number of scattered photon energies
+    const F64       *Efin;              //!< Scattered photon energies [eV] [EfinCount]
+    F64             *Flux;              //!< ICS flux [EfinCount] (output)
+    U64             Cost;               //!< Kernel evaluations of the configuration (output)
+}ICS_SWEEP_CONFIG;
+
+//----------------------------------------------------------
+//! einit rule and precision shared by every configuration
+//----------------------------------------------------------
+typedef struct ics_sweep_grid_t {
+    S32             Precision;          //!< ICS_PRECISION_xxx
+    const ICS_JONES_TABLE *JonesTable;  //!< Jones kernel table (ICS_PRECISION_TABLE only)
+    F64             ThomsonLimit;       //!< Jones : Thomson limit threshold (0 : never)
+    U32             CmbPoints;          //!< Gauss-Laguerre points over the CMB (0 : EinitRange)
+    INTEGRATION_RANGE EinitRange;       //!< Log grid of incident photon energy [eV]
+}ICS_SWEEP_GRID;
+
+
+
+//==============================================================================
+// Export Scope Function Prototype
+//==============================================================================
+/**
+ * @brief               Calculates the ICS flux of every configuration of a sweep
+ * 
+ * @param configs       Configurations (Flux and Cost are written)
+ * @param count         Number of configurations
+ * @param grid          einit rule and precision
+ * @param evaluations   Kernel evaluations of the whole sweep
+ * @return BOOL         TRUE on success, FALSE if the arrays cannot be allocated
+ */
+extern BOOL IcsSweep_Run(ICS_SWEEP_CONFIG *configs, const U32 count, const ICS_SWEEP_GRID *grid, U64 *evaluations);
+
+
+
+#ifdef _cplusplus
+}
+#endif
+
+#endif
+
+//******************************************************************************
+// End of File
+//******************************************************************************
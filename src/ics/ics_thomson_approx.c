@@ -33,10 +33,22 @@
 
 
 
+//==============================================================================
+// Macro Definition
+//==============================================================================
+//----------------------------------------------------------
+//! Below this Lorentz factor the 1/beta^6 normalisation cancels most of the
+//! bracket, and the double precision path defers to quad precision.
+//----------------------------------------------------------
+#define THOMSON_F64_GAMMA_MIN           (1.1)
+
+
+
 //==============================================================================
 // File Scope Function Prototype
 //==============================================================================
 static inline F128 toBeta(const F128 gamma);
+static inline F64 toBetaF64(const F64 gamma);
 
 
 
@@ -169,6 +181,486 @@ F128 IcsThomson_MaxEnergyIso(const F128 einit, const F128 gamma)
 
 
 
+//******************************************************************************
+//! \breif      Calculates the Thomson approximation ICS spectrum in double
+//!             precision
+//! \remark     1) Same expression as IcsThomson_CalcFluxIso
+//!             2) 1 - beta is evaluated as 1 / (gamma^2 (1 + beta)) and
+//!                (1 + beta) / (1 - beta) as gamma^2 (1 + beta)^2, so neither
+//!                collapses to zero or infinity for large gamma
+//!             3) beta^2 = 1 - 1/gamma^2 and 9 - 4 beta^2 = 5 + 4/gamma^2 are
+//!                taken from 1/gamma^2 directly instead of from beta
+//!             4) Agrees with the quad precision version to 1E-9 relative
+//!                wherever the spectrum exceeds 1E-6 of its peak, and to
+//!                1E-11 after integration over efin, for gamma >= 1.1.
+//!                Below that the quad precision version is used.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  efin  - Scattered Photon Energy [eV]
+//! \param[in]  einit - Incident Photon Energy [eV]
+//! \param[in]  gamma - Electron Lorentz Factor
+//! \return     ICS flux on isotropic photon using Thomson approximation
+//******************************************************************************
+F64 IcsThomson_CalcFluxIsoF64(const F64 efin, const F64 einit, const F64 gamma)
+{
+    register F64 flux;
+    F64 tmp[5];
+    F64 beta, beta2, beta6, inv_gamma2, inv_gamma4, one_minus_beta, boost, ratio;
+    const F64 R0 = CLASIC_ELECTRON_RADIUS;
+    const F64 C = LIGHT_SPEED;
+
+    if (gamma < THOMSON_F64_GAMMA_MIN) {
+        return (F64)IcsThomson_CalcFluxIso((F128)efin, (F128)einit, (F128)gamma);
+    }
+
+    inv_gamma2 = 1.0 / (gamma * gamma);
+    inv_gamma4 = inv_gamma2 * inv_gamma2;
+    beta2 = 1.0 - inv_gamma2;
+    beta = toBetaF64(gamma);
+    beta6 = beta2 * beta2 * beta2;
+    one_minus_beta = inv_gamma2 / (1.0 + beta);
+    boost = (1.0 + beta) * (1.0 + beta) * gamma * gamma;
+    ratio = efin / einit;
+
+    //------------------------------------------------------
+    // In case of photon energy lossing after the scattering
+    //------------------------------------------------------
+    if ((ratio * boost >= 1.0) && (efin < einit)) {
+        tmp[0]  = (beta * (beta2 + 3.0)) + ((5.0 + 4.0 * inv_gamma2) * inv_gamma2);
+        tmp[0] *= (1.0 + beta) * ratio;
+
+        tmp[1]  = (beta * (beta2 + 3.0)) - ((5.0 + 4.0 * inv_gamma2) * inv_gamma2);
+        tmp[1] *= one_minus_beta;
+
+        tmp[2]  = log(ratio * boost);
+        tmp[2] *= (3.0 - beta2) * (1.0 + ratio);
+        tmp[2] *= 2.0 * inv_gamma2;
+
+        tmp[3]  = inv_gamma4 / ratio;
+
+        tmp[4]  = ratio * ratio * inv_gamma4;
+
+        flux  = tmp[0] + tmp[1] - tmp[2] - tmp[3] + tmp[4];
+        flux *= MATH_PI * R0 * R0 * C * inv_gamma2;
+        flux /= 4.0 * beta6 * einit;
+    }
+    //------------------------------------------------------
+    // In case of photon energy increasing after the scattering
+    //------------------------------------------------------
+    else if ((einit <= efin) && (ratio <= boost)) {
+        tmp[0]  = (beta * (beta2 + 3.0)) + ((5.0 + 4.0 * inv_gamma2) * inv_gamma2);
+        tmp[0] *= (1.0 + beta);
+
+        tmp[1]  = (beta * (beta2 + 3.0)) - ((5.0 + 4.0 * inv_gamma2) * inv_gamma2);
+        tmp[1] *= one_minus_beta * ratio;
+
+        tmp[2]  = log(boost / ratio);
+        tmp[2] *= (3.0 - beta2) * (1.0 + ratio);
+        tmp[2] *= 2.0 * inv_gamma2;
+
+        tmp[3]  = inv_gamma4 / ratio;
+
+        tmp[4]  = ratio * ratio * inv_gamma4;
+
+        flux  = tmp[0] + tmp[1] - tmp[2] + tmp[3] - tmp[4];
+        flux *= MATH_PI * R0 * R0 * C * inv_gamma2;
+        flux /= 4.0 * beta6 * einit;
+    }
+    else {
+        flux = 0.0;
+    }
+
+    return flux;
+}
+
+
+
+//******************************************************************************
+//! \breif      Calculates the Thomson approximation ICS spectrum in single
+//!             precision
+//! \remark     Same formulation as IcsThomson_CalcFluxIsoF64, with the gamma^-4
+//!             terms split into two factors so that they stay inside the
+//!             single precision range up to gamma ~ 1E+10
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  efin  - Scattered Photon Energy [eV]
+//! \param[in]  einit - Incident Photon Energy [eV]
+//! \param[in]  gamma - Electron Lorentz Factor
+//! \return     ICS flux on isotropic photon using Thomson approximation
+//******************************************************************************
+F32 IcsThomson_CalcFluxIsoF32(const F32 efin, const F32 einit, const F32 gamma)
+{
+    register F32 flux;
+    F32 tmp[5];
+    F32 beta, beta2, beta6, inv_gamma2, one_minus_beta, boost, ratio;
+    const F32 R0 = (F32)CLASIC_ELECTRON_RADIUS;
+    const F32 C = (F32)LIGHT_SPEED;
+
+    if (gamma < (F32)THOMSON_F64_GAMMA_MIN) {
+        return (F32)IcsThomson_CalcFluxIso((F128)efin, (F128)einit, (F128)gamma);
+    }
+
+    inv_gamma2 = 1.0F / (gamma * gamma);
+    beta2 = 1.0F - inv_gamma2;
+    beta = sqrtf(beta2);
+    beta6 = beta2 * beta2 * beta2;
+    one_minus_beta = inv_gamma2 / (1.0F + beta);
+    boost = (1.0F + beta) * (1.0F + beta) * gamma * gamma;
+    ratio = efin / einit;
+
+    //------------------------------------------------------
+    // In case of photon energy lossing after the scattering
+    //------------------------------------------------------
+    if ((ratio * boost >= 1.0F) && (efin < einit)) {
+        tmp[0]  = (beta * (beta2 + 3.0F)) + ((5.0F + 4.0F * inv_gamma2) * inv_gamma2);
+        tmp[0] *= (1.0F + beta) * ratio;
+
+        tmp[1]  = (beta * (beta2 + 3.0F)) - ((5.0F + 4.0F * inv_gamma2) * inv_gamma2);
+        tmp[1] *= one_minus_beta;
+
+        tmp[2]  = logf(ratio * boost);
+        tmp[2] *= (3.0F - beta2) * (1.0F + ratio);
+        tmp[2] *= 2.0F * inv_gamma2;
+
+        tmp[3]  = inv_gamma2 * (inv_gamma2 / ratio);
+
+        tmp[4]  = (ratio * inv_gamma2) * (ratio * inv_gamma2);
+
+        flux  = tmp[0] + tmp[1] - tmp[2] - tmp[3] + tmp[4];
+        flux *= (F32)MATH_PI * R0 * R0 * C * inv_gamma2;
+        flux /= 4.0F * beta6 * einit;
+    }
+    //------------------------------------------------------
+    // In case of photon energy increasing after the scattering
+    //------------------------------------------------------
+    else if ((einit <= efin) && (ratio <= boost)) {
+        tmp[0]  = (beta * (beta2 + 3.0F)) + ((5.0F + 4.0F * inv_gamma2) * inv_gamma2);
+        tmp[0] *= (1.0F + beta);
+
+        tmp[1]  = (beta * (beta2 + 3.0F)) - ((5.0F + 4.0F * inv_gamma2) * inv_gamma2);
+        tmp[1] *= one_minus_beta * ratio;
+
+        tmp[2]  = logf(boost / ratio);
+        tmp[2] *= (3.0F - beta2) * (1.0F + ratio);
+        tmp[2] *= 2.0F * inv_gamma2;
+
+        tmp[3]  = inv_gamma2 * (inv_gamma2 / ratio);
+
+        tmp[4]  = (ratio * inv_gamma2) * (ratio * inv_gamma2);
+
+        flux  = tmp[0] + tmp[1] - tmp[2] + tmp[3] - tmp[4];
+        flux *= (F32)MATH_PI * R0 * R0 * C * inv_gamma2;
+        flux /= 4.0F * beta6 * einit;
+    }
+    else {
+        flux = 0.0F;
+    }
+
+    return flux;
+}
+
+
+
+//******************************************************************************
+//! \breif      Calaulates the minimum energy of scattered photon in case of
+//!             Thomson approximation and isotropic photon in double precision
+//! \remark     (1 - beta) / (1 + beta) = 1 / (gamma^2 (1 + beta)^2)
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  einit - Incident Photon Energy [eV]
+//! \param[in]  gamma - Electron Lorentz Factor
+//! \return     Minimum energy of scattered photon
+//******************************************************************************
+F64 IcsThomson_MinEnergyIsoF64(const F64 einit, const F64 gamma)
+{
+    F64 beta;
+
+    beta = toBetaF64(gamma);
+
+    return einit / ((1.0 + beta) * (1.0 + beta) * gamma * gamma);
+}
+
+
+
+//******************************************************************************
+//! \breif      Calaulates the maximum energy of scattered photon in case of
+//!             Thomson approximation and isotropic photon in double precision
+//! \remark     (1 + beta) / (1 - beta) = gamma^2 (1 + beta)^2
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  einit - Incident Photon Energy [eV]
+//! \param[in]  gamma - Electron Lorentz Factor
+//! \return     Maximum energy of scattered photon
+//******************************************************************************
+F64 IcsThomson_MaxEnergyIsoF64(const F64 einit, const F64 gamma)
+{
+    F64 beta;
+
+    beta = toBetaF64(gamma);
+
+    return einit * (1.0 + beta) * (1.0 + beta) * gamma * gamma;
+}
+
+
+
+
+//******************************************************************************
+//! \breif      Prepare the gamma factors of the Thomson kernel
+//! \remark     Holds every factor of eq.(23a) and (23b) that does not depend
+//!             on efin or einit, so beta is taken once per gamma node instead
+//!             of three times per evaluation
+//! 
+//! \callgraph  
+//! 
+//! \param[out] prepared : Gamma factors
+//! \param[in]  gamma    : Electron Lorentz Factor
+//! \return     None
+//******************************************************************************
+void IcsThomson_PrepareGamma(ICS_THOMSON_GAMMA *prepared, const F128 gamma)
+{
+    F128 beta, beta2, beta6, gamma2, correction;
+    const F128 R0 = (F128)CLASIC_ELECTRON_RADIUS;
+    const F128 C = (F128)LIGHT_SPEED;
+
+    beta = toBeta(gamma);
+    beta2 = beta * beta;
+    beta6 = beta2 * beta2 * beta2;
+    gamma2 = gamma * gamma;
+    correction = (9.0Q - 4.0Q * beta2) / gamma2;
+
+    prepared->EminRatio = (1.0Q - beta) / (1.0Q + beta);
+    prepared->EmaxRatio = (1.0Q + beta) / (1.0Q - beta);
+    prepared->Plus = ((beta * (beta2 + 3.0Q)) + correction) * (1.0Q + beta);
+    prepared->Minus = ((beta * (beta2 + 3.0Q)) - correction) * (1.0Q - beta);
+    prepared->LogFactor = (3.0Q - beta2) * (2.0Q / gamma2);
+    prepared->InvGamma4 = 1.0Q / (gamma2 * gamma2);
+    prepared->Scale = ((F128)MATH_PI * R0 * R0 * C) / (4.0Q * beta6 * gamma2);
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Prepare the einit factors of the Thomson kernel
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[out] prepared : Einit factors
+//! \param[in]  einit    : Incident Photon Energy [eV]
+//! \return     None
+//******************************************************************************
+void IcsThomson_PrepareEinit(ICS_THOMSON_EINIT *prepared, const F128 einit)
+{
+    prepared->Einit = einit;
+    prepared->InvEinit = 1.0Q / einit;
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Calculates the Thomson approximation ICS spectrum from prepared
+//!             factors
+//! \remark     Same expression as IcsThomson_CalcFluxIso, with efin / einit
+//!             as the only quantity formed per evaluation
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  efin  - Scattered Photon Energy [eV]
+//! \param[in]  einit - Einit factors (IcsThomson_PrepareEinit)
+//! \param[in]  gamma - Gamma factors (IcsThomson_PrepareGamma)
+//! \return     ICS flux on isotropic photon using Thomson approximation
+//******************************************************************************
+F128 IcsThomson_CalcFluxPrepared(const F128 efin, const ICS_THOMSON_EINIT *einit, const ICS_THOMSON_GAMMA *gamma)
+{
+    register F128 flux;
+    F128 tmp[5];
+    F128 ratio;
+
+    ratio = efin * einit->InvEinit;
+
+    //------------------------------------------------------
+    // In case of photon energy lossing after the scattering
+    //------------------------------------------------------
+    if ((efin >= einit->Einit * gamma->EminRatio) && (efin < einit->Einit)) {
+        tmp[0]  = gamma->Plus * ratio;
+
+        tmp[1]  = gamma->Minus;
+
+        tmp[2]  = logq(ratio * gamma->EmaxRatio);
+        tmp[2] *= gamma->LogFactor * (1.0Q + ratio);
+
+        tmp[3]  = gamma->InvGamma4 / ratio;
+
+        tmp[4]  = ratio * ratio * gamma->InvGamma4;
+
+        flux  = tmp[0] + tmp[1] - tmp[2] - tmp[3] + tmp[4];
+        flux *= gamma->Scale * einit->InvEinit;
+    }
+    //------------------------------------------------------
+    // In case of photon energy increasing after the scattering
+    //------------------------------------------------------
+    else if ((einit->Einit <= efin) && (efin <= einit->Einit * gamma->EmaxRatio)) {
+        tmp[0]  = gamma->Plus;
+
+        tmp[1]  = gamma->Minus * ratio;
+
+        tmp[2]  = logq(gamma->EmaxRatio / ratio);
+        tmp[2] *= gamma->LogFactor * (1.0Q + ratio);
+
+        tmp[3]  = gamma->InvGamma4 / ratio;
+
+        tmp[4]  = ratio * ratio * gamma->InvGamma4;
+
+        flux  = tmp[0] + tmp[1] - tmp[2] + tmp[3] - tmp[4];
+        flux *= gamma->Scale * einit->InvEinit;
+    }
+    else {
+        flux = 0.0Q;
+    }
+
+    return flux;
+}
+
+
+
+//******************************************************************************
+//! \breif      Prepare the gamma factors of the Thomson kernel in double
+//!             precision
+//! \remark     Same factors as IcsThomson_CalcFluxIsoF64. Below
+//!             THOMSON_F64_GAMMA_MIN only gamma is kept and the kernel defers
+//!             to quad precision.
+//! 
+//! \callgraph  
+//! 
+//! \param[out] prepared : Gamma factors
+//! \param[in]  gamma    : Electron Lorentz Factor
+//! \return     None
+//******************************************************************************
+void IcsThomson_PrepareGammaF64(ICS_THOMSON_GAMMA_F64 *prepared, const F64 gamma)
+{
+    F64 beta, beta2, beta6, inv_gamma2, correction;
+    const F64 R0 = CLASIC_ELECTRON_RADIUS;
+    const F64 C = LIGHT_SPEED;
+
+    prepared->Gamma = gamma;
+    prepared->Quad = (gamma < THOMSON_F64_GAMMA_MIN) ? TRUE : FALSE;
+
+    inv_gamma2 = 1.0 / (gamma * gamma);
+    beta2 = 1.0 - inv_gamma2;
+    beta = toBetaF64(gamma);
+    beta6 = beta2 * beta2 * beta2;
+    correction = (5.0 + 4.0 * inv_gamma2) * inv_gamma2;
+
+    prepared->Boost = (1.0 + beta) * (1.0 + beta) * gamma * gamma;
+    prepared->Plus = ((beta * (beta2 + 3.0)) + correction) * (1.0 + beta);
+    prepared->Minus = ((beta * (beta2 + 3.0)) - correction) * (inv_gamma2 / (1.0 + beta));
+    prepared->LogFactor = (3.0 - beta2) * (2.0 * inv_gamma2);
+    prepared->InvGamma4 = inv_gamma2 * inv_gamma2;
+    prepared->Scale = (MATH_PI * R0 * R0 * C * inv_gamma2) / (4.0 * beta6);
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Prepare the einit factors of the Thomson kernel in double
+//!             precision
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[out] prepared : Einit factors
+//! \param[in]  einit    : Incident Photon Energy [eV]
+//! \return     None
+//******************************************************************************
+void IcsThomson_PrepareEinitF64(ICS_THOMSON_EINIT_F64 *prepared, const F64 einit)
+{
+    prepared->Einit = einit;
+    prepared->InvEinit = 1.0 / einit;
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Calculates the Thomson approximation ICS spectrum from prepared
+//!             factors in double precision
+//! \remark     Same expression as IcsThomson_CalcFluxIsoF64
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  efin  - Scattered Photon Energy [eV]
+//! \param[in]  einit - Einit factors (IcsThomson_PrepareEinitF64)
+//! \param[in]  gamma - Gamma factors (IcsThomson_PrepareGammaF64)
+//! \return     ICS flux on isotropic photon using Thomson approximation
+//******************************************************************************
+F64 IcsThomson_CalcFluxPreparedF64(const F64 efin, const ICS_THOMSON_EINIT_F64 *einit, const ICS_THOMSON_GAMMA_F64 *gamma)
+{
+    register F64 flux;
+    F64 tmp[5];
+    F64 ratio;
+
+    if (gamma->Quad == TRUE) {
+        return (F64)IcsThomson_CalcFluxIso((F128)efin, (F128)einit->Einit, (F128)gamma->Gamma);
+    }
+
+    ratio = efin * einit->InvEinit;
+
+    //------------------------------------------------------
+    // In case of photon energy lossing after the scattering
+    //------------------------------------------------------
+    if ((ratio * gamma->Boost >= 1.0) && (efin < einit->Einit)) {
+        tmp[0]  = gamma->Plus * ratio;
+
+        tmp[1]  = gamma->Minus;
+
+        tmp[2]  = log(ratio * gamma->Boost);
+        tmp[2] *= gamma->LogFactor * (1.0 + ratio);
+
+        tmp[3]  = gamma->InvGamma4 / ratio;
+
+        tmp[4]  = ratio * ratio * gamma->InvGamma4;
+
+        flux  = tmp[0] + tmp[1] - tmp[2] - tmp[3] + tmp[4];
+        flux *= gamma->Scale * einit->InvEinit;
+    }
+    //------------------------------------------------------
+    // In case of photon energy increasing after the scattering
+    //------------------------------------------------------
+    else if ((einit->Einit <= efin) && (ratio <= gamma->Boost)) {
+        tmp[0]  = gamma->Plus;
+
+        tmp[1]  = gamma->Minus * ratio;
+
+        tmp[2]  = log(gamma->Boost / ratio);
+        tmp[2] *= gamma->LogFactor * (1.0 + ratio);
+
+        tmp[3]  = gamma->InvGamma4 / ratio;
+
+        tmp[4]  = ratio * ratio * gamma->InvGamma4;
+
+        flux  = tmp[0] + tmp[1] - tmp[2] + tmp[3] - tmp[4];
+        flux *= gamma->Scale * einit->InvEinit;
+    }
+    else {
+        flux = 0.0;
+    }
+
+    return flux;
+}
+
+
+
 //******************************************************************************
 //! \breif      Convert to adimensional electron velocity from Lorentz factor
 //! \remark     
@@ -191,6 +683,29 @@ static inline F128 toBeta(const F128 gamma)
 
 
 
+//******************************************************************************
+//! \breif      Convert to adimensional electron velocity from Lorentz factor
+//!             in double precision
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  gamma  - Electron Lorentz Factor
+//! \return     Adimensional electron velocity corresponding Lorentz factor
+//******************************************************************************
+static inline F64 toBetaF64(const F64 gamma)
+{
+    F64 beta;
+
+    beta  = sqrt(gamma + 1.0);
+    beta *= sqrt(gamma - 1.0);
+    beta /= gamma;
+
+    return beta;
+}
+
+
+
 
 
 //******************************************************************************
@@ -36,6 +36,54 @@ extern "C" {
 
 
 
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! Thomson kernel factors that depend on gamma only
+//----------------------------------------------------------
+typedef struct ics_thomson_gamma_t {
+    F128    EminRatio;          //!< (1 - beta) / (1 + beta)
+    F128    EmaxRatio;          //!< (1 + beta) / (1 - beta)
+    F128    Plus;               //!< (beta (beta^2 + 3) + (9 - 4 beta^2) / gamma^2) (1 + beta)
+    F128    Minus;              //!< (beta (beta^2 + 3) - (9 - 4 beta^2) / gamma^2) (1 - beta)
+    F128    LogFactor;          //!< 2 (3 - beta^2) / gamma^2
+    F128    InvGamma4;          //!< 1 / gamma^4
+    F128    Scale;              //!< pi r0^2 c / (4 beta^6 gamma^2)
+}ICS_THOMSON_GAMMA;
+
+//----------------------------------------------------------
+//! Thomson kernel factors that depend on einit only
+//----------------------------------------------------------
+typedef struct ics_thomson_einit_t {
+    F128    Einit;              //!< Incident Photon Energy [eV]
+    F128    InvEinit;           //!< 1 / einit [1/eV]
+}ICS_THOMSON_EINIT;
+
+//----------------------------------------------------------
+//! Thomson kernel factors that depend on gamma only (double precision)
+//----------------------------------------------------------
+typedef struct ics_thomson_gamma_f64_t {
+    F64     Gamma;              //!< Electron Lorentz Factor
+    F64     Boost;              //!< (1 + beta) / (1 - beta) = gamma^2 (1 + beta)^2
+    F64     Plus;               //!< (beta (beta^2 + 3) + (5 + 4 / gamma^2) / gamma^2) (1 + beta)
+    F64     Minus;              //!< (beta (beta^2 + 3) - (5 + 4 / gamma^2) / gamma^2) (1 - beta)
+    F64     LogFactor;          //!< 2 (3 - beta^2) / gamma^2
+    F64     InvGamma4;          //!< 1 / gamma^4
+    F64     Scale;              //!< pi r0^2 c / (4 beta^6 gamma^2)
+    BOOL    Quad;               //!< TRUE if the kernel defers to quad precision
+}ICS_THOMSON_GAMMA_F64;
+
+//----------------------------------------------------------
+//! Thomson kernel factors that depend on einit only (double precision)
+//----------------------------------------------------------
+typedef struct ics_thomson_einit_f64_t {
+    F64     Einit;              //!< Incident Photon Energy [eV]
+    F64     InvEinit;           //!< 1 / einit [1/eV]
+}ICS_THOMSON_EINIT_F64;
+
+
+
 //==============================================================================
 // Export Scope Function Prototype
 //==============================================================================
@@ -67,6 +115,99 @@ extern F128 IcsThomson_MinEnergyIso(const F128 einit, const F128 gamma);
  */
 extern F128 IcsThomson_MaxEnergyIso(const F128 einit, const F128 gamma);
 
+/**
+ * @brief       Calculates the Thomson approximation ICS spectrum in double
+ *              precision without cancellation in 1 - beta
+ * 
+ * @param efin  Scattered Photon Energy [eV]
+ * @param einit Incident Photon Energy [eV]
+ * @param gamma Electron Lorentz Factor
+ * @return F64  ICS flux on isotropic photon using Thomson approximation
+ */
+extern F64 IcsThomson_CalcFluxIsoF64(const F64 efin, const F64 einit, const F64 gamma);
+
+/**
+ * @brief       Calculates the Thomson approximation ICS spectrum in single
+ *              precision
+ * 
+ * @param efin  Scattered Photon Energy [eV]
+ * @param einit Incident Photon Energy [eV]
+ * @param gamma Electron Lorentz Factor
+ * @return F32  ICS flux on isotropic photon using Thomson approximation
+ */
+extern F32 IcsThomson_CalcFluxIsoF32(const F32 efin, const F32 einit, const F32 gamma);
+
+/**
+ * @brief       Calaulates the minimum energy of scattered photon in case of
+ *              Thomson approximation and isotropic photon in double precision
+ * @param einit Incident Photon Energy [eV]
+ * @param gamma Electron Lorentz Factor
+ * @return F64  Minimum energy of scattered photon
+ */
+extern F64 IcsThomson_MinEnergyIsoF64(const F64 einit, const F64 gamma);
+
+/**
+ * @brief       Calaulates the maximum energy of scattered photon in case of
+ *              Thomson approximation and isotropic photon in double precision
+ * @param einit Incident Photon Energy [eV]
+ * @param gamma Electron Lorentz Factor
+ * @return F64  Maximum energy of scattered photon
+ */
+extern F64 IcsThomson_MaxEnergyIsoF64(const F64 einit, const F64 gamma);
+
+/**
+ * @brief           Prepare the gamma factors of the Thomson kernel
+ * 
+ * @param prepared  Gamma factors
+ * @param gamma     Electron Lorentz Factor
+ */
+extern void IcsThomson_PrepareGamma(ICS_THOMSON_GAMMA *prepared, const F128 gamma);
+
+/**
+ * @brief           Prepare the einit factors of the Thomson kernel
+ * 
+ * @param prepared  Einit factors
+ * @param einit     Incident Photon Energy [eV]
+ */
+extern void IcsThomson_PrepareEinit(ICS_THOMSON_EINIT *prepared, const F128 einit);
+
+/**
+ * @brief       Calculates the Thomson approximation ICS spectrum from prepared factors
+ * 
+ * @param efin  Scattered Photon Energy [eV]
+ * @param einit Einit factors (IcsThomson_PrepareEinit)
+ * @param gamma Gamma factors (IcsThomson_PrepareGamma)
+ * @return F128 ICS flux on isotropic photon using Thomson approximation
+ */
+extern F128 IcsThomson_CalcFluxPrepared(const F128 efin, const ICS_THOMSON_EINIT *einit, const ICS_THOMSON_GAMMA *gamma);
+
+/**
+ * @brief           Prepare the gamma factors of the Thomson kernel in double precision
+ * 
+ * @param prepared  Gamma factors
+ * @param gamma     Electron Lorentz Factor
+ */
+extern void IcsThomson_PrepareGammaF64(ICS_THOMSON_GAMMA_F64 *prepared, const F64 gamma);
+
+/**
+ * @brief           Prepare the einit factors of the Thomson kernel in double precision
+ * 
+ * @param prepared  Einit factors
+ * @param einit     Incident Photon Energy [eV]
+ */
+extern void IcsThomson_PrepareEinitF64(ICS_THOMSON_EINIT_F64 *prepared, const F64 einit);
+
+/**
+ * @brief       Calculates the Thomson approximation ICS spectrum from prepared factors
+ *              in double precision
+ * 
+ * @param efin  Scattered Photon Energy [eV]
+ * @param einit Einit factors (IcsThomson_PrepareEinitF64)
+ * @param gamma Gamma factors (IcsThomson_PrepareGammaF64)
+ * @return F64  ICS flux on isotropic photon using Thomson approximation
+ */
+extern F64 IcsThomson_CalcFluxPreparedF64(const F64 efin, const ICS_THOMSON_EINIT_F64 *einit, const ICS_THOMSON_GAMMA_F64 *gamma);
+
 
 
 #ifdef _cplusplus
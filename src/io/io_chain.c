@@ -0,0 +1,261 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#define IO_CHAIN_C_
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "io_chain.h"
+
+
+
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! Compile-time check of the on-disk header size
+//----------------------------------------------------------
+typedef CHAR IO_CHAIN_HEADER_SIZE_CHECK[(sizeof(IO_CHAIN_HEADER) == 64) ? 1 : -1];
+
+
+
+//==============================================================================
+// File Scope Function Prototype
+//==============================================================================
+static BOOL isValidHeader(const IO_CHAIN_HEADER *header);
+static BOOL seekRecord(FILE *fp, const U64 step, const U32 record_count);
+
+
+
+
+
+//******************************************************************************
+//! \breif      Open a chain file for streaming
+//! \remark     With steps > 0 the file must exist with the same walkers,
+//!             dimension and mode and hold at least that many synced
+//!             records. The records after them are overwritten.
+//! 
+//! \callgraph  
+//! 
+//! \param[out] chain     : Opened chain
+//! \param[in]  file_name : File name
+//! \param[in]  walkers   : Number of walkers
+//! \param[in]  dimension : Number of parameters
+//! \param[in]  mode      : ICS kernel mode
+//! \param[in]  steps     : Records kept from an existing file (0 : new file)
+//! \return     TRUE on success, FALSE if the file cannot be opened or does
+//!             not hold the records to be kept
+//******************************************************************************
+BOOL IoChain_Open(IO_CHAIN *chain, const CHAR *file_name, const U32 walkers, const U32 dimension, const S32 mode, const U64 steps)
+{
+    IO_CHAIN_HEADER *header = &chain->Header;
+
+    chain->RecordCount = walkers * (dimension + 1);
+
+    if (steps == 0) {
+        if ((chain->File = fopen(file_name, "w+b")) == NULL) {
+            return FALSE;
+        }
+        memset(header, 0, sizeof(IO_CHAIN_HEADER));
+        memcpy(header->Magic, IO_CHAIN_MAGIC, sizeof(header->Magic));
+        header->Version = IO_CHAIN_VERSION;
+        header->HeaderSize = (U32)sizeof(IO_CHAIN_HEADER);
+        header->Walkers = walkers;
+        header->Dimension = dimension;
+        header->Mode = mode;
+
+        return IoChain_Sync(chain);
+    }
+
+    if ((chain->File = fopen(file_name, "r+b")) == NULL) {
+        return FALSE;
+    }
+    if ((fread(header, sizeof(IO_CHAIN_HEADER), 1, chain->File) != 1) || (isValidHeader(header) == FALSE) ||
+        (header->Walkers != walkers) || (header->Dimension != dimension) || (header->Mode != mode) || (header->Steps < steps) ||
+        (seekRecord(chain->File, steps, chain->RecordCount) == FALSE)) {
+        fclose(chain->File);
+        chain->File = NULL;
+        return FALSE;
+    }
+    header->Steps = steps;
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Append one record
+//! \remark     The record is counted in the header at the next sync.
+//! 
+//! \callgraph  
+//! 
+//! \param[in,out] chain  : Opened chain
+//! \param[in]     record : Record [Walkers][Dimension + 1]
+//! \return     TRUE on success
+//******************************************************************************
+BOOL IoChain_Append(IO_CHAIN *chain, const F64 *record)
+{
+    if (fwrite(record, sizeof(F64), chain->RecordCount, chain->File) != chain->RecordCount) {
+        return FALSE;
+    }
+    chain->Header.Steps++;
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Write the step count to the header and flush the file
+//! \remark     A reader (or a resumed run) only trusts the synced records.
+//! 
+//! \callgraph  
+//! 
+//! \param[in,out] chain : Opened chain
+//! \return     TRUE on success
+//******************************************************************************
+BOOL IoChain_Sync(IO_CHAIN *chain)
+{
+    if ((fflush(chain->File) != 0) || (fseek(chain->File, 0, SEEK_SET) != 0) ||
+        (fwrite(&chain->Header, sizeof(IO_CHAIN_HEADER), 1, chain->File) != 1) ||
+        (seekRecord(chain->File, chain->Header.Steps, chain->RecordCount) == FALSE)) {
+        return FALSE;
+    }
+
+    return (fflush(chain->File) == 0) ? TRUE : FALSE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Read every synced record of a chain file
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  file_name : File name
+//! \param[out] header    : Header of the file
+//! \param[out] records   : Records [Steps][Walkers][Dimension + 1] (allocated)
+//! \return     TRUE on success, FALSE if the file is missing or invalid
+//******************************************************************************
+BOOL IoChain_Read(const CHAR *file_name, IO_CHAIN_HEADER *header, F64 **records)
+{
+    FILE *fp;
+    size_t count;
+    BOOL result;
+
+    *records = NULL;
+    if ((fp = fopen(file_name, "rb")) == NULL) {
+        return FALSE;
+    }
+
+    result = FALSE;
+    if ((fread(header, sizeof(IO_CHAIN_HEADER), 1, fp) == 1) && (isValidHeader(header) == TRUE)) {
+        count = (size_t)header->Steps * header->Walkers * (header->Dimension + 1);
+        if ((*records = (F64 *)malloc(sizeof(F64) * count + 1)) != NULL) {
+            result = (fread(*records, sizeof(F64), count, fp) == count) ? TRUE : FALSE;
+        }
+    }
+    fclose(fp);
+
+    if (result == FALSE) {
+        free(*records);
+        *records = NULL;
+    }
+
+    return result;
+}
+
+
+
+//******************************************************************************
+//! \breif      Sync and close a chain file
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in,out] chain : Opened chain
+//! \return     None
+//******************************************************************************
+void IoChain_Close(IO_CHAIN *chain)
+{
+    if (chain->File != NULL) {
+        IoChain_Sync(chain);
+        fclose(chain->File);
+        chain->File = NULL;
+    }
+
+    return;
+}
+
+
+
+
+
+//******************************************************************************
+//! \breif      Check the signature and the version of a header
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  header : Header read from a file
+//! \return     TRUE if the header is valid
+//******************************************************************************
+static BOOL isValidHeader(const IO_CHAIN_HEADER *header)
+{
+    return ((memcmp(header->Magic, IO_CHAIN_MAGIC, sizeof(header->Magic)) == 0) &&
+            (header->Version == IO_CHAIN_VERSION) &&
+            (header->HeaderSize == sizeof(IO_CHAIN_HEADER)) &&
+            (header->Walkers > 0) && (header->Dimension > 0)) ? TRUE : FALSE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Move the file position to a record
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  fp           : Opened file
+//! \param[in]  step         : Record index
+//! \param[in]  record_count : float64 elements per record
+//! \return     TRUE on success
+//******************************************************************************
+static BOOL seekRecord(FILE *fp, const U64 step, const U32 record_count)
+{
+    return (fseek(fp, (long)(sizeof(IO_CHAIN_HEADER) + step * record_count * sizeof(F64)), SEEK_SET) == 0) ? TRUE : FALSE;
+}
+
+
+
+
+//******************************************************************************
+// End of File
+//******************************************************************************
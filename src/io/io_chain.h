@@ -0,0 +1,139 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#ifndef IO_CHAIN_H_
+#define IO_CHAIN_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include <stdio.h>
+#include "common_typedef.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+#define IO_CHAIN_MAGIC                  "ICSCHAIN"      //!< File signature (8 bytes)
+#define IO_CHAIN_VERSION                (1)             //!< Format version
+
+
+
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! File header (64 bytes, records follow)
+//! One record per step : [Walkers][Dimension + 1] float64, the parameters of
+//! each walker followed by its log posterior.
+//----------------------------------------------------------
+typedef struct io_chain_header_t {
+    CHAR        Magic[8];               //!< IO_CHAIN_MAGIC
+    U32         Version;                //!< IO_CHAIN_VERSION
+    U32         HeaderSize;             //!< sizeof(IO_CHAIN_HEADER)
+    U32         Walkers;                //!< Number of walkers
+    U32         Dimension;              //!< Number of parameters
+    U64         Steps;                  //!< Records written up to the last sync
+    S32         Mode;                   //!< ICS kernel mode
+    U8          Reserved[28];           //!< Reserved (zero)
+}IO_CHAIN_HEADER;
+
+//----------------------------------------------------------
+//! Chain file opened for streaming
+//----------------------------------------------------------
+typedef struct io_chain_t {
+    FILE        *File;                  //!< Opened file
+    IO_CHAIN_HEADER Header;             //!< Header (Steps counts the appended records)
+    U32         RecordCount;            //!< float64 elements per record
+}IO_CHAIN;
+
+
+
+//==============================================================================
+// Export Scope Function Prototype
+//==============================================================================
+/**
+ * @brief           Open a chain file for streaming
+ * 
+ * @param chain     Opened chain
+ * @param file_name File name
+ * @param walkers   Number of walkers
+ * @param dimension Number of parameters
+ * @param mode      ICS kernel mode
+ * @param steps     Records kept from an existing file (0 : new file)
+ * @return BOOL     TRUE on success, FALSE if the file cannot be opened or
+ *                  does not hold the records to be kept
+ */
+extern BOOL IoChain_Open(IO_CHAIN *chain, const CHAR *file_name, const U32 walkers, const U32 dimension, const S32 mode, const U64 steps);
+
+/**
+ * @brief           Append one record
+ * 
+ * @param chain     Opened chain
+ * @param record    Record [Walkers][Dimension + 1]
+ * @return BOOL     TRUE on success
+ */
+extern BOOL IoChain_Append(IO_CHAIN *chain, const F64 *record);
+
+/**
+ * @brief           Write the step count to the header and flush the file
+ * 
+ * @param chain     Opened chain
+ * @return BOOL     TRUE on success
+ */
+extern BOOL IoChain_Sync(IO_CHAIN *chain);
+
+/**
+ * @brief           Read every synced record of a chain file
+ * 
+ * @param file_name File name
+ * @param header    Header of the file
+ * @param records   Records [Steps][Walkers][Dimension + 1] (allocated)
+ * @return BOOL     TRUE on success, FALSE if the file is missing or invalid
+ */
+extern BOOL IoChain_Read(const CHAR *file_name, IO_CHAIN_HEADER *header, F64 **records);
+
+/**
+ * @brief           Sync and close a chain file
+ * 
+ * @param chain     Opened chain
+ */
+extern void IoChain_Close(IO_CHAIN *chain);
+
+
+
+#ifdef _cplusplus
+}
+#endif
+
+#endif
+
+//******************************************************************************
+// End of File
+//******************************************************************************
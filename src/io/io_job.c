@@ -0,0 +1,472 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#define IO_JOB_C_
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "io_job.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+#define IO_JOB_LINE_LENGTH              (1024)          //!< Longest line of a job file
+#define IO_JOB_INITIAL_CAPACITY         (16)            //!< First allocation of the job array
+#define IO_JOB_AXIS_MODE                (0)             //!< Axis of the mode (index of IO_JOB_AXIS_KEY)
+#define IO_JOB_AXIS_POWER               (2)             //!< Axis of the power
+#define IO_JOB_AXIS_LOWER               (4)             //!< Axis of the lower energy
+#define IO_JOB_AXIS_UPPER               (5)             //!< Axis of the upper energy
+
+
+
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! Values of one sweep axis
+//----------------------------------------------------------
+typedef struct io_job_axis_t {
+    U32         Count;                  //!< Number of values
+    F64         *Value;                 //!< Values
+    U32         Line;                   //!< Line number of the axis
+}IO_JOB_AXIS;
+
+
+
+//==============================================================================
+// File Scope Function Prototype
+//==============================================================================
+static S32 parseLine(CHAR *line, IO_JOB *job);
+static S32 parseAxis(CHAR *line, const U32 line_number, IO_JOB_AXIS *axes);
+static BOOL isValidAxisValue(const U32 axis, const F64 value);
+static BOOL expandAxes(const IO_JOB_AXIS *axes, IO_JOB **jobs, U32 *count);
+
+
+
+//==============================================================================
+// File Scope Variables
+//==============================================================================
+static const CHAR *const IO_JOB_AXIS_KEY[IO_JOB_AXES] = { "mode", "norm", "power", "gamma-max", "lower", "upper" };
+
+
+
+
+
+//******************************************************************************
+//! \breif      Read a job file
+//! \remark     One job per line : mode norm power gamma_max lower upper.
+//!             Blank lines and text after IO_JOB_COMMENT are ignored.
+//!             A job that fails IoJob_IsValid is an invalid line. The mode
+//!             is not checked here.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  file_name  : Job file name
+//! \param[out] jobs       : Jobs (allocated, release with IoJob_Release)
+//! \param[out] count      : Number of jobs
+//! \param[out] error_line : Line number of the first invalid line
+//!                          (0 if the file cannot be read)
+//! \return     TRUE on success, FALSE otherwise
+//******************************************************************************
+BOOL IoJob_Read(const CHAR *file_name, IO_JOB **jobs, U32 *count, U32 *error_line)
+{
+    FILE *fp;
+    CHAR line[IO_JOB_LINE_LENGTH];
+    IO_JOB job, *grown;
+    U32 capacity, line_number;
+    S32 parsed;
+
+    *jobs = NULL;
+    *count = 0;
+    *error_line = 0;
+
+    if ((fp = fopen(file_name, "r")) == NULL) {
+        return FALSE;
+    }
+
+    capacity = 0;
+    line_number = 0;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        line_number++;
+
+        if ((parsed = parseLine(line, &job)) == 0) {
+            continue;
+        }
+        if (parsed < 0) {
+            *error_line = line_number;
+            break;
+        }
+
+        if (*count == capacity) {
+            capacity = (capacity == 0) ? IO_JOB_INITIAL_CAPACITY : (2 * capacity);
+            if ((grown = (IO_JOB *)realloc(*jobs, sizeof(IO_JOB) * capacity)) == NULL) {
+                break;
+            }
+            *jobs = grown;
+        }
+        (*jobs)[(*count)++] = job;
+    }
+
+    if ((ferror(fp) != 0) || (feof(fp) == 0)) {
+        fclose(fp);
+        IoJob_Release(*jobs);
+        *jobs = NULL;
+        *count = 0;
+        return FALSE;
+    }
+
+    fclose(fp);
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Read a sweep file and expand its axes into jobs
+//! \remark     One axis per line : key value [value ...], where the keys are
+//!             mode, norm, power, gamma-max, lower and upper. Every key must
+//!             be given once. The jobs are the Cartesian product of the axes
+//!             in that order (upper varies fastest).
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  file_name  : Sweep file name
+//! \param[out] jobs       : Jobs (allocated, release with IoJob_Release)
+//! \param[out] count      : Number of jobs
+//! \param[out] error_line : Line number of the first invalid line
+//!                          (0 if the file cannot be read or an axis is missing)
+//! \return     TRUE on success, FALSE otherwise
+//******************************************************************************
+BOOL IoJob_ReadSweep(const CHAR *file_name, IO_JOB **jobs, U32 *count, U32 *error_line)
+{
+    FILE *fp;
+    CHAR line[IO_JOB_LINE_LENGTH];
+    IO_JOB_AXIS axes[IO_JOB_AXES];
+    U32 a, i, line_number;
+    BOOL result;
+
+    *jobs = NULL;
+    *count = 0;
+    *error_line = 0;
+
+    if ((fp = fopen(file_name, "r")) == NULL) {
+        return FALSE;
+    }
+
+    for (a = 0; a < IO_JOB_AXES; a++) {
+        axes[a].Count = 0;
+        axes[a].Value = NULL;
+        axes[a].Line  = 0;
+    }
+
+    line_number = 0;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        line_number++;
+        if (parseAxis(line, line_number, axes) < 0) {
+            *error_line = line_number;
+            break;
+        }
+    }
+
+    result = ((ferror(fp) == 0) && (feof(fp) != 0)) ? TRUE : FALSE;
+    fclose(fp);
+
+    for (a = 0; (a < IO_JOB_AXES) && (result == TRUE); a++) {
+        if (axes[a].Count == 0) {
+            result = FALSE;
+        }
+    }
+
+    // Every lower must be below every upper, since all pairs are run
+    for (a = 0; (a < axes[IO_JOB_AXIS_LOWER].Count) && (result == TRUE); a++) {
+        for (i = 0; i < axes[IO_JOB_AXIS_UPPER].Count; i++) {
+            if (axes[IO_JOB_AXIS_LOWER].Value[a] >= axes[IO_JOB_AXIS_UPPER].Value[i]) {
+                *error_line = (axes[IO_JOB_AXIS_LOWER].Line > axes[IO_JOB_AXIS_UPPER].Line) ?
+                              axes[IO_JOB_AXIS_LOWER].Line : axes[IO_JOB_AXIS_UPPER].Line;
+                result = FALSE;
+                break;
+            }
+        }
+    }
+
+    if (result == TRUE) {
+        result = expandAxes(axes, jobs, count);
+    }
+
+    for (a = 0; a < IO_JOB_AXES; a++) {
+        free(axes[a].Value);
+    }
+
+    return result;
+}
+
+
+
+//******************************************************************************
+//! \breif      Release the jobs read by IoJob_Read
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  jobs : Jobs
+//! \return     None
+//******************************************************************************
+void IoJob_Release(IO_JOB *jobs)
+{
+    free(jobs);
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check the values of a job
+//! \remark     The mode is not checked here.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  job : Job
+//! \return     TRUE if norm and gamma_max are positive, 0 < lower < upper
+//!             and every value is finite, FALSE otherwise
+//******************************************************************************
+BOOL IoJob_IsValid(const IO_JOB *job)
+{
+    if ((isfinite(job->Norm) == 0) || (isfinite(job->Power) == 0) || (isfinite(job->GammaMax) == 0) ||
+        (isfinite(job->Lower) == 0) || (isfinite(job->Upper) == 0)) {
+        return FALSE;
+    }
+
+    return ((0.0 < job->Norm) && (0.0 < job->GammaMax) && (0.0 < job->Lower) && (job->Lower < job->Upper)) ? TRUE : FALSE;
+}
+
+
+
+
+
+//******************************************************************************
+//! \breif      Parse one line of a job file
+//! \remark     The fields are in the order of IO_JOB_AXIS_KEY. Each one must
+//!             be a whole number token that passes isValidAxisValue (the
+//!             mode an integer), so "1.5" or "1e3x" is rejected instead of
+//!             being read up to its first invalid character.
+//! 
+//! \callgraph  
+//! 
+//! \param[in,out] line : Line (the comment is cut off)
+//! \param[out] job     : Job
+//! \return     1 : job, 0 : blank or comment line, -1 : invalid line
+//******************************************************************************
+static S32 parseLine(CHAR *line, IO_JOB *job)
+{
+    CHAR *comment, *token, *end;
+    F64 value[IO_JOB_AXES];
+    U32 a;
+
+    // Longer than IO_JOB_LINE_LENGTH (the last line may lack the newline)
+    if ((strchr(line, '\n') == NULL) && (strlen(line) == IO_JOB_LINE_LENGTH - 1)) {
+        return -1;
+    }
+
+    if ((comment = strchr(line, IO_JOB_COMMENT)) != NULL) {
+        *comment = '\0';
+    }
+    if ((token = strtok(line, " \t\r\n")) == NULL) {
+        return 0;
+    }
+
+    for (a = 0; a < IO_JOB_AXES; a++) {
+        if (token == NULL) {
+            return -1;
+        }
+        value[a] = strtod(token, &end);
+        if ((end == token) || (*end != '\0') || (isValidAxisValue(a, value[a]) == FALSE)) {
+            return -1;
+        }
+        token = strtok(NULL, " \t\r\n");
+    }
+    if (token != NULL) {
+        return -1;
+    }
+
+    job->Mode     = (S32)value[0];
+    job->Norm     = value[1];
+    job->Power    = value[2];
+    job->GammaMax = value[3];
+    job->Lower    = value[4];
+    job->Upper    = value[5];
+
+    return (IoJob_IsValid(job) == TRUE) ? 1 : -1;
+}
+
+
+
+
+//******************************************************************************
+//! \breif      Parse one line of a sweep file
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in,out] line : Line (the comment is cut off)
+//! \param[in]  line_number : Line number
+//! \param[in,out] axes : Axes read so far [IO_JOB_AXES]
+//! \return     1 : axis, 0 : blank or comment line, -1 : invalid line
+//******************************************************************************
+static S32 parseAxis(CHAR *line, const U32 line_number, IO_JOB_AXIS *axes)
+{
+    CHAR *comment, *token, *end;
+    IO_JOB_AXIS *axis;
+    F64 *grown;
+    U32 a;
+
+    if ((strchr(line, '\n') == NULL) && (strlen(line) == IO_JOB_LINE_LENGTH - 1)) {
+        return -1;
+    }
+
+    if ((comment = strchr(line, IO_JOB_COMMENT)) != NULL) {
+        *comment = '\0';
+    }
+    if ((token = strtok(line, " \t\r\n")) == NULL) {
+        return 0;
+    }
+
+    for (a = 0; a < IO_JOB_AXES; a++) {
+        if (strcmp(token, IO_JOB_AXIS_KEY[a]) == 0) {
+            break;
+        }
+    }
+    if ((a == IO_JOB_AXES) || (axes[a].Count > 0)) {
+        return -1;
+    }
+
+    axis = &axes[a];
+    axis->Line = line_number;
+    while ((token = strtok(NULL, " \t\r\n")) != NULL) {
+        if ((grown = (F64 *)realloc(axis->Value, sizeof(F64) * (axis->Count + 1))) == NULL) {
+            return -1;
+        }
+        axis->Value = grown;
+        axis->Value[axis->Count] = strtod(token, &end);
+        if ((end == token) || (*end != '\0') || (isValidAxisValue(a, axis->Value[axis->Count]) == FALSE)) {
+            return -1;
+        }
+        axis->Count++;
+    }
+
+    return (axis->Count > 0) ? 1 : -1;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check one value of a sweep axis
+//! \remark     lower < upper is checked once every axis is read.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  axis  : Axis (index of IO_JOB_AXIS_KEY)
+//! \param[in]  value : Value
+//! \return     TRUE if the value is finite, an integer for mode, and
+//!             positive for norm, gamma-max, lower and upper, FALSE otherwise
+//******************************************************************************
+static BOOL isValidAxisValue(const U32 axis, const F64 value)
+{
+    if (isfinite(value) == 0) {
+        return FALSE;
+    }
+    if (axis == IO_JOB_AXIS_MODE) {
+        return ((value == floor(value)) && (fabs(value) <= (F64)INT32_MAX)) ? TRUE : FALSE;
+    }
+    if (axis == IO_JOB_AXIS_POWER) {
+        return TRUE;
+    }
+
+    return (0.0 < value) ? TRUE : FALSE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Expand the sweep axes into jobs
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  axes  : Axes [IO_JOB_AXES]
+//! \param[out] jobs  : Jobs (allocated)
+//! \param[out] count : Number of jobs
+//! \return     TRUE on success, FALSE if the jobs cannot be allocated
+//******************************************************************************
+static BOOL expandAxes(const IO_JOB_AXIS *axes, IO_JOB **jobs, U32 *count)
+{
+    U32 index[IO_JOB_AXES];
+    U32 a, j;
+    U64 n_jobs;
+
+    for (n_jobs = 1, a = 0; a < IO_JOB_AXES; a++) {
+        n_jobs *= axes[a].Count;
+        index[a] = 0;
+    }
+    if (n_jobs > 0xFFFFFFFFULL) {
+        return FALSE;
+    }
+    if ((*jobs = (IO_JOB *)malloc(sizeof(IO_JOB) * (size_t)n_jobs)) == NULL) {
+        return FALSE;
+    }
+
+    for (j = 0; j < (U32)n_jobs; j++) {
+        (*jobs)[j].Mode     = (S32)axes[0].Value[index[0]];
+        (*jobs)[j].Norm     = axes[1].Value[index[1]];
+        (*jobs)[j].Power    = axes[2].Value[index[2]];
+        (*jobs)[j].GammaMax = axes[3].Value[index[3]];
+        (*jobs)[j].Lower    = axes[4].Value[index[4]];
+        (*jobs)[j].Upper    = axes[5].Value[index[5]];
+
+        // Odometer, the last axis fastest
+        for (a = IO_JOB_AXES; a > 0; a--) {
+            if (++index[a - 1] < axes[a - 1].Count) {
+                break;
+            }
+            index[a - 1] = 0;
+        }
+    }
+    *count = (U32)n_jobs;
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+// End of File
+//******************************************************************************
@@ -0,0 +1,125 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#ifndef IO_JOB_H_
+#define IO_JOB_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include "common_typedef.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+#define IO_JOB_COMMENT                  '#'             //!< Rest of the line is ignored
+#define IO_JOB_AXES                     (6)             //!< Axes of a sweep file
+
+
+
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! One ICS calculation
+//----------------------------------------------------------
+typedef struct io_job_t {
+    S32         Mode;                   //!< ICS calculation mode
+    F64         Norm;                   //!< Electron spectrum : Normalization Factor
+    F64         Power;                  //!< Electron spectrum : Power
+    F64         GammaMax;               //!< Electron spectrum : Maximum Lorentz Factor (Cut-off)
+    F64         Lower;                  //!< Lower emitted energy [eV]
+    F64         Upper;                  //!< Upper emitted energy [eV]
+}IO_JOB;
+
+
+
+//==============================================================================
+// Export Scope Function Prototype
+//==============================================================================
+/**
+ * @brief               Read a job file
+ * 
+ * One job per line : mode norm power gamma_max lower upper.
+ * Blank lines and text after IO_JOB_COMMENT are ignored. Every field must be
+ * a whole number token and the mode an integer. A line with a missing or
+ * extra field, or a job that fails IoJob_IsValid, is an invalid line.
+ * 
+ * @param file_name     Job file name
+ * @param jobs          Jobs (allocated, release with IoJob_Release)
+ * @param count         Number of jobs
+ * @param error_line    Line number of the first invalid line (0 if the file cannot be read)
+ * @return BOOL         TRUE on success, FALSE otherwise
+ */
+extern BOOL IoJob_Read(const CHAR *file_name, IO_JOB **jobs, U32 *count, U32 *error_line);
+
+/**
+ * @brief               Read a sweep file and expand its axes into jobs
+ * 
+ * One axis per line : key value [value ...], where the keys are mode, norm,
+ * power, gamma-max, lower and upper. Every key must be given once. The jobs
+ * are the Cartesian product of the axes in that order (upper varies fastest).
+ * Mode values must be integers. Norm, gamma-max, lower and upper must be
+ * positive and every lower below every upper.
+ * 
+ * @param file_name     Sweep file name
+ * @param jobs          Jobs (allocated, release with IoJob_Release)
+ * @param count         Number of jobs
+ * @param error_line    Line number of the first invalid line (0 if the file cannot be read or an axis is missing)
+ * @return BOOL         TRUE on success, FALSE otherwise
+ */
+extern BOOL IoJob_ReadSweep(const CHAR *file_name, IO_JOB **jobs, U32 *count, U32 *error_line);
+
+/**
+ * @brief               Release the jobs read by IoJob_Read or IoJob_ReadSweep
+ * 
+ * @param jobs          Jobs
+ */
+extern void IoJob_Release(IO_JOB *jobs);
+
+/**
+ * @brief               Check the values of a job (not the mode)
+ * 
+ * @param job           Job
+ * @return BOOL         TRUE if norm and gamma_max are positive, 0 < lower < upper and every value is finite
+ */
+extern BOOL IoJob_IsValid(const IO_JOB *job);
+
+
+
+#ifdef _cplusplus
+}
+#endif
+
+#endif
+
+//******************************************************************************
+// End of File
+//******************************************************************************
@@ -0,0 +1,398 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#define IO_TABLE_C_
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#if defined(__unix__) || defined(__APPLE__)
+#define _POSIX_C_SOURCE 200809L
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define IO_TABLE_USE_MMAP
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "io_table.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+#define IO_TABLE_TEMPORARY_SUFFIX       ".tmp"          //!< Suffix of the file written before the rename
+
+
+
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! Compile-time check of the on-disk header size
+//----------------------------------------------------------
+typedef CHAR IO_TABLE_HEADER_SIZE_CHECK[(sizeof(IO_TABLE_HEADER) == 512) ? 1 : -1];
+
+
+
+//==============================================================================
+// File Scope Function Prototype
+//==============================================================================
+static U64 alignOffset(const U64 offset);
+static BOOL readImage(IO_TABLE *table, const CHAR *file_name);
+static BOOL isValidImage(const IO_TABLE *table);
+
+
+
+//==============================================================================
+// File Scope Variables
+//==============================================================================
+//----------------------------------------------------------
+//! Zero padding written between payloads
+//----------------------------------------------------------
+static const U8 PADDING[IO_TABLE_ALIGNMENT] = { 0 };
+
+
+
+
+
+//******************************************************************************
+//! \breif      Initialize a header with the signature and the version
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[out] header : Header to be initialized
+//! \param[in]  kind   : IO_TABLE_KIND_xxx
+//! \return     None
+//******************************************************************************
+void IoTable_InitHeader(IO_TABLE_HEADER *header, const U32 kind)
+{
+    memset(header, 0, sizeof(IO_TABLE_HEADER));
+    memcpy(header->Magic, IO_TABLE_MAGIC, sizeof(header->Magic));
+    header->Version = IO_TABLE_VERSION;
+    header->HeaderSize = (U32)sizeof(IO_TABLE_HEADER);
+    header->Kind = kind;
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Write a table file
+//! \remark     1) The payload offsets are assigned here, each one rounded up
+//!                to IO_TABLE_ALIGNMENT so that a mapped payload can be used
+//!                as an aligned F64 array.
+//!             2) The table is written to "<file>.tmp" and renamed over the
+//!                file. A process that mapped the previous file keeps its
+//!                pages, and an interrupted write leaves the previous file
+//!                intact.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  file_name : File name
+//! \param[in]  header    : Header with SectionCount and Section[].Count set
+//! \param[in]  sections  : Payload arrays [SectionCount]
+//! \return     TRUE on success
+//******************************************************************************
+BOOL IoTable_Write(const CHAR *file_name, const IO_TABLE_HEADER *header, const F64 *const *sections)
+{
+    IO_TABLE_HEADER image;
+    FILE *fp;
+    CHAR *temporary;
+    U64 offset, position;
+    U32 i;
+    BOOL result;
+
+    if (header->SectionCount > IO_TABLE_MAX_SECTIONS) {
+        return FALSE;
+    }
+    if ((temporary = (CHAR *)malloc(strlen(file_name) + sizeof(IO_TABLE_TEMPORARY_SUFFIX))) == NULL) {
+        return FALSE;
+    }
+    sprintf(temporary, "%s%s", file_name, IO_TABLE_TEMPORARY_SUFFIX);
+
+    image = *header;
+    offset = sizeof(IO_TABLE_HEADER);
+    for (i = 0; i < image.SectionCount; i++) {
+        offset = alignOffset(offset);
+        image.Section[i].Offset = offset;
+        offset += image.Section[i].Count * sizeof(F64);
+    }
+
+    if ((fp = fopen(temporary, "wb")) == NULL) {
+        free(temporary);
+        return FALSE;
+    }
+
+    result = (fwrite(&image, sizeof(IO_TABLE_HEADER), 1, fp) == 1) ? TRUE : FALSE;
+    position = sizeof(IO_TABLE_HEADER);
+
+    for (i = 0; (i < image.SectionCount) && (result == TRUE); i++) {
+        if (fwrite(PADDING, 1, (size_t)(image.Section[i].Offset - position), fp) != (size_t)(image.Section[i].Offset - position)) {
+            result = FALSE;
+        }
+        else if (fwrite(sections[i], sizeof(F64), (size_t)image.Section[i].Count, fp) != (size_t)image.Section[i].Count) {
+            result = FALSE;
+        }
+        position = image.Section[i].Offset + image.Section[i].Count * sizeof(F64);
+    }
+
+    if (fclose(fp) != 0) {
+        result = FALSE;
+    }
+
+    if (result == FALSE) {
+        remove(temporary);
+    }
+    else if (rename(temporary, file_name) != 0) {
+        // rename does not replace an existing file on every platform
+        remove(file_name);
+        result = (rename(temporary, file_name) == 0) ? TRUE : FALSE;
+    }
+    free(temporary);
+
+    return result;
+}
+
+
+
+//******************************************************************************
+//! \breif      Open a table file without parsing its payloads
+//! \remark     The file is memory-mapped read-only where mmap is available, so
+//!             processes opening the same file share its pages. Elsewhere the
+//!             file is read into memory.
+//! 
+//! \callgraph  
+//! 
+//! \param[out] table     : Opened table
+//! \param[in]  file_name : File name
+//! \return     TRUE on success, FALSE if the file is missing or invalid
+//******************************************************************************
+BOOL IoTable_Open(IO_TABLE *table, const CHAR *file_name)
+{
+    table->Header = NULL;
+    table->Image = NULL;
+    table->Size = 0;
+    table->Mapped = FALSE;
+
+    if (readImage(table, file_name) == FALSE) {
+        return FALSE;
+    }
+
+    if (isValidImage(table) == FALSE) {
+        IoTable_Close(table);
+        return FALSE;
+    }
+
+    table->Header = (const IO_TABLE_HEADER *)table->Image;
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Get a payload of an opened table
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  table : Opened table
+//! \param[in]  index : Payload index
+//! \return     Payload (NULL if the index is out of range)
+//******************************************************************************
+const F64 *IoTable_GetSection(const IO_TABLE *table, const U32 index)
+{
+    if ((table->Header == NULL) || (index >= table->Header->SectionCount)) {
+        return NULL;
+    }
+
+    return (const F64 *)(table->Image + table->Header->Section[index].Offset);
+}
+
+
+
+//******************************************************************************
+//! \breif      Close a table file
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  table : Opened table
+//! \return     None
+//******************************************************************************
+void IoTable_Close(IO_TABLE *table)
+{
+    if (table->Image != NULL) {
+#ifdef IO_TABLE_USE_MMAP
+        if (table->Mapped == TRUE) {
+            munmap((void *)table->Image, table->Size);
+        }
+        else {
+            free((void *)table->Image);
+        }
+#else
+        free((void *)table->Image);
+#endif
+    }
+
+    table->Header = NULL;
+    table->Image = NULL;
+    table->Size = 0;
+    table->Mapped = FALSE;
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Round an offset up to the payload alignment
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  offset : Offset [byte]
+//! \return     Aligned offset [byte]
+//******************************************************************************
+static U64 alignOffset(const U64 offset)
+{
+    return (offset + (IO_TABLE_ALIGNMENT - 1)) & ~((U64)IO_TABLE_ALIGNMENT - 1);
+}
+
+
+
+//******************************************************************************
+//! \breif      Map or read the whole file
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[out] table     : Table receiving the file image
+//! \param[in]  file_name : File name
+//! \return     TRUE on success
+//******************************************************************************
+static BOOL readImage(IO_TABLE *table, const CHAR *file_name)
+{
+#ifdef IO_TABLE_USE_MMAP
+    struct stat st;
+    void *image;
+    int fd;
+
+    if ((fd = open(file_name, O_RDONLY)) < 0) {
+        return FALSE;
+    }
+
+    if ((fstat(fd, &st) != 0) || (st.st_size < (off_t)sizeof(IO_TABLE_HEADER))) {
+        close(fd);
+        return FALSE;
+    }
+
+    image = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (image == MAP_FAILED) {
+        return FALSE;
+    }
+
+    table->Image = (const U8 *)image;
+    table->Size = (size_t)st.st_size;
+    table->Mapped = TRUE;
+#else
+    FILE *fp;
+    long size;
+    U8 *image;
+
+    if ((fp = fopen(file_name, "rb")) == NULL) {
+        return FALSE;
+    }
+
+    if ((fseek(fp, 0, SEEK_END) != 0) || ((size = ftell(fp)) < (long)sizeof(IO_TABLE_HEADER)) ||
+        (fseek(fp, 0, SEEK_SET) != 0) || ((image = (U8 *)malloc((size_t)size)) == NULL)) {
+        fclose(fp);
+        return FALSE;
+    }
+
+    if (fread(image, 1, (size_t)size, fp) != (size_t)size) {
+        free(image);
+        fclose(fp);
+        return FALSE;
+    }
+    fclose(fp);
+
+    table->Image = image;
+    table->Size = (size_t)size;
+    table->Mapped = FALSE;
+#endif
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Validate the header and the payload descriptors of an image
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  table : Table holding the file image
+//! \return     TRUE if the image is a valid table of this version
+//******************************************************************************
+static BOOL isValidImage(const IO_TABLE *table)
+{
+    const IO_TABLE_HEADER *header = (const IO_TABLE_HEADER *)table->Image;
+    U32 i;
+
+    if ((memcmp(header->Magic, IO_TABLE_MAGIC, sizeof(header->Magic)) != 0) ||
+        (header->Version != IO_TABLE_VERSION) ||
+        (header->HeaderSize != sizeof(IO_TABLE_HEADER)) ||
+        (header->SectionCount > IO_TABLE_MAX_SECTIONS)) {
+        return FALSE;
+    }
+
+    for (i = 0; i < header->SectionCount; i++) {
+        if (((header->Section[i].Offset % IO_TABLE_ALIGNMENT) != 0) ||
+            (header->Section[i].Offset > table->Size) ||
+            (header->Section[i].Count > (table->Size - header->Section[i].Offset) / sizeof(F64))) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+
+
+
+
+//******************************************************************************
+// End of File
+//******************************************************************************
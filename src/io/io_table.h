@@ -0,0 +1,168 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#ifndef IO_TABLE_H_
+#define IO_TABLE_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include <stddef.h>
+#include "common_typedef.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+#define IO_TABLE_MAGIC                  "ICSTABLE"      //!< File signature (8 bytes)
+#define IO_TABLE_VERSION                (1)             //!< Format version
+#define IO_TABLE_ALIGNMENT              (64)            //!< Payload alignment [byte]
+#define IO_TABLE_MAX_SECTIONS           (8)             //!< Maximum number of payloads
+
+#define IO_TABLE_KIND_KERNEL            (1)             //!< CMB-integrated ICS kernel
+#define IO_TABLE_KIND_SPECTRUM          (2)             //!< ICS spectrum
+#define IO_TABLE_KIND_CHECKPOINT        (3)             //!< MCMC ensemble checkpoint
+#define IO_TABLE_KIND_JONES             (4)             //!< Chebyshev table of the Jones kernel
+
+
+
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! Payload descriptor (float64 array)
+//----------------------------------------------------------
+typedef struct io_table_section_t {
+    U64         Offset;                 //!< Offset from the top of the file [byte]
+    U64         Count;                  //!< Number of float64 elements
+}IO_TABLE_SECTION;
+
+//----------------------------------------------------------
+//! File header (512 bytes, payloads follow on 64-byte boundaries)
+//----------------------------------------------------------
+typedef struct io_table_header_t {
+    CHAR        Magic[8];               //!< IO_TABLE_MAGIC
+    U32         Version;                //!< IO_TABLE_VERSION
+    U32         HeaderSize;             //!< sizeof(IO_TABLE_HEADER)
+    U32         Kind;                   //!< IO_TABLE_KIND_xxx
+    S32         Mode;                   //!< ICS kernel mode
+    F64         CmbTemperature;         //!< CMB Temperature [K]
+    F64         EinitLower;             //!< Lower incident photon energy [eV]
+    F64         EinitUpper;             //!< Upper incident photon energy [eV]
+    F64         GammaLower;             //!< Lower Lorentz factor
+    F64         GammaUpper;             //!< Upper Lorentz factor
+    F64         EfinLower;              //!< Lower scattered photon energy [eV]
+    F64         EfinUpper;              //!< Upper scattered photon energy [eV]
+    U32         EinitIteration;         //!< Iteration count of incident photon energy
+    U32         GammaIteration;         //!< Iteration count of Lorentz factor
+    U32         EfinCount;              //!< Number of scattered photon energies
+    U32         SectionCount;           //!< Number of payloads
+    F64         NormFactor;             //!< Electron normalization factor (spectrum only)
+    F64         SpectrumPower;          //!< Electron power (spectrum only)
+    F64         GammaMax;               //!< Electron maximum Lorentz factor (spectrum only)
+    IO_TABLE_SECTION Section[IO_TABLE_MAX_SECTIONS];   //!< Payload descriptors
+    S32         Precision;              //!< ICS kernel precision (0 : double)
+    U32         Padding;                //!< Reserved (zero)
+    F64         ThomsonLimit;           //!< Jones kernel : Thomson limit threshold (0 : never)
+    F64         TableTolerance;         //!< Jones kernel table : requested maximum relative error (0 : no table)
+    U8          Reserved[240];          //!< Reserved (zero)
+}IO_TABLE_HEADER;
+
+//----------------------------------------------------------
+//! Opened table file
+//----------------------------------------------------------
+typedef struct io_table_t {
+    const IO_TABLE_HEADER *Header;      //!< Header at the top of the file image
+    const U8    *Image;                 //!< File image
+    size_t      Size;                   //!< File size [byte]
+    BOOL        Mapped;                 //!< TRUE if the image is memory-mapped
+}IO_TABLE;
+
+
+
+//==============================================================================
+// Export Scope Function Prototype
+//==============================================================================
+/**
+ * @brief           Initialize a header with the signature and the version
+ * 
+ * @param header    Header to be initialized
+ * @param kind      IO_TABLE_KIND_xxx
+ */
+extern void IoTable_InitHeader(IO_TABLE_HEADER *header, const U32 kind);
+
+/**
+ * @brief           Write a table file
+ * 
+ * Written to "<file_name>.tmp" and renamed, so a mapped previous file keeps
+ * its content.
+ * 
+ * @param file_name File name
+ * @param header    Header with SectionCount and Section[].Count set
+ * @param sections  Payload arrays [SectionCount]
+ * @return BOOL     TRUE on success
+ */
+extern BOOL IoTable_Write(const CHAR *file_name, const IO_TABLE_HEADER *header, const F64 *const *sections);
+
+/**
+ * @brief           Open a table file without parsing its payloads
+ * 
+ * @param table     Opened table
+ * @param file_name File name
+ * @return BOOL     TRUE on success, FALSE if the file is missing or invalid
+ */
+extern BOOL IoTable_Open(IO_TABLE *table, const CHAR *file_name);
+
+/**
+ * @brief           Get a payload of an opened table
+ * 
+ * @param table     Opened table
+ * @param index     Payload index
+ * @return const F64* Payload (NULL if the index is out of range)
+ */
+extern const F64 *IoTable_GetSection(const IO_TABLE *table, const U32 index);
+
+/**
+ * @brief           Close a table file
+ * 
+ * @param table     Opened table
+ */
+extern void IoTable_Close(IO_TABLE *table);
+
+
+
+#ifdef _cplusplus
+}
+#endif
+
+#endif
+
+//******************************************************************************
+// End of File
+//******************************************************************************
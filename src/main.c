@@ -35,9 +35,16 @@
 #include <math.h>
 
 #include "common_typedef.h"
-#include "ics_jones_approx.h"
-#include "ics_thomson_approx.h"
-#include "numerics_trapezoidal.h"
+#include "ics_cmb_spectrum.h"
+#include "ics_response.h"
+#include "ics_sweep.h"
+#include "ics_precision.h"
+#include "fitting_data.h"
+#include "fitting_mcmc.h"
+#include "fitting_spectrum.h"
+#include "io_chain.h"
+#include "io_job.h"
+#include "io_table.h"
 #include "particles_cmb.h"
 #include "particles_electron.h"
 
@@ -45,37 +52,79 @@
 //==============================================================================
 // Macro Definitios
 //==============================================================================
-#define USE_JONES_APPROX                    (1)
-#define USE_THOMSON_APPROX                  (2)
 #define INTEGRATION_RANGE_EINIT_LOWER       (1.0E-15)
 #define INTEGRATION_RANGE_EINIT_UPPER       (1.0E+4)
 #define INTEGRATION_RANGE_EINIT_ITERATION   (500)
 #define INTEGRATION_RANGE_GAMMA_LOWER       (1.0E+1)
 #define INTEGRATION_RANGE_GAMMA_UPPER_PLUS  (1.0E+2)
 #define INTEGRATION_RANGE_GAMMA_ITERATION   (500)
+#define INTEGRATION_CMB_LAGUERRE_POINTS     (0)     //!< Default -c (0 : log grid)
+#define INTEGRATION_CMB_LAGUERRE_MAX        (256)   //!< Largest -c (the Laguerre roots are not found above about 290)
 #define FLUX_CALC_STRIDE_LOG                (0.1000)
+#define THOMSON_LIMIT_MAX                   (0.01)  //!< Largest --thomson-limit (the flux deviates by up to about G)
+
+#define MAIN_SWEEP_FILE                     (0)     //!< getFileName mode of a parameter sweep
+#define MAIN_FIT_FILE                       (-1)    //!< getFileName mode of a spectral fit
+#define MAIN_MCMC_FILE                      (-2)    //!< getFileName mode of a posterior chain
+
+#define FIT_GAMMA_UPPER                     (1.0E+11)   //!< Upper Lorentz factor of the fit response matrix
+#define FIT_GAMMA_ITERATION                 (1000)      //!< Gamma nodes of the fit response matrix
+#define FIT_START_POWER                     (2.5)       //!< Start power unless the electron flags are given
+#define FIT_START_GAMMA_MAX                 (1.0E+8)    //!< Start gamma_max unless the electron flags are given
+#define FIT_DEGENERATE_CORRELATION          (0.95)      //!< |correlation| above which a parameter pair is reported as degenerate
+#define MCMC_WALKERS                        (32)        //!< Default number of walkers
+#define MCMC_SEED                           (1)         //!< Default random seed
+#define MCMC_STRETCH_SCALE                  (2.0)       //!< Stretch scale of the proposal
+#define MCMC_CHECKPOINT_INTERVAL            (100)       //!< Steps between checkpoints
+
+#define MAIN_JOB_MODE                       (0x01)  //!< --mode given
+#define MAIN_JOB_NORM                       (0x02)  //!< --norm given
+#define MAIN_JOB_POWER                      (0x04)  //!< --power given
+#define MAIN_JOB_GAMMA_MAX                  (0x08)  //!< --gamma-max given
+#define MAIN_JOB_LOWER                      (0x10)  //!< --lower given
+#define MAIN_JOB_UPPER                      (0x20)  //!< --upper given
+#define MAIN_JOB_ELECTRON                   (MAIN_JOB_NORM | MAIN_JOB_POWER | MAIN_JOB_GAMMA_MAX)
+#define MAIN_JOB_RANGE                      (MAIN_JOB_LOWER | MAIN_JOB_UPPER)
 
 
 
 //==============================================================================
-// File Scope Global Variables
+// Type Definition
 //==============================================================================
 //----------------------------------------------------------
-//! Jones approximation or Thomson approximation
-//----------------------------------------------------------
-static S32 icsMode = 0;
-
-//----------------------------------------------------------
-// Electron Flux Parameter
+//! Command-line options
 //----------------------------------------------------------
-static F64 normFactor    = 0.0;         //!< Normalization Factor
-static F64 spectrumPower = 0.0;         //!< Power
-static F64 gammaMax      = 0.0;         //!< Maximum Lorentz Factor
+typedef struct main_options_t {
+    const CHAR* ResponseFile;       //!< Response matrix cache file (NULL if not given)
+    S32         Precision;          //!< Kernel precision (ICS_PRECISION_xxx)
+    BOOL        PrecisionReport;    //!< Print the kernel precision report and exit
+    const CHAR* TableFile;          //!< Jones kernel table file (NULL if not given)
+    ICS_JONES_TABLE JonesTable;     //!< Jones kernel table (ICS_PRECISION_TABLE only)
+    F64         ThomsonLimit;       //!< Jones : 4 einit gamma / mc^2 below which the Thomson limit is used (0 : never)
+    F64         Tolerance;          //!< Relative tolerance of the adaptive rule (0 : fixed grid)
+    U32         CmbPoints;          //!< Gauss-Laguerre points over the CMB (0 : log grid)
+    F64         TailTolerance;      //!< Relative tail level of the integration bounds (0 : fixed bounds)
+    BOOL        Sweep;              //!< All emitted energies in one sweep of the grid
+    const CHAR* JobFile;            //!< Job file (NULL : single job)
+    const CHAR* SweepFile;          //!< Sweep file (NULL : no sweep)
+    const CHAR* FitFile;            //!< Observed spectrum to be fitted (NULL : no fit)
+    U32         McmcSteps;          //!< Posterior sampling steps after the fit (0 : none)
+    U32         McmcWalkers;        //!< Number of walkers
+    U32         McmcSeed;           //!< Random seed
+    const CHAR* ChainFile;          //!< Chain file (NULL : named after the time)
+    IO_JOB      Job;                //!< Job given on the command line
+    U32         JobFields;          //!< MAIN_JOB_xxx given on the command line
+}MAIN_OPTIONS;
 
 //----------------------------------------------------------
-//! Energy currently being calculated
+//! Grids and response matrix kept between jobs
 //----------------------------------------------------------
-static F64 emittedEnergy = 0.0;
+typedef struct main_cache_t {
+    BOOL                HasSpectrum;    //!< Spectrum holds the grids of the previous job
+    ICS_CMB_SPECTRUM    Spectrum;       //!< Grids and CMB density
+    BOOL                HasResponse;    //!< Response holds a loaded or built matrix
+    ICS_RESPONSE        Response;       //!< Response matrix
+}MAIN_CACHE;
 
 
 
@@ -111,15 +160,19 @@ static const CHAR *getCurrentTime(void)
 
 
 //******************************************************************************
-//! \breif     Get the file name
+//! \breif     Get the file name without extension
 //! \remark
 //!
 //! \callgraph
 //!
-//! \param[in]  mode - 1 : Use Jones Approximation, 2 : Thomson Approximation
-//! \return     File name
+//! \param[in]  mode - 1 : Use Jones Approximation, 2 : Thomson Approximation,
+//!                    3 : KAK Approximation, 4 : Jones and Thomson Approximation,
+//!                    MAIN_SWEEP_FILE : Parameter sweep,
+//!                    MAIN_FIT_FILE : Spectral fit, MAIN_MCMC_FILE : Posterior chain
+//! \param[in]  index - Job number appended to the name (0 : none)
+//! \return     File name without extension
 //******************************************************************************
-static const CHAR *getFileName(const S32 mode)
+static const CHAR *getFileName(const S32 mode, const U32 index)
 {
     time_t now;
     struct tm *ts;
@@ -136,10 +189,25 @@ static const CHAR *getFileName(const S32 mode)
     //------------------------------------------------------
     switch (mode) {
     case USE_JONES_APPROX:
-        strftime(name, sizeof(name), "ics_jones_%Y%m%d%H%M%S.log", ts);
+        strftime(name, sizeof(name), "ics_jones_%Y%m%d%H%M%S", ts);
         break;
     case USE_THOMSON_APPROX:
-        strftime(name, sizeof(name), "ics_thomson_%Y%m%d%H%M%S.log", ts);
+        strftime(name, sizeof(name), "ics_thomson_%Y%m%d%H%M%S", ts);
+        break;
+    case USE_KAK_APPROX:
+        strftime(name, sizeof(name), "ics_kak_%Y%m%d%H%M%S", ts);
+        break;
+    case USE_JONES_THOMSON_APPROX:
+        strftime(name, sizeof(name), "ics_jones_thomson_%Y%m%d%H%M%S", ts);
+        break;
+    case MAIN_SWEEP_FILE:
+        strftime(name, sizeof(name), "ics_sweep_%Y%m%d%H%M%S", ts);
+        break;
+    case MAIN_FIT_FILE:
+        strftime(name, sizeof(name), "ics_fit_%Y%m%d%H%M%S", ts);
+        break;
+    case MAIN_MCMC_FILE:
+        strftime(name, sizeof(name), "ics_mcmc_%Y%m%d%H%M%S", ts);
         break;
     default:
         printf("[ERROR] ");
@@ -147,11 +215,85 @@ static const CHAR *getFileName(const S32 mode)
         break;
     }
 
+    if (index > 0) {
+        sprintf(&name[strlen(name)], "_%04u", index);
+    }
+
     return (const CHAR *)&name[0];
 }
 
 
 
+//******************************************************************************
+//! \breif      Check the ICS calculation mode.
+//! \remark     Exits on an unknown mode.
+//!
+//! \callgraph
+//!
+//! \param[in]  mode ICS calculation mode
+//! \return     None
+//******************************************************************************
+static void checkIcsCalcMode(const S32 mode)
+{
+    if ((mode != USE_JONES_APPROX) && (mode != USE_THOMSON_APPROX) && (mode != USE_KAK_APPROX) && (mode != USE_JONES_THOMSON_APPROX)) {
+        printf("[ERROR] Select 1 (Jones), 2 (Thomson), 3 (KAK) or 4 (Jones and Thomson) for calculation mode ...\n\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check the ICS calculation mode of a job against the options.
+//! \remark     Exits on an unknown mode, or on mode 4 with -r, -a or -s.
+//!             Every job is checked before the first one runs.
+//!
+//! \callgraph
+//!
+//! \param[in]  options Command-line options
+//! \param[in]  mode    ICS calculation mode
+//! \return     None
+//******************************************************************************
+static void checkJobMode(const MAIN_OPTIONS *options, const S32 mode)
+{
+    checkIcsCalcMode(mode);
+
+    if ((mode == USE_JONES_THOMSON_APPROX) && ((options->ResponseFile != NULL) || (options->Tolerance > 0.0) || (options->Sweep == TRUE))) {
+        printf("[ERROR] Mode 4 cannot be used with -r, -a or -s.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check the values of a job given on the command line or console.
+//! \remark     Exits unless norm and gamma_max are positive and
+//!             0 < lower < upper. Job and sweep files are checked as they
+//!             are read.
+//!
+//! \callgraph
+//!
+//! \param[in]  job Calculation conditions
+//! \return     None
+//******************************************************************************
+static void checkJob(const IO_JOB *job)
+{
+    if (IoJob_IsValid(job) == FALSE) {
+        printf("[ERROR] Norm and gamma max must be positive and 0 < lower < upper : %E %E %E %E\n",
+               job->Norm, job->GammaMax, job->Lower, job->Upper);
+        exit(EXIT_FAILURE);
+    }
+
+    return;
+}
+
+
+
 //******************************************************************************
 //! \breif      Read the ICS calculation mode from the console.
 //! \remark
@@ -159,15 +301,18 @@ static const CHAR *getFileName(const S32 mode)
 //! \callgraph
 //!
 //! \param      None
-//! \return     1 : Use Jones Approximation, 2 : Thomson Approximation
+//! \return     1 : Use Jones Approximation, 2 : Thomson Approximation,
+//!             3 : KAK Approximation, 4 : Jones and Thomson Approximation
 //******************************************************************************
 static S32 readIcsCalcMode(void)
 {
     S32 mode, scan_result;
 
-    printf("Enter the ICS calculation mode (1 or 2).\n");
+    printf("Enter the ICS calculation mode (1, 2, 3 or 4).\n");
     printf("  1 : ICS flux on CMB and non-thermal electron using Jones Approximation\n");
     printf("  2 : ICS flux on CMB and non-thermal electron using Thomson Approximation\n");
+    printf("  3 : ICS flux on CMB and non-thermal electron using KAK Approximation (analytic CMB integral)\n");
+    printf("  4 : ICS flux on CMB and non-thermal electron using Jones and Thomson Approximation (one pass, with their ratio)\n");
     printf("[User's Operation] Mode = ");
 
     scan_result = scanf("%d", &mode);
@@ -178,10 +323,7 @@ static S32 readIcsCalcMode(void)
         exit(EXIT_FAILURE);
     }
 
-    if ((mode != USE_JONES_APPROX) && (mode != USE_THOMSON_APPROX)) {
-        printf("[ERROR] Select 1 (Jones) or 2 (Thomson) for calculation mode ...\n\n");
-        exit(EXIT_FAILURE);
-    }
+    checkIcsCalcMode(mode);
 
     return mode;
 }
@@ -264,91 +406,1360 @@ static void readElectronSpectrum(F64 *norm, F64 *power, F64 *gmax)
 
 
 //******************************************************************************
-//! \breif      Integrand used for the ICS flux calculation.
-//! \remark
+//! \breif      Write the calculated spectrum as a binary table.
+//! \remark     Payloads : scattered photon energies, flux (and the Thomson
+//!             flux of USE_JONES_THOMSON_APPROX).
+//!
+//! \callgraph
+//!
+//! \param[in]  file_name    File name
+//! \param[in]  mode         ICS calculation mode
+//! \param[in]  einit_range  Integration Range of incident photon energy [eV]
+//! \param[in]  gamma_range  Integration Range of Lorentz factor
+//! \param[in]  norm         Normalization Factor
+//! \param[in]  power        Power of spectrum
+//! \param[in]  gmax         Maximum Lorentz Factor
+//! \param[in]  energies     Scattered photon energies [eV]
+//! \param[in]  fluxes       ICS flux
+//! \param[in]  thomsons     ICS flux of the Thomson approximation (NULL : none)
+//! \param[in]  count        Number of points
+//! \return     TRUE on success
+//******************************************************************************
+static BOOL writeSpectrumTable(const CHAR *file_name, const S32 mode, const INTEGRATION_RANGE *einit_range, const INTEGRATION_RANGE *gamma_range,
+                               const F64 norm, const F64 power, const F64 gmax, const F64 *energies, const F64 *fluxes, const F64 *thomsons, const U32 count)
+{
+    IO_TABLE_HEADER header;
+    const F64 *sections[3];
+
+    IoTable_InitHeader(&header, IO_TABLE_KIND_SPECTRUM);
+    header.Mode = mode;
+    header.CmbTemperature = PatriclesCmb_GetTemperature();
+    header.EinitLower = einit_range->Lower;
+    header.EinitUpper = einit_range->Upper;
+    header.EinitIteration = einit_range->Iteration;
+    header.GammaLower = gamma_range->Lower;
+    header.GammaUpper = gamma_range->Upper;
+    header.GammaIteration = gamma_range->Iteration;
+    header.EfinCount = count;
+    header.EfinLower = (count > 0) ? energies[0] : 0.0;
+    header.EfinUpper = (count > 0) ? energies[count - 1] : 0.0;
+    header.NormFactor = norm;
+    header.SpectrumPower = power;
+    header.GammaMax = gmax;
+
+    header.SectionCount = (thomsons != NULL) ? 3 : 2;
+    header.Section[0].Count = count;
+    header.Section[1].Count = count;
+    header.Section[2].Count = count;
+    sections[0] = energies;
+    sections[1] = fluxes;
+    sections[2] = thomsons;
+
+    return IoTable_Write(file_name, &header, sections);
+}
+
+
+
+//******************************************************************************
+//! \breif      Print the fraction of the kernel evaluations removed by the
+//!             kinematic pruning.
+//! \remark     With a Thomson limit threshold, the evaluations that use the
+//!             Thomson limit and the full Jones kernel are printed as well.
+//!
+//! \callgraph
+//!
+//! \param[in]  spectrum ICS spectrum
+//! \param[in]  energies Emitted energies [eV]
+//! \param[in]  count    Number of emitted energies
+//! \return     None
+//******************************************************************************
+static void printPruning(const ICS_CMB_SPECTRUM *spectrum, const F64 *energies, const S32 count)
+{
+    U64 evaluated, total, sum_evaluated = 0, sum_total = 0, sum_thomson = 0;
+    S32 i;
+
+    for (i = 0; i < count; i++) {
+        IcsCmbSpectrum_CountEvaluations(spectrum, energies[i], &evaluated, &total);
+        sum_evaluated += evaluated;
+        sum_total += total;
+        sum_thomson += IcsCmbSpectrum_CountThomsonLimit(spectrum, energies[i]);
+    }
+
+    if (sum_total > 0) {
+        printf("Kinematic pruning : %.1f %% of %.3E kernel evaluations skipped\n\n",
+               100.0 * (1.0 - (F64)sum_evaluated / (F64)sum_total), (F64)sum_total);
+    }
+    if ((spectrum->ThomsonLimit > 0.0) && ((spectrum->Mode == USE_JONES_APPROX) || (spectrum->Mode == USE_JONES_THOMSON_APPROX)) && (sum_evaluated > 0)) {
+        printf("Kernel regimes : %.3E Thomson limit (%.1f %%), %.3E Klein-Nishina (4 einit gamma / mc^2 >= %.1E)\n\n",
+               (F64)sum_thomson, 100.0 * (F64)sum_thomson / (F64)sum_evaluated, (F64)(sum_evaluated - sum_thomson), spectrum->ThomsonLimit);
+    }
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Create the emitted energies and the gamma range of a job
+//! \remark     Emitted energies are spaced by FLUX_CALC_STRIDE_LOG from the
+//!             lower energy. The gamma range ends where the cut-off falls
+//!             below the tail tolerance, or INTEGRATION_RANGE_GAMMA_UPPER_PLUS
+//!             times gamma_max without one.
 //!
 //! \callgraph
 //!
-//! \param[in]  einit   Incident photon energy [eV]
-//! \param[in]  gamma   Lorentz factor
-//! \return     Flux
+//! \param[in]  options     Command-line options
+//! \param[in]  job         Calculation conditions
+//! \param[out] energies    Emitted energies [eV] (allocated)
+//! \param[out] gamma_range Integration Range of Lorentz factor
+//! \return     Number of emitted energies
 //******************************************************************************
-static F64 icsFluxIntegrand(const F64 einit, const F64 gamma)
+static S32 createEnergies(const MAIN_OPTIONS *options, const IO_JOB *job, F64 **energies, INTEGRATION_RANGE *gamma_range)
 {
-    F64 flux;
+    F64 lower_log, upper_log;
+    S32 n_calc_points, i;
+
+    lower_log  = log10(job->Lower);
+    upper_log  = log10(job->Upper);
+    n_calc_points = (S32)((upper_log - lower_log) / FLUX_CALC_STRIDE_LOG);
+    if (n_calc_points < 0) {
+        n_calc_points = 0;
+    }
+
+    if ((*energies = (F64 *)calloc((size_t)n_calc_points + 1, sizeof(F64))) == NULL) {
+        printf("[ERROR] %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < n_calc_points; i++) {
+        (*energies)[i] = pow(10.0, lower_log + FLUX_CALC_STRIDE_LOG * (F64)i);
+    }
+
+    gamma_range->Lower = INTEGRATION_RANGE_GAMMA_LOWER;
+    gamma_range->Upper = job->GammaMax * INTEGRATION_RANGE_GAMMA_UPPER_PLUS;
+    if (options->TailTolerance > 0.0) {
+        gamma_range->Upper = fmax(ParticlesElectron_CalcCutoffBound(job->GammaMax, options->TailTolerance),
+                                  gamma_range->Lower * INTEGRATION_RANGE_GAMMA_UPPER_PLUS);
+    }
+    gamma_range->Iteration = INTEGRATION_RANGE_GAMMA_ITERATION;
+
+    return n_calc_points;
+}
+
+
+
+//******************************************************************************
+//! \breif      Create the log-grid range of einit
+//! \remark     The range ends where the CMB density falls below the tail
+//!             tolerance relative to its peak, or is the fixed
+//!             INTEGRATION_RANGE_EINIT_LOWER..UPPER without one. The
+//!             Gauss-Laguerre rule does not use it.
+//!
+//! \callgraph
+//!
+//! \param[in]  options     : Command-line options
+//! \param[out] einit_range : Integration Range of incident photon energy [eV]
+//! \return     None
+//******************************************************************************
+static void createEinitRange(const MAIN_OPTIONS *options, INTEGRATION_RANGE *einit_range)
+{
+    einit_range->Lower = INTEGRATION_RANGE_EINIT_LOWER;
+    einit_range->Upper = INTEGRATION_RANGE_EINIT_UPPER;
+    if (options->TailTolerance > 0.0) {
+        PatriclesCmb_CalcTailBounds(options->TailTolerance, &einit_range->Lower, &einit_range->Upper);
+    }
+    einit_range->Iteration = INTEGRATION_RANGE_EINIT_ITERATION;
+
+    return;
+}
+
 
-    flux = PatriclesCmb_CalcFlux(einit);
-    flux *= ParticlesElectron_CalcFlux(gamma, normFactor, spectrumPower, gammaMax);
 
-    if (icsMode == USE_JONES_APPROX) {
-        flux *= IcsJones_CalcFluxIso(emittedEnergy, einit, gamma);
+//******************************************************************************
+//! \breif      Create the ICS spectrum selected by the options
+//! \remark     The Gauss-Laguerre rule is used on einit when -c selects it,
+//!             unless the adaptive rule is selected, which only needs the
+//!             log-grid range.
+//!
+//! \callgraph
+//!
+//! \param[out] spectrum    : ICS spectrum
+//! \param[in]  mode        : ICS calculation mode
+//! \param[in]  options     : Command-line options
+//! \param[in]  gamma_range : Integration Range of Lorentz factor
+//! \return     None
+//******************************************************************************
+static void createSpectrum(ICS_CMB_SPECTRUM *spectrum, const S32 mode, const MAIN_OPTIONS *options, const INTEGRATION_RANGE *gamma_range)
+{
+    INTEGRATION_RANGE einit_range;
+    BOOL created;
+
+    if ((options->CmbPoints > 0) && (options->Tolerance == 0.0)) {
+        created = IcsCmbSpectrum_CreateBlackbody(spectrum, mode, options->CmbPoints, gamma_range);
     }
     else {
-        flux *= (F64)IcsThomson_CalcFluxIso((F128)emittedEnergy, (F128)einit, (F128)gamma);
+        createEinitRange(options, &einit_range);
+        created = IcsCmbSpectrum_Create(spectrum, mode, &einit_range, gamma_range);
     }
+    if (created == FALSE) {
+        printf("[ERROR] Failed to create the integration grids.\n");
+        exit(EXIT_FAILURE);
+    }
+    spectrum->Precision = options->Precision;
+    spectrum->JonesTable = &options->JonesTable;
+    spectrum->ThomsonLimit = options->ThomsonLimit;
 
-    return flux;
+    return;
 }
 
 
+
 //******************************************************************************
-//! \breif      Entry point.
-//! \remark
+//! \breif      Print the deviation of the KAK result from the Jones result
+//! \remark     The Jones flux is calculated on the same emitted energies and
+//!             the same integration grids.
+//!
+//! \callgraph
+//!
+//! \param[in]  options     : Command-line options
+//! \param[in]  gamma_range : Integration Range of Lorentz factor
+//! \param[in]  norm        : Normalization Factor
+//! \param[in]  power       : Power
+//! \param[in]  gamma_max   : Maximum Lorentz Factor (Cut-off)
+//! \param[in]  energies    : Emitted energies [eV]
+//! \param[in]  fluxes      : ICS flux of the KAK approximation
+//! \param[in]  count       : Number of emitted energies
+//! \return     None
+//******************************************************************************
+static void printJonesDeviation(const MAIN_OPTIONS *options, const INTEGRATION_RANGE *gamma_range, const F64 norm, const F64 power, const F64 gamma_max,
+                                const F64 *energies, const F64 *fluxes, const S32 count)
+{
+    ICS_CMB_SPECTRUM jones;
+    F64 flux, deviation, max_deviation = 0.0, sum_square = 0.0;
+    S32 i, n_compared = 0;
+
+    createSpectrum(&jones, USE_JONES_APPROX, options, gamma_range);
+    IcsCmbSpectrum_SetElectron(&jones, norm, power, gamma_max);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, 1) private(flux, deviation) reduction(max:max_deviation) reduction(+:sum_square, n_compared)
+#endif
+    for (i = 0; i < count; i++) {
+        flux = IcsCmbSpectrum_CalcFlux((const ICS_CMB_SPECTRUM *)&jones, energies[i]);
+        if (flux > 0.0) {
+            deviation = fabs(fluxes[i] / flux - 1.0);
+            max_deviation = fmax(max_deviation, deviation);
+            sum_square += deviation * deviation;
+            n_compared++;
+        }
+    }
+
+    IcsCmbSpectrum_Release(&jones);
+
+    if (n_compared > 0) {
+        printf("\nDeviation from Jones : max %.3f %%, rms %.3f %% (%d points)\n",
+               100.0 * max_deviation, 100.0 * sqrt(sum_square / (F64)n_compared), n_compared);
+    }
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Parse an unsigned integer argument.
+//! \remark     The whole text must be decimal digits.
+//!
+//! \callgraph
+//!
+//! \param[in]  text    Argument
+//! \param[in]  maximum Largest value accepted
+//! \param[out] value   Parsed value
+//! \return     TRUE on success, FALSE if the text is not an integer between
+//!             0 and maximum
+//******************************************************************************
+static BOOL parseUnsigned(const CHAR *text, const unsigned long maximum, U32 *value)
+{
+    CHAR *end;
+    unsigned long parsed;
+
+    errno = 0;
+    parsed = strtoul(text, &end, 10);
+    if ((end == text) || (*end != '\0') || (text[0] == '-') || (errno != 0) || (parsed > maximum)) {
+        return FALSE;
+    }
+    *value = (U32)parsed;
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Parse a signed integer argument.
+//! \remark     The whole text must be a decimal integer.
+//!
+//! \callgraph
+//!
+//! \param[in]  text  Argument
+//! \param[out] value Parsed value
+//! \return     TRUE on success, FALSE if the text is not an integer in the
+//!             range of S32
+//******************************************************************************
+static BOOL parseInteger(const CHAR *text, S32 *value)
+{
+    CHAR *end;
+    long parsed;
+
+    errno = 0;
+    parsed = strtol(text, &end, 10);
+    if ((end == text) || (*end != '\0') || (errno != 0) || (parsed < INT32_MIN) || (parsed > INT32_MAX)) {
+        return FALSE;
+    }
+    *value = (S32)parsed;
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Parse a floating-point argument.
+//! \remark     The whole text must be a number. Infinity and NaN are not
+//!             accepted.
+//!
+//! \callgraph
+//!
+//! \param[in]  text  Argument
+//! \param[out] value Parsed value
+//! \return     TRUE on success, FALSE if the text is not a finite number
+//******************************************************************************
+static BOOL parseDouble(const CHAR *text, F64 *value)
+{
+    CHAR *end;
+    F64 parsed;
+
+    errno = 0;
+    parsed = strtod(text, &end);
+    if ((end == text) || (*end != '\0') || (errno != 0) || (isfinite(parsed) == 0)) {
+        return FALSE;
+    }
+    *value = parsed;
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Parse the command-line arguments.
+//! \remark     -r <file>            : ICS response matrix cache. The matrix is
+//!                                   loaded from the file when it matches the
+//!                                   calculation, otherwise it is built and
+//!                                   saved to the file.
+//!             -P <32|64|128|table> : Kernel precision (default 64). table
+//!                                   evaluates the Jones kernel from a
+//!                                   Chebyshev table in double precision.
+//!             --table <file>       : Jones kernel table of -P table. The
+//!                                   table is loaded from the file when it
+//!                                   matches, otherwise it is built and
+//!                                   saved to the file.
+//!             --thomson-limit <G>  : Jones kernel in the Thomson limit where
+//!                                   4 einit gamma / mc^2 < G (at most
+//!                                   THOMSON_LIMIT_MAX). The kernel deviates
+//!                                   by less than G times its peak and the
+//!                                   flux by up to about G near the cut-off.
+//!                                   Needs -P 64 or -P table, not with -a.
+//!             --precision-report   : Print the error of every kernel precision
+//!                                   against quad precision and exit.
+//!             -a <tolerance>       : Adaptive Gauss-Kronrod integration with
+//!                                   the given relative tolerance instead of
+//!                                   the fixed grid.
+//!             -c <points>          : Gauss-Laguerre points of the blackbody
+//!                                   rule on einit (at most 256). 0 selects
+//!                                   the log grid 1E-15..1E+4 eV (default).
+//!             -s                   : All emitted energies in one sweep of
+//!                                   the grid.
+//!             --tail <tolerance>   : Integration bounds where the electron
+//!                                   cut-off and the CMB density fall below
+//!                                   the tolerance (relative to their peak)
+//!                                   instead of the fixed bounds.
+//!             --mode <1|2|3|4>     : ICS calculation mode. 4 calculates
+//!                                   Jones and Thomson in one pass and
+//!                                   writes both with their ratio (fixed
+//!                                   grid only, not with -r, -a, -s,
+//!                                   --sweep or --fit).
+//!             --norm <N0>          : Electron spectrum, normalization factor
+//!             --power <p>          : Electron spectrum, power
+//!             --gamma-max <rmax>   : Electron spectrum, maximum Lorentz factor
+//!             --lower <eV>         : Lower emitted energy
+//!             --upper <eV>         : Upper emitted energy
+//!             --job <file>         : Run every job of the file back to back
+//!                                   (see IoJob_Read for the format).
+//!             --sweep <file>       : Run the Cartesian product of the axes of
+//!                                   the file as one parallel sweep (see
+//!                                   IoJob_ReadSweep for the format).
+//!             --fit <file>         : Fit the electron spectrum to the
+//!                                   observed spectrum of the file (see
+//!                                   FittingData_Load for the format). The
+//!                                   electron flags give the start point.
+//!             --mcmc <steps>       : After the fit, sample the posterior
+//!                                   with an ensemble of walkers.
+//!             --walkers <n>        : Number of walkers (default 32)
+//!             --seed <n>           : Random seed (default 1)
+//!             --chain <file>       : Chain file. The checkpoint is
+//!                                   "<file>.ckpt" and a matching one is
+//!                                   resumed.
+//!             The mode, the electron spectrum and the energy range are read
+//!             from the console unless all of their flags are given.
 //!
 //! \callgraph
 //!
 //! \param[in]  argc    Count of command-line arguments
 //! \param[in]  argv    Values of command-line arguments
-//! \return     EXIT_SUCCESS
+//! \param[out] options Parsed options
+//! \return     None
 //******************************************************************************
-int main(int argc, char* argv[])
+static void parseArguments(int argc, char* argv[], MAIN_OPTIONS *options)
+{
+    S32 i;
+
+    options->ResponseFile = NULL;
+    options->Precision = ICS_PRECISION_F64;
+    options->PrecisionReport = FALSE;
+    options->TableFile = NULL;
+    options->ThomsonLimit = 0.0;
+    options->Tolerance = 0.0;
+    options->CmbPoints = INTEGRATION_CMB_LAGUERRE_POINTS;
+    options->TailTolerance = 0.0;
+    options->Sweep = FALSE;
+    options->JobFile = NULL;
+    options->SweepFile = NULL;
+    options->FitFile = NULL;
+    options->McmcSteps = 0;
+    options->McmcWalkers = MCMC_WALKERS;
+    options->McmcSeed = MCMC_SEED;
+    options->ChainFile = NULL;
+    options->JobFields = 0;
+
+    for (i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-r") == 0) && (i + 1 < argc)) {
+            options->ResponseFile = argv[++i];
+        }
+        else if ((strcmp(argv[i], "-P") == 0) && (i + 1 < argc)) {
+            if (strcmp(argv[++i], "table") == 0) {
+                options->Precision = ICS_PRECISION_TABLE;
+            }
+            else {
+                if ((parseInteger(argv[i], &options->Precision) == FALSE) ||
+                    ((options->Precision != ICS_PRECISION_F32) &&
+                    (options->Precision != ICS_PRECISION_F64) &&
+                     (options->Precision != ICS_PRECISION_F128))) {
+                    printf("[ERROR] Unknown precision : %s (32, 64, 128 or table)\n", argv[i]);
+                    exit(EXIT_FAILURE);
+                }
+            }
+        }
+        else if ((strcmp(argv[i], "--table") == 0) && (i + 1 < argc)) {
+            options->TableFile = argv[++i];
+        }
+        else if ((strcmp(argv[i], "--thomson-limit") == 0) && (i + 1 < argc)) {
+            if ((parseDouble(argv[++i], &options->ThomsonLimit) == FALSE) ||
+                !((0.0 < options->ThomsonLimit) && (options->ThomsonLimit <= THOMSON_LIMIT_MAX))) {
+                printf("[ERROR] Thomson limit threshold must be a number above 0 and at most %.2f : %s\n", THOMSON_LIMIT_MAX, argv[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if ((strcmp(argv[i], "-a") == 0) && (i + 1 < argc)) {
+            if ((parseDouble(argv[++i], &options->Tolerance) == FALSE) || !(options->Tolerance > 0.0)) {
+                printf("[ERROR] Tolerance must be a positive number : %s\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if ((strcmp(argv[i], "-c") == 0) && (i + 1 < argc)) {
+            if (parseUnsigned(argv[++i], INTEGRATION_CMB_LAGUERRE_MAX, &options->CmbPoints) == FALSE) {
+                printf("[ERROR] CMB points must be an integer between 0 and %d : %s\n", INTEGRATION_CMB_LAGUERRE_MAX, argv[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "-s") == 0) {
+            options->Sweep = TRUE;
+        }
+        else if ((strcmp(argv[i], "--tail") == 0) && (i + 1 < argc)) {
+            if ((parseDouble(argv[++i], &options->TailTolerance) == FALSE) ||
+                !((0.0 < options->TailTolerance) && (options->TailTolerance < 1.0))) {
+                printf("[ERROR] Tail tolerance must be a number between 0 and 1 : %s\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--precision-report") == 0) {
+            options->PrecisionReport = TRUE;
+        }
+        else if ((strcmp(argv[i], "--mode") == 0) && (i + 1 < argc)) {
+            if (parseInteger(argv[++i], &options->Job.Mode) == FALSE) {
+                printf("[ERROR] Mode must be an integer : %s\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            checkIcsCalcMode(options->Job.Mode);
+            options->JobFields |= MAIN_JOB_MODE;
+        }
+        else if ((strcmp(argv[i], "--norm") == 0) && (i + 1 < argc)) {
+            if (parseDouble(argv[++i], &options->Job.Norm) == FALSE) {
+                printf("[ERROR] Norm must be a number : %s\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            options->JobFields |= MAIN_JOB_NORM;
+        }
+        else if ((strcmp(argv[i], "--power") == 0) && (i + 1 < argc)) {
+            if (parseDouble(argv[++i], &options->Job.Power) == FALSE) {
+                printf("[ERROR] Power must be a number : %s\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            options->JobFields |= MAIN_JOB_POWER;
+        }
+        else if ((strcmp(argv[i], "--gamma-max") == 0) && (i + 1 < argc)) {
+            if (parseDouble(argv[++i], &options->Job.GammaMax) == FALSE) {
+                printf("[ERROR] Gamma max must be a number : %s\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            options->JobFields |= MAIN_JOB_GAMMA_MAX;
+        }
+        else if ((strcmp(argv[i], "--lower") == 0) && (i + 1 < argc)) {
+            if (parseDouble(argv[++i], &options->Job.Lower) == FALSE) {
+                printf("[ERROR] Lower energy must be a number : %s\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            options->JobFields |= MAIN_JOB_LOWER;
+        }
+        else if ((strcmp(argv[i], "--upper") == 0) && (i + 1 < argc)) {
+            if (parseDouble(argv[++i], &options->Job.Upper) == FALSE) {
+                printf("[ERROR] Upper energy must be a number : %s\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            options->JobFields |= MAIN_JOB_UPPER;
+        }
+        else if ((strcmp(argv[i], "--job") == 0) && (i + 1 < argc)) {
+            options->JobFile = argv[++i];
+        }
+        else if ((strcmp(argv[i], "--sweep") == 0) && (i + 1 < argc)) {
+            options->SweepFile = argv[++i];
+        }
+        else if ((strcmp(argv[i], "--fit") == 0) && (i + 1 < argc)) {
+            options->FitFile = argv[++i];
+        }
+        else if ((strcmp(argv[i], "--mcmc") == 0) && (i + 1 < argc)) {
+            if ((parseUnsigned(argv[++i], UINT32_MAX, &options->McmcSteps) == FALSE) || (options->McmcSteps == 0)) {
+                printf("[ERROR] MCMC steps must be a positive integer : %s\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if ((strcmp(argv[i], "--walkers") == 0) && (i + 1 < argc)) {
+            if ((parseUnsigned(argv[++i], UINT32_MAX, &options->McmcWalkers) == FALSE) ||
+                (options->McmcWalkers < 2 * FITTING_PARAMETERS) || ((options->McmcWalkers % 2) != 0)) {
+                printf("[ERROR] The number of walkers must be even and at least %d : %s\n", 2 * FITTING_PARAMETERS, argv[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if ((strcmp(argv[i], "--seed") == 0) && (i + 1 < argc)) {
+            if (parseUnsigned(argv[++i], UINT32_MAX, &options->McmcSeed) == FALSE) {
+                printf("[ERROR] Seed must be an integer between 0 and %lu : %s\n", (unsigned long)UINT32_MAX, argv[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if ((strcmp(argv[i], "--chain") == 0) && (i + 1 < argc)) {
+            options->ChainFile = argv[++i];
+        }
+        else {
+            printf("[ERROR] Unknown argument : %s\n", argv[i]);
+            printf("Usage : %s [-r response_file | -a tolerance | -s] [-c points] [-P 32|64|128|table [--table file]] [--thomson-limit G] [--tail tolerance] [--precision-report]\n", argv[0]);
+            printf("          [--job file | --sweep file | [--mode 1|2|3|4] [--norm N0 --power p --gamma-max rmax] [--lower eV --upper eV]]\n");
+            printf("          [--fit file [--mode 1|2|3] [--norm N0 --power p --gamma-max rmax] [--mcmc steps [--walkers n] [--seed n] [--chain file]]]\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if ((options->TableFile != NULL) && (options->Precision != ICS_PRECISION_TABLE)) {
+        printf("[ERROR] --table needs -P table.\n");
+        exit(EXIT_FAILURE);
+    }
+    if ((options->ThomsonLimit > 0.0) && (options->Precision != ICS_PRECISION_F64) && (options->Precision != ICS_PRECISION_TABLE)) {
+        printf("[ERROR] --thomson-limit needs -P 64 or -P table.\n");
+        exit(EXIT_FAILURE);
+    }
+    if ((options->ThomsonLimit > 0.0) && (options->Tolerance > 0.0)) {
+        printf("[ERROR] --thomson-limit cannot be used with -a.\n");
+        exit(EXIT_FAILURE);
+    }
+    if ((options->ResponseFile != NULL) && (options->Tolerance > 0.0)) {
+        printf("[ERROR] -r and -a cannot be used together.\n");
+        exit(EXIT_FAILURE);
+    }
+    if ((options->Sweep == TRUE) && ((options->ResponseFile != NULL) || (options->Tolerance > 0.0))) {
+        printf("[ERROR] -s cannot be used with -r or -a.\n");
+        exit(EXIT_FAILURE);
+    }
+    if ((options->JobFile != NULL) && (options->JobFields != 0)) {
+        printf("[ERROR] --job cannot be used with the job flags.\n");
+        exit(EXIT_FAILURE);
+    }
+    if ((options->SweepFile != NULL) &&
+        ((options->JobFile != NULL) || (options->JobFields != 0) || (options->ResponseFile != NULL) || (options->Tolerance > 0.0) || (options->Sweep == TRUE))) {
+        printf("[ERROR] --sweep cannot be used with --job, the job flags, -r, -a or -s.\n");
+        exit(EXIT_FAILURE);
+    }
+    if ((options->FitFile != NULL) &&
+        ((options->JobFile != NULL) || (options->SweepFile != NULL) || ((options->JobFields & MAIN_JOB_RANGE) != 0) ||
+         (options->Tolerance > 0.0) || (options->Sweep == TRUE))) {
+        printf("[ERROR] --fit cannot be used with --job, --sweep, --lower, --upper, -a or -s.\n");
+        exit(EXIT_FAILURE);
+    }
+    if ((options->FitFile == NULL) && (options->McmcSteps > 0)) {
+        printf("[ERROR] --mcmc needs --fit.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (((options->JobFields & MAIN_JOB_ELECTRON) != 0) && ((options->JobFields & MAIN_JOB_ELECTRON) != MAIN_JOB_ELECTRON)) {
+        printf("[ERROR] --norm, --power and --gamma-max must be given together.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (((options->JobFields & MAIN_JOB_RANGE) != 0) && ((options->JobFields & MAIN_JOB_RANGE) != MAIN_JOB_RANGE)) {
+        printf("[ERROR] --lower and --upper must be given together.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Prepare the Jones kernel table of -P table.
+//! \remark     The table in options->TableFile is used when it matches the
+//!             layout of this build. Otherwise it is built and saved to
+//!             options->TableFile (if given).
+//!
+//! \callgraph
+//!
+//! \param[in,out] options Command-line options (JonesTable is written)
+//! \return     None
+//******************************************************************************
+static void prepareJonesTable(MAIN_OPTIONS *options)
+{
+    ICS_JONES_TABLE *table = &options->JonesTable;
+    clock_t begin;
+
+    begin = clock();
+    if ((options->TableFile != NULL) && (IcsJonesTable_Load(table, options->TableFile) == TRUE)) {
+        printf("Jones kernel table loaded from %s\n", options->TableFile);
+    }
+    else {
+        if (IcsJonesTable_Build(table, JONES_TABLE_TOLERANCE) == FALSE) {
+            printf("[ERROR] Failed to build the Jones kernel table.\n");
+            exit(EXIT_FAILURE);
+        }
+        if ((options->TableFile != NULL) && (IcsJonesTable_Save(table, options->TableFile) == FALSE)) {
+            printf("[WARNING] Failed to save the Jones kernel table to %s\n", options->TableFile);
+        }
+    }
+    printf("Jones kernel table : degree %d, max relative error %.3E, %.3f [sec]\n\n",
+           JONES_TABLE_DEGREE, options->JonesTable.MaxError, (F64)(clock() - begin) / (F64)CLOCKS_PER_SEC);
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Prepare the response matrix of a calculation.
+//! \remark     The matrix in the cache or in options->ResponseFile is reused
+//!             when it covers the calculation. Otherwise it is built and
+//!             saved to options->ResponseFile (if given).
+//!
+//! \callgraph
+//!
+//! \param[in]     options  : Command-line options
+//! \param[in]     spectrum : ICS spectrum providing the grids and the CMB density
+//! \param[in]     energies : Emitted energies [eV]
+//! \param[in]     count    : Number of emitted energies
+//! \param[in,out] cache    : Grids and response matrix kept between jobs
+//! \return     None
+//******************************************************************************
+static void prepareResponse(const MAIN_OPTIONS *options, const ICS_CMB_SPECTRUM *spectrum, const F64 *energies, const U32 count, MAIN_CACHE *cache)
+{
+    ICS_RESPONSE *response = &cache->Response;
+
+    if ((cache->HasResponse == TRUE) && (IcsResponse_IsCompatible(response, spectrum, energies, count) == TRUE)) {
+        printf("Response matrix reused\n\n");
+        return;
+    }
+
+    if (cache->HasResponse == TRUE) {
+        IcsResponse_Release(response);
+        cache->HasResponse = FALSE;
+    }
+
+    if ((options->ResponseFile != NULL) &&
+        (IcsResponse_Load(response, options->ResponseFile) == TRUE) &&
+        (IcsResponse_IsCompatible(response, spectrum, energies, count) == TRUE)) {
+        printf("Response matrix loaded from %s\n\n", options->ResponseFile);
+    }
+    else {
+        if (options->ResponseFile != NULL) {
+            IcsResponse_Release(response);
+        }
+        printf("Building response matrix ...\n\n");
+
+        printPruning(spectrum, energies, (S32)count);
+        if (IcsResponse_Build(response, spectrum, energies, count) == FALSE) {
+            printf("[ERROR] Failed to build the response matrix.\n");
+            exit(EXIT_FAILURE);
+        }
+
+        if ((options->ResponseFile != NULL) && (IcsResponse_Save(response, options->ResponseFile) == FALSE)) {
+            printf("[WARNING] Failed to save the response matrix to %s\n\n", options->ResponseFile);
+        }
+    }
+    cache->HasResponse = TRUE;
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Run one ICS calculation.
+//! \remark     The grids are kept in the cache and reused by the next job
+//!             with the same mode and gamma range. The response matrix is
+//!             kept as well and reused while it stays compatible.
+//!             USE_JONES_THOMSON_APPROX writes energy, Jones flux, Thomson
+//!             flux and Thomson / Jones (0 where Jones is 0).
+//!
+//! \callgraph
+//!
+//! \param[in]  options Command-line options
+//! \param[in]  job     Calculation conditions
+//! \param[in]  index   Job number (0 : single job)
+//! \param[in,out] cache Grids and response matrix kept between jobs
+//! \return     None
+//******************************************************************************
+static void runJob(const MAIN_OPTIONS *options, const IO_JOB *job, const U32 index, MAIN_CACHE *cache)
 {
     INTEGRATION_RANGE gamma_range, energy_range;
-    F64 lower, upper, lower_log, upper_log, energy_log, flux;
-    S32 n_calc_points, i;
+    ICS_CMB_SPECTRUM *spectrum = &cache->Spectrum;
+    ICS_RESPONSE *response = &cache->Response;
+    const S32 mode = job->Mode;
+    const F64 norm = job->Norm, power = job->Power, gamma_max = job->GammaMax;
+    F64 *energies, *fluxes, *thomsons = NULL;
+    S32 n_calc_points, n_done, i;
     const CHAR* file_name;
+    GAUSS_KRONROD_TOLERANCE tolerance;
+    GAUSS_KRONROD_RESULT result;
+    BOOL converged;
+    U64 evaluations;
+    CHAR log_name[80], table_name[80];
     FILE* fp;
 
-    // Read calculation conditions from the console.
-    icsMode = readIcsCalcMode();
-    readElectronSpectrum(&normFactor, &spectrumPower, &gammaMax);
-    readIcsFluxEnergyRange(&lower, &upper);
-
-    // Calculation range
-    lower_log  = log10(lower);
-    upper_log  = log10(upper);
-    n_calc_points = (S32)((upper_log - lower_log) / FLUX_CALC_STRIDE_LOG);
+    // Calculation range and integration range
+    n_calc_points = createEnergies(options, job, &energies, &gamma_range);
 
-    // Integration Range
-    energy_range.Lower = INTEGRATION_RANGE_EINIT_LOWER;
-    energy_range.Upper = INTEGRATION_RANGE_EINIT_UPPER;
-    energy_range.Iteration = INTEGRATION_RANGE_EINIT_ITERATION;
-    gamma_range.Lower = INTEGRATION_RANGE_GAMMA_LOWER;
-    gamma_range.Upper = gammaMax * INTEGRATION_RANGE_GAMMA_UPPER_PLUS;
-    gamma_range.Iteration = INTEGRATION_RANGE_GAMMA_ITERATION;
+    // Results are kept in energy order and written after the loop
+    if ((fluxes = (F64 *)calloc((size_t)n_calc_points + 1, sizeof(F64))) == NULL) {
+        printf("[ERROR] %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    if ((mode == USE_JONES_THOMSON_APPROX) && ((thomsons = (F64 *)calloc((size_t)n_calc_points + 1, sizeof(F64))) == NULL)) {
+        printf("[ERROR] %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
 
     // File
-    file_name = getFileName(icsMode);
-    if ((fp = fopen(file_name, "w")) == NULL){
+    file_name = getFileName(mode, index);
+    sprintf(log_name, "%s.log", file_name);
+    sprintf(table_name, "%s.bin", file_name);
+    if ((fp = fopen(log_name, "w")) == NULL){
         printf("[ERROR] %s\n", strerror(errno));
         exit(EXIT_FAILURE);
     }
 
     // Print start time
+    if (index > 0) {
+        printf("Job %u : mode %d, N0 %.3E, p %.3f, rmax %.3E, %.3E - %.3E eV\n", index, mode, norm, power, gamma_max, job->Lower, job->Upper);
+    }
     printf("Start Time : %s\n\n", getCurrentTime());
 
-    // ICS Flux Calculation Loop
-    for (i = 0, energy_log = lower_log; i < n_calc_points; i++, energy_log += FLUX_CALC_STRIDE_LOG) {
-        emittedEnergy = pow(10.0, energy_log);
-        flux = NumericsTrapezoidal_Inetegrate2d(&icsFluxIntegrand, (const INTEGRATION_RANGE *)&energy_range, (const INTEGRATION_RANGE *)&gamma_range);
+    // Grids and CMB density shared by every emitted energy (and by the
+    // following jobs with the same mode and gamma range)
+    if ((cache->HasSpectrum == TRUE) &&
+        ((spectrum->Mode != mode) || (spectrum->GammaRange.Lower != gamma_range.Lower) ||
+         (spectrum->GammaRange.Upper != gamma_range.Upper) || (spectrum->GammaRange.Iteration != gamma_range.Iteration))) {
+        IcsCmbSpectrum_Release(spectrum);
+        cache->HasSpectrum = FALSE;
+    }
+    if (cache->HasSpectrum == FALSE) {
+        createSpectrum(spectrum, mode, options, &gamma_range);
+        cache->HasSpectrum = TRUE;
+    }
+    energy_range = spectrum->EinitRange;
+
+    printf("Integration bounds : gamma %.3E - %.3E, einit %.3E - %.3E eV\n\n",
+           gamma_range.Lower, gamma_range.Upper, energy_range.Lower, energy_range.Upper);
+    if (options->TailTolerance > 0.0) {
+        fprintf(fp, "# tail %.3E : gamma %.8E - %.8E, einit %.8E - %.8E eV\n", options->TailTolerance,
+                gamma_range.Lower, gamma_range.Upper, energy_range.Lower, energy_range.Upper);
+    }
+
+    if (options->ResponseFile != NULL) {
+        prepareResponse(options, spectrum, energies, (U32)n_calc_points, cache);
+
+        if (IcsResponse_CalcFlux(response, norm, power, gamma_max, fluxes) == FALSE) {
+            printf("[ERROR] Failed to calculate the flux from the response matrix.\n");
+            exit(EXIT_FAILURE);
+        }
+
+        for (i = 0; i < n_calc_points; i++) {
+            printf("[%03d/%03d] %.8E %.8E\n", i + 1, n_calc_points, energies[i], fluxes[i]);
+        }
+    }
+    else if (options->Sweep == TRUE) {
+        // Single sweep of the grid for every emitted energy
+        IcsCmbSpectrum_SetElectron(spectrum, norm, power, gamma_max);
+        if (IcsCmbSpectrum_CalcFluxSweep(spectrum, energies, (U32)n_calc_points, fluxes, &evaluations) == FALSE) {
+            printf("[ERROR] Failed to calculate the flux in a single sweep.\n");
+            exit(EXIT_FAILURE);
+        }
+        printf("Single sweep : %.3E kernel evaluations\n\n", (F64)evaluations);
+
+        for (i = 0; i < n_calc_points; i++) {
+            printf("[%03d/%03d] %.8E %.8E\n", i + 1, n_calc_points, energies[i], fluxes[i]);
+        }
+    }
+    else {
+        IcsCmbSpectrum_SetElectron(spectrum, norm, power, gamma_max);
+        if (options->Tolerance > 0.0) {
+            tolerance.Rule = GAUSS_KRONROD_21;
+            tolerance.Absolute = 0.0;
+            tolerance.Relative = options->Tolerance;
+        }
+        else {
+            printPruning(spectrum, energies, n_calc_points);
+        }
+
+        // ICS Flux Calculation Loop (each emitted energy is independent)
+        n_done = 0;
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(dynamic, 1) private(result, converged)
+#endif
+        for (i = 0; i < n_calc_points; i++) {
+            if (options->Tolerance > 0.0) {
+                converged = IcsCmbSpectrum_CalcFluxAdaptive((const ICS_CMB_SPECTRUM *)spectrum, energies[i], &tolerance, &result);
+                fluxes[i] = result.Value;
+            }
+            else if (thomsons != NULL) {
+                IcsCmbSpectrum_CalcFluxPair((const ICS_CMB_SPECTRUM *)spectrum, energies[i], &fluxes[i], &thomsons[i]);
+                converged = TRUE;
+            }
+            else {
+                fluxes[i] = IcsCmbSpectrum_CalcFlux((const ICS_CMB_SPECTRUM *)spectrum, energies[i]);
+                converged = TRUE;
+            }
+
+#ifdef _OPENMP
+            #pragma omp critical (ics_progress)
+#endif
+            {
+                n_done++;
+                if (options->Tolerance > 0.0) {
+                    printf("[%03d/%03d] %.8E %.8E (error %.2E, %llu evaluations%s)\n", n_done, n_calc_points, energies[i], fluxes[i],
+                           result.Error, (unsigned long long)result.Evaluations, (converged == TRUE) ? "" : ", not converged");
+                }
+                else if (thomsons != NULL) {
+                    printf("[%03d/%03d] %.8E %.8E %.8E %.8E\n", n_done, n_calc_points, energies[i], fluxes[i], thomsons[i],
+                           (fluxes[i] > 0.0) ? (thomsons[i] / fluxes[i]) : 0.0);
+                }
+                else {
+                    printf("[%03d/%03d] %.8E %.8E\n", n_done, n_calc_points, energies[i], fluxes[i]);
+                }
+                fflush(stdout);
+            }
+        }
+    }
+
+    if (mode == USE_KAK_APPROX) {
+        printJonesDeviation(options, &gamma_range, norm, power, gamma_max, energies, fluxes, n_calc_points);
+    }
+
+    if (thomsons != NULL) {
+        fprintf(fp, "# energy[eV] jones thomson thomson/jones\n");
+        for (i = 0; i < n_calc_points; i++) {
+            fprintf(fp, "%.8E %.8E %.8E %.8E\n", energies[i], fluxes[i], thomsons[i], (fluxes[i] > 0.0) ? (thomsons[i] / fluxes[i]) : 0.0);
+        }
+    }
+    else {
+        for (i = 0; i < n_calc_points; i++) {
+            fprintf(fp, "%.8E %.8E\n", energies[i], fluxes[i]);
+        }
+    }
 
-        printf("[%03d/%03d] %.8E %.8E\n", i + 1, n_calc_points, emittedEnergy, flux);
-        fprintf(fp, "%.8E %.8E\n", emittedEnergy, flux);
+    if (writeSpectrumTable(table_name, mode, &energy_range, &gamma_range, norm, power, gamma_max, energies, fluxes, thomsons, (U32)n_calc_points) == FALSE) {
+        printf("[WARNING] Failed to write %s\n", table_name);
     }
 
     // Print end time
     printf("\nEnd Time : %s\n\n", getCurrentTime());
     fclose(fp);
+    free(energies);
+    free(fluxes);
+    free(thomsons);
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Run a parameter sweep.
+//! \remark     Every job is one configuration of IcsSweep_Run. All results
+//!             go to one file indexed by job and emitted energy :
+//!             job point mode N0 p rmax energy flux
+//!             The sweep always runs on the fixed grid, so parseArguments
+//!             rejects -r, -a and -s with --sweep.
+//!
+//! \callgraph
+//!
+//! \param[in]  options Command-line options
+//! \param[in]  jobs    Configurations
+//! \param[in]  n_jobs  Number of configurations
+//! \return     None
+//******************************************************************************
+static void runSweep(const MAIN_OPTIONS *options, const IO_JOB *jobs, const U32 n_jobs)
+{
+    ICS_SWEEP_CONFIG *configs;
+    ICS_SWEEP_GRID grid;
+    F64 *energies;
+    U64 evaluations, n_points;
+    U32 i, k;
+    CHAR log_name[80];
+    FILE *fp;
+
+    if ((configs = (ICS_SWEEP_CONFIG *)calloc((size_t)n_jobs + 1, sizeof(ICS_SWEEP_CONFIG))) == NULL) {
+        printf("[ERROR] %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    for (n_points = 0, i = 0; i < n_jobs; i++) {
+        configs[i].Mode = jobs[i].Mode;
+        configs[i].Norm = jobs[i].Norm;
+        configs[i].Power = jobs[i].Power;
+        configs[i].GammaMax = jobs[i].GammaMax;
+        configs[i].EfinCount = (U32)createEnergies(options, &jobs[i], &energies, &configs[i].GammaRange);
+        configs[i].Efin = energies;
+        if ((configs[i].Flux = (F64 *)calloc((size_t)configs[i].EfinCount + 1, sizeof(F64))) == NULL) {
+            printf("[ERROR] %s\n", strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+        n_points += configs[i].EfinCount;
+    }
+
+    grid.Precision = options->Precision;
+    grid.JonesTable = &options->JonesTable;
+    grid.ThomsonLimit = options->ThomsonLimit;
+    grid.CmbPoints = options->CmbPoints;
+    createEinitRange(options, &grid.EinitRange);
+
+    sprintf(log_name, "%s.log", getFileName(MAIN_SWEEP_FILE, 0));
+    if ((fp = fopen(log_name, "w")) == NULL){
+        printf("[ERROR] %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    printf("Start Time : %s\n\n", getCurrentTime());
+    printf("Sweep : %u configurations, %llu tasks\n\n", n_jobs, (unsigned long long)n_points);
+
+    if (IcsSweep_Run(configs, n_jobs, &grid, &evaluations) == FALSE) {
+        printf("[ERROR] Failed to run the sweep.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    fprintf(fp, "# job point mode N0 p rmax energy[eV] flux\n");
+    for (i = 0; i < n_jobs; i++) {
+        for (k = 0; k < configs[i].EfinCount; k++) {
+            fprintf(fp, "%u %u %d %.6E %.6E %.6E %.8E %.8E\n", i + 1, k, configs[i].Mode, configs[i].Norm, configs[i].Power,
+                    configs[i].GammaMax, configs[i].Efin[k], configs[i].Flux[k]);
+        }
+        printf("[%04u/%04u] mode %d, N0 %.3E, p %.3f, rmax %.3E : %.3E kernel evaluations\n", i + 1, n_jobs, configs[i].Mode,
+               configs[i].Norm, configs[i].Power, configs[i].GammaMax, (F64)configs[i].Cost);
+    }
+    printf("\nSweep : %.3E kernel evaluations written to %s\n", (F64)evaluations, log_name);
+
+    printf("\nEnd Time : %s\n\n", getCurrentTime());
+    fclose(fp);
+
+    for (i = 0; i < n_jobs; i++) {
+        free((F64 *)configs[i].Efin);
+        free(configs[i].Flux);
+    }
+    free(configs);
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Compare two F64 values for qsort
+//! \remark
+//!
+//! \callgraph
+//!
+//! \param[in]  a  First value
+//! \param[in]  b  Second value
+//! \return     Negative, zero or positive as a is below, equal to or above b
+//******************************************************************************
+static int compareValues(const void *a, const void *b)
+{
+    const F64 x = *(const F64 *)a, y = *(const F64 *)b;
+
+    return (x < y) ? -1 : ((x > y) ? 1 : 0);
+}
+
+
+
+//******************************************************************************
+//! \breif      Print the posterior summary of a chain file
+//! \remark     The first half of the steps is discarded as burn-in. The
+//!             median and the 16 / 84 percentiles of each parameter are
+//!             printed.
+//!
+//! \callgraph
+//!
+//! \param[in]  file_name  Chain file
+//! \return     None
+//******************************************************************************
+static void printPosterior(const CHAR *file_name)
+{
+    static const CHAR *names[FITTING_PARAMETERS] = { "N0  ", "p   ", "rmax" };
+    IO_CHAIN_HEADER header;
+    F64 *records, *values;
+    size_t n_samples, first, n, i;
+    U32 width, d;
+
+    if (IoChain_Read(file_name, &header, &records) == FALSE) {
+        printf("[WARNING] Failed to read %s\n", file_name);
+        return;
+    }
+
+    width = header.Dimension + 1;
+    first = (size_t)(header.Steps / 2) * header.Walkers;
+    n_samples = (size_t)header.Steps * header.Walkers - first;
+    if ((n_samples == 0) || ((values = (F64 *)malloc(sizeof(F64) * n_samples)) == NULL)) {
+        free(records);
+        return;
+    }
+
+    printf("Posterior (%llu samples after burn-in) : median [16 %%, 84 %%]\n", (unsigned long long)n_samples);
+    for (d = 0; (d < header.Dimension) && (d < FITTING_PARAMETERS); d++) {
+        for (n = 0, i = first; n < n_samples; n++, i++) {
+            values[n] = records[i * width + d];
+        }
+        qsort(values, n_samples, sizeof(F64), compareValues);
+        printf("  %s : %.6E [%.6E, %.6E]\n", names[d], values[n_samples / 2],
+               values[(size_t)(0.16 * (F64)(n_samples - 1))], values[(size_t)(0.84 * (F64)(n_samples - 1))]);
+    }
+
+    free(values);
+    free(records);
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Sample the posterior of the electron spectrum parameters.
+//! \remark     The walkers start around the best fit. The chain goes to
+//!             options->ChainFile (or ics_mcmc_<time>.chain) and the
+//!             checkpoint to "<chain>.ckpt".
+//!
+//! \callgraph
+//!
+//! \param[in]  options  Command-line options
+//! \param[in]  response Response matrix built at the data energies
+//! \param[in]  data     Observed spectrum
+//! \param[in]  best     Best fit
+//! \return     None
+//******************************************************************************
+static void runMcmc(const MAIN_OPTIONS *options, const ICS_RESPONSE *response, const FITTING_DATA *data, const FITTING_PARAMS *best)
+{
+    FITTING_MCMC_CONFIG config;
+    FITTING_MCMC_RESULT result;
+    CHAR chain_name[80], checkpoint_name[1024];
+    clock_t begin;
+
+    if (options->ChainFile != NULL) {
+        config.ChainFile = options->ChainFile;
+    }
+    else {
+        sprintf(chain_name, "%s.chain", getFileName(MAIN_MCMC_FILE, 0));
+        config.ChainFile = chain_name;
+    }
+    if (strlen(config.ChainFile) + 6 > sizeof(checkpoint_name)) {
+        printf("[ERROR] Chain file name too long : %s\n", config.ChainFile);
+        exit(EXIT_FAILURE);
+    }
+    sprintf(checkpoint_name, "%s.ckpt", config.ChainFile);
+
+    config.Walkers = options->McmcWalkers;
+    config.Steps = options->McmcSteps;
+    config.Seed = options->McmcSeed;
+    config.CheckpointInterval = MCMC_CHECKPOINT_INTERVAL;
+    config.Scale = MCMC_STRETCH_SCALE;
+    config.CheckpointFile = checkpoint_name;
+
+    printf("\nMCMC : %u walkers, %u steps, seed %u\n", config.Walkers, config.Steps, config.Seed);
+
+    begin = clock();
+    if (FittingMcmc_Run(response, data, best, &config, &result) == FALSE) {
+        printf("[ERROR] Failed to sample the posterior (chain %s).\n", config.ChainFile);
+        exit(EXIT_FAILURE);
+    }
+
+    if (result.StartStep > 0) {
+        printf("Resumed from step %u of %s\n", result.StartStep, checkpoint_name);
+    }
+    printf("MCMC : %llu evaluations, acceptance %.3f, %.3f s, %u steps in %s\n\n", (unsigned long long)result.Evaluations,
+           result.Acceptance, (F64)(clock() - begin) / (F64)CLOCKS_PER_SEC, result.Steps, config.ChainFile);
+
+    printPosterior(config.ChainFile);
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Fit the electron spectrum to an observed spectrum.
+//! \remark     The response matrix is built once at the data energies, so
+//!             every chi-square evaluation is a matrix-vector product. The
+//!             data and the best-fit model go to one file :
+//!             energy flux lower upper model
+//!             With --mcmc the posterior is sampled around the best fit.
+//!
+//! \callgraph
+//!
+//! \param[in]  options Command-line options
+//! \param[in,out] cache Grids and response matrix
+//! \return     None
+//******************************************************************************
+static void runFit(const MAIN_OPTIONS *options, MAIN_CACHE *cache)
+{
+    FITTING_DATA data;
+    FITTING_PARAMS start;
+    FITTING_RESULT result;
+    INTEGRATION_RANGE gamma_range;
+    F64 *model;
+    S32 mode;
+    U32 k, a, b;
+    clock_t begin;
+    const CHAR *const param_names[FITTING_PARAMETERS] = { "N0", "p", "rmax" };
+    CHAR log_name[80];
+    FILE *fp;
+
+    if (FittingData_Load(&data, options->FitFile) == FALSE) {
+        printf("[ERROR] Failed to read %s\n", options->FitFile);
+        exit(EXIT_FAILURE);
+    }
+    if (data.Count <= FITTING_PARAMETERS) {
+        printf("[ERROR] %s has %u points, more than %d are needed.\n", options->FitFile, data.Count, FITTING_PARAMETERS);
+        exit(EXIT_FAILURE);
+    }
+
+    mode = ((options->JobFields & MAIN_JOB_MODE) != 0) ? options->Job.Mode : USE_JONES_APPROX;
+    if (mode == USE_JONES_THOMSON_APPROX) {
+        printf("[ERROR] Mode 4 cannot be used with --fit.\n");
+        exit(EXIT_FAILURE);
+    }
+    if ((options->JobFields & MAIN_JOB_ELECTRON) != 0) {
+        start.Norm = options->Job.Norm;
+        start.Power = options->Job.Power;
+        start.GammaMax = options->Job.GammaMax;
+    }
+    else {
+        start.Norm = 0.0;
+        start.Power = FIT_START_POWER;
+        start.GammaMax = FIT_START_GAMMA_MAX;
+    }
+
+    if ((model = (F64 *)calloc((size_t)data.Count, sizeof(F64))) == NULL) {
+        printf("[ERROR] %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    printf("Start Time : %s\n\n", getCurrentTime());
+    printf("Fit : %u points of %s, mode %d\n\n", data.Count, options->FitFile, mode);
+
+    gamma_range.Lower = INTEGRATION_RANGE_GAMMA_LOWER;
+    gamma_range.Upper = FIT_GAMMA_UPPER;
+    gamma_range.Iteration = FIT_GAMMA_ITERATION;
+    createSpectrum(&cache->Spectrum, mode, options, &gamma_range);
+    cache->HasSpectrum = TRUE;
+
+    prepareResponse(options, &cache->Spectrum, data.Energy, data.Count, cache);
+
+    begin = clock();
+    if (FittingSpectrum_Fit(&cache->Response, &data, &start, &result) == FALSE) {
+        printf("[ERROR] Failed to fit the spectrum.\n");
+        exit(EXIT_FAILURE);
+    }
+    FittingSpectrum_CalcChiSquare(&cache->Response, &data, &result.Params, model);
+
+    printf("Best fit%s : N0 %.6E, p %.6f, rmax %.6E\n", (result.Converged == TRUE) ? "" : " (not converged)",
+           result.Params.Norm, result.Params.Power, result.Params.GammaMax);
+    if (result.HasErrors == TRUE) {
+        printf("Errors     : log10 N0 %.4f, p %.4f, log10 rmax %.4f (Fisher matrix)\n", result.Errors[0], result.Errors[1], result.Errors[2]);
+        printf("Correlation: N0-p %+.3f, N0-rmax %+.3f, p-rmax %+.3f\n", result.Correlation[0][1], result.Correlation[0][2], result.Correlation[1][2]);
+        for (a = 0; a < FITTING_PARAMETERS; a++) {
+            for (b = a + 1; b < FITTING_PARAMETERS; b++) {
+                if (fabs(result.Correlation[a][b]) > FIT_DEGENERATE_CORRELATION) {
+                    printf("[WARNING] %s and %s are degenerate (correlation %+.3f) : the errors above do not bound them jointly, use --mcmc\n",
+                           param_names[a], param_names[b], result.Correlation[a][b]);
+                }
+            }
+        }
+    }
+    printf("Chi-square : %.4f / %u dof\n", result.ChiSquare, result.Dof);
+    printf("Minimizer  : %u evaluations, %u iterations, %.3f s\n\n", result.Evaluations, result.Iterations,
+           (F64)(clock() - begin) / (F64)CLOCKS_PER_SEC);
+
+    sprintf(log_name, "%s.log", getFileName(MAIN_FIT_FILE, 0));
+    if ((fp = fopen(log_name, "w")) == NULL){
+        printf("[ERROR] %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    fprintf(fp, "# mode %d, N0 %.8E, p %.8E, rmax %.8E, chi-square %.6E / %u dof\n", mode,
+            result.Params.Norm, result.Params.Power, result.Params.GammaMax, result.ChiSquare, result.Dof);
+    fprintf(fp, "# energy[eV] flux lower upper model\n");
+    for (k = 0; k < data.Count; k++) {
+        fprintf(fp, "%.8E %.8E %.8E %.8E %.8E\n", data.Energy[k], data.Flux[k], data.Lower[k], data.Upper[k], model[k]);
+        printf("[%03u/%03u] %.8E %.8E %.8E\n", k + 1, data.Count, data.Energy[k], data.Flux[k], model[k]);
+    }
+
+    fclose(fp);
+
+    if (options->McmcSteps > 0) {
+        runMcmc(options, &cache->Response, &data, &result.Params);
+    }
+
+    printf("\nEnd Time : %s\n\n", getCurrentTime());
+    free(model);
+    FittingData_Release(&data);
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Entry point.
+//! \remark
+//!
+//! \callgraph
+//!
+//! \param[in]  argc    Count of command-line arguments
+//! \param[in]  argv    Values of command-line arguments
+//! \return     EXIT_SUCCESS
+//******************************************************************************
+int main(int argc, char* argv[])
+{
+    MAIN_OPTIONS options;
+    MAIN_CACHE cache;
+    IO_JOB job, *jobs;
+    U32 n_jobs, error_line, i;
+
+    parseArguments(argc, argv, &options);
+
+    if (options.PrecisionReport == TRUE) {
+        IcsPrecision_Report(stdout);
+        return EXIT_SUCCESS;
+    }
+
+    if (options.Precision == ICS_PRECISION_TABLE) {
+        prepareJonesTable(&options);
+    }
+
+    cache.HasSpectrum = FALSE;
+    cache.HasResponse = FALSE;
+
+    if (options.FitFile != NULL) {
+        // Electron spectrum fitted to an observed spectrum
+        runFit(&options, &cache);
+    }
+    else if (options.SweepFile != NULL) {
+        // Cartesian product of the axes as one parallel sweep
+        if (IoJob_ReadSweep(options.SweepFile, &jobs, &n_jobs, &error_line) == FALSE) {
+            if (error_line > 0) {
+                printf("[ERROR] Invalid axis in %s (line %u)\n", options.SweepFile, error_line);
+            }
+            else {
+                printf("[ERROR] Failed to read %s (every axis must be given)\n", options.SweepFile);
+            }
+            exit(EXIT_FAILURE);
+        }
+        for (i = 0; i < n_jobs; i++) {
+            checkIcsCalcMode(jobs[i].Mode);
+            if (jobs[i].Mode == USE_JONES_THOMSON_APPROX) {
+                printf("[ERROR] Mode 4 cannot be used with --sweep.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        runSweep(&options, jobs, n_jobs);
+        IoJob_Release(jobs);
+    }
+    else if (options.JobFile != NULL) {
+        // Every job of the file in one process
+        if (IoJob_Read(options.JobFile, &jobs, &n_jobs, &error_line) == FALSE) {
+            if (error_line > 0) {
+                printf("[ERROR] Invalid job in %s (line %u)\n", options.JobFile, error_line);
+            }
+            else {
+                printf("[ERROR] Failed to read %s\n", options.JobFile);
+            }
+            exit(EXIT_FAILURE);
+        }
+        for (i = 0; i < n_jobs; i++) {
+            checkJobMode(&options, jobs[i].Mode);
+        }
+
+        for (i = 0; i < n_jobs; i++) {
+            runJob(&options, &jobs[i], i + 1, &cache);
+        }
+        IoJob_Release(jobs);
+    }
+    else {
+        // Read the conditions not given on the command line from the console.
+        job = options.Job;
+        if ((options.JobFields & MAIN_JOB_MODE) == 0) {
+            job.Mode = readIcsCalcMode();
+        }
+        if ((options.JobFields & MAIN_JOB_ELECTRON) == 0) {
+            readElectronSpectrum(&job.Norm, &job.Power, &job.GammaMax);
+        }
+        if ((options.JobFields & MAIN_JOB_RANGE) == 0) {
+            readIcsFluxEnergyRange(&job.Lower, &job.Upper);
+        }
+        checkJobMode(&options, job.Mode);
+        checkJob(&job);
+
+        runJob(&options, &job, 0, &cache);
+    }
+
+    if (cache.HasResponse == TRUE) {
+        IcsResponse_Release(&cache.Response);
+    }
+    if (cache.HasSpectrum == TRUE) {
+        IcsCmbSpectrum_Release(&cache.Spectrum);
+    }
+    if (options.Precision == ICS_PRECISION_TABLE) {
+        IcsJonesTable_Release(&options.JonesTable);
+    }
 
     return EXIT_SUCCESS;
 }
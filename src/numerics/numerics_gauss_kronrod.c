@@ -0,0 +1,465 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#define NUMERICS_GAUSS_KRONROD_C_
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include <stdlib.h>
+#include <float.h>
+#include <math.h>
+#include "numerics_gauss_kronrod.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+//----------------------------------------------------------
+//! Inner integrals of the nested rule use a tighter relative tolerance
+//----------------------------------------------------------
+#define GAUSS_KRONROD_INNER_FACTOR      (0.1)
+
+
+
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! Gauss-Kronrod rule (abscissae on [0, 1], the last one is the center)
+//----------------------------------------------------------
+typedef struct gauss_kronrod_rule_t {
+    U32         Count;          //!< Number of abscissae including the center
+    const F64   *Xgk;           //!< Kronrod abscissae (odd indices are Gauss)
+    const F64   *Wgk;           //!< Kronrod weights
+    const F64   *Wg;            //!< Gauss weights
+    BOOL        CenterGauss;    //!< The center is also a Gauss node
+}GAUSS_KRONROD_RULE;
+
+//----------------------------------------------------------
+//! Subinterval of the global bisection
+//----------------------------------------------------------
+typedef struct gauss_kronrod_interval_t {
+    F64         Lower;          //!< Lower
+    F64         Upper;          //!< Upper
+    F64         Value;          //!< Kronrod value
+    F64         Error;          //!< Error estimate
+}GAUSS_KRONROD_INTERVAL;
+
+//----------------------------------------------------------
+//! Context of the log-space substitution
+//----------------------------------------------------------
+typedef struct gauss_kronrod_log_context_t {
+    INTEGRAND_CTX   Integrand;  //!< Integrand in x
+    void            *Context;   //!< User context
+}GAUSS_KRONROD_LOG_CONTEXT;
+
+//----------------------------------------------------------
+//! Context of the nested multiple integration
+//----------------------------------------------------------
+typedef struct gauss_kronrod_nested_context_t {
+    MULTIPLE_INTEGRAND_CTX  Integrand;      //!< Integrand in (x, y)
+    void                    *Context;       //!< User context
+    const INTEGRATION_RANGE *RangeY;        //!< Inner range
+    GAUSS_KRONROD_TOLERANCE Tolerance;      //!< Inner tolerance
+    F64                     X;              //!< Current outer value
+    F64                     MaxRelError;    //!< Largest relative error of the inner integrals
+    U64                     Evaluations;    //!< Inner integrand evaluations
+    BOOL                    Converged;      //!< All inner integrals met the tolerance
+}GAUSS_KRONROD_NESTED_CONTEXT;
+
+
+
+//==============================================================================
+// File Scope Function Prototype
+//==============================================================================
+static const GAUSS_KRONROD_RULE *getRule(const S32 rule);
+static void evaluateInterval(INTEGRAND_CTX integrand, void *context, const GAUSS_KRONROD_RULE *rule, GAUSS_KRONROD_INTERVAL *interval);
+static F64 logIntegrand(const F64 t, void *context);
+static F64 innerIntegrand(const F64 y, void *context);
+static F64 outerIntegrand(const F64 x, void *context);
+
+
+
+//==============================================================================
+// File Scope Variables
+//==============================================================================
+//----------------------------------------------------------
+// Abscissae and weights (QUADPACK qk15 / qk21)
+//----------------------------------------------------------
+static const F64 XGK15[8] = {
+    0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+    0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+    0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+    0.207784955007898467600689403773245, 0.000000000000000000000000000000000
+};
+static const F64 WGK15[8] = {
+    0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+    0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+    0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+    0.204432940075298892414161999234649, 0.209482141084727828012999174891714
+};
+static const F64 WG7[4] = {
+    0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+    0.381830050505118944950369775488975, 0.417959183673469387755102040816327
+};
+static const F64 XGK21[11] = {
+    0.995657163025808080735527280689003, 0.973906528517171720077964012084452,
+    0.930157491355708226001207180059508, 0.865063366688984510732096688423493,
+    0.780817726586416897063717578345042, 0.679409568299024406234327365114874,
+    0.562757134668604683339000099272694, 0.433395394129247190799265943165784,
+    0.294392862701460198131126603103866, 0.148874338981631210884826001129720,
+    0.000000000000000000000000000000000
+};
+static const F64 WGK21[11] = {
+    0.011694638867371874278064396062192, 0.032558162307964727478818972459390,
+    0.054755896574351996031381300244580, 0.075039674810919952767043140916190,
+    0.093125454583697605535065465083366, 0.109387158802297641899210590325805,
+    0.123491976262065851077208936179810, 0.134709217311473325928054001771707,
+    0.142775938577060080797094273138717, 0.147739104901338491374841515972068,
+    0.149445554002916905664936468389821
+};
+static const F64 WG10[5] = {
+    0.066671344308688137593568809893332, 0.149451349150580593145776339657697,
+    0.219086362515982043995534934228163, 0.269266719309996355091226921569469,
+    0.295524224714752870173892994651338
+};
+
+static const GAUSS_KRONROD_RULE GK15 = { 8, XGK15, WGK15, WG7, TRUE };
+static const GAUSS_KRONROD_RULE GK21 = { 11, XGK21, WGK21, WG10, FALSE };
+
+
+
+
+
+//******************************************************************************
+//! \breif      Adaptive Gauss-Kronrod integration
+//! \remark     Global bisection : the subinterval with the largest error
+//!             estimate is halved until the total error meets
+//!             max(Absolute, Relative * |Value|), the number of subintervals
+//!             reaches range->Iteration, or a subinterval cannot be halved.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  integrand : Function Pointer (Integrand with user context)
+//! \param[in]  context   : User context passed to the integrand
+//! \param[in]  range     : Integration Range
+//! \param[in]  tolerance : Tolerance
+//! \param[out] result    : Integrated value, error estimate and evaluation count
+//! \return     TRUE if the tolerance is met, otherwise FALSE
+//******************************************************************************
+BOOL NumericsGaussKronrod_Integrate(INTEGRAND_CTX integrand, void *context, const INTEGRATION_RANGE *range, const GAUSS_KRONROD_TOLERANCE *tolerance, GAUSS_KRONROD_RESULT *result)
+{
+    const GAUSS_KRONROD_RULE *rule = getRule(tolerance->Rule);
+    GAUSS_KRONROD_INTERVAL *interval;
+    U32 max_intervals, count, worst, i;
+    F64 middle;
+    BOOL converged;
+
+    max_intervals = (range->Iteration > 0) ? range->Iteration : 1;
+
+    result->Value = 0.0;
+    result->Error = 0.0;
+    result->Evaluations = 0;
+    result->Intervals = 0;
+
+    if ((interval = (GAUSS_KRONROD_INTERVAL *)malloc(sizeof(GAUSS_KRONROD_INTERVAL) * max_intervals)) == NULL) {
+        result->Value = result->Error = NAN;
+        return FALSE;
+    }
+
+    interval[0].Lower = range->Lower;
+    interval[0].Upper = range->Upper;
+    evaluateInterval(integrand, context, rule, &interval[0]);
+    result->Evaluations += 2 * rule->Count - 1;
+    count = 1;
+
+    for (;;) {
+        result->Value = result->Error = 0.0;
+        for (worst = 0, i = 0; i < count; i++) {
+            result->Value += interval[i].Value;
+            result->Error += interval[i].Error;
+            if (interval[i].Error > interval[worst].Error) {
+                worst = i;
+            }
+        }
+
+        converged = (result->Error <= fmax(tolerance->Absolute, tolerance->Relative * fabs(result->Value))) ? TRUE : FALSE;
+        if ((converged == TRUE) || (count >= max_intervals)) {
+            break;
+        }
+
+        middle = 0.5 * (interval[worst].Lower + interval[worst].Upper);
+        if ((middle <= interval[worst].Lower) || (middle >= interval[worst].Upper)) {
+            break;
+        }
+
+        interval[count].Lower = middle;
+        interval[count].Upper = interval[worst].Upper;
+        interval[worst].Upper = middle;
+        evaluateInterval(integrand, context, rule, &interval[worst]);
+        evaluateInterval(integrand, context, rule, &interval[count]);
+        result->Evaluations += 2 * (2 * rule->Count - 1);
+        count++;
+    }
+
+    result->Intervals = count;
+    free(interval);
+
+    return converged;
+}
+
+
+
+//******************************************************************************
+//! \breif      Adaptive Gauss-Kronrod integration in log space
+//! \remark     Integrates f(e^t) e^t over t = [ln(Lower), ln(Upper)], which
+//!             suits integrands spanning many decades.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  integrand : Function Pointer (Integrand with user context)
+//! \param[in]  context   : User context passed to the integrand
+//! \param[in]  range     : Integration Range (positive)
+//! \param[in]  tolerance : Tolerance
+//! \param[out] result    : Integrated value, error estimate and evaluation count
+//! \return     TRUE if the tolerance is met, otherwise FALSE
+//******************************************************************************
+BOOL NumericsGaussKronrod_IntegrateLog(INTEGRAND_CTX integrand, void *context, const INTEGRATION_RANGE *range, const GAUSS_KRONROD_TOLERANCE *tolerance, GAUSS_KRONROD_RESULT *result)
+{
+    GAUSS_KRONROD_LOG_CONTEXT log_context;
+    INTEGRATION_RANGE log_range;
+
+    log_context.Integrand = integrand;
+    log_context.Context = context;
+
+    log_range.Lower = log(range->Lower);
+    log_range.Upper = log(range->Upper);
+    log_range.Iteration = range->Iteration;
+
+    return NumericsGaussKronrod_Integrate(logIntegrand, &log_context, &log_range, tolerance, result);
+}
+
+
+
+//******************************************************************************
+//! \breif      Nested adaptive Gauss-Kronrod multiple integration in log space
+//! \remark     The outer integral over x is adaptive on the inner integral
+//!             over y, which is computed with a tighter relative tolerance.
+//!             The error estimate adds the largest relative inner error to
+//!             the outer one, and the evaluation count is that of (x, y).
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  integrand : Function Pointer (Integrand with user context)
+//! \param[in]  context   : User context passed to the integrand
+//! \param[in]  range_x   : Integration Range for X-axis (outer)
+//! \param[in]  range_y   : Integration Range for Y-axis (inner)
+//! \param[in]  tolerance : Tolerance
+//! \param[out] result    : Integrated value, error estimate and evaluation count
+//! \return     TRUE if the tolerance is met, otherwise FALSE
+//******************************************************************************
+BOOL NumericsGaussKronrod_Integrate2dLog(MULTIPLE_INTEGRAND_CTX integrand, void *context, const INTEGRATION_RANGE *range_x, const INTEGRATION_RANGE *range_y, const GAUSS_KRONROD_TOLERANCE *tolerance, GAUSS_KRONROD_RESULT *result)
+{
+    GAUSS_KRONROD_NESTED_CONTEXT nested;
+    BOOL converged;
+
+    nested.Integrand = integrand;
+    nested.Context = context;
+    nested.RangeY = range_y;
+    nested.Tolerance = *tolerance;
+    nested.Tolerance.Absolute = 0.0;
+    nested.Tolerance.Relative = tolerance->Relative * GAUSS_KRONROD_INNER_FACTOR;
+    nested.MaxRelError = 0.0;
+    nested.Evaluations = 0;
+    nested.Converged = TRUE;
+
+    converged = NumericsGaussKronrod_IntegrateLog(outerIntegrand, &nested, range_x, tolerance, result);
+
+    result->Error += nested.MaxRelError * fabs(result->Value);
+    result->Evaluations = nested.Evaluations;
+
+    return ((converged == TRUE) && (nested.Converged == TRUE)) ? TRUE : FALSE;
+}
+
+
+
+
+
+//******************************************************************************
+//! \breif      Get a Gauss-Kronrod rule
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  rule : GAUSS_KRONROD_15 or GAUSS_KRONROD_21
+//! \return     Rule (G7K15 unless GAUSS_KRONROD_21 is requested)
+//******************************************************************************
+static const GAUSS_KRONROD_RULE *getRule(const S32 rule)
+{
+    return (rule == GAUSS_KRONROD_21) ? &GK21 : &GK15;
+}
+
+
+
+//******************************************************************************
+//! \breif      Apply a Gauss-Kronrod rule to one subinterval
+//! \remark     Error estimate of QUADPACK (qk15 / qk21)
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  integrand : Function Pointer (Integrand with user context)
+//! \param[in]  context   : User context passed to the integrand
+//! \param[in]  rule      : Gauss-Kronrod rule
+//! \param[in,out] interval : Subinterval (Value and Error are written)
+//! \return     None
+//******************************************************************************
+static void evaluateInterval(INTEGRAND_CTX integrand, void *context, const GAUSS_KRONROD_RULE *rule, GAUSS_KRONROD_INTERVAL *interval)
+{
+    F64 f1[11], f2[11];
+    F64 center, half, abscissa, fc;
+    F64 res_gauss, res_kronrod, res_abs, res_asc, mean, error;
+    U32 j;
+    const U32 n = rule->Count - 1;
+
+    center = 0.5 * (interval->Lower + interval->Upper);
+    half = 0.5 * (interval->Upper - interval->Lower);
+
+    fc = integrand(center, context);
+    res_kronrod = rule->Wgk[n] * fc;
+    res_gauss = (rule->CenterGauss == TRUE) ? rule->Wg[n / 2] * fc : 0.0;
+    res_abs = fabs(res_kronrod);
+
+    for (j = 0; j < n; j++) {
+        abscissa = half * rule->Xgk[j];
+        f1[j] = integrand(center - abscissa, context);
+        f2[j] = integrand(center + abscissa, context);
+        res_kronrod += rule->Wgk[j] * (f1[j] + f2[j]);
+        res_abs += rule->Wgk[j] * (fabs(f1[j]) + fabs(f2[j]));
+        if ((j % 2) == 1) {
+            res_gauss += rule->Wg[j / 2] * (f1[j] + f2[j]);
+        }
+    }
+
+    mean = 0.5 * res_kronrod;
+    res_asc = rule->Wgk[n] * fabs(fc - mean);
+    for (j = 0; j < n; j++) {
+        res_asc += rule->Wgk[j] * (fabs(f1[j] - mean) + fabs(f2[j] - mean));
+    }
+
+    error = fabs((res_kronrod - res_gauss) * half);
+    res_kronrod *= half;
+    res_abs *= fabs(half);
+    res_asc *= fabs(half);
+
+    if ((res_asc != 0.0) && (error != 0.0)) {
+        error = res_asc * fmin(1.0, pow(200.0 * error / res_asc, 1.5));
+    }
+    if (res_abs > DBL_MIN / (50.0 * DBL_EPSILON)) {
+        error = fmax(50.0 * DBL_EPSILON * res_abs, error);
+    }
+
+    interval->Value = res_kronrod;
+    interval->Error = error;
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Integrand of the log-space substitution
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  t       : ln(x)
+//! \param[in]  context : GAUSS_KRONROD_LOG_CONTEXT
+//! \return     f(e^t) e^t
+//******************************************************************************
+static F64 logIntegrand(const F64 t, void *context)
+{
+    const GAUSS_KRONROD_LOG_CONTEXT *log_context = (const GAUSS_KRONROD_LOG_CONTEXT *)context;
+    const F64 x = exp(t);
+
+    return log_context->Integrand(x, log_context->Context) * x;
+}
+
+
+
+//******************************************************************************
+//! \breif      Inner integrand of the nested multiple integration
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  y       : Inner variable
+//! \param[in]  context : GAUSS_KRONROD_NESTED_CONTEXT
+//! \return     f(x, y)
+//******************************************************************************
+static F64 innerIntegrand(const F64 y, void *context)
+{
+    const GAUSS_KRONROD_NESTED_CONTEXT *nested = (const GAUSS_KRONROD_NESTED_CONTEXT *)context;
+
+    return nested->Integrand(nested->X, y, nested->Context);
+}
+
+
+
+//******************************************************************************
+//! \breif      Outer integrand of the nested multiple integration
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  x       : Outer variable
+//! \param[in]  context : GAUSS_KRONROD_NESTED_CONTEXT
+//! \return     Integral of f(x, y) over y
+//******************************************************************************
+static F64 outerIntegrand(const F64 x, void *context)
+{
+    GAUSS_KRONROD_NESTED_CONTEXT *nested = (GAUSS_KRONROD_NESTED_CONTEXT *)context;
+    GAUSS_KRONROD_RESULT inner;
+
+    nested->X = x;
+    if (NumericsGaussKronrod_IntegrateLog(innerIntegrand, nested, nested->RangeY, &nested->Tolerance, &inner) == FALSE) {
+        nested->Converged = FALSE;
+    }
+
+    nested->Evaluations += inner.Evaluations;
+    if (inner.Value != 0.0) {
+        nested->MaxRelError = fmax(nested->MaxRelError, inner.Error / fabs(inner.Value));
+    }
+
+    return inner.Value;
+}
+
+
+
+
+
+//******************************************************************************
+// End of File
+//******************************************************************************
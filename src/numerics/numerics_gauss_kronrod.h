@@ -0,0 +1,122 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#ifndef NUMERICS_GAUSS_KRONROD_H_
+#define NUMERICS_GAUSS_KRONROD_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include "common_typedef.h"
+#include "numerics_integration.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+#define GAUSS_KRONROD_15                (15)    //!< 7-point Gauss, 15-point Kronrod
+#define GAUSS_KRONROD_21                (21)    //!< 10-point Gauss, 21-point Kronrod
+
+
+
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! Tolerance of the adaptive integration
+//----------------------------------------------------------
+typedef struct gauss_kronrod_tolerance_t {
+    S32         Rule;           //!< GAUSS_KRONROD_15 or GAUSS_KRONROD_21
+    F64         Absolute;       //!< Absolute tolerance
+    F64         Relative;       //!< Relative tolerance
+}GAUSS_KRONROD_TOLERANCE;
+
+//----------------------------------------------------------
+//! Result of the adaptive integration
+//----------------------------------------------------------
+typedef struct gauss_kronrod_result_t {
+    F64         Value;          //!< Integrated value
+    F64         Error;          //!< Estimated absolute error
+    U64         Evaluations;    //!< Number of integrand evaluations
+    U32         Intervals;      //!< Number of subintervals at the end
+}GAUSS_KRONROD_RESULT;
+
+
+
+//==============================================================================
+// Export Scope Function Prototype
+//==============================================================================
+/**
+ * @brief           Adaptive Gauss-Kronrod integration
+ * 
+ * @param integrand Function Pointer (Integrand with user context)
+ * @param context   User context passed to the integrand
+ * @param range     Integration Range (Iteration is the maximum number of subintervals)
+ * @param tolerance Tolerance
+ * @param result    Integrated value, error estimate and evaluation count
+ * @return BOOL     TRUE if the tolerance is met, otherwise FALSE
+ */
+extern BOOL NumericsGaussKronrod_Integrate(INTEGRAND_CTX integrand, void *context, const INTEGRATION_RANGE *range, const GAUSS_KRONROD_TOLERANCE *tolerance, GAUSS_KRONROD_RESULT *result);
+
+/**
+ * @brief           Adaptive Gauss-Kronrod integration in log space
+ * 
+ * @param integrand Function Pointer (Integrand with user context)
+ * @param context   User context passed to the integrand
+ * @param range     Integration Range (positive, Iteration is the maximum number of subintervals)
+ * @param tolerance Tolerance
+ * @param result    Integrated value, error estimate and evaluation count
+ * @return BOOL     TRUE if the tolerance is met, otherwise FALSE
+ */
+extern BOOL NumericsGaussKronrod_IntegrateLog(INTEGRAND_CTX integrand, void *context, const INTEGRATION_RANGE *range, const GAUSS_KRONROD_TOLERANCE *tolerance, GAUSS_KRONROD_RESULT *result);
+
+/**
+ * @brief           Nested adaptive Gauss-Kronrod multiple integration in log space
+ * 
+ * @param integrand Function Pointer (Integrand with user context)
+ * @param context   User context passed to the integrand
+ * @param range_x   Integration Range for X-axis (outer)
+ * @param range_y   Integration Range for Y-axis (inner)
+ * @param tolerance Tolerance
+ * @param result    Integrated value, error estimate and evaluation count
+ * @return BOOL     TRUE if the tolerance is met, otherwise FALSE
+ */
+extern BOOL NumericsGaussKronrod_Integrate2dLog(MULTIPLE_INTEGRAND_CTX integrand, void *context, const INTEGRATION_RANGE *range_x, const INTEGRATION_RANGE *range_y, const GAUSS_KRONROD_TOLERANCE *tolerance, GAUSS_KRONROD_RESULT *result);
+
+
+
+#ifdef _cplusplus
+}
+#endif
+
+#endif
+
+//******************************************************************************
+// End of File
+//******************************************************************************
@@ -48,6 +48,15 @@ typedef struct integration_range_t {
     U32         Iteration;      //!< Iteration Count
 }INTEGRATION_RANGE;
 
+//----------------------------------------------------------
+//! Quadrature Rule (nodes and weights)
+//----------------------------------------------------------
+typedef struct quadrature_rule_t {
+    U32         Count;          //!< Number of nodes
+    F64         *Node;          //!< Nodes (ascending)
+    F64         *Weight;        //!< Weights
+}QUADRATURE_RULE;
+
 //----------------------------------------------------------
 //! Integrand
 //----------------------------------------------------------
@@ -63,6 +72,21 @@ typedef F64 (*MULTIPLE_INTEGRAND)(const F64 x, const F64 y);
 //----------------------------------------------------------
 typedef F64 (*TRIPLE_INTEGRAND)(const F64 x, const F64 y, const F64 z); 
 
+//----------------------------------------------------------
+//! Integrand with user context
+//----------------------------------------------------------
+typedef F64 (*INTEGRAND_CTX)(const F64 x, void *context);
+
+//----------------------------------------------------------
+//! Integrand with user context for multiple integration
+//----------------------------------------------------------
+typedef F64 (*MULTIPLE_INTEGRAND_CTX)(const F64 x, const F64 y, void *context);
+
+//----------------------------------------------------------
+//! Integrand with user context for triple integration
+//----------------------------------------------------------
+typedef F64 (*TRIPLE_INTEGRAND_CTX)(const F64 x, const F64 y, const F64 z, void *context);
+
 
 
 #ifdef _cplusplus
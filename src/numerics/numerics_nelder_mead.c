@@ -0,0 +1,300 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#define NUMERICS_NELDER_MEAD_C_
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include <math.h>
+#include "numerics_nelder_mead.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+#define NELDER_MEAD_REFLECTION          (1.0)           //!< Reflection coefficient
+#define NELDER_MEAD_EXPANSION           (2.0)           //!< Expansion coefficient
+#define NELDER_MEAD_CONTRACTION         (0.5)           //!< Contraction coefficient
+#define NELDER_MEAD_SHRINK              (0.5)           //!< Shrink coefficient
+#define NELDER_MEAD_VERTICES            (NELDER_MEAD_MAX_DIMENSION + 1)
+
+
+
+//==============================================================================
+// File Scope Function Prototype
+//==============================================================================
+static void sortSimplex(F64 simplex[][NELDER_MEAD_MAX_DIMENSION], F64 *values, const U32 dimension);
+static void movePoint(const F64 *centroid, const F64 *worst, const F64 coefficient, const U32 dimension, F64 *point);
+static BOOL isConverged(F64 simplex[][NELDER_MEAD_MAX_DIMENSION], const F64 *values, const U32 dimension, const NELDER_MEAD_TOLERANCE *tolerance);
+
+
+
+
+
+//******************************************************************************
+//! \breif      Minimize a function with the Nelder-Mead simplex method
+//! \remark     1) Standard coefficients (1, 2, 0.5, 0.5) and the ordering
+//!                rules of [Lagarias et al., SIAM J. Optim., 9, 112].
+//!             2) Stops when the objective spread over the simplex is below
+//!                Value relative to the best value and every vertex is within
+//!                Step of the best one, or after MaxEvaluations evaluations.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  objective : Function Pointer (Objective with user context)
+//! \param[in]  context   : User context passed to the objective
+//! \param[in]  dimension : Number of parameters (up to NELDER_MEAD_MAX_DIMENSION)
+//! \param[in,out] x      : Start point on input, best point on output [dimension]
+//! \param[in]  step      : Initial simplex step of each parameter [dimension]
+//! \param[in]  tolerance : Stopping rule
+//! \param[out] result    : Minimum, evaluations and iterations
+//! \return     TRUE if the tolerance is met, FALSE otherwise
+//******************************************************************************
+BOOL NumericsNelderMead_Minimize(OBJECTIVE_CTX objective, void *context, const U32 dimension, F64 *x, const F64 *step,
+                                 const NELDER_MEAD_TOLERANCE *tolerance, NELDER_MEAD_RESULT *result)
+{
+    F64 simplex[NELDER_MEAD_VERTICES][NELDER_MEAD_MAX_DIMENSION];
+    F64 values[NELDER_MEAD_VERTICES];
+    F64 centroid[NELDER_MEAD_MAX_DIMENSION], reflected[NELDER_MEAD_MAX_DIMENSION], trial[NELDER_MEAD_MAX_DIMENSION];
+    F64 f_reflected, f_trial;
+    U32 i, d;
+    BOOL converged = FALSE;
+
+    result->Evaluations = 0;
+    result->Iterations = 0;
+
+    if ((dimension == 0) || (dimension > NELDER_MEAD_MAX_DIMENSION)) {
+        result->Minimum = NAN;
+        return FALSE;
+    }
+
+    //------------------------------------------------------
+    // Initial simplex : the start point and one step along each axis
+    //------------------------------------------------------
+    for (i = 0; i <= dimension; i++) {
+        for (d = 0; d < dimension; d++) {
+            simplex[i][d] = x[d];
+        }
+        if (i > 0) {
+            simplex[i][i - 1] += step[i - 1];
+        }
+        values[i] = objective(simplex[i], context);
+        result->Evaluations++;
+    }
+    sortSimplex(simplex, values, dimension);
+
+    while (result->Evaluations < tolerance->MaxEvaluations) {
+        if ((converged = isConverged(simplex, values, dimension, tolerance)) == TRUE) {
+            break;
+        }
+        result->Iterations++;
+
+        // Centroid of every vertex but the worst
+        for (d = 0; d < dimension; d++) {
+            for (centroid[d] = 0.0, i = 0; i < dimension; i++) {
+                centroid[d] += simplex[i][d];
+            }
+            centroid[d] /= (F64)dimension;
+        }
+
+        movePoint(centroid, simplex[dimension], NELDER_MEAD_REFLECTION, dimension, reflected);
+        f_reflected = objective(reflected, context);
+        result->Evaluations++;
+
+        if (f_reflected < values[0]) {
+            // Expansion
+            movePoint(centroid, simplex[dimension], NELDER_MEAD_REFLECTION * NELDER_MEAD_EXPANSION, dimension, trial);
+            f_trial = objective(trial, context);
+            result->Evaluations++;
+
+            if (f_trial < f_reflected) {
+                for (d = 0; d < dimension; d++) {
+                    simplex[dimension][d] = trial[d];
+                }
+                values[dimension] = f_trial;
+            }
+            else {
+                for (d = 0; d < dimension; d++) {
+                    simplex[dimension][d] = reflected[d];
+                }
+                values[dimension] = f_reflected;
+            }
+        }
+        else if (f_reflected < values[dimension - 1]) {
+            // Reflection
+            for (d = 0; d < dimension; d++) {
+                simplex[dimension][d] = reflected[d];
+            }
+            values[dimension] = f_reflected;
+        }
+        else {
+            // Outside or inside contraction
+            if (f_reflected < values[dimension]) {
+                movePoint(centroid, simplex[dimension], NELDER_MEAD_REFLECTION * NELDER_MEAD_CONTRACTION, dimension, trial);
+            }
+            else {
+                movePoint(centroid, simplex[dimension], -NELDER_MEAD_CONTRACTION, dimension, trial);
+            }
+            f_trial = objective(trial, context);
+            result->Evaluations++;
+
+            if (f_trial < fmin(f_reflected, values[dimension])) {
+                for (d = 0; d < dimension; d++) {
+                    simplex[dimension][d] = trial[d];
+                }
+                values[dimension] = f_trial;
+            }
+            else {
+                // Shrink toward the best vertex
+                for (i = 1; i <= dimension; i++) {
+                    for (d = 0; d < dimension; d++) {
+                        simplex[i][d] = simplex[0][d] + NELDER_MEAD_SHRINK * (simplex[i][d] - simplex[0][d]);
+                    }
+                    values[i] = objective(simplex[i], context);
+                    result->Evaluations++;
+                }
+            }
+        }
+
+        sortSimplex(simplex, values, dimension);
+    }
+
+    for (d = 0; d < dimension; d++) {
+        x[d] = simplex[0][d];
+    }
+    result->Minimum = values[0];
+
+    return converged;
+}
+
+
+
+
+
+//******************************************************************************
+//! \breif      Sort the vertices by increasing objective
+//! \remark     Insertion sort, stable so that ties keep their order.
+//! 
+//! \callgraph  
+//! 
+//! \param[in,out] simplex : Vertices
+//! \param[in,out] values  : Objective at the vertices
+//! \param[in]  dimension  : Number of parameters
+//! \return     None
+//******************************************************************************
+static void sortSimplex(F64 simplex[][NELDER_MEAD_MAX_DIMENSION], F64 *values, const U32 dimension)
+{
+    F64 vertex[NELDER_MEAD_MAX_DIMENSION];
+    F64 value;
+    U32 i, j, d;
+
+    for (i = 1; i <= dimension; i++) {
+        value = values[i];
+        for (d = 0; d < dimension; d++) {
+            vertex[d] = simplex[i][d];
+        }
+
+        for (j = i; (j > 0) && (values[j - 1] > value); j--) {
+            values[j] = values[j - 1];
+            for (d = 0; d < dimension; d++) {
+                simplex[j][d] = simplex[j - 1][d];
+            }
+        }
+
+        values[j] = value;
+        for (d = 0; d < dimension; d++) {
+            simplex[j][d] = vertex[d];
+        }
+    }
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Move the worst vertex through the centroid
+//! \remark     point = centroid + coefficient * (centroid - worst)
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  centroid    : Centroid of the other vertices
+//! \param[in]  worst       : Worst vertex
+//! \param[in]  coefficient : Coefficient
+//! \param[in]  dimension   : Number of parameters
+//! \param[out] point       : Moved point
+//! \return     None
+//******************************************************************************
+static void movePoint(const F64 *centroid, const F64 *worst, const F64 coefficient, const U32 dimension, F64 *point)
+{
+    U32 d;
+
+    for (d = 0; d < dimension; d++) {
+        point[d] = centroid[d] + coefficient * (centroid[d] - worst[d]);
+    }
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check the stopping rule
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  simplex   : Vertices (sorted)
+//! \param[in]  values    : Objective at the vertices (sorted)
+//! \param[in]  dimension : Number of parameters
+//! \param[in]  tolerance : Stopping rule
+//! \return     TRUE if the simplex has converged
+//******************************************************************************
+static BOOL isConverged(F64 simplex[][NELDER_MEAD_MAX_DIMENSION], const F64 *values, const U32 dimension, const NELDER_MEAD_TOLERANCE *tolerance)
+{
+    U32 i, d;
+
+    if (fabs(values[dimension] - values[0]) > tolerance->Value * (fabs(values[0]) + tolerance->Value)) {
+        return FALSE;
+    }
+
+    for (i = 1; i <= dimension; i++) {
+        for (d = 0; d < dimension; d++) {
+            if (fabs(simplex[i][d] - simplex[0][d]) > tolerance->Step) {
+                return FALSE;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+
+
+
+//******************************************************************************
+// End of File
+//******************************************************************************
@@ -0,0 +1,102 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#ifndef NUMERICS_NELDER_MEAD_H_
+#define NUMERICS_NELDER_MEAD_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include "common_typedef.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+#define NELDER_MEAD_MAX_DIMENSION       (8)             //!< Largest number of parameters
+
+
+
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! Function to be minimized
+//----------------------------------------------------------
+typedef F64 (*OBJECTIVE_CTX)(const F64 *x, void *context);
+
+//----------------------------------------------------------
+//! Stopping rule of the minimization
+//----------------------------------------------------------
+typedef struct nelder_mead_tolerance_t {
+    F64         Value;                  //!< Relative spread of the objective over the simplex
+    F64         Step;                   //!< Largest distance of the simplex from its best vertex
+    U32         MaxEvaluations;         //!< Maximum number of objective evaluations
+}NELDER_MEAD_TOLERANCE;
+
+//----------------------------------------------------------
+//! Result of the minimization
+//----------------------------------------------------------
+typedef struct nelder_mead_result_t {
+    F64         Minimum;                //!< Objective at the best vertex
+    U32         Evaluations;            //!< Objective evaluations
+    U32         Iterations;             //!< Simplex iterations
+}NELDER_MEAD_RESULT;
+
+
+
+//==============================================================================
+// Export Scope Function Prototype
+//==============================================================================
+/**
+ * @brief           Minimize a function with the Nelder-Mead simplex method
+ * 
+ * @param objective Function Pointer (Objective with user context)
+ * @param context   User context passed to the objective
+ * @param dimension Number of parameters (up to NELDER_MEAD_MAX_DIMENSION)
+ * @param x         Start point on input, best point on output [dimension]
+ * @param step      Initial simplex step of each parameter [dimension]
+ * @param tolerance Stopping rule
+ * @param result    Minimum, evaluations and iterations
+ * @return BOOL     TRUE if the tolerance is met, FALSE otherwise
+ */
+extern BOOL NumericsNelderMead_Minimize(OBJECTIVE_CTX objective, void *context, const U32 dimension, F64 *x, const F64 *step,
+                                        const NELDER_MEAD_TOLERANCE *tolerance, NELDER_MEAD_RESULT *result);
+
+
+
+#ifdef _cplusplus
+}
+#endif
+
+#endif
+
+//******************************************************************************
+// End of File
+//******************************************************************************
@@ -0,0 +1,421 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#define NUMERICS_QUADRATURE_C_
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include <stdlib.h>
+#include <math.h>
+#include "numerics_quadrature.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+#define LAGUERRE_MAX_NEWTON             (100)       //!< Newton iterations per root
+#define LAGUERRE_ROOT_TOLERANCE         (1.0E-13)   //!< Relative Newton step to stop at
+#define INTEGRATE3D_BLOCK_SIZE          (16)        //!< Nodes per block on the X- and Y-axis
+
+
+
+//==============================================================================
+// File Scope Function Prototype
+//==============================================================================
+static BOOL allocateRule(QUADRATURE_RULE *rule, const U32 count);
+static void setTrapezoidalWeights(QUADRATURE_RULE *rule);
+
+
+
+
+
+//******************************************************************************
+//! \breif      Create a trapezoidal rule on linearly spaced nodes
+//! \remark     Nodes are computed from the node index, so the rule always
+//!             has exactly (Iteration + 1) nodes and ends on range->Upper.
+//! 
+//! \callgraph  
+//! 
+//! \param[out] rule  : Quadrature rule to be created
+//! \param[in]  range : Integration Range
+//! \return     TRUE on success, FALSE if Iteration is 0 or the arrays cannot
+//!             be allocated
+//******************************************************************************
+BOOL NumericsQuadrature_CreateLinear(QUADRATURE_RULE *rule, const INTEGRATION_RANGE *range)
+{
+    U32 i;
+    F64 dx;
+
+    if (range->Iteration == 0) {
+        rule->Count = 0;
+        rule->Node = rule->Weight = NULL;
+        return FALSE;
+    }
+    if (allocateRule(rule, range->Iteration + 1) == FALSE) {
+        return FALSE;
+    }
+
+    dx = (range->Upper - range->Lower) / (F64)range->Iteration;
+
+    for (i = 0; i < range->Iteration; i++) {
+        rule->Node[i] = range->Lower + dx * (F64)i;
+    }
+    rule->Node[range->Iteration] = range->Upper;
+
+    setTrapezoidalWeights(rule);
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Create a trapezoidal rule on logarithmically spaced nodes
+//! \remark     The weights are those of the trapezoidal rule in x, so the rule
+//!             integrates f(x) dx directly without any change of variable.
+//! 
+//! \callgraph  
+//! 
+//! \param[out] rule  : Quadrature rule to be created
+//! \param[in]  range : Integration Range (Lower must be positive)
+//! \return     TRUE on success, FALSE if Iteration is 0 or the arrays cannot
+//!             be allocated
+//******************************************************************************
+BOOL NumericsQuadrature_CreateLog(QUADRATURE_RULE *rule, const INTEGRATION_RANGE *range)
+{
+    U32 i;
+    F64 logx_lower, dlogx;
+
+    if (range->Iteration == 0) {
+        rule->Count = 0;
+        rule->Node = rule->Weight = NULL;
+        return FALSE;
+    }
+    if (allocateRule(rule, range->Iteration + 1) == FALSE) {
+        return FALSE;
+    }
+
+    logx_lower = log10(range->Lower);
+    dlogx = (log10(range->Upper) - logx_lower) / (F64)range->Iteration;
+
+    rule->Node[0] = range->Lower;
+    for (i = 1; i < range->Iteration; i++) {
+        rule->Node[i] = pow(10.0, logx_lower + dlogx * (F64)i);
+    }
+    rule->Node[range->Iteration] = range->Upper;
+
+    setTrapezoidalWeights(rule);
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Create a generalized Gauss-Laguerre rule
+//! \remark     sum_i Weight[i] f(Node[i]) ~ integral_0^inf x^alpha e^(-x) f(x) dx.
+//!             Roots of L_n^alpha by Newton's method from the asymptotic
+//!             initial guesses of Numerical Recipes (gaulag).
+//! 
+//! \callgraph  
+//! 
+//! \param[out] rule  : Quadrature rule to be created
+//! \param[in]  count : Number of nodes
+//! \param[in]  alpha : Exponent of the weight function (> -1)
+//! \return     TRUE on success, FALSE if the arrays cannot be allocated or
+//!             Newton's method does not converge
+//******************************************************************************
+BOOL NumericsQuadrature_CreateLaguerre(QUADRATURE_RULE *rule, const U32 count, const F64 alpha)
+{
+    U32 i, j, k;
+    F64 z = 0.0, z_prev, p1, p2, p3, dp = 1.0, step;
+
+    if ((count == 0) || (allocateRule(rule, count) == FALSE)) {
+        return FALSE;
+    }
+
+    for (i = 0; i < count; i++) {
+        //------------------------------------------------------
+        // Initial guess of the i-th root
+        //------------------------------------------------------
+        if (i == 0) {
+            z = (1.0 + alpha) * (3.0 + 0.92 * alpha) / (1.0 + 2.4 * (F64)count + 1.8 * alpha);
+        }
+        else if (i == 1) {
+            z += (15.0 + 6.25 * alpha) / (1.0 + 0.9 * alpha + 2.5 * (F64)count);
+        }
+        else {
+            step = (F64)(i - 1);
+            z += ((1.0 + 2.55 * step) / (1.9 * step) + 1.26 * step * alpha / (1.0 + 3.5 * step))
+               * (z - rule->Node[i - 2]) / (1.0 + 0.3 * alpha);
+        }
+
+        //------------------------------------------------------
+        // Newton's method on L_n^alpha (recurrence in j)
+        //------------------------------------------------------
+        for (k = 0; k < LAGUERRE_MAX_NEWTON; k++) {
+            p1 = 1.0;
+            p2 = 0.0;
+            for (j = 1; j <= count; j++) {
+                p3 = p2;
+                p2 = p1;
+                p1 = ((2.0 * (F64)j - 1.0 + alpha - z) * p2 - ((F64)j - 1.0 + alpha) * p3) / (F64)j;
+            }
+            dp = ((F64)count * p1 - ((F64)count + alpha) * p2) / z;
+            z_prev = z;
+            z = z_prev - p1 / dp;
+            if (fabs(z - z_prev) <= LAGUERRE_ROOT_TOLERANCE * fabs(z)) {
+                break;
+            }
+        }
+        if (k == LAGUERRE_MAX_NEWTON) {
+            NumericsQuadrature_Release(rule);
+            return FALSE;
+        }
+
+        rule->Node[i] = z;
+        rule->Weight[i] = -exp(lgamma(alpha + (F64)count) - lgamma((F64)count)) / (dp * (F64)count * p2);
+    }
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Release the arrays owned by a quadrature rule
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  rule : Quadrature rule
+//! \return     None
+//******************************************************************************
+void NumericsQuadrature_Release(QUADRATURE_RULE *rule)
+{
+    free(rule->Node);
+    free(rule->Weight);
+
+    rule->Node = NULL;
+    rule->Weight = NULL;
+    rule->Count = 0;
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Numerical integration using a quadrature rule
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  integrand : Function Pointer (Integrand with user context)
+//! \param[in]  context   : User context passed to the integrand
+//! \param[in]  rule      : Quadrature rule
+//! \return     Integrated value
+//******************************************************************************
+F64 NumericsQuadrature_Integrate(INTEGRAND_CTX integrand, void *context, const QUADRATURE_RULE *rule)
+{
+    register U32 i;
+    register F64 integrated = 0.0;
+
+    for (i = 0; i < rule->Count; i++) {
+        integrated += rule->Weight[i] * integrand(rule->Node[i], context);
+    }
+
+    return integrated;
+}
+
+
+
+//******************************************************************************
+//! \breif      Numerical multiple integration using quadrature rules
+//! \remark     Tensor product of the two rules.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  integrand : Function Pointer (Integrand with user context)
+//! \param[in]  context   : User context passed to the integrand
+//! \param[in]  rule_x    : Quadrature rule for X-axis
+//! \param[in]  rule_y    : Quadrature rule for Y-axis
+//! \return     Integrated value
+//******************************************************************************
+F64 NumericsQuadrature_Integrate2d(MULTIPLE_INTEGRAND_CTX integrand, void *context, const QUADRATURE_RULE *rule_x, const QUADRATURE_RULE *rule_y)
+{
+    register U32 i, j;
+    register F64 x, sum, integrated;
+
+    for (integrated = 0.0, i = 0; i < rule_x->Count; i++) {
+        x = rule_x->Node[i];
+
+        for (sum = 0.0, j = 0; j < rule_y->Count; j++) {
+            sum += rule_y->Weight[j] * integrand(x, rule_y->Node[j], context);
+        }
+        integrated += rule_x->Weight[i] * sum;
+    }
+
+    return integrated;
+}
+
+
+
+//******************************************************************************
+//! \breif      Numerical triple integration using quadrature rules
+//! \remark     1) Tensor product of the three rules.
+//!             2) The (x, y) plane is cut into INTEGRATE3D_BLOCK_SIZE square
+//!                blocks that run in parallel; each block sweeps the whole
+//!                z rule, whose arrays stay in cache.
+//!             3) Every block stores its own partial sum and the partial sums
+//!                are added in block order, so the result does not depend on
+//!                the number of threads.
+//!             4) The integrand may be called from several threads at once.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  integrand : Function Pointer (Integrand with user context)
+//! \param[in]  context   : User context passed to the integrand
+//! \param[in]  rule_x    : Quadrature rule for X-axis
+//! \param[in]  rule_y    : Quadrature rule for Y-axis
+//! \param[in]  rule_z    : Quadrature rule for Z-axis
+//! \return     Integrated value (NaN if the work array cannot be allocated)
+//******************************************************************************
+F64 NumericsQuadrature_Integrate3d(TRIPLE_INTEGRAND_CTX integrand, void *context, const QUADRATURE_RULE *rule_x, const QUADRATURE_RULE *rule_y, const QUADRATURE_RULE *rule_z)
+{
+    S32 bx, by, n_blocks_x, n_blocks_y;
+    U32 i, j, k, i_end, j_end;
+    F64 x, y, sum_y, sum_z, block, integrated;
+    F64 *partial;
+
+    n_blocks_x = (S32)((rule_x->Count + INTEGRATE3D_BLOCK_SIZE - 1) / INTEGRATE3D_BLOCK_SIZE);
+    n_blocks_y = (S32)((rule_y->Count + INTEGRATE3D_BLOCK_SIZE - 1) / INTEGRATE3D_BLOCK_SIZE);
+
+    if ((partial = (F64 *)calloc((size_t)n_blocks_x * (size_t)n_blocks_y + 1, sizeof(F64))) == NULL) {
+        return NAN;
+    }
+
+#ifdef _OPENMP
+    #pragma omp parallel for collapse(2) schedule(dynamic, 1) private(i, j, k, i_end, j_end, x, y, sum_y, sum_z, block)
+#endif
+    for (bx = 0; bx < n_blocks_x; bx++) {
+        for (by = 0; by < n_blocks_y; by++) {
+            i_end = (U32)(bx + 1) * INTEGRATE3D_BLOCK_SIZE;
+            i_end = (i_end < rule_x->Count) ? i_end : rule_x->Count;
+            j_end = (U32)(by + 1) * INTEGRATE3D_BLOCK_SIZE;
+            j_end = (j_end < rule_y->Count) ? j_end : rule_y->Count;
+
+            for (block = 0.0, i = (U32)bx * INTEGRATE3D_BLOCK_SIZE; i < i_end; i++) {
+                x = rule_x->Node[i];
+
+                for (sum_y = 0.0, j = (U32)by * INTEGRATE3D_BLOCK_SIZE; j < j_end; j++) {
+                    y = rule_y->Node[j];
+
+                    for (sum_z = 0.0, k = 0; k < rule_z->Count; k++) {
+                        sum_z += rule_z->Weight[k] * integrand(x, y, rule_z->Node[k], context);
+                    }
+                    sum_y += rule_y->Weight[j] * sum_z;
+                }
+                block += rule_x->Weight[i] * sum_y;
+            }
+            partial[bx * n_blocks_y + by] = block;
+        }
+    }
+
+    for (integrated = 0.0, bx = 0; bx < n_blocks_x * n_blocks_y; bx++) {
+        integrated += partial[bx];
+    }
+
+    free(partial);
+
+    return integrated;
+}
+
+
+
+//******************************************************************************
+//! \breif      Allocate the node and weight arrays of a quadrature rule
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[out] rule  : Quadrature rule
+//! \param[in]  count : Number of nodes
+//! \return     TRUE on success, FALSE if the arrays cannot be allocated
+//******************************************************************************
+static BOOL allocateRule(QUADRATURE_RULE *rule, const U32 count)
+{
+    rule->Count  = count;
+    rule->Node   = (F64 *)malloc(sizeof(F64) * count);
+    rule->Weight = (F64 *)malloc(sizeof(F64) * count);
+
+    if ((rule->Node == NULL) || (rule->Weight == NULL)) {
+        NumericsQuadrature_Release(rule);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Set the trapezoidal weights for the nodes of a rule
+//! \remark     w[0] = (x[1] - x[0]) / 2, w[i] = (x[i+1] - x[i-1]) / 2,
+//!             w[n] = (x[n] - x[n-1]) / 2
+//! 
+//! \callgraph  
+//! 
+//! \param[in,out] rule : Quadrature rule with its nodes set
+//! \return     None
+//******************************************************************************
+static void setTrapezoidalWeights(QUADRATURE_RULE *rule)
+{
+    U32 i, n;
+
+    n = rule->Count - 1;
+
+    if (n == 0) {
+        rule->Weight[0] = 0.0;
+        return;
+    }
+
+    rule->Weight[0] = 0.5 * (rule->Node[1] - rule->Node[0]);
+    for (i = 1; i < n; i++) {
+        rule->Weight[i] = 0.5 * (rule->Node[i + 1] - rule->Node[i - 1]);
+    }
+    rule->Weight[n] = 0.5 * (rule->Node[n] - rule->Node[n - 1]);
+
+    return;
+}
+
+
+
+
+
+//******************************************************************************
+// End of File
+//******************************************************************************
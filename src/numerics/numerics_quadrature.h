@@ -0,0 +1,122 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+#ifndef NUMERICS_QUADRATURE_H_
+#define NUMERICS_QUADRATURE_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include "common_typedef.h"
+#include "numerics_integration.h"
+
+
+
+//==============================================================================
+// Export Scope Function Prototype
+//==============================================================================
+/**
+ * @brief           Create a trapezoidal rule on linearly spaced nodes
+ * 
+ * @param rule      Quadrature rule to be created
+ * @param range     Integration Range (Iteration is the number of intervals)
+ * @return BOOL     TRUE on success, FALSE if Iteration is 0 or the arrays cannot be allocated
+ */
+extern BOOL NumericsQuadrature_CreateLinear(QUADRATURE_RULE *rule, const INTEGRATION_RANGE *range);
+
+/**
+ * @brief           Create a trapezoidal rule on logarithmically spaced nodes
+ * 
+ * @param rule      Quadrature rule to be created
+ * @param range     Integration Range (Iteration is the number of intervals)
+ * @return BOOL     TRUE on success, FALSE if Iteration is 0 or the arrays cannot be allocated
+ */
+extern BOOL NumericsQuadrature_CreateLog(QUADRATURE_RULE *rule, const INTEGRATION_RANGE *range);
+
+/**
+ * @brief           Create a generalized Gauss-Laguerre rule
+ * 
+ * @param rule      Quadrature rule to be created (weight function x^alpha e^(-x) on [0, inf))
+ * @param count     Number of nodes
+ * @param alpha     Exponent of the weight function (> -1)
+ * @return BOOL     TRUE on success, FALSE on allocation or convergence failure
+ */
+extern BOOL NumericsQuadrature_CreateLaguerre(QUADRATURE_RULE *rule, const U32 count, const F64 alpha);
+
+/**
+ * @brief           Release the arrays owned by a quadrature rule
+ * 
+ * @param rule      Quadrature rule
+ */
+extern void NumericsQuadrature_Release(QUADRATURE_RULE *rule);
+
+/**
+ * @brief           Numerical integration using a quadrature rule
+ * 
+ * @param integrand Function Pointer (Integrand with user context)
+ * @param context   User context passed to the integrand
+ * @param rule      Quadrature rule
+ * @return F64      Integrated value
+ */
+extern F64 NumericsQuadrature_Integrate(INTEGRAND_CTX integrand, void *context, const QUADRATURE_RULE *rule);
+
+/**
+ * @brief           Numerical multiple integration using quadrature rules
+ * 
+ * @param integrand Function Pointer (Integrand with user context)
+ * @param context   User context passed to the integrand
+ * @param rule_x    Quadrature rule for X-axis
+ * @param rule_y    Quadrature rule for Y-axis
+ * @return F64      Integrated value
+ */
+extern F64 NumericsQuadrature_Integrate2d(MULTIPLE_INTEGRAND_CTX integrand, void *context, const QUADRATURE_RULE *rule_x, const QUADRATURE_RULE *rule_y);
+
+/**
+ * @brief           Numerical triple integration using quadrature rules
+ *                  (blocked and parallel, the integrand must be reentrant)
+ * 
+ * @param integrand Function Pointer (Integrand with user context)
+ * @param context   User context passed to the integrand
+ * @param rule_x    Quadrature rule for X-axis
+ * @param rule_y    Quadrature rule for Y-axis
+ * @param rule_z    Quadrature rule for Z-axis
+ * @return F64      Integrated value (NaN if the work array cannot be allocated)
+ */
+extern F64 NumericsQuadrature_Integrate3d(TRIPLE_INTEGRAND_CTX integrand, void *context, const QUADRATURE_RULE *rule_x, const QUADRATURE_RULE *rule_y, const QUADRATURE_RULE *rule_z);
+
+
+
+#ifdef _cplusplus
+}
+#endif
+
+#endif
+
+//******************************************************************************
+// End of File
+//******************************************************************************
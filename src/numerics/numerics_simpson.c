@@ -31,6 +31,25 @@
 
 
 
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! Context used to call a bare integrand through the reentrant API
+//----------------------------------------------------------
+typedef struct simpson_bare_context_t {
+    INTEGRAND   Integrand;      //!< Bare integrand
+}SIMPSON_BARE_CONTEXT;
+
+
+
+//==============================================================================
+// File Scope Function Prototype
+//==============================================================================
+static F64 callBareIntegrand(const F64 x, void *context);
+
+
+
 
 
 //******************************************************************************
@@ -44,6 +63,29 @@
 //! \return     Integrated value
 //******************************************************************************
 F64 NumericsSimpson_Integrate(INTEGRAND integrand, const INTEGRATION_RANGE *range)
+{
+    SIMPSON_BARE_CONTEXT bare;
+
+    bare.Integrand = integrand;
+
+    return NumericsSimpson_IntegrateCtx(&callBareIntegrand, (void *)&bare, range);
+}
+
+
+
+//******************************************************************************
+//! \breif      Numerical integration using Simpson rule (reentrant)
+//! \remark     The context is passed through to every integrand call and
+//!             must be safe to read from several threads at once.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  integrand : Function Pointer (Integrand with user context)
+//! \param[in]  context   : User context passed to the integrand
+//! \param[in]  range     : Integration Range
+//! \return     Integrated value
+//******************************************************************************
+F64 NumericsSimpson_IntegrateCtx(INTEGRAND_CTX integrand, void *context, const INTEGRATION_RANGE *range)
 {
     S32 i;
     F64 x, dx, dxp2, dxp6;
@@ -59,9 +101,9 @@ F64 NumericsSimpson_Integrate(INTEGRAND integrand, const INTEGRATION_RANGE *rang
 #endif
     for (i = 0; i < range->Iteration; i++) {
         x  = range->Lower + dx * (F64)i;
-        x0 = integrand(x);
-        x1 = 4.0 * integrand(x + dxp2);
-        x2 = integrand(x + dx);
+        x0 = integrand(x, context);
+        x1 = 4.0 * integrand(x + dxp2, context);
+        x2 = integrand(x + dx, context);
         
         integrated += dxp6 * (x0 + x1 + x2);
     }
@@ -71,6 +113,23 @@ F64 NumericsSimpson_Integrate(INTEGRAND integrand, const INTEGRATION_RANGE *rang
 
 
 
+//******************************************************************************
+//! \breif      Call a bare integrand stored in the context
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  x       : Integration variable
+//! \param[in]  context : SIMPSON_BARE_CONTEXT
+//! \return     Integrand value
+//******************************************************************************
+static F64 callBareIntegrand(const F64 x, void *context)
+{
+    return ((const SIMPSON_BARE_CONTEXT *)context)->Integrand(x);
+}
+
+
+
 
 
 //******************************************************************************
@@ -49,6 +49,16 @@ extern "C" {
  */
 extern F64 NumericsSimpson_Integrate(INTEGRAND integrand, const INTEGRATION_RANGE *range);
 
+/**
+ * @brief           Numerical integration using Simpson rule (reentrant)
+ * 
+ * @param integrand : Function Pointer (Integrand with user context)
+ * @param context   : User context passed to the integrand
+ * @param range     : Integration Range
+ * @return F64      : Integrated value
+ */
+extern F64 NumericsSimpson_IntegrateCtx(INTEGRAND_CTX integrand, void *context, const INTEGRATION_RANGE *range);
+
 
 
 #ifdef _cplusplus
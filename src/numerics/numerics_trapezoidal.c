@@ -28,10 +28,34 @@
 // Header File Include
 //==============================================================================
 #include <math.h>
+#include "numerics_quadrature.h"
 #include "numerics_trapezoidal.h"
 
 
 
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! Context used to call a bare integrand through the reentrant API
+//----------------------------------------------------------
+typedef struct trapezoidal_bare_context_t {
+    INTEGRAND           Integrand;          //!< Bare integrand
+    MULTIPLE_INTEGRAND  MultipleIntegrand;  //!< Bare integrand for multiple integration
+    TRIPLE_INTEGRAND    TripleIntegrand;    //!< Bare integrand for triple integration
+}TRAPEZOIDAL_BARE_CONTEXT;
+
+
+
+//==============================================================================
+// File Scope Function Prototype
+//==============================================================================
+static F64 callBareIntegrand(const F64 x, void *context);
+static F64 callBareMultipleIntegrand(const F64 x, const F64 y, void *context);
+static F64 callBareTripleIntegrand(const F64 x, const F64 y, const F64 z, void *context);
+
+
+
 
 
 //******************************************************************************
@@ -45,15 +69,37 @@
 //! \return     Integrated value
 //******************************************************************************
 F64 NumericsTrapezoidal_Inetegrate(INTEGRAND integrand, const INTEGRATION_RANGE *range)
+{
+    TRAPEZOIDAL_BARE_CONTEXT bare;
+
+    bare.Integrand = integrand;
+
+    return NumericsTrapezoidal_InetegrateCtx(&callBareIntegrand, (void *)&bare, range);
+}
+
+
+
+//******************************************************************************
+//! \breif      Numerical integration using trapezoidal rule (reentrant)
+//! \remark     The context is passed through to every integrand call.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  integrand : Function Pointer (Integrand with user context)
+//! \param[in]  context   : User context passed to the integrand
+//! \param[in]  range     : Integration Range
+//! \return     Integrated value
+//******************************************************************************
+F64 NumericsTrapezoidal_InetegrateCtx(INTEGRAND_CTX integrand, void *context, const INTEGRATION_RANGE *range)
 {
     register F64 x, dx;
-    register S32 i;
+    register U32 i;
     register F64 integrated = 0.0;
 
     dx = (range->Upper - range->Lower) / (F64)range->Iteration;
 
     for (i = 0, x = range->Lower; i < range->Iteration; i++, x += dx) {
-        integrated += (integrand(x) + integrand(x + dx)) * dx * 0.50;
+        integrated += (integrand(x, context) + integrand(x + dx, context)) * dx * 0.50;
     }
 
     return integrated;
@@ -74,33 +120,47 @@ F64 NumericsTrapezoidal_Inetegrate(INTEGRAND integrand, const INTEGRATION_RANGE
 //******************************************************************************
 F64 NumericsTrapezoidal_Inetegrate2d(MULTIPLE_INTEGRAND  integrand, const INTEGRATION_RANGE *range_x, const INTEGRATION_RANGE *range_y)
 {
-    register F64 x, y, dx, dy;
-    register F64 logx, logy;
-    register F64 dlogx, dlogy;
-    register F64 logx_lower, logx_upper, logy_lower, logy_upper;
-    register F64 sum, integrated;
-
-    logx_lower = log10(range_x->Lower);
-    logx_upper = log10(range_x->Upper);
-    logy_lower = log10(range_y->Lower);
-    logy_upper = log10(range_y->Upper);
-
-    dlogx = (logx_upper - logx_lower) / (F64)range_x->Iteration;
-    dlogy = (logy_upper - logy_lower) / (F64)range_y->Iteration;
-
-    for (integrated = 0.0, logx = logx_lower; logx <= logx_upper; logx += dlogx) {
-        x = pow(10.0, logx);
-        dx = pow(10.0, (logx + dlogx)) - x;
-
-        for (sum = 0.0, logy = logy_lower; logy <= logy_upper; logy += dlogy) {
-            y  = pow(10.0, logy);
-            dy = pow(10.0, (logy + dlogy)) - y;
-
-            sum += (integrand(x, y) + integrand(x + dx, y + dy)) * dx * dy * 0.50;
-        }
-        integrated += sum;
+    TRAPEZOIDAL_BARE_CONTEXT bare;
+
+    bare.MultipleIntegrand = integrand;
+
+    return NumericsTrapezoidal_Inetegrate2dCtx(&callBareMultipleIntegrand, (void *)&bare, range_x, range_y);
+}
+
+
+
+//******************************************************************************
+//! \breif      Numerical multiple integration using trapezoidal rule (reentrant)
+//! \remark     Both axes are sampled on logarithmically spaced nodes. Callers
+//!             integrating repeatedly over the same ranges should build the
+//!             rules once and use NumericsQuadrature_Integrate2d instead.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  integrand : Function Pointer (Integrand with user context)
+//! \param[in]  context   : User context passed to the integrand
+//! \param[in]  range_x   : Integration Range for X-axis
+//! \param[in]  range_y   : Integration Range for Y-axis
+//! \return     Integrated value
+//******************************************************************************
+F64 NumericsTrapezoidal_Inetegrate2dCtx(MULTIPLE_INTEGRAND_CTX integrand, void *context, const INTEGRATION_RANGE *range_x, const INTEGRATION_RANGE *range_y)
+{
+    QUADRATURE_RULE rule_x, rule_y;
+    F64 integrated;
+
+    if (NumericsQuadrature_CreateLog(&rule_x, range_x) == FALSE) {
+        return NAN;
+    }
+    if (NumericsQuadrature_CreateLog(&rule_y, range_y) == FALSE) {
+        NumericsQuadrature_Release(&rule_x);
+        return NAN;
     }
 
+    integrated = NumericsQuadrature_Integrate2d(integrand, context, &rule_x, &rule_y);
+
+    NumericsQuadrature_Release(&rule_x);
+    NumericsQuadrature_Release(&rule_y);
+
     return integrated;
 }
 
@@ -108,7 +168,8 @@ F64 NumericsTrapezoidal_Inetegrate2d(MULTIPLE_INTEGRAND  integrand, const INTEGR
 
 //******************************************************************************
 //! \breif      Numerical triple integration using trapezoidal rule
-//! \remark     
+//! \remark     Integrated in parallel (NumericsTrapezoidal_Inetegrate3dCtx),
+//!             so the integrand must be reentrant.
 //! 
 //! \callgraph  
 //! 
@@ -120,23 +181,56 @@ F64 NumericsTrapezoidal_Inetegrate2d(MULTIPLE_INTEGRAND  integrand, const INTEGR
 //******************************************************************************
 F64 NumericsTrapezoidal_Inetegrate3d(TRIPLE_INTEGRAND integrand, const INTEGRATION_RANGE *range_x, const INTEGRATION_RANGE *range_y, const INTEGRATION_RANGE *range_z)
 {
-    register    F64   x, y, z, dx, dy, dz;
-    register    F64   sumy, sumz, integrated;
-
-    dx = (range_x->Upper - range_x->Lower) / (F64)range_x->Iteration;
-    dy = (range_y->Upper - range_y->Lower) / (F64)range_y->Iteration;
-    dz = (range_z->Upper - range_z->Lower) / (F64)range_z->Iteration;
-
-    for (integrated = 0.0, x = range_x->Lower; x < range_x->Upper; x += dx) {
-        for (sumy = 0.0, y = range_y->Lower; y <= range_y->Upper; y += dy) {
-            for (sumz = 0.0, z = range_z->Lower; z <= range_z->Upper; z += dz) {
-                sumz += (integrand(x, y, z) + integrand(x + dx, y + dy, z + dz)) * dx * dy * dz * 0.50;
-            }
-            sumy += sumz;
-        }
-        integrated += sumy;
+    TRAPEZOIDAL_BARE_CONTEXT bare;
+
+    bare.TripleIntegrand = integrand;
+
+    return NumericsTrapezoidal_Inetegrate3dCtx(&callBareTripleIntegrand, (void *)&bare, range_x, range_y, range_z);
+}
+
+
+
+//******************************************************************************
+//! \breif      Numerical triple integration using trapezoidal rule (reentrant)
+//! \remark     Tensor product of trapezoidal rules on linearly spaced nodes,
+//!             integrated in parallel by NumericsQuadrature_Integrate3d, so
+//!             the integrand may be called from several threads at once.
+//!             Build log-spaced rules with NumericsQuadrature_CreateLog and
+//!             call NumericsQuadrature_Integrate3d directly for log spacing.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  integrand : Function Pointer (Integrand with user context)
+//! \param[in]  context   : User context passed to the integrand
+//! \param[in]  range_x   : Integration Range for X-axis
+//! \param[in]  range_y   : Integration Range for Y-axis
+//! \param[in]  range_z   : Integration Range for Z-axis
+//! \return     Integrated value
+//******************************************************************************
+F64 NumericsTrapezoidal_Inetegrate3dCtx(TRIPLE_INTEGRAND_CTX integrand, void *context, const INTEGRATION_RANGE *range_x, const INTEGRATION_RANGE *range_y, const INTEGRATION_RANGE *range_z)
+{
+    QUADRATURE_RULE rule_x, rule_y, rule_z;
+    F64 integrated;
+
+    if (NumericsQuadrature_CreateLinear(&rule_x, range_x) == FALSE) {
+        return NAN;
+    }
+    if (NumericsQuadrature_CreateLinear(&rule_y, range_y) == FALSE) {
+        NumericsQuadrature_Release(&rule_x);
+        return NAN;
+    }
+    if (NumericsQuadrature_CreateLinear(&rule_z, range_z) == FALSE) {
+        NumericsQuadrature_Release(&rule_x);
+        NumericsQuadrature_Release(&rule_y);
+        return NAN;
     }
 
+    integrated = NumericsQuadrature_Integrate3d(integrand, context, &rule_x, &rule_y, &rule_z);
+
+    NumericsQuadrature_Release(&rule_x);
+    NumericsQuadrature_Release(&rule_y);
+    NumericsQuadrature_Release(&rule_z);
+
     return integrated;
 }
 
@@ -144,6 +238,62 @@ F64 NumericsTrapezoidal_Inetegrate3d(TRIPLE_INTEGRAND integrand, const INTEGRATI
 
 
 
+//******************************************************************************
+//! \breif      Call a bare integrand stored in the context
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  x       : Integration variable
+//! \param[in]  context : TRAPEZOIDAL_BARE_CONTEXT
+//! \return     Integrand value
+//******************************************************************************
+static F64 callBareIntegrand(const F64 x, void *context)
+{
+    return ((const TRAPEZOIDAL_BARE_CONTEXT *)context)->Integrand(x);
+}
+
+
+
+//******************************************************************************
+//! \breif      Call a bare multiple integrand stored in the context
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  x       : Integration variable for X-axis
+//! \param[in]  y       : Integration variable for Y-axis
+//! \param[in]  context : TRAPEZOIDAL_BARE_CONTEXT
+//! \return     Integrand value
+//******************************************************************************
+static F64 callBareMultipleIntegrand(const F64 x, const F64 y, void *context)
+{
+    return ((const TRAPEZOIDAL_BARE_CONTEXT *)context)->MultipleIntegrand(x, y);
+}
+
+
+
+//******************************************************************************
+//! \breif      Call a bare triple integrand stored in the context
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  x       : Integration variable for X-axis
+//! \param[in]  y       : Integration variable for Y-axis
+//! \param[in]  z       : Integration variable for Z-axis
+//! \param[in]  context : TRAPEZOIDAL_BARE_CONTEXT
+//! \return     Integrand value
+//******************************************************************************
+static F64 callBareTripleIntegrand(const F64 x, const F64 y, const F64 z, void *context)
+{
+    return ((const TRAPEZOIDAL_BARE_CONTEXT *)context)->TripleIntegrand(x, y, z);
+}
+
+
+
+
+
 //******************************************************************************
 // End of File
 //******************************************************************************
@@ -62,6 +62,10 @@ extern F64 NumericsTrapezoidal_Inetegrate2d(MULTIPLE_INTEGRAND  integrand, const
 /**
  * @brief           Numerical triple integration using trapezoidal rule
  * 
+ * The integrand is called from several OpenMP threads at once, so it must be
+ * reentrant : no global or static state that is written without
+ * synchronization.
+ * 
  * @param integrand Function Pointer (Integrand)
  * @param range_x   Integration Range for X-axis
  * @param range_y   Integration Range for Y-axis
@@ -70,6 +74,42 @@ extern F64 NumericsTrapezoidal_Inetegrate2d(MULTIPLE_INTEGRAND  integrand, const
  */
 extern F64 NumericsTrapezoidal_Inetegrate3d(TRIPLE_INTEGRAND integrand, const INTEGRATION_RANGE *range_x, const INTEGRATION_RANGE *range_y, const INTEGRATION_RANGE *range_z);
 
+/**
+ * @brief           Numerical integration using trapezoidal rule (reentrant)
+ * 
+ * @param integrand Function Pointer (Integrand with user context)
+ * @param context   User context passed to the integrand
+ * @param range     Integration Range
+ * @return F64      Integrated value
+ */
+extern F64 NumericsTrapezoidal_InetegrateCtx(INTEGRAND_CTX integrand, void *context, const INTEGRATION_RANGE *range);
+
+/**
+ * @brief           Numerical multiple integration using trapezoidal rule (reentrant)
+ * 
+ * @param integrand Function Pointer (Integrand with user context)
+ * @param context   User context passed to the integrand
+ * @param range_x   Integration Range for X-axis
+ * @param range_y   Integration Range for Y-axis
+ * @return F64      Integrated value
+ */
+extern F64 NumericsTrapezoidal_Inetegrate2dCtx(MULTIPLE_INTEGRAND_CTX integrand, void *context, const INTEGRATION_RANGE *range_x, const INTEGRATION_RANGE *range_y);
+
+/**
+ * @brief           Numerical triple integration using trapezoidal rule (reentrant)
+ * 
+ * The integrand is called from several OpenMP threads at once with the same
+ * context, so it must not write to the context without synchronization.
+ * 
+ * @param integrand Function Pointer (Integrand with user context)
+ * @param context   User context passed to the integrand
+ * @param range_x   Integration Range for X-axis
+ * @param range_y   Integration Range for Y-axis
+ * @param range_z   Integration Range for Z-axis
+ * @return F64      Integrated value
+ */
+extern F64 NumericsTrapezoidal_Inetegrate3dCtx(TRIPLE_INTEGRAND_CTX integrand, void *context, const INTEGRATION_RANGE *range_x, const INTEGRATION_RANGE *range_y, const INTEGRATION_RANGE *range_z);
+
 
 
 #ifdef _cplusplus
@@ -30,13 +30,31 @@
 #include <math.h>
 #include "common_typedef.h"
 #include "common_physical_const.h"
+#include "numerics_quadrature.h"
 #include "particles_cmb.h"
 
 
 
+//==============================================================================
+// Macro Definition
+//==============================================================================
+#define CMB_PEAK_X                  (1.5936242600400401)    //!< x = energy / kT at the peak of x^2 / (e^x - 1)
+#define CMB_TAIL_X_MIN              (1.0E-300)              //!< Lowest x searched for the lower bound
+#define CMB_TAIL_X_MAX              (1.0E+3)                //!< Highest x searched for the upper bound
+#define CMB_TAIL_BISECTIONS         (200)                   //!< Bisections in ln(x)
+
+
 
 //==============================================================================
-// Header File Include
+// File Scope Function Prototype
+//==============================================================================
+static F64 calcPlanckShape(const F64 x);
+static F64 findTail(const F64 level, const F64 x_low, const F64 x_high);
+
+
+
+//==============================================================================
+// File Scope Variables
 //==============================================================================
 //----------------------------------------------------------
 //! CMB Temperature [T] (Block Body Radiation)
@@ -76,6 +94,155 @@ F64 PatriclesCmb_CalcFlux(const F64 energy)
 
 
 
+//******************************************************************************
+//! \breif      Create a quadrature rule for integrals over the CMB spectrum
+//! \remark     Gauss-Laguerre rule with alpha = 1 in x = energy / kT, so that
+//!             x e^(-x) carries the Planck shape and the factor left to the
+//!             nodes, x / (1 - e^(-x)), is analytic on the real axis and the
+//!             rule converges geometrically (alpha = 2 would leave
+//!             1 / (1 - e^(-x)), whose pole at x = 0 slows it to
+//!             1 / count^2). Nodes are in eV and the weights are for
+//!             d(energy), i.e.
+//!             sum_i Weight[i] PatriclesCmb_CalcFlux(Node[i]) g(Node[i])
+//!             ~ integral CMB flux * g d(energy).
+//! 
+//! \callgraph  
+//! 
+//! \param[out] rule  : Quadrature rule to be created
+//! \param[in]  count : Number of nodes
+//! \return     TRUE on success, FALSE otherwise
+//******************************************************************************
+BOOL PatriclesCmb_CreateQuadrature(QUADRATURE_RULE *rule, const U32 count)
+{
+    U32 i;
+    F64 x;
+    const F64 kT = BOLTZMANN_CONST * CMB_TEMP;
+
+    if (NumericsQuadrature_CreateLaguerre(rule, count, 1.0) == FALSE) {
+        return FALSE;
+    }
+
+    for (i = 0; i < rule->Count; i++) {
+        x = rule->Node[i];
+        rule->Node[i] = x * kT;
+        // Folded in log space : e^x overflows beyond x ~ 709, while the
+        // weight underflows there first
+        rule->Weight[i] = (rule->Weight[i] > 0.0) ? kT * exp(log(rule->Weight[i]) + x - log(x)) : 0.0;
+    }
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Find where the CMB density falls below a tolerance relative to
+//!             its peak
+//! \remark     The shape x^2 / (e^x - 1), x = energy / kT, rises as x below
+//!             the peak and falls as x^2 e^(-x) (Wien tail) above it. Each
+//!             side is bracketed and bisected in ln(x).
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  tolerance : Relative density at the bounds (0 < tolerance < 1)
+//! \param[out] lower     : Lower CMB Photon Energy [eV]
+//! \param[out] upper     : Upper CMB Photon Energy [eV]
+//! \return     TRUE on success, FALSE if the tolerance is out of range
+//******************************************************************************
+BOOL PatriclesCmb_CalcTailBounds(const F64 tolerance, F64 *lower, F64 *upper)
+{
+    const F64 kT = BOLTZMANN_CONST * CMB_TEMP;
+    F64 level;
+
+    if (!((0.0 < tolerance) && (tolerance < 1.0))) {
+        return FALSE;
+    }
+
+    level = tolerance * calcPlanckShape(CMB_PEAK_X);
+    *lower = kT * findTail(level, CMB_TAIL_X_MIN, CMB_PEAK_X);
+    *upper = kT * findTail(level, CMB_PEAK_X, CMB_TAIL_X_MAX);
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Get the CMB temperature
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param      None
+//! \return     CMB Temperature [K]
+//******************************************************************************
+F64 PatriclesCmb_GetTemperature(void)
+{
+    return CMB_TEMP;
+}
+
+
+
+
+
+//******************************************************************************
+//! \breif      Planck shape of the CMB density
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  x : energy / kT
+//! \return     x^2 / (e^x - 1)
+//******************************************************************************
+static F64 calcPlanckShape(const F64 x)
+{
+    return x * x / expm1(x);
+}
+
+
+
+//******************************************************************************
+//! \breif      Bisect for the point where the Planck shape crosses a level
+//! \remark     The shape must be monotonic on [x_low, x_high] and cross the
+//!             level once. If it does not, the end farther from the peak is
+//!             returned.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  level  : Level of the Planck shape
+//! \param[in]  x_low  : Lower end of the bracket
+//! \param[in]  x_high : Upper end of the bracket
+//! \return     x where the shape crosses the level
+//******************************************************************************
+static F64 findTail(const F64 level, const F64 x_low, const F64 x_high)
+{
+    const BOOL rising = (calcPlanckShape(x_low) < calcPlanckShape(x_high)) ? TRUE : FALSE;
+    F64 log_low = log(x_low), log_high = log(x_high), log_mid;
+    U32 i;
+
+    if ((rising == TRUE) && (calcPlanckShape(x_low) >= level)) {
+        return x_low;
+    }
+    if ((rising == FALSE) && (calcPlanckShape(x_high) >= level)) {
+        return x_high;
+    }
+
+    for (i = 0; i < CMB_TAIL_BISECTIONS; i++) {
+        log_mid = 0.5 * (log_low + log_high);
+        if ((calcPlanckShape(exp(log_mid)) < level) == rising) {
+            log_low = log_mid;
+        }
+        else {
+            log_high = log_mid;
+        }
+    }
+
+    // The end on the tail side keeps the shape below the level
+    return (rising == TRUE) ? exp(log_low) : exp(log_high);
+}
+
+
+
 
 
 //******************************************************************************
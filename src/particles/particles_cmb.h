@@ -33,6 +33,7 @@ extern "C" {
 // Header File Include
 //==============================================================================
 #include "common_typedef.h"
+#include "numerics_integration.h"
 
 
 
@@ -47,6 +48,32 @@ extern "C" {
  */
 extern F64 PatriclesCmb_CalcFlux(const F64  energy);
 
+/**
+ * @brief Create a quadrature rule for integrals over the CMB spectrum
+ * 
+ * @param rule : Quadrature rule to be created (nodes [eV], weights for d(energy))
+ * @param count : Number of nodes
+ * @return BOOL : TRUE on success, FALSE otherwise
+ */
+extern BOOL PatriclesCmb_CreateQuadrature(QUADRATURE_RULE *rule, const U32 count);
+
+/**
+ * @brief Find where the CMB density falls below a tolerance relative to its peak
+ * 
+ * @param tolerance : Relative density at the bounds (0 < tolerance < 1)
+ * @param lower : Lower CMB Photon Energy [eV]
+ * @param upper : Upper CMB Photon Energy [eV]
+ * @return BOOL : TRUE on success, FALSE if the tolerance is out of range
+ */
+extern BOOL PatriclesCmb_CalcTailBounds(const F64 tolerance, F64 *lower, F64 *upper);
+
+/**
+ * @brief Get the CMB temperature
+ * 
+ * @return F64 : CMB Temperature [K]
+ */
+extern F64 PatriclesCmb_GetTemperature(void);
+
 
 
 #ifdef _cplusplus
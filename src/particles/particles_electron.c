@@ -53,6 +53,56 @@ F64 ParticlesElectron_CalcFlux(const F64 gamma, const F64 norm, const F64 power,
 
 
 
+//******************************************************************************
+//! \breif      Find where the cut-off falls below a tolerance
+//! \remark     exp(-r / rmax) = tolerance at r = rmax ln(1 / tolerance). The
+//!             power law is not part of the criterion : it falls by orders
+//!             of magnitude across the range without the flux at high
+//!             emitted energies losing its support.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  gamma_max : Maximum Lorentz Factor (Cut-off)
+//! \param[in]  tolerance : Cut-off factor at the bound (0 < tolerance < 1)
+//! \return     Lorentz Factor at the bound
+//******************************************************************************
+F64 ParticlesElectron_CalcCutoffBound(const F64 gamma_max, const F64 tolerance)
+{
+    return gamma_max * log(1.0 / tolerance);
+}
+
+
+
+//******************************************************************************
+//! \breif      Calculates the Non-thermal electron flux and its parameter
+//!             derivatives
+//! \remark     f = N0 r^(-p) exp(-r / rmax), so the derivatives are closed
+//!             forms of f : f / N0, -ln(r) f and r / rmax^2 f.
+//!
+//! \callgraph
+//!
+//! \param[in]  gamma     : Electron Lorentz Factor
+//! \param[in]  norm      : Normalized Parameter
+//! \param[in]  power     : Power
+//! \param[in]  gamma_max : Maximum Lorenrz Factor (Cut-off)
+//! \param[out] gradient  : d/dnorm, d/dpower, d/dgamma_max of the flux [3]
+//! \return     Electron Flux
+//******************************************************************************
+F64 ParticlesElectron_CalcFluxGradient(const F64 gamma, const F64 norm, const F64 power, const F64 gamma_max, F64 *gradient)
+{
+    F64 flux;
+
+    flux = ParticlesElectron_CalcFlux(gamma, norm, power, gamma_max);
+
+    gradient[0] = (norm != 0.0) ? flux / norm : pow(gamma, -power) * exp(-gamma / gamma_max);
+    gradient[1] = -log(gamma) * flux;
+    gradient[2] = gamma / (gamma_max * gamma_max) * flux;
+
+    return flux;
+}
+
+
+
 
 
 //******************************************************************************
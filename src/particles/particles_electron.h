@@ -50,6 +50,27 @@ extern "C" {
  */
 extern F64 ParticlesElectron_CalcFlux(const F64 gamma, const F64 norm, const F64 power, const F64 gamma_max);
 
+/**
+ * @brief Find where the cut-off falls below a tolerance
+ * 
+ * @param gamma_max : Maximum Lorentz Factor (Cut-off)
+ * @param tolerance : Cut-off factor at the bound (0 < tolerance < 1)
+ * @return F64      : Lorentz Factor at the bound
+ */
+extern F64 ParticlesElectron_CalcCutoffBound(const F64 gamma_max, const F64 tolerance);
+
+/**
+ * @brief Calculates the Non-thermal electron flux and its parameter derivatives
+ * 
+ * @param gamma     : Lorenrz Factor
+ * @param norm      : Normalized Parameter
+ * @param power     : Power
+ * @param gamma_max : Maximum Lorenrz Factor (Cut-off)
+ * @param gradient  : d/dnorm, d/dpower, d/dgamma_max of the flux [3]
+ * @return F64      : Electron Flux
+ */
+extern F64 ParticlesElectron_CalcFluxGradient(const F64 gamma, const F64 norm, const F64 power, const F64 gamma_max, F64 *gradient);
+
 
 
 #ifdef _cplusplus
@@ -0,0 +1,104 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+
+#define TEST_COMMON_C_
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include <stdio.h>
+#include <math.h>
+#include "test_common.h"
+
+
+
+
+
+//******************************************************************************
+//! \breif      Check a value against its expected value
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  name      : Name of the check
+//! \param[in]  value     : Value
+//! \param[in]  expected  : Expected value
+//! \param[in]  tolerance : Largest relative deviation (absolute if expected is 0)
+//! \return     TRUE if the value is within the tolerance
+//******************************************************************************
+BOOL TestCommon_CheckValue(const CHAR *name, const F64 value, const F64 expected, const F64 tolerance)
+{
+    const F64 deviation = (expected != 0.0) ? fabs(value / expected - 1.0) : fabs(value);
+    const BOOL passed = (deviation <= tolerance) ? TRUE : FALSE;
+
+    printf("[%s] %-52s : %+.15E (expected %+.15E, deviation %.2E)\n", (passed == TRUE) ? "PASS" : "FAIL", name, value, expected, deviation);
+
+    return passed;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check a condition
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  name      : Name of the check
+//! \param[in]  condition : Condition
+//! \return     condition
+//******************************************************************************
+BOOL TestCommon_CheckTrue(const CHAR *name, const BOOL condition)
+{
+    printf("[%s] %s\n", (condition == TRUE) ? "PASS" : "FAIL", name);
+
+    return condition;
+}
+
+
+
+//******************************************************************************
+//! \breif      Largest of two deviations, keeping NaN
+//! \remark     fmax returns the other argument for NaN, which would let a NaN
+//!             result pass.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  worst     : Largest deviation so far
+//! \param[in]  deviation : Deviation
+//! \return     The larger one, or NaN if either is NaN
+//******************************************************************************
+F64 TestCommon_MaxDeviation(const F64 worst, const F64 deviation)
+{
+    return ((isnan(worst) != 0) || (deviation <= worst)) ? worst : deviation;
+}
+
+
+
+
+
+//******************************************************************************
+// End of File
+//******************************************************************************
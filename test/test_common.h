@@ -0,0 +1,85 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+
+#ifndef TEST_COMMON_H_
+#define TEST_COMMON_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include "common_typedef.h"
+
+
+
+//==============================================================================
+// Export Scope Function Prototype
+//==============================================================================
+/**
+ * @brief           Check a value against its expected value and print the result
+ * 
+ * @param name      Name of the check
+ * @param value     Value
+ * @param expected  Expected value
+ * @param tolerance Largest relative deviation (absolute if expected is 0)
+ * @return BOOL     TRUE if the value is within the tolerance
+ */
+extern BOOL TestCommon_CheckValue(const CHAR *name, const F64 value, const F64 expected, const F64 tolerance);
+
+/**
+ * @brief           Check a condition and print the result
+ * 
+ * @param name      Name of the check
+ * @param condition Condition
+ * @return BOOL     condition
+ */
+extern BOOL TestCommon_CheckTrue(const CHAR *name, const BOOL condition);
+
+/**
+ * @brief           Largest of two deviations, keeping NaN
+ * 
+ * Unlike fmax, a NaN deviation is returned rather than dropped, so a NaN
+ * result fails the check it is accumulated into.
+ * 
+ * @param worst     Largest deviation so far
+ * @param deviation Deviation
+ * @return F64      The larger one, or NaN if either is NaN
+ */
+extern F64 TestCommon_MaxDeviation(const F64 worst, const F64 deviation);
+
+
+
+#ifdef _cplusplus
+}
+#endif
+
+#endif
+
+//******************************************************************************
+// End of File
+//******************************************************************************
@@ -0,0 +1,443 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+
+#define TEST_FITTING_C_
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "numerics_quadrature.h"
+#include "particles_cmb.h"
+#include "io_chain.h"
+#include "ics_response.h"
+#include "fitting_data.h"
+#include "fitting_spectrum.h"
+#include "fitting_mcmc.h"
+#include "test_common.h"
+#include "test_fitting.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+#define TEST_CHAIN_FILE                 "ics_test_mcmc.bin"         //!< Scratch chain file
+#define TEST_RESUMED_CHAIN_FILE         "ics_test_resumed.bin"      //!< Scratch chain file of the resumed run
+#define TEST_CHECKPOINT_FILE            "ics_test_checkpoint.bin"   //!< Scratch checkpoint file
+#define TEST_RESUMED_CHECKPOINT_FILE    "ics_test_resumed.ckpt"     //!< Scratch checkpoint file of the resumed run
+
+#define TEST_RESPONSE_EFIN_COUNT        (24)            //!< Data points of the synthetic spectrum
+#define TEST_RESPONSE_GAMMA_COUNT       (161)           //!< Gamma nodes of the synthetic response matrix
+#define TEST_RESPONSE_GAMMA_LOWER       (1.0E+1)        //!< Lower Lorentz factor
+#define TEST_RESPONSE_GAMMA_UPPER       (1.0E+9)        //!< Upper Lorentz factor
+#define TEST_RESPONSE_EFIN_LOWER        (1.0E+1)        //!< Lower scattered photon energy [eV]
+#define TEST_RESPONSE_EFIN_UPPER        (1.0E+12)       //!< Upper scattered photon energy [eV]
+#define TEST_RESPONSE_EINIT             (6.3E-4)        //!< Mean CMB photon energy [eV]
+#define TEST_DATA_ERROR                 (0.05)          //!< Relative error bar of the synthetic spectrum
+
+#define TEST_MCMC_WALKERS               (16)            //!< Walkers
+#define TEST_MCMC_STEPS                 (600)           //!< Steps of the whole run
+#define TEST_MCMC_BURN_IN               (200)           //!< Steps dropped from the statistics
+#define TEST_MCMC_INTERVAL              (100)           //!< Steps between checkpoints
+
+
+
+//==============================================================================
+// Type Definition
+//==============================================================================
+//----------------------------------------------------------
+//! Synthetic fitting problem
+//----------------------------------------------------------
+typedef struct test_fitting_t {
+    ICS_RESPONSE    Response;           //!< Response matrix
+    FITTING_DATA    Data;               //!< Spectrum of Truth with TEST_DATA_ERROR error bars
+    FITTING_PARAMS  Truth;              //!< Parameters the spectrum is made from
+}TEST_FITTING;
+
+
+
+//==============================================================================
+// File Scope Function Prototype
+//==============================================================================
+static BOOL createFitting(TEST_FITTING *fitting);
+static void releaseFitting(TEST_FITTING *fitting);
+static BOOL testFit(const TEST_FITTING *fitting);
+static BOOL testFisher(const TEST_FITTING *fitting);
+static BOOL testMcmc(const TEST_FITTING *fitting);
+
+
+
+
+
+//******************************************************************************
+//! \breif      Check the spectrum fit and the posterior sampler
+//! \remark     Every check runs on one synthetic fitting problem.
+//! 
+//! \callgraph  
+//! 
+//! \param      None
+//! \return     TRUE if every check passes
+//******************************************************************************
+BOOL TestFitting_Run(void)
+{
+    TEST_FITTING fitting;
+    BOOL result = TRUE;
+
+    if (TestCommon_CheckTrue("Synthetic fitting problem", createFitting(&fitting)) == FALSE) {
+        releaseFitting(&fitting);
+        return FALSE;
+    }
+
+    result = (testFit(&fitting) == TRUE) ? result : FALSE;
+    result = (testFisher(&fitting) == TRUE) ? result : FALSE;
+    result = (testMcmc(&fitting) == TRUE) ? result : FALSE;
+
+    releaseFitting(&fitting);
+    remove(TEST_CHAIN_FILE);
+    remove(TEST_RESUMED_CHAIN_FILE);
+    remove(TEST_CHECKPOINT_FILE);
+    remove(TEST_RESUMED_CHECKPOINT_FILE);
+
+    return result;
+}
+
+
+
+
+
+//******************************************************************************
+//! \breif      Create a synthetic fitting problem
+//! \remark     The response matrix maps a Lorentz factor to a Gaussian in
+//!             ln(efin) around einit gamma^2 (the Thomson-limit peak), times
+//!             the trapezoidal weight of the node. The data are the model
+//!             of Truth with symmetric TEST_DATA_ERROR error bars, so the
+//!             best fit is Truth with chi-square 0.
+//! 
+//! \callgraph  
+//! 
+//! \param[out] fitting : Synthetic fitting problem
+//! \return     TRUE on success, FALSE if the arrays cannot be allocated
+//******************************************************************************
+static BOOL createFitting(TEST_FITTING *fitting)
+{
+    INTEGRATION_RANGE range;
+    QUADRATURE_RULE rule;
+    ICS_RESPONSE *response = &fitting->Response;
+    FITTING_DATA *data = &fitting->Data;
+    F64 t;
+    U32 j, k;
+
+    memset(fitting, 0, sizeof(TEST_FITTING));
+    fitting->Truth.Norm = 1.0E-3;
+    fitting->Truth.Power = 2.2;
+    fitting->Truth.GammaMax = 1.0E+6;
+
+    range.Lower = TEST_RESPONSE_GAMMA_LOWER;
+    range.Upper = TEST_RESPONSE_GAMMA_UPPER;
+    range.Iteration = TEST_RESPONSE_GAMMA_COUNT - 1;
+    if (NumericsQuadrature_CreateLog(&rule, &range) == FALSE) {
+        return FALSE;
+    }
+
+    response->Mode = USE_JONES_APPROX;
+    response->Precision = ICS_PRECISION_F64;
+    response->CmbTemperature = PatriclesCmb_GetTemperature();
+    response->EinitRange.Lower = TEST_RESPONSE_EINIT;
+    response->EinitRange.Upper = TEST_RESPONSE_EINIT;
+    response->EinitRange.Iteration = 1;
+    response->GammaRange = range;
+    response->EfinCount = TEST_RESPONSE_EFIN_COUNT;
+    response->GammaCount = TEST_RESPONSE_GAMMA_COUNT;
+    response->Efin = (F64 *)malloc(sizeof(F64) * TEST_RESPONSE_EFIN_COUNT);
+    response->Gamma = (F64 *)malloc(sizeof(F64) * TEST_RESPONSE_GAMMA_COUNT);
+    response->Matrix = (F64 *)malloc(sizeof(F64) * TEST_RESPONSE_EFIN_COUNT * TEST_RESPONSE_GAMMA_COUNT);
+
+    data->Count = TEST_RESPONSE_EFIN_COUNT;
+    data->Energy = (F64 *)malloc(sizeof(F64) * TEST_RESPONSE_EFIN_COUNT);
+    data->Flux = (F64 *)malloc(sizeof(F64) * TEST_RESPONSE_EFIN_COUNT);
+    data->Lower = (F64 *)malloc(sizeof(F64) * TEST_RESPONSE_EFIN_COUNT);
+    data->Upper = (F64 *)malloc(sizeof(F64) * TEST_RESPONSE_EFIN_COUNT);
+
+    if ((response->Efin == NULL) || (response->Gamma == NULL) || (response->Matrix == NULL) ||
+        (data->Energy == NULL) || (data->Flux == NULL) || (data->Lower == NULL) || (data->Upper == NULL)) {
+        NumericsQuadrature_Release(&rule);
+        return FALSE;
+    }
+
+    memcpy(response->Gamma, rule.Node, sizeof(F64) * TEST_RESPONSE_GAMMA_COUNT);
+    for (k = 0; k < TEST_RESPONSE_EFIN_COUNT; k++) {
+        response->Efin[k] = TEST_RESPONSE_EFIN_LOWER *
+                            pow(TEST_RESPONSE_EFIN_UPPER / TEST_RESPONSE_EFIN_LOWER, (F64)k / (F64)(TEST_RESPONSE_EFIN_COUNT - 1));
+        data->Energy[k] = response->Efin[k];
+        for (j = 0; j < TEST_RESPONSE_GAMMA_COUNT; j++) {
+            t = log(response->Efin[k] / (TEST_RESPONSE_EINIT * rule.Node[j] * rule.Node[j]));
+            response->Matrix[k * TEST_RESPONSE_GAMMA_COUNT + j] = rule.Weight[j] * exp(-0.5 * t * t);
+        }
+    }
+    NumericsQuadrature_Release(&rule);
+
+    if (IcsResponse_CalcFlux(response, fitting->Truth.Norm, fitting->Truth.Power, fitting->Truth.GammaMax, data->Flux) == FALSE) {
+        return FALSE;
+    }
+    for (k = 0; k < TEST_RESPONSE_EFIN_COUNT; k++) {
+        data->Lower[k] = data->Flux[k] * (1.0 - TEST_DATA_ERROR);
+        data->Upper[k] = data->Flux[k] * (1.0 + TEST_DATA_ERROR);
+    }
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Release a synthetic fitting problem
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in,out] fitting : Synthetic fitting problem
+//! \return     None
+//******************************************************************************
+static void releaseFitting(TEST_FITTING *fitting)
+{
+    IcsResponse_Release(&fitting->Response);
+    FittingData_Release(&fitting->Data);
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check the fit
+//! \remark     The fit from a distant start recovers Truth with a vanishing
+//!             chi-square.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  fitting : Synthetic fitting problem
+//! \return     TRUE if every check passes
+//******************************************************************************
+static BOOL testFit(const TEST_FITTING *fitting)
+{
+    FITTING_PARAMS start;
+    FITTING_RESULT fit;
+    BOOL result = TRUE;
+
+    start.Norm = -1.0;
+    start.Power = 2.6;
+    start.GammaMax = 2.0E+5;
+    result = (TestCommon_CheckTrue("Fit converges", FittingSpectrum_Fit(&fitting->Response, &fitting->Data, &start, &fit)) == TRUE) ? result : FALSE;
+    result = (TestCommon_CheckValue("Fit N0", fit.Params.Norm, fitting->Truth.Norm, 1.0E-4) == TRUE) ? result : FALSE;
+    result = (TestCommon_CheckValue("Fit p", fit.Params.Power, fitting->Truth.Power, 1.0E-5) == TRUE) ? result : FALSE;
+    result = (TestCommon_CheckValue("Fit gamma_max", fit.Params.GammaMax, fitting->Truth.GammaMax, 1.0E-4) == TRUE) ? result : FALSE;
+    result = (TestCommon_CheckValue("Fit chi-square", fit.ChiSquare, 0.0, 1.0E-6) == TRUE) ? result : FALSE;
+
+    return result;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check the Fisher errors
+//! \remark     At Truth the residuals vanish, so the chi-square Hessian is
+//!             exactly 2 J^T W J. Its central differences in the fitting
+//!             coordinates give the covariance 2 H^(-1) to compare the
+//!             Fisher errors and correlations with.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  fitting : Synthetic fitting problem
+//! \return     TRUE if every check passes
+//******************************************************************************
+static BOOL testFisher(const TEST_FITTING *fitting)
+{
+    static const CHAR *names[FITTING_PARAMETERS] = { "log10(N0)", "p", "log10(gamma_max)" };
+    const F64 h = 1.0E-4;
+    F64 errors[FITTING_PARAMETERS], correlation[FITTING_PARAMETERS][FITTING_PARAMETERS];
+    F64 hessian[FITTING_PARAMETERS][FITTING_PARAMETERS], cofactor[FITTING_PARAMETERS][FITTING_PARAMETERS];
+    F64 x[FITTING_PARAMETERS], truth[FITTING_PARAMETERS], fx[4], determinant, covariance;
+    F64 *model;
+    CHAR name[64];
+    U32 a, b, c;
+    BOOL result = TRUE;
+
+    if ((model = (F64 *)malloc(sizeof(F64) * fitting->Data.Count)) == NULL) {
+        return TestCommon_CheckTrue("Fisher work array", FALSE);
+    }
+
+    result = (TestCommon_CheckTrue("Fisher errors",
+                        FittingSpectrum_CalcErrors(&fitting->Response, &fitting->Data, &fitting->Truth, errors, correlation)) == TRUE) ? result : FALSE;
+
+    FittingSpectrum_ToCoordinates(&fitting->Truth, truth);
+    for (a = 0; a < FITTING_PARAMETERS; a++) {
+        for (b = 0; b < FITTING_PARAMETERS; b++) {
+            for (c = 0; c < 4; c++) {
+                memcpy(x, truth, sizeof(x));
+                x[a] += ((c & 1) == 0) ? h : -h;
+                x[b] += ((c & 2) == 0) ? h : -h;
+                fx[c] = FittingSpectrum_CalcObjective(&fitting->Response, &fitting->Data, x, model);
+            }
+            hessian[a][b] = (fx[0] - fx[1] - fx[2] + fx[3]) / (4.0 * h * h);
+        }
+    }
+    free(model);
+
+    // Cofactors of the symmetric 3 x 3 Hessian
+    for (a = 0; a < FITTING_PARAMETERS; a++) {
+        for (b = 0; b < FITTING_PARAMETERS; b++) {
+            cofactor[a][b] = hessian[(a + 1) % 3][(b + 1) % 3] * hessian[(a + 2) % 3][(b + 2) % 3] -
+                             hessian[(a + 1) % 3][(b + 2) % 3] * hessian[(a + 2) % 3][(b + 1) % 3];
+        }
+    }
+    determinant = hessian[0][0] * cofactor[0][0] + hessian[0][1] * cofactor[0][1] + hessian[0][2] * cofactor[0][2];
+
+    for (a = 0; a < FITTING_PARAMETERS; a++) {
+        covariance = 2.0 * cofactor[a][a] / determinant;
+        snprintf(name, sizeof(name), "Fisher error of %s", names[a]);
+        result = (TestCommon_CheckValue(name, errors[a], sqrt(covariance), 1.0E-3) == TRUE) ? result : FALSE;
+        for (b = a + 1; b < FITTING_PARAMETERS; b++) {
+            snprintf(name, sizeof(name), "Fisher correlation of %s, %s", names[a], names[b]);
+            result = (TestCommon_CheckValue(name, correlation[a][b], cofactor[a][b] / sqrt(cofactor[a][a] * cofactor[b][b]), 1.0E-3) == TRUE) ? result : FALSE;
+        }
+    }
+
+    return result;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check the Goodman-Weare sampler and its checkpoint
+//! \remark     1) At Truth the posterior is close to a Gaussian with the
+//!                Fisher covariance, so the chain mean must be near Truth
+//!                and the chain spread near the Fisher errors.
+//!             2) A run stopped at a checkpoint and resumed must write the
+//!                same chain as an uninterrupted run.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  fitting : Synthetic fitting problem
+//! \return     TRUE if every check passes
+//******************************************************************************
+static BOOL testMcmc(const TEST_FITTING *fitting)
+{
+    static const CHAR *names[FITTING_PARAMETERS] = { "log10(N0)", "p", "log10(gamma_max)" };
+    FITTING_MCMC_CONFIG config;
+    FITTING_MCMC_RESULT sampler;
+    IO_CHAIN_HEADER header, resumed_header;
+    FITTING_PARAMS params;
+    F64 errors[FITTING_PARAMETERS], correlation[FITTING_PARAMETERS][FITTING_PARAMETERS];
+    F64 truth[FITTING_PARAMETERS], x[FITTING_PARAMETERS], sum[FITTING_PARAMETERS], sum_square[FITTING_PARAMETERS];
+    F64 *records, *resumed, mean, deviation;
+    const F64 *record;
+    CHAR name[64];
+    U32 step, k, d, samples;
+    BOOL result = TRUE;
+
+    remove(TEST_CHAIN_FILE);
+    remove(TEST_CHECKPOINT_FILE);
+    remove(TEST_RESUMED_CHAIN_FILE);
+    remove(TEST_RESUMED_CHECKPOINT_FILE);
+
+    config.Walkers = TEST_MCMC_WALKERS;
+    config.Steps = TEST_MCMC_STEPS;
+    config.Seed = 1;
+    config.CheckpointInterval = TEST_MCMC_INTERVAL;
+    config.Scale = 2.0;
+    config.ChainFile = TEST_CHAIN_FILE;
+    config.CheckpointFile = TEST_CHECKPOINT_FILE;
+    if (TestCommon_CheckTrue("MCMC run", FittingMcmc_Run(&fitting->Response, &fitting->Data, &fitting->Truth, &config, &sampler)) == FALSE) {
+        return FALSE;
+    }
+    if (TestCommon_CheckTrue("MCMC chain read", IoChain_Read(TEST_CHAIN_FILE, &header, &records)) == FALSE) {
+        return FALSE;
+    }
+    result = (TestCommon_CheckTrue("MCMC chain length", ((header.Steps == TEST_MCMC_STEPS) && (header.Walkers == TEST_MCMC_WALKERS)) ? TRUE : FALSE) == TRUE) ? result : FALSE;
+
+    //------------------------------------------------------
+    // Moments against the Fisher errors
+    //------------------------------------------------------
+    FittingSpectrum_CalcErrors(&fitting->Response, &fitting->Data, &fitting->Truth, errors, correlation);
+    FittingSpectrum_ToCoordinates(&fitting->Truth, truth);
+    memset(sum, 0, sizeof(sum));
+    memset(sum_square, 0, sizeof(sum_square));
+    for (samples = 0, step = TEST_MCMC_BURN_IN; step < TEST_MCMC_STEPS; step++) {
+        for (k = 0; k < TEST_MCMC_WALKERS; k++, samples++) {
+            record = &records[((size_t)step * TEST_MCMC_WALKERS + k) * (FITTING_PARAMETERS + 1)];
+            params.Norm = record[0];
+            params.Power = record[1];
+            params.GammaMax = record[2];
+            FittingSpectrum_ToCoordinates(&params, x);
+            for (d = 0; d < FITTING_PARAMETERS; d++) {
+                sum[d] += x[d] - truth[d];
+                sum_square[d] += (x[d] - truth[d]) * (x[d] - truth[d]);
+            }
+        }
+    }
+    for (d = 0; d < FITTING_PARAMETERS; d++) {
+        mean = sum[d] / (F64)samples;
+        deviation = sqrt(sum_square[d] / (F64)samples - mean * mean);
+        snprintf(name, sizeof(name), "MCMC mean of %s [sigma]", names[d]);
+        result = (TestCommon_CheckValue(name, mean / errors[d], 0.0, 0.5) == TRUE) ? result : FALSE;
+        snprintf(name, sizeof(name), "MCMC spread of %s [sigma]", names[d]);
+        result = (TestCommon_CheckValue(name, deviation / errors[d], 1.0, 0.3) == TRUE) ? result : FALSE;
+    }
+
+    //------------------------------------------------------
+    // Resume from a checkpoint
+    //------------------------------------------------------
+    config.ChainFile = TEST_RESUMED_CHAIN_FILE;
+    config.CheckpointFile = TEST_RESUMED_CHECKPOINT_FILE;
+    config.Steps = TEST_MCMC_STEPS / 2;
+    result = (FittingMcmc_Run(&fitting->Response, &fitting->Data, &fitting->Truth, &config, &sampler) == TRUE) ? result : FALSE;
+    config.Steps = TEST_MCMC_STEPS;
+    result = (FittingMcmc_Run(&fitting->Response, &fitting->Data, &fitting->Truth, &config, &sampler) == TRUE) ? result : FALSE;
+    result = (TestCommon_CheckTrue("MCMC run resumed from the checkpoint", (sampler.StartStep == TEST_MCMC_STEPS / 2) ? TRUE : FALSE) == TRUE) ? result : FALSE;
+    if (IoChain_Read(TEST_RESUMED_CHAIN_FILE, &resumed_header, &resumed) == TRUE) {
+        result = (TestCommon_CheckTrue("MCMC resumed chain matches the uninterrupted one",
+                            ((resumed_header.Steps == header.Steps) &&
+                             (memcmp(records, resumed, sizeof(F64) * (size_t)header.Steps * header.Walkers * (header.Dimension + 1)) == 0)) ? TRUE : FALSE) == TRUE) ? result : FALSE;
+        free(resumed);
+    }
+    else {
+        result = TestCommon_CheckTrue("MCMC resumed chain read", FALSE);
+    }
+    free(records);
+
+    return result;
+}
+
+
+
+
+
+//******************************************************************************
+// End of File
+//******************************************************************************
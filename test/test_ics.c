@@ -0,0 +1,904 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+
+#define TEST_ICS_C_
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "common_physical_const.h"
+#include "ics_cmb_spectrum.h"
+#include "ics_jones_approx.h"
+#include "ics_jones_batch.h"
+#include "ics_jones_table.h"
+#include "ics_thomson_approx.h"
+#include "ics_response.h"
+#include "test_common.h"
+#include "test_ics.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+#define TEST_RESPONSE_FILE              "ics_test_response.bin"     //!< Scratch response file
+
+#define TEST_CMB_POINTS                 (16)            //!< Gauss-Laguerre nodes on einit
+#define TEST_GAMMA_LOWER                (1.0E+1)        //!< Lower Lorentz factor
+#define TEST_GAMMA_UPPER                (1.0E+8)        //!< Upper Lorentz factor
+#define TEST_GAMMA_ITERATION            (200)           //!< Gamma intervals
+#define TEST_NORM                       (1.0)           //!< Electron spectrum : Normalization Factor
+#define TEST_POWER                      (2.2)           //!< Electron spectrum : Power
+#define TEST_GAMMA_MAX                  (1.0E+6)        //!< Electron spectrum : Maximum Lorentz Factor
+#define TEST_EFIN_COUNT                 (9)             //!< Scattered photon energies
+#define TEST_EFIN_LOWER                 (1.0E+2)        //!< Lower scattered photon energy [eV]
+#define TEST_EFIN_UPPER                 (1.0E+14)       //!< Upper scattered photon energy [eV]
+
+#define TEST_KERNEL_GAMMA_LOWER         (1.1)           //!< Lowest log-spaced Lorentz factor of the kernel checks
+#define TEST_KERNEL_GAMMA_UPPER         (3.0E+10)       //!< Highest Lorentz factor of the kernel checks
+#define TEST_KERNEL_GAMMA_COUNT         (24)            //!< Log-spaced Lorentz factors of the kernel checks
+#define TEST_KERNEL_EINIT_LOWER         (1.0E-6)        //!< Lowest incident photon energy of the kernel checks [eV]
+#define TEST_KERNEL_EINIT_UPPER         (1.0E-1)        //!< Highest incident photon energy of the kernel checks [eV]
+#define TEST_KERNEL_EINIT_COUNT         (6)             //!< Log-spaced incident photon energies of the kernel checks
+#define TEST_KERNEL_EFIN_COUNT          (401)           //!< Scattered photon energies across the kinematic range
+#define TEST_KERNEL_PEAK_FRACTION       (1.0E-6)        //!< Pointwise errors are checked above this fraction of the peak
+#define TEST_BATCH_COUNT                (37)            //!< Longest batch (not a multiple of any lane width)
+#define TEST_BATCH_EDGE_COUNT           (9)             //!< Batch elements placed around the kinematic edge
+#define TEST_BATCH_SENTINEL             (-1.0)          //!< Value that must survive past the end of a batch
+#define TEST_THOMSON_LIMIT              (1.0E-2)        //!< Thomson limit threshold of the pruning check
+#define TEST_TABLE_EINIT                (1.0E-3)        //!< Incident photon energy of the table checks [eV]
+#define TEST_TABLE_GAMMA                (1.0E+4)        //!< Lowest Lorentz factor of the table checks
+#define TEST_TABLE_OFFSET               (1.0E-15)       //!< Relative offset of q around an interval boundary
+
+
+
+//==============================================================================
+// File Scope Function Prototype
+//==============================================================================
+static BOOL createSpectrum(ICS_CMB_SPECTRUM *spectrum, const S32 mode);
+static void createEnergies(F64 *efin);
+static BOOL isSameResponse(const ICS_RESPONSE *a, const ICS_RESPONSE *b);
+static BOOL testResponse(const ICS_JONES_TABLE *table);
+static BOOL testThomsonF64(void);
+static void createBatchAxis(const F64 center, F64 *axis);
+static F64 compareBatch(const S32 variant, const F64 efin, const F64 einit, const F64 *axis);
+static BOOL testJonesBatch(void);
+static F64 calcFullGridFlux(const ICS_CMB_SPECTRUM *spectrum, const F64 efin);
+static F64 comparePruning(const ICS_CMB_SPECTRUM *spectrum);
+static BOOL testPruning(void);
+static BOOL compareSweep(const ICS_CMB_SPECTRUM *spectrum, const CHAR *name);
+static BOOL testSweep(void);
+static F64 calcTableDeviation(const F64 value, const F64 expected);
+static void compareJonesTable(const ICS_JONES_TABLE *table, const F64 q, F64 *deviation);
+static BOOL testJonesTable(const ICS_JONES_TABLE *table);
+static BOOL testPair(void);
+
+
+
+
+
+//******************************************************************************
+//! \breif      Check the ICS kernels, spectra and response matrix
+//! \remark     The Jones kernel table is built once and shared.
+//! 
+//! \callgraph  
+//! 
+//! \param      None
+//! \return     TRUE if every check passes
+//******************************************************************************
+BOOL TestIcs_Run(void)
+{
+    ICS_JONES_TABLE table;
+    BOOL result = TRUE;
+
+    if (TestCommon_CheckTrue("Jones table build", IcsJonesTable_Build(&table, JONES_TABLE_TOLERANCE)) == FALSE) {
+        return FALSE;
+    }
+
+    result = (testResponse(&table) == TRUE) ? result : FALSE;
+    result = (testThomsonF64() == TRUE) ? result : FALSE;
+    result = (testJonesBatch() == TRUE) ? result : FALSE;
+    result = (testPruning() == TRUE) ? result : FALSE;
+    result = (testSweep() == TRUE) ? result : FALSE;
+    result = (testJonesTable(&table) == TRUE) ? result : FALSE;
+    result = (testPair() == TRUE) ? result : FALSE;
+
+    IcsJonesTable_Release(&table);
+    remove(TEST_RESPONSE_FILE);
+
+    return result;
+}
+
+
+
+
+
+//******************************************************************************
+//! \breif      Create a small ICS spectrum with the test electron spectrum
+//! \remark     TEST_CMB_POINTS Gauss-Laguerre nodes on einit and
+//!             TEST_GAMMA_ITERATION log intervals on gamma.
+//! 
+//! \callgraph  
+//! 
+//! \param[out] spectrum : ICS spectrum
+//! \param[in]  mode     : ICS calculation mode
+//! \return     TRUE on success
+//******************************************************************************
+static BOOL createSpectrum(ICS_CMB_SPECTRUM *spectrum, const S32 mode)
+{
+    INTEGRATION_RANGE gamma_range;
+
+    gamma_range.Lower = TEST_GAMMA_LOWER;
+    gamma_range.Upper = TEST_GAMMA_UPPER;
+    gamma_range.Iteration = TEST_GAMMA_ITERATION;
+    if (IcsCmbSpectrum_CreateBlackbody(spectrum, mode, TEST_CMB_POINTS, &gamma_range) == FALSE) {
+        return FALSE;
+    }
+    IcsCmbSpectrum_SetElectron(spectrum, TEST_NORM, TEST_POWER, TEST_GAMMA_MAX);
+
+    return TRUE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Log-spaced scattered photon energies
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[out] efin : Scattered photon energies [eV] [TEST_EFIN_COUNT]
+//! \return     None
+//******************************************************************************
+static void createEnergies(F64 *efin)
+{
+    U32 k;
+
+    for (k = 0; k < TEST_EFIN_COUNT; k++) {
+        efin[k] = TEST_EFIN_LOWER * pow(TEST_EFIN_UPPER / TEST_EFIN_LOWER, (F64)k / (F64)(TEST_EFIN_COUNT - 1));
+    }
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Compare two response matrices field by field
+//! \remark     INTEGRATION_RANGE has padding, so it is not compared with
+//!             memcmp.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  a : Response matrix
+//! \param[in]  b : Response matrix
+//! \return     TRUE if every field and array is the same
+//******************************************************************************
+static BOOL isSameResponse(const ICS_RESPONSE *a, const ICS_RESPONSE *b)
+{
+    return ((a->Mode == b->Mode) && (a->Precision == b->Precision) &&
+            (a->ThomsonLimit == b->ThomsonLimit) && (a->TableTolerance == b->TableTolerance) &&
+            (a->CmbTemperature == b->CmbTemperature) &&
+            (a->EinitRange.Lower == b->EinitRange.Lower) && (a->EinitRange.Upper == b->EinitRange.Upper) &&
+            (a->EinitRange.Iteration == b->EinitRange.Iteration) &&
+            (a->GammaRange.Lower == b->GammaRange.Lower) && (a->GammaRange.Upper == b->GammaRange.Upper) &&
+            (a->GammaRange.Iteration == b->GammaRange.Iteration) &&
+            (a->EfinCount == b->EfinCount) && (a->GammaCount == b->GammaCount) &&
+            (memcmp(a->Efin, b->Efin, sizeof(F64) * a->EfinCount) == 0) &&
+            (memcmp(a->Gamma, b->Gamma, sizeof(F64) * a->GammaCount) == 0) &&
+            (memcmp(a->Matrix, b->Matrix, sizeof(F64) * a->EfinCount * a->GammaCount) == 0)) ? TRUE : FALSE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check the response matrix and its cache file
+//! \remark     1) The flux of the matrix matches the spectrum it is built
+//!                from.
+//!             2) The matrix loads back from IcsResponse_Save to the same
+//!                fields and flux.
+//!             3) The cache is keyed on the gamma node count and the table
+//!                tolerance as well as the grids.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  table : Jones kernel table
+//! \return     TRUE if every check passes
+//******************************************************************************
+static BOOL testResponse(const ICS_JONES_TABLE *table)
+{
+    ICS_CMB_SPECTRUM spectrum, other;
+    ICS_RESPONSE built, loaded;
+    ICS_JONES_TABLE other_table;
+    F64 efin[TEST_EFIN_COUNT], flux[TEST_EFIN_COUNT], loaded_flux[TEST_EFIN_COUNT];
+    CHAR name[64];
+    U32 k;
+    BOOL result = TRUE;
+
+    if (TestCommon_CheckTrue("Response spectrum", createSpectrum(&spectrum, USE_JONES_APPROX)) == FALSE) {
+        return FALSE;
+    }
+    spectrum.Precision = ICS_PRECISION_TABLE;
+    spectrum.JonesTable = table;
+    createEnergies(efin);
+
+    if (TestCommon_CheckTrue("Response build", IcsResponse_Build(&built, &spectrum, efin, TEST_EFIN_COUNT)) == FALSE) {
+        IcsCmbSpectrum_Release(&spectrum);
+        return FALSE;
+    }
+    result = (IcsResponse_CalcFlux(&built, TEST_NORM, TEST_POWER, TEST_GAMMA_MAX, flux) == TRUE) ? result : FALSE;
+    for (k = 0; k < TEST_EFIN_COUNT; k++) {
+        sprintf(name, "Response flux at %.0E eV", efin[k]);
+        result = (TestCommon_CheckValue(name, flux[k], IcsCmbSpectrum_CalcFlux(&spectrum, efin[k]), 1.0E-12) == TRUE) ? result : FALSE;
+    }
+
+    result = (TestCommon_CheckTrue("Response save", IcsResponse_Save(&built, TEST_RESPONSE_FILE)) == TRUE) ? result : FALSE;
+    if (TestCommon_CheckTrue("Response load", IcsResponse_Load(&loaded, TEST_RESPONSE_FILE)) == TRUE) {
+        result = (TestCommon_CheckTrue("Response loads back to the same matrix", isSameResponse(&loaded, &built)) == TRUE) ? result : FALSE;
+        result = (IcsResponse_CalcFlux(&loaded, TEST_NORM, TEST_POWER, TEST_GAMMA_MAX, loaded_flux) == TRUE) ? result : FALSE;
+        result = (TestCommon_CheckTrue("Loaded response gives the same flux",
+                                       (memcmp(loaded_flux, flux, sizeof(flux)) == 0) ? TRUE : FALSE) == TRUE) ? result : FALSE;
+        result = (TestCommon_CheckTrue("Loaded response matches its spectrum",
+                                       IcsResponse_IsCompatible(&loaded, &spectrum, efin, TEST_EFIN_COUNT)) == TRUE) ? result : FALSE;
+
+        // Only the fields read by IcsResponse_IsCompatible are changed
+        other = spectrum;
+        other.GammaRange.Iteration++;
+        result = (TestCommon_CheckTrue("Response rejects another gamma node count",
+                                       (IcsResponse_IsCompatible(&loaded, &other, efin, TEST_EFIN_COUNT) == FALSE) ? TRUE : FALSE) == TRUE) ? result : FALSE;
+        other = spectrum;
+        other_table = *table;
+        other_table.Tolerance *= 10.0;
+        other.JonesTable = &other_table;
+        result = (TestCommon_CheckTrue("Response rejects another table tolerance",
+                                       (IcsResponse_IsCompatible(&loaded, &other, efin, TEST_EFIN_COUNT) == FALSE) ? TRUE : FALSE) == TRUE) ? result : FALSE;
+        IcsResponse_Release(&loaded);
+    }
+    else {
+        result = FALSE;
+    }
+
+    IcsResponse_Release(&built);
+    IcsCmbSpectrum_Release(&spectrum);
+
+    return result;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check the double precision Thomson kernel against quad
+//!             precision
+//! \remark     For every Lorentz factor and incident energy, efin runs across
+//!             the whole kinematic range. The pointwise error is checked
+//!             where the quad precision spectrum exceeds
+//!             TEST_KERNEL_PEAK_FRACTION of its peak, and the integral over
+//!             ln(efin) of efin times the spectrum is compared as well. The
+//!             Lorentz factors below 1.1 take the quad precision fallback.
+//! 
+//! \callgraph  
+//! 
+//! \param      None
+//! \return     TRUE if every check passes
+//******************************************************************************
+static BOOL testThomsonF64(void)
+{
+    static const F64 low_gamma[] = { 1.001, 1.01, 1.05, 1.099 };
+    const U32 low_count = sizeof(low_gamma) / sizeof(low_gamma[0]);
+    ICS_THOMSON_GAMMA_F64 prepared_gamma;
+    ICS_THOMSON_EINIT_F64 prepared_einit;
+    F128 reference[TEST_KERNEL_EFIN_COUNT];
+    F64 efin[TEST_KERNEL_EFIN_COUNT];
+    F64 gamma, einit, lower, upper, peak, error, flux, prepared, sum, sum_reference;
+    F64 worst = 0.0, worst_prepared = 0.0, worst_integral = 0.0;
+    U32 g, i, k;
+    BOOL result = TRUE;
+
+    for (g = 0; g < low_count + TEST_KERNEL_GAMMA_COUNT; g++) {
+        gamma = (g < low_count) ? low_gamma[g] :
+                TEST_KERNEL_GAMMA_LOWER * pow(TEST_KERNEL_GAMMA_UPPER / TEST_KERNEL_GAMMA_LOWER, (F64)(g - low_count) / (F64)(TEST_KERNEL_GAMMA_COUNT - 1));
+        IcsThomson_PrepareGammaF64(&prepared_gamma, gamma);
+
+        for (i = 0; i < TEST_KERNEL_EINIT_COUNT; i++) {
+            einit = TEST_KERNEL_EINIT_LOWER * pow(TEST_KERNEL_EINIT_UPPER / TEST_KERNEL_EINIT_LOWER, (F64)i / (F64)(TEST_KERNEL_EINIT_COUNT - 1));
+            IcsThomson_PrepareEinitF64(&prepared_einit, einit);
+            lower = (F64)IcsThomson_MinEnergyIso((F128)einit, (F128)gamma);
+            upper = (F64)IcsThomson_MaxEnergyIso((F128)einit, (F128)gamma);
+
+            for (peak = 0.0, k = 0; k < TEST_KERNEL_EFIN_COUNT; k++) {
+                efin[k] = lower * pow(upper / lower, (F64)k / (F64)(TEST_KERNEL_EFIN_COUNT - 1));
+                reference[k] = IcsThomson_CalcFluxIso((F128)efin[k], (F128)einit, (F128)gamma);
+                peak = fmax(peak, (F64)reference[k]);
+            }
+
+            for (sum = 0.0, sum_reference = 0.0, k = 0; k < TEST_KERNEL_EFIN_COUNT; k++) {
+                flux = IcsThomson_CalcFluxIsoF64(efin[k], einit, gamma);
+                prepared = IcsThomson_CalcFluxPreparedF64(efin[k], &prepared_einit, &prepared_gamma);
+                if ((F64)reference[k] > peak * TEST_KERNEL_PEAK_FRACTION) {
+                    error = fabs(flux / (F64)reference[k] - 1.0);
+                    worst = TestCommon_MaxDeviation(worst, error);
+                    error = fabs(prepared / (F64)reference[k] - 1.0);
+                    worst_prepared = TestCommon_MaxDeviation(worst_prepared, error);
+                }
+                sum += flux * efin[k];
+                sum_reference += (F64)reference[k] * efin[k];
+            }
+            worst_integral = TestCommon_MaxDeviation(worst_integral, fabs(sum / sum_reference - 1.0));
+        }
+    }
+
+    result = (TestCommon_CheckValue("Thomson F64 worst pointwise error", worst, 0.0, 1.0E-9) == TRUE) ? result : FALSE;
+    result = (TestCommon_CheckValue("Thomson prepared F64 worst pointwise error", worst_prepared, 0.0, 1.0E-9) == TRUE) ? result : FALSE;
+    result = (TestCommon_CheckValue("Thomson F64 worst integrated error", worst_integral, 0.0, 1.0E-11) == TRUE) ? result : FALSE;
+
+    return result;
+}
+
+
+
+//******************************************************************************
+//! \breif      Batch axis around a kinematic edge
+//! \remark     The first TEST_BATCH_EDGE_COUNT elements sit within a few ulp
+//!             to 1E-6 of the center, the rest are log-spaced over four
+//!             decades around it.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  center : Value at the kinematic edge
+//! \param[out] axis   : Axis [TEST_BATCH_COUNT]
+//! \return     None
+//******************************************************************************
+static void createBatchAxis(const F64 center, F64 *axis)
+{
+    static const F64 offset[TEST_BATCH_EDGE_COUNT] = { -1.0E-6, -1.0E-10, -1.0E-14, -2.2E-16, 0.0, 2.2E-16, 1.0E-14, 1.0E-10, 1.0E-6 };
+    U32 j;
+
+    for (j = 0; j < TEST_BATCH_COUNT; j++) {
+        if (j < TEST_BATCH_EDGE_COUNT) {
+            axis[j] = center * (1.0 + offset[j]);
+        }
+        else {
+            axis[j] = center * pow(10.0, -2.0 + 4.0 * (F64)(j - TEST_BATCH_EDGE_COUNT) / (F64)(TEST_BATCH_COUNT - TEST_BATCH_EDGE_COUNT - 1));
+        }
+        axis[j] = fmax(axis[j], 1.0 + 1.0E-9);
+    }
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Compare a batch evaluator with its scalar kernel
+//! \remark     Every count from 1 to TEST_BATCH_COUNT is run, so each lane
+//!             width sees full vectors and every tail length. The elements
+//!             past the count must be left untouched.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  variant : 0 : IsoGamma, 1 : ThomsonLimitGamma, 2 : IsoEinit
+//! \param[in]  efin    : Scattered Photon Energy [eV]
+//! \param[in]  einit   : Incident Photon Energy [eV] (Lorentz factor for IsoEinit)
+//! \param[in]  axis    : Lorentz factors (incident energies for IsoEinit) [TEST_BATCH_COUNT]
+//! \return     Largest deviation relative to the peak of the scalar kernel
+//!             and to the condition number 1 + 4 einit gamma / mc^2, or 1 if
+//!             an element past the count was written
+//******************************************************************************
+static F64 compareBatch(const S32 variant, const F64 efin, const F64 einit, const F64 *axis)
+{
+    ICS_JONES_EINIT prepared_einit;
+    ICS_JONES_GAMMA prepared_gamma;
+    F64 scalar[TEST_BATCH_COUNT], batch[TEST_BATCH_COUNT + 1], condition[TEST_BATCH_COUNT];
+    F64 peak, worst;
+    U32 count, j;
+
+    IcsJones_PrepareEinit(&prepared_einit, einit);
+    for (peak = 0.0, j = 0; j < TEST_BATCH_COUNT; j++) {
+        switch (variant) {
+        case 0:
+            scalar[j] = IcsJones_CalcFluxIso(efin, einit, axis[j]);
+            break;
+        case 1:
+            IcsJones_PrepareGamma(&prepared_gamma, axis[j]);
+            scalar[j] = IcsJones_CalcFluxThomsonLimit(efin, &prepared_einit, &prepared_gamma);
+            break;
+        default:
+            scalar[j] = IcsJones_CalcFluxIso(efin, axis[j], einit);
+            break;
+        }
+        condition[j] = 1.0 + 4.0 * einit * axis[j] / ELECTRON_REST_ENERGY;
+        peak = fmax(peak, fabs(scalar[j]));
+    }
+    peak = (peak > 0.0) ? peak : 1.0;
+
+    for (worst = 0.0, count = 1; count <= TEST_BATCH_COUNT; count++) {
+        for (j = 0; j <= TEST_BATCH_COUNT; j++) {
+            batch[j] = TEST_BATCH_SENTINEL;
+        }
+        switch (variant) {
+        case 0:
+            IcsJonesBatch_CalcFluxIsoGamma(efin, einit, axis, count, batch);
+            break;
+        case 1:
+            IcsJonesBatch_CalcFluxThomsonLimitGamma(efin, einit, axis, count, batch);
+            break;
+        default:
+            IcsJonesBatch_CalcFluxIsoEinit(efin, axis, einit, count, batch);
+            break;
+        }
+        for (j = 0; j <= TEST_BATCH_COUNT; j++) {
+            if (j >= count) {
+                if (batch[j] != TEST_BATCH_SENTINEL) {
+                    return 1.0;
+                }
+            }
+            else {
+                worst = TestCommon_MaxDeviation(worst, fabs(batch[j] - scalar[j]) / (peak * condition[j]));
+            }
+        }
+    }
+
+    return worst;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check the batch Jones evaluators against the scalar kernel
+//! \remark     1) Every instruction set the CPU supports is selected in turn.
+//!             2) The Lorentz factors (or the incident energies) straddle the
+//!                upward and downward kinematic edges of efin and the
+//!                efin = einit boundary between the two branches.
+//!             3) The deviation is measured relative to the peak of each
+//!                batch, since the spectrum vanishes at the edges. In the
+//!                Klein-Nishina regime, 1 - efin / (gamma mc^2) near the
+//!                upward edge cancels to 1 / (1 + 4 einit gamma / mc^2), so
+//!                one rounding of either kernel is amplified by that factor.
+//! 
+//! \callgraph  
+//! 
+//! \param      None
+//! \return     TRUE if every check passes
+//******************************************************************************
+static BOOL testJonesBatch(void)
+{
+    static const CHAR *isa_name[] = { "scalar", "AVX2", "AVX-512" };
+    static const CHAR *variant_name[] = { "IsoGamma", "ThomsonLimitGamma", "IsoEinit" };
+    static const F64 einit[] = { 1.0E-6, 6.3E-4, 1.0E-1 };
+    static const F64 gamma[] = { 2.0, 1.0E+3, 1.0E+6, 1.0E+9 };
+    const S32 native = IcsJonesBatch_GetIsa();
+    F64 axis[TEST_BATCH_COUNT], efin[3], worst;
+    CHAR name[96];
+    S32 isa, variant;
+    U32 i, g, e;
+    BOOL result = TRUE;
+
+    for (isa = ICS_JONES_BATCH_ISA_SCALAR; IcsJonesBatch_SetIsa(isa) == TRUE; isa++) {
+        for (variant = 0; variant < 3; variant++) {
+            for (worst = 0.0, i = 0; i < sizeof(einit) / sizeof(einit[0]); i++) {
+                for (g = 0; g < sizeof(gamma) / sizeof(gamma[0]); g++) {
+                    // Upward edge, downward edge and the boundary of the branches
+                    efin[0] = IcsJones_MaxEnegyIso(einit[i], gamma[g]);
+                    efin[1] = IcsJones_MinEnegyIso(einit[i], gamma[g]);
+                    efin[2] = einit[i];
+                    for (e = 0; e < 3; e++) {
+                        if (variant == 2) {
+                            createBatchAxis(einit[i], axis);
+                            worst = TestCommon_MaxDeviation(worst, compareBatch(variant, efin[e], gamma[g], axis));
+                        }
+                        else {
+                            createBatchAxis(gamma[g], axis);
+                            worst = TestCommon_MaxDeviation(worst, compareBatch(variant, efin[e], einit[i], axis));
+                        }
+                    }
+                }
+            }
+            sprintf(name, "Jones batch %s (%s) vs scalar", variant_name[variant], isa_name[isa]);
+            result = (TestCommon_CheckValue(name, worst, 0.0, 1.0E-12) == TRUE) ? result : FALSE;
+        }
+    }
+    IcsJonesBatch_SetIsa(native);
+
+    return result;
+}
+
+
+
+//******************************************************************************
+//! \breif      ICS flux over the full grid without pruning
+//! \remark     Same kernels and summation order as IcsCmbSpectrum_CalcFlux
+//!             with the scalar evaluators, but every row and every gamma
+//!             node is evaluated.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  spectrum : ICS spectrum (USE_JONES_APPROX or USE_THOMSON_APPROX, F64)
+//! \param[in]  efin     : Scattered Photon Energy [eV]
+//! \return     ICS flux
+//******************************************************************************
+static F64 calcFullGridFlux(const ICS_CMB_SPECTRUM *spectrum, const F64 efin)
+{
+    ICS_JONES_EINIT jones;
+    ICS_THOMSON_EINIT_F64 thomson;
+    F64 einit, limit, kernel, sum, flux;
+    U32 i, j;
+
+    for (flux = 0.0, i = 0; i < spectrum->Einit.Count; i++) {
+        einit = spectrum->Einit.Node[i];
+        IcsJones_PrepareEinit(&jones, einit);
+        IcsThomson_PrepareEinitF64(&thomson, einit);
+        limit = spectrum->ThomsonLimit * ELECTRON_REST_ENERGY / (4.0 * einit);
+
+        for (sum = 0.0, j = 0; j < spectrum->Gamma.Count; j++) {
+            if (spectrum->Mode == USE_THOMSON_APPROX) {
+                kernel = IcsThomson_CalcFluxPreparedF64(efin, &thomson, &spectrum->ThomsonGammaF64[j]);
+            }
+            else if (spectrum->Gamma.Node[j] < limit) {
+                kernel = IcsJones_CalcFluxThomsonLimit(efin, &jones, &spectrum->JonesGamma[j]);
+            }
+            else {
+                kernel = IcsJones_CalcFluxPrepared(efin, &jones, &spectrum->JonesGamma[j]);
+            }
+            sum += spectrum->ElectronDensity[j] * kernel;
+        }
+        flux += spectrum->CmbDensity[i] * sum;
+    }
+
+    return flux;
+}
+
+
+
+//******************************************************************************
+//! \breif      Compare the pruned flux with the full grid near the thresholds
+//! \remark     efin is placed on the kinematic edges of a gamma node for a
+//!             few einit rows, so the threshold of that row falls on the
+//!             node, and then moved by a few ulp up to 1E-6 either way.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  spectrum : ICS spectrum
+//! \return     Largest relative deviation
+//******************************************************************************
+static F64 comparePruning(const ICS_CMB_SPECTRUM *spectrum)
+{
+    static const F64 offset[] = { -1.0E-6, -1.0E-12, -4.4E-16, 0.0, 4.4E-16, 1.0E-12, 1.0E-6 };
+    static const F64 node_fraction[] = { 0.1, 0.35, 0.5, 0.7 };
+    const U32 row[] = { 0, spectrum->Einit.Count / 2, spectrum->Einit.Count - 1 };
+    F64 edge[4], einit, gamma, efin, flux, reference, worst = 0.0;
+    U32 r, g, e, o;
+
+    for (r = 0; r < sizeof(row) / sizeof(row[0]); r++) {
+        einit = spectrum->Einit.Node[row[r]];
+        for (g = 0; g < sizeof(node_fraction) / sizeof(node_fraction[0]); g++) {
+            gamma = spectrum->Gamma.Node[(U32)(node_fraction[g] * (F64)(spectrum->Gamma.Count - 1))];
+            if (spectrum->Mode == USE_THOMSON_APPROX) {
+                edge[0] = IcsThomson_MaxEnergyIsoF64(einit, gamma);
+                edge[1] = IcsThomson_MinEnergyIsoF64(einit, gamma);
+            }
+            else {
+                edge[0] = IcsJones_MaxEnegyIso(einit, gamma);
+                edge[1] = IcsJones_MinEnegyIso(einit, gamma);
+            }
+            edge[2] = 4.0 * einit * gamma * gamma;     // Upper edge of the Thomson limit
+            edge[3] = einit;
+
+            for (e = 0; e < sizeof(edge) / sizeof(edge[0]); e++) {
+                for (o = 0; o < sizeof(offset) / sizeof(offset[0]); o++) {
+                    efin = edge[e] * (1.0 + offset[o]);
+                    flux = IcsCmbSpectrum_CalcFlux(spectrum, efin);
+                    reference = calcFullGridFlux(spectrum, efin);
+                    worst = TestCommon_MaxDeviation(worst, (reference != 0.0) ? fabs(flux / reference - 1.0) : fabs(flux));
+                }
+            }
+        }
+    }
+
+    return worst;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check that the pruning drops no nonzero kernel value
+//! \remark     Jones, Jones with the Thomson limit and Thomson, with the
+//!             scalar evaluators so that the pruned and full sums add the
+//!             same terms in the same order.
+//! 
+//! \callgraph  
+//! 
+//! \param      None
+//! \return     TRUE if every check passes
+//******************************************************************************
+static BOOL testPruning(void)
+{
+    ICS_CMB_SPECTRUM jones, thomson;
+    const S32 native = IcsJonesBatch_GetIsa();
+    BOOL result = TRUE;
+
+    if ((TestCommon_CheckTrue("Pruning spectra", ((createSpectrum(&jones, USE_JONES_APPROX) == TRUE) &&
+                                                  (createSpectrum(&thomson, USE_THOMSON_APPROX) == TRUE)) ? TRUE : FALSE)) == FALSE) {
+        return FALSE;
+    }
+    IcsJonesBatch_SetIsa(ICS_JONES_BATCH_ISA_SCALAR);
+
+    result = (TestCommon_CheckValue("Pruned Jones flux vs full grid", comparePruning(&jones), 0.0, 1.0E-14) == TRUE) ? result : FALSE;
+    jones.ThomsonLimit = TEST_THOMSON_LIMIT;
+    result = (TestCommon_CheckValue("Pruned Jones Thomson-limit flux vs full grid", comparePruning(&jones), 0.0, 1.0E-14) == TRUE) ? result : FALSE;
+    result = (TestCommon_CheckValue("Pruned Thomson flux vs full grid", comparePruning(&thomson), 0.0, 1.0E-14) == TRUE) ? result : FALSE;
+
+    IcsJonesBatch_SetIsa(native);
+    IcsCmbSpectrum_Release(&jones);
+    IcsCmbSpectrum_Release(&thomson);
+
+    return result;
+}
+
+
+
+//******************************************************************************
+//! \breif      Compare the sweep with the per-energy flux
+//! \remark     The sweep adds the same terms in a different order, so the
+//!             fluxes agree to rounding. Its kernel evaluations are bounded
+//!             by the per-energy pruned count (the sweep support is never
+//!             wider than the per-energy pruning) and must not be zero.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  spectrum : ICS spectrum
+//! \param[in]  name     : Name of the spectrum in the check names
+//! \return     TRUE if every check passes
+//******************************************************************************
+static BOOL compareSweep(const ICS_CMB_SPECTRUM *spectrum, const CHAR *name)
+{
+    U32 k;
+    F64 efin[TEST_EFIN_COUNT], flux[TEST_EFIN_COUNT];
+    F64 expected, deviation = 0.0;
+    U64 evaluations = 0, evaluated, total, bound = 0;
+    CHAR check[64];
+    BOOL result = TRUE;
+
+    createEnergies(efin);
+
+    snprintf(check, sizeof(check), "%s sweep", name);
+    if (TestCommon_CheckTrue(check, IcsCmbSpectrum_CalcFluxSweep(spectrum, efin, TEST_EFIN_COUNT, flux, &evaluations)) == FALSE) {
+        return FALSE;
+    }
+
+    for (k = 0; k < TEST_EFIN_COUNT; k++) {
+        expected = IcsCmbSpectrum_CalcFlux(spectrum, efin[k]);
+        deviation = TestCommon_MaxDeviation(deviation, (expected != 0.0) ? fabs(flux[k] / expected - 1.0) : fabs(flux[k]));
+        IcsCmbSpectrum_CountEvaluations(spectrum, efin[k], &evaluated, &total);
+        bound += evaluated;
+    }
+
+    snprintf(check, sizeof(check), "%s sweep vs per-energy flux", name);
+    result = (TestCommon_CheckValue(check, deviation, 0.0, 1.0E-12) == TRUE) ? result : FALSE;
+    snprintf(check, sizeof(check), "%s sweep evaluations within the pruned count", name);
+    result = (TestCommon_CheckTrue(check, ((evaluations > 0) && (evaluations <= bound)) ? TRUE : FALSE) == TRUE) ? result : FALSE;
+
+    return result;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check the one-pass sweep over ascending emitted energies
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param      None
+//! \return     TRUE if every check passes
+//******************************************************************************
+static BOOL testSweep(void)
+{
+    ICS_CMB_SPECTRUM jones, thomson;
+    BOOL result = TRUE;
+
+    if ((TestCommon_CheckTrue("Sweep spectra", ((createSpectrum(&jones, USE_JONES_APPROX) == TRUE) &&
+                                                (createSpectrum(&thomson, USE_THOMSON_APPROX) == TRUE)) ? TRUE : FALSE)) == FALSE) {
+        return FALSE;
+    }
+
+    result = (compareSweep(&jones, "Jones") == TRUE) ? result : FALSE;
+    jones.ThomsonLimit = TEST_THOMSON_LIMIT;
+    result = (compareSweep(&jones, "Jones Thomson-limit") == TRUE) ? result : FALSE;
+    result = (compareSweep(&thomson, "Thomson") == TRUE) ? result : FALSE;
+
+    IcsCmbSpectrum_Release(&jones);
+    IcsCmbSpectrum_Release(&thomson);
+
+    return result;
+}
+
+
+
+//******************************************************************************
+//! \breif      Relative deviation of a table flux
+//! \remark     The table checks only visit the up-scattering branch, so a
+//!             reference flux that is not positive counts as a failure.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  value    : Flux from the table
+//! \param[in]  expected : Flux from the Jones kernel
+//! \return     |value / expected - 1|, or 1 if expected is not positive
+//******************************************************************************
+static F64 calcTableDeviation(const F64 value, const F64 expected)
+{
+    return (expected > 0.0) ? fabs(value / expected - 1.0) : 1.0;
+}
+
+
+
+//******************************************************************************
+//! \breif      Compare the table with the Jones kernel at one q
+//! \remark     efin is chosen so that the kernel forms the requested q :
+//!             efin = 4 einit gamma^2 q in the Thomson limit and
+//!             efin = 4 einit gamma^2 q / (1 + 4 einit gamma q / mc^2)
+//!             otherwise. gamma is raised to 1 / sqrt(q) for small q to keep
+//!             efin above einit. Both sides form q with the same
+//!             expression, so rounding in efin moves q but not the
+//!             comparison.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  table     : Jones kernel table
+//! \param[in]  q         : 0 < q < 1
+//! \param[in,out] deviation : Largest relative deviation so far
+//!                            [0 : flux, 1 : Thomson limit]
+//! \return     None
+//******************************************************************************
+static void compareJonesTable(const ICS_JONES_TABLE *table, const F64 q, F64 *deviation)
+{
+    ICS_JONES_EINIT einit;
+    ICS_JONES_GAMMA gamma;
+    F64 area, efin;
+
+    IcsJones_PrepareEinit(&einit, TEST_TABLE_EINIT);
+    IcsJones_PrepareGamma(&gamma, fmax(TEST_TABLE_GAMMA, 1.0 / sqrt(q)));
+    area = einit.FourEinit * gamma.Gamma2 * q;
+
+    efin = area / (1.0 + area * gamma.InvGammaMc2);
+    deviation[0] = TestCommon_MaxDeviation(deviation[0], calcTableDeviation(IcsJonesTable_CalcFlux(table, efin, &einit, &gamma),
+                                                                              IcsJones_CalcFluxPrepared(efin, &einit, &gamma)));
+
+    efin = area;
+    deviation[1] = TestCommon_MaxDeviation(deviation[1], calcTableDeviation(IcsJonesTable_CalcFluxThomsonLimit(table, efin, &einit, &gamma),
+                                                                              IcsJones_CalcFluxThomsonLimit(efin, &einit, &gamma)));
+
+    return;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check the Jones kernel table against the Jones kernel
+//! \remark     q runs over every interval boundary of the table (binades
+//!             and their JONES_TABLE_SUBDIVISIONS subintervals), each at the
+//!             boundary and TEST_TABLE_OFFSET to either side, down to the
+//!             bottom of the table at 2^JONES_TABLE_EXPONENT_MIN where
+//!             G = 1 + 2 q takes over, and up to q just below 1, where the
+//!             flux vanishes as 1 - q.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  table : Jones kernel table
+//! \return     TRUE if every check passes
+//******************************************************************************
+static BOOL testJonesTable(const ICS_JONES_TABLE *table)
+{
+    static const F64 below_one[] = { 1.0E-2, 1.0E-4, 1.0E-6, 1.0E-8, 1.0E-10, 1.0E-12, 1.0E-14 };
+    F64 deviation[2] = { 0.0, 0.0 };
+    F64 boundary;
+    S32 exponent;
+    U32 sub, k;
+    BOOL result = TRUE;
+
+    for (exponent = JONES_TABLE_EXPONENT_MIN; exponent < 0; exponent++) {
+        for (sub = 0; sub < JONES_TABLE_SUBDIVISIONS; sub++) {
+            boundary = ldexp(1.0 + (F64)sub / (F64)JONES_TABLE_SUBDIVISIONS, exponent);
+            compareJonesTable(table, boundary * (1.0 - TEST_TABLE_OFFSET), deviation);
+            compareJonesTable(table, boundary, deviation);
+            compareJonesTable(table, boundary * (1.0 + TEST_TABLE_OFFSET), deviation);
+        }
+    }
+    compareJonesTable(table, ldexp(1.0, JONES_TABLE_EXPONENT_MIN - 1), deviation);
+    for (k = 0; k < sizeof(below_one) / sizeof(below_one[0]); k++) {
+        compareJonesTable(table, 1.0 - below_one[k], deviation);
+    }
+
+    result = (TestCommon_CheckValue("Jones table flux vs kernel", deviation[0], 0.0, JONES_TABLE_TOLERANCE) == TRUE) ? result : FALSE;
+    result = (TestCommon_CheckValue("Jones table Thomson-limit flux vs kernel", deviation[1], 0.0, JONES_TABLE_TOLERANCE) == TRUE) ? result : FALSE;
+
+    return result;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check the one-pass Jones and Thomson flux and its NaN contract
+//! \remark     1) The pair is the flux of modes 1 and 2 on the same grids.
+//!             2) The pair on another mode gives NaN for both outputs, and
+//!                the single-mode entry points reject
+//!                USE_JONES_THOMSON_APPROX (NaN flux, FALSE sweep).
+//! 
+//! \callgraph  
+//! 
+//! \param      None
+//! \return     TRUE if every check passes
+//******************************************************************************
+static BOOL testPair(void)
+{
+    ICS_CMB_SPECTRUM jones, thomson, pair;
+    F64 efin[TEST_EFIN_COUNT], flux[TEST_EFIN_COUNT];
+    F64 pair_jones, pair_thomson, expected, deviation, jones_deviation = 0.0, thomson_deviation = 0.0;
+    U32 k;
+    BOOL result = TRUE;
+
+    if ((TestCommon_CheckTrue("Pair spectra", ((createSpectrum(&jones, USE_JONES_APPROX) == TRUE) &&
+                                               (createSpectrum(&thomson, USE_THOMSON_APPROX) == TRUE) &&
+                                               (createSpectrum(&pair, USE_JONES_THOMSON_APPROX) == TRUE)) ? TRUE : FALSE)) == FALSE) {
+        return FALSE;
+    }
+    createEnergies(efin);
+
+    for (k = 0; k < TEST_EFIN_COUNT; k++) {
+        IcsCmbSpectrum_CalcFluxPair(&pair, efin[k], &pair_jones, &pair_thomson);
+        expected = IcsCmbSpectrum_CalcFlux(&jones, efin[k]);
+        deviation = (expected != 0.0) ? fabs(pair_jones / expected - 1.0) : fabs(pair_jones);
+        jones_deviation = TestCommon_MaxDeviation(jones_deviation, deviation);
+        expected = IcsCmbSpectrum_CalcFlux(&thomson, efin[k]);
+        deviation = (expected != 0.0) ? fabs(pair_thomson / expected - 1.0) : fabs(pair_thomson);
+        thomson_deviation = TestCommon_MaxDeviation(thomson_deviation, deviation);
+    }
+    result = (TestCommon_CheckValue("Pair Jones flux vs mode 1", jones_deviation, 0.0, 1.0E-14) == TRUE) ? result : FALSE;
+    result = (TestCommon_CheckValue("Pair Thomson flux vs mode 2", thomson_deviation, 0.0, 1.0E-14) == TRUE) ? result : FALSE;
+
+    IcsCmbSpectrum_CalcFluxPair(&jones, efin[0], &pair_jones, &pair_thomson);
+    result = (TestCommon_CheckTrue("Pair on mode 1 gives NaN", ((isnan(pair_jones) != 0) && (isnan(pair_thomson) != 0)) ? TRUE : FALSE) == TRUE) ? result : FALSE;
+    result = (TestCommon_CheckTrue("Flux on mode 4 gives NaN", (isnan(IcsCmbSpectrum_CalcFlux(&pair, efin[0])) != 0) ? TRUE : FALSE) == TRUE) ? result : FALSE;
+    result = (TestCommon_CheckTrue("Sweep on mode 4 fails",
+                                   (IcsCmbSpectrum_CalcFluxSweep(&pair, efin, TEST_EFIN_COUNT, flux, NULL) == FALSE) ? TRUE : FALSE) == TRUE) ? result : FALSE;
+
+    IcsCmbSpectrum_Release(&jones);
+    IcsCmbSpectrum_Release(&thomson);
+    IcsCmbSpectrum_Release(&pair);
+
+    return result;
+}
+
+
+
+
+
+//******************************************************************************
+// End of File
+//******************************************************************************
@@ -0,0 +1,346 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+
+#define TEST_IO_C_
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "io_chain.h"
+#include "io_job.h"
+#include "io_table.h"
+#include "test_common.h"
+#include "test_io.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+#define TEST_TABLE_FILE                 "ics_test_table.bin"        //!< Scratch table file
+#define TEST_CHAIN_FILE                 "ics_test_chain.bin"        //!< Scratch chain file
+#define TEST_JOB_FILE                   "ics_test_job.txt"          //!< Scratch job file
+
+
+
+//==============================================================================
+// File Scope Function Prototype
+//==============================================================================
+static BOOL isSamePayload(const IO_TABLE *table, const U32 index, const F64 *expected, const U64 count);
+static BOOL testTable(void);
+static BOOL writeText(const CHAR *file_name, const CHAR *text);
+static BOOL isRejectedJob(const CHAR *text);
+static BOOL testJob(void);
+static BOOL testChain(void);
+
+
+
+
+
+//******************************************************************************
+//! \breif      Check the file formats
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param      None
+//! \return     TRUE if every check passes
+//******************************************************************************
+BOOL TestIo_Run(void)
+{
+    BOOL result = TRUE;
+
+    result = (testTable() == TRUE) ? result : FALSE;
+    result = (testJob() == TRUE) ? result : FALSE;
+    result = (testChain() == TRUE) ? result : FALSE;
+
+    remove(TEST_TABLE_FILE);
+    remove(TEST_JOB_FILE);
+    remove(TEST_CHAIN_FILE);
+
+    return result;
+}
+
+
+
+
+
+//******************************************************************************
+//! \breif      Compare a payload of an opened table
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  table    : Opened table
+//! \param[in]  index    : Section index
+//! \param[in]  expected : Expected payload
+//! \param[in]  count    : Number of elements
+//! \return     TRUE if the payload is IO_TABLE_ALIGNMENT aligned and the same
+//******************************************************************************
+static BOOL isSamePayload(const IO_TABLE *table, const U32 index, const F64 *expected, const U64 count)
+{
+    const F64 *payload = IoTable_GetSection(table, index);
+
+    return ((payload != NULL) && (((const U8 *)payload - table->Image) % IO_TABLE_ALIGNMENT == 0) &&
+            (table->Header->Section[index].Count == count) &&
+            (memcmp(payload, expected, sizeof(F64) * (size_t)count) == 0)) ? TRUE : FALSE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check that table files load back to the same data
+//! \remark     1) A table with two payloads, checking the header fields and
+//!                the payload alignment.
+//!             2) A table opened while the file is rewritten keeps the
+//!                previous content, and reopening gives the new one.
+//! 
+//! \callgraph  
+//! 
+//! \param      None
+//! \return     TRUE if every check passes
+//******************************************************************************
+static BOOL testTable(void)
+{
+    static const F64 first[] = { 1.0, -2.5, 1.0E-300, 1.0E+300, 0.0 };
+    static const F64 second[] = { 3.0, 4.0, 5.0 };
+    static const F64 rewritten[] = { 6.0, 7.0 };
+    const F64 *sections[2];
+    IO_TABLE_HEADER header;
+    IO_TABLE table, reopened;
+    BOOL result = TRUE;
+    BOOL same;
+
+    IoTable_InitHeader(&header, IO_TABLE_KIND_SPECTRUM);
+    header.Mode = 2;
+    header.NormFactor = 1.5;
+    header.SpectrumPower = 2.2;
+    header.GammaMax = 1.0E+6;
+    header.SectionCount = 2;
+    header.Section[0].Count = sizeof(first) / sizeof(first[0]);
+    header.Section[1].Count = sizeof(second) / sizeof(second[0]);
+    sections[0] = first;
+    sections[1] = second;
+    result = (TestCommon_CheckTrue("Table write", IoTable_Write(TEST_TABLE_FILE, &header, sections)) == TRUE) ? result : FALSE;
+    if (TestCommon_CheckTrue("Table open", IoTable_Open(&table, TEST_TABLE_FILE)) == FALSE) {
+        return FALSE;
+    }
+
+    same = ((table.Header->Kind == IO_TABLE_KIND_SPECTRUM) && (table.Header->Mode == 2) &&
+            (table.Header->NormFactor == 1.5) && (table.Header->SpectrumPower == 2.2) && (table.Header->GammaMax == 1.0E+6) &&
+            (table.Header->SectionCount == 2)) ? TRUE : FALSE;
+    result = (TestCommon_CheckTrue("Table header loads back", same) == TRUE) ? result : FALSE;
+    same = ((isSamePayload(&table, 0, first, header.Section[0].Count) == TRUE) &&
+            (isSamePayload(&table, 1, second, header.Section[1].Count) == TRUE) &&
+            (IoTable_GetSection(&table, 2) == NULL)) ? TRUE : FALSE;
+    result = (TestCommon_CheckTrue("Table payloads load back aligned", same) == TRUE) ? result : FALSE;
+
+    //------------------------------------------------------
+    // Rewrite the file while it is open
+    //------------------------------------------------------
+    header.SectionCount = 1;
+    header.Section[0].Count = sizeof(rewritten) / sizeof(rewritten[0]);
+    sections[0] = rewritten;
+    result = (TestCommon_CheckTrue("Table rewrite while open", IoTable_Write(TEST_TABLE_FILE, &header, sections)) == TRUE) ? result : FALSE;
+    same = ((table.Header->SectionCount == 2) &&
+            (isSamePayload(&table, 0, first, sizeof(first) / sizeof(first[0])) == TRUE) &&
+            (isSamePayload(&table, 1, second, sizeof(second) / sizeof(second[0])) == TRUE)) ? TRUE : FALSE;
+    result = (TestCommon_CheckTrue("Opened table keeps the previous content", same) == TRUE) ? result : FALSE;
+    if (TestCommon_CheckTrue("Table reopen", IoTable_Open(&reopened, TEST_TABLE_FILE)) == TRUE) {
+        same = ((reopened.Header->SectionCount == 1) &&
+                (isSamePayload(&reopened, 0, rewritten, sizeof(rewritten) / sizeof(rewritten[0])) == TRUE)) ? TRUE : FALSE;
+        result = (TestCommon_CheckTrue("Reopened table has the new content", same) == TRUE) ? result : FALSE;
+        IoTable_Close(&reopened);
+    }
+    else {
+        result = FALSE;
+    }
+    IoTable_Close(&table);
+
+    return result;
+}
+
+
+
+//******************************************************************************
+//! \breif      Write a text file
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  file_name : File name
+//! \param[in]  text      : Content
+//! \return     TRUE on success
+//******************************************************************************
+static BOOL writeText(const CHAR *file_name, const CHAR *text)
+{
+    FILE *fp;
+    BOOL result;
+
+    if ((fp = fopen(file_name, "w")) == NULL) {
+        return FALSE;
+    }
+    result = (fputs(text, fp) >= 0) ? TRUE : FALSE;
+
+    return ((fclose(fp) == 0) && (result == TRUE)) ? TRUE : FALSE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check that a job file is rejected at its second line
+//! \remark     The first line is a valid job.
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  text : Second line
+//! \return     TRUE if IoJob_Read fails with error line 2
+//******************************************************************************
+static BOOL isRejectedJob(const CHAR *text)
+{
+    CHAR content[256];
+    IO_JOB *jobs;
+    U32 count, error_line;
+
+    snprintf(content, sizeof(content), "1 1.0 2.2 1E+6 1E+3 1E+12\n%s\n", text);
+    if (writeText(TEST_JOB_FILE, content) == FALSE) {
+        return FALSE;
+    }
+
+    return ((IoJob_Read(TEST_JOB_FILE, &jobs, &count, &error_line) == FALSE) && (jobs == NULL) && (error_line == 2)) ? TRUE : FALSE;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check the job file parser
+//! \remark     A valid file with comments and blank lines, then lines with a
+//!             non-integer mode, a partly numeric field, a missing field and
+//!             an extra field, which must all be rejected. "1.5 2.2 ..." must
+//!             not be read as mode 1 and norm 0.5.
+//! 
+//! \callgraph  
+//! 
+//! \param      None
+//! \return     TRUE if every check passes
+//******************************************************************************
+static BOOL testJob(void)
+{
+    IO_JOB *jobs;
+    U32 count, error_line;
+    BOOL result = TRUE;
+
+    result = (TestCommon_CheckTrue("Job write", writeText(TEST_JOB_FILE, "# mode norm power gamma_max lower upper\n"
+                                                                        "1 1.0 2.2 1E+6 1E+3 1E+12  # first\n"
+                                                                        "\n"
+                                                                        "\t4 2 -0.5 3E+4 10 20\n")) == TRUE) ? result : FALSE;
+    if (TestCommon_CheckTrue("Job read", IoJob_Read(TEST_JOB_FILE, &jobs, &count, &error_line)) == FALSE) {
+        return FALSE;
+    }
+    result = (TestCommon_CheckTrue("Job count and fields", ((count == 2) &&
+                                                            (jobs[0].Mode == 1) && (jobs[0].Norm == 1.0) && (jobs[0].Power == 2.2) &&
+                                                            (jobs[0].GammaMax == 1.0E+6) && (jobs[0].Lower == 1.0E+3) && (jobs[0].Upper == 1.0E+12) &&
+                                                            (jobs[1].Mode == 4) && (jobs[1].Norm == 2.0) && (jobs[1].Power == -0.5) &&
+                                                            (jobs[1].GammaMax == 3.0E+4) && (jobs[1].Lower == 10.0) && (jobs[1].Upper == 20.0)) ? TRUE : FALSE) == TRUE) ? result : FALSE;
+    IoJob_Release(jobs);
+
+    result = (TestCommon_CheckTrue("Job non-integer mode rejected", isRejectedJob("1.5 1.0 2.2 1E+6 1E+3 1E+12")) == TRUE) ? result : FALSE;
+    result = (TestCommon_CheckTrue("Job mode not split into mode and norm", isRejectedJob("1.5 2.2 1E+6 1E+3 1E+12")) == TRUE) ? result : FALSE;
+    result = (TestCommon_CheckTrue("Job partly numeric field rejected", isRejectedJob("1 1.0 2.2x 1E+6 1E+3 1E+12")) == TRUE) ? result : FALSE;
+    result = (TestCommon_CheckTrue("Job missing field rejected", isRejectedJob("1 1.0 2.2 1E+6 1E+3")) == TRUE) ? result : FALSE;
+    result = (TestCommon_CheckTrue("Job extra field rejected", isRejectedJob("1 1.0 2.2 1E+6 1E+3 1E+12 7")) == TRUE) ? result : FALSE;
+    result = (TestCommon_CheckTrue("Job lower above upper rejected", isRejectedJob("1 1.0 2.2 1E+6 1E+12 1E+3")) == TRUE) ? result : FALSE;
+
+    return result;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check that chain files load back to the same records
+//! \remark     Records appended after a sync are only visible once synced,
+//!             and a reopened chain keeps the requested records and appends
+//!             after them.
+//! 
+//! \callgraph  
+//! 
+//! \param      None
+//! \return     TRUE if every check passes
+//******************************************************************************
+static BOOL testChain(void)
+{
+    const U32 walkers = 4, dimension = 3, steps = 5, record_count = walkers * (dimension + 1);
+    IO_CHAIN chain;
+    IO_CHAIN_HEADER header;
+    F64 written[5 * 4 * (3 + 1)];
+    F64 *records;
+    U32 i;
+    BOOL result = TRUE;
+
+    for (i = 0; i < steps * record_count; i++) {
+        written[i] = sin((F64)i) * pow(10.0, (F64)(i % 7) - 3.0);
+    }
+
+    remove(TEST_CHAIN_FILE);
+    if (TestCommon_CheckTrue("Chain open", IoChain_Open(&chain, TEST_CHAIN_FILE, walkers, dimension, 1, 0)) == FALSE) {
+        return FALSE;
+    }
+    for (i = 0; i < 3; i++) {
+        result = (IoChain_Append(&chain, &written[i * record_count]) == TRUE) ? result : FALSE;
+    }
+    result = (IoChain_Sync(&chain) == TRUE) ? result : FALSE;
+    IoChain_Close(&chain);
+
+    // Keep 2 of the 3 records and append the rest
+    result = (TestCommon_CheckTrue("Chain reopen", IoChain_Open(&chain, TEST_CHAIN_FILE, walkers, dimension, 1, 2)) == TRUE) ? result : FALSE;
+    for (i = 2; i < steps; i++) {
+        result = (IoChain_Append(&chain, &written[i * record_count]) == TRUE) ? result : FALSE;
+    }
+    IoChain_Close(&chain);
+
+    if (TestCommon_CheckTrue("Chain read", IoChain_Read(TEST_CHAIN_FILE, &header, &records)) == TRUE) {
+        result = (TestCommon_CheckTrue("Chain loads back to the same records",
+                            ((header.Steps == steps) && (header.Walkers == walkers) && (header.Dimension == dimension) && (header.Mode == 1) &&
+                             (memcmp(records, written, sizeof(written)) == 0)) ? TRUE : FALSE) == TRUE) ? result : FALSE;
+        free(records);
+    }
+    else {
+        result = FALSE;
+    }
+
+    return result;
+}
+
+
+
+
+
+//******************************************************************************
+// End of File
+//******************************************************************************
@@ -0,0 +1,75 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+
+#define TEST_MAIN_C_
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include "test_fitting.h"
+#include "test_ics.h"
+#include "test_io.h"
+#include "test_numerics.h"
+
+
+
+
+
+//******************************************************************************
+//! \breif      Check target of the numerics, the kernels, the file formats and
+//!             the fitting
+//! \remark     Every check compares against a closed form, a reference
+//!             evaluation or a file written by the test itself, so it needs
+//!             no data files. Scratch files are written to the working
+//!             directory and removed by the module that wrote them.
+//! 
+//! \callgraph  
+//! 
+//! \param      None
+//! \return     EXIT_SUCCESS if every check passes, EXIT_FAILURE otherwise
+//******************************************************************************
+int main(void)
+{
+    BOOL result = TRUE;
+
+    result = (TestNumerics_Run() == TRUE) ? result : FALSE;
+    result = (TestIcs_Run() == TRUE) ? result : FALSE;
+    result = (TestIo_Run() == TRUE) ? result : FALSE;
+    result = (TestFitting_Run() == TRUE) ? result : FALSE;
+
+    printf("%s\n", (result == TRUE) ? "All checks passed" : "[ERROR] Some checks failed");
+
+    return (result == TRUE) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+
+
+
+//******************************************************************************
+// End of File
+//******************************************************************************
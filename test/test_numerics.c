@@ -0,0 +1,496 @@
+//******************************************************************************
+// MIT License
+//
+// Copyright (c) 2022 Tomonobu Inayama
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//******************************************************************************
+
+
+#define TEST_NUMERICS_C_
+
+//==============================================================================
+// Header File Include
+//==============================================================================
+#include <stdio.h>
+#include <math.h>
+#include "numerics_gauss_kronrod.h"
+#include "numerics_nelder_mead.h"
+#include "numerics_quadrature.h"
+#include "numerics_trapezoidal.h"
+#include "common_physical_const.h"
+#include "particles_cmb.h"
+#include "test_common.h"
+#include "test_numerics.h"
+
+
+
+//==============================================================================
+// Macro Definition
+//==============================================================================
+#define TEST_RIEMANN_ZETA_3             (1.2020569031595943)        //!< zeta(3)
+
+
+
+//==============================================================================
+// File Scope Function Prototype
+//==============================================================================
+static F64 polynomial(const F64 x, void *context);
+static F64 inverse(const F64 x, void *context);
+static F64 sine(const F64 x, void *context);
+static F64 inverseProduct(const F64 x, const F64 y, void *context);
+static F64 cmbFlux(const F64 x, void *context);
+static F64 exponentialProduct(const F64 x, const F64 y, const F64 z, void *context);
+static F64 exponentialProductBare(const F64 x, const F64 y, const F64 z);
+static F64 rosenbrock(const F64 *x, void *context);
+static BOOL testTrapezoidal(void);
+static BOOL testGaussKronrod(void);
+static BOOL testLaguerre(void);
+static BOOL testTriple(void);
+static BOOL testNelderMead(void);
+
+
+
+
+
+//******************************************************************************
+//! \breif      Check the quadrature rules and the minimizer
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param      None
+//! \return     TRUE if every check passes
+//******************************************************************************
+BOOL TestNumerics_Run(void)
+{
+    BOOL result = TRUE;
+
+    result = (testTrapezoidal() == TRUE) ? result : FALSE;
+    result = (testGaussKronrod() == TRUE) ? result : FALSE;
+    result = (testLaguerre() == TRUE) ? result : FALSE;
+    result = (testTriple() == TRUE) ? result : FALSE;
+    result = (testNelderMead() == TRUE) ? result : FALSE;
+
+    return result;
+}
+
+
+
+
+
+//******************************************************************************
+//! \breif      x^n
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  x       : x
+//! \param[in]  context : Exponent n (F64)
+//! \return     x^n
+//******************************************************************************
+static F64 polynomial(const F64 x, void *context)
+{
+    return pow(x, *(const F64 *)context);
+}
+
+
+
+//******************************************************************************
+//! \breif      1 / x
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  x       : x
+//! \param[in]  context : Unused
+//! \return     1 / x
+//******************************************************************************
+static F64 inverse(const F64 x, void *context)
+{
+    (void)context;
+
+    return 1.0 / x;
+}
+
+
+
+//******************************************************************************
+//! \breif      sin(x)
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  x       : x
+//! \param[in]  context : Unused
+//! \return     sin(x)
+//******************************************************************************
+static F64 sine(const F64 x, void *context)
+{
+    (void)context;
+
+    return sin(x);
+}
+
+
+
+//******************************************************************************
+//! \breif      1 / (x y)
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  x       : x
+//! \param[in]  y       : y
+//! \param[in]  context : Unused
+//! \return     1 / (x y)
+//******************************************************************************
+static F64 inverseProduct(const F64 x, const F64 y, void *context)
+{
+    (void)context;
+
+    return 1.0 / (x * y);
+}
+
+
+
+//******************************************************************************
+//! \breif      CMB flux as an integrand
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  x       : CMB Photon Energy [eV]
+//! \param[in]  context : Unused
+//! \return     CMB Flux [cm^(-3) eV^(-1)]
+//******************************************************************************
+static F64 cmbFlux(const F64 x, void *context)
+{
+    (void)context;
+
+    return PatriclesCmb_CalcFlux(x);
+}
+
+
+
+//******************************************************************************
+//! \breif      exp(x + 2y + 3z)
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  x       : x
+//! \param[in]  y       : y
+//! \param[in]  z       : z
+//! \param[in]  context : Unused
+//! \return     exp(x + 2y + 3z)
+//******************************************************************************
+static F64 exponentialProduct(const F64 x, const F64 y, const F64 z, void *context)
+{
+    (void)context;
+
+    return exp(x + 2.0 * y + 3.0 * z);
+}
+
+
+
+//******************************************************************************
+//! \breif      exp(x + 2y + 3z) without a context
+//! \remark     
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  x : x
+//! \param[in]  y : y
+//! \param[in]  z : z
+//! \return     exp(x + 2y + 3z)
+//******************************************************************************
+static F64 exponentialProductBare(const F64 x, const F64 y, const F64 z)
+{
+    return exp(x + 2.0 * y + 3.0 * z);
+}
+
+
+
+//******************************************************************************
+//! \breif      Rosenbrock function
+//! \remark     Minimum 0 at (1, 1, ..., 1).
+//! 
+//! \callgraph  
+//! 
+//! \param[in]  x       : Point
+//! \param[in]  context : Dimension (U32)
+//! \return     sum 100 (x[i+1] - x[i]^2)^2 + (1 - x[i])^2
+//******************************************************************************
+static F64 rosenbrock(const F64 *x, void *context)
+{
+    const U32 dimension = *(const U32 *)context;
+    F64 value;
+    U32 i;
+
+    for (value = 0.0, i = 0; i + 1 < dimension; i++) {
+        value += 100.0 * (x[i + 1] - x[i] * x[i]) * (x[i + 1] - x[i] * x[i]) + (1.0 - x[i]) * (1.0 - x[i]);
+    }
+
+    return value;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check the trapezoidal rules
+//! \remark     Linear and log nodes against closed forms, and the empty
+//!             range, which both rules reject with no nodes allocated.
+//! 
+//! \callgraph  
+//! 
+//! \param      None
+//! \return     TRUE if every check passes
+//******************************************************************************
+static BOOL testTrapezoidal(void)
+{
+    INTEGRATION_RANGE range, empty;
+    QUADRATURE_RULE rule;
+    F64 n;
+    BOOL result = TRUE;
+
+    range.Lower = 0.0;
+    range.Upper = 1.0;
+    range.Iteration = 1000;
+    n = 2.0;
+    result = (NumericsQuadrature_CreateLinear(&rule, &range) == TRUE) ? result : FALSE;
+    result = (TestCommon_CheckValue("Linear trapezoid x^2 on [0, 1]", NumericsQuadrature_Integrate(polynomial, &n, &rule), 1.0 / 3.0, 1.0E-6) == TRUE) ? result : FALSE;
+    NumericsQuadrature_Release(&rule);
+
+    range.Lower = 1.0;
+    range.Upper = 1.0E+4;
+    range.Iteration = 2000;
+    result = (NumericsQuadrature_CreateLog(&rule, &range) == TRUE) ? result : FALSE;
+    result = (TestCommon_CheckValue("Log trapezoid 1 / x on [1, 1e4]", NumericsQuadrature_Integrate(inverse, NULL, &rule), log(1.0E+4), 1.0E-5) == TRUE) ? result : FALSE;
+    NumericsQuadrature_Release(&rule);
+
+    empty = range;
+    empty.Iteration = 0;
+    result = (TestCommon_CheckTrue("Empty range is rejected",
+                                   ((NumericsQuadrature_CreateLinear(&rule, &empty) == FALSE) && (rule.Count == 0) &&
+                                    (NumericsQuadrature_CreateLog(&rule, &empty) == FALSE) && (rule.Count == 0)) ? TRUE : FALSE) == TRUE) ? result : FALSE;
+
+    return result;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check the adaptive Gauss-Kronrod integration
+//! \remark     G7K15 and G10K21 against closed forms, in linear and log
+//!             space and nested in 2D.
+//! 
+//! \callgraph  
+//! 
+//! \param      None
+//! \return     TRUE if every check passes
+//******************************************************************************
+static BOOL testGaussKronrod(void)
+{
+    static const S32 rules[] = { GAUSS_KRONROD_15, GAUSS_KRONROD_21 };
+    INTEGRATION_RANGE range, range_y;
+    GAUSS_KRONROD_TOLERANCE tolerance;
+    GAUSS_KRONROD_RESULT integral;
+    CHAR name[64];
+    F64 n;
+    U32 r;
+    BOOL result = TRUE;
+
+    for (r = 0; r < sizeof(rules) / sizeof(rules[0]); r++) {
+        tolerance.Rule = rules[r];
+        tolerance.Absolute = 0.0;
+        tolerance.Relative = 1.0E-10;
+
+        range.Lower = 0.0;
+        range.Upper = MATH_PI;
+        range.Iteration = 100;
+        sprintf(name, "G%dK%d sin on [0, pi]", (rules[r] - 1) / 2, rules[r]);
+        result = (NumericsGaussKronrod_Integrate(sine, NULL, &range, &tolerance, &integral) == TRUE) ? result : FALSE;
+        result = (TestCommon_CheckValue(name, integral.Value, 2.0, 1.0E-10) == TRUE) ? result : FALSE;
+
+        range.Lower = 1.0;
+        range.Upper = 1.0E+3;
+        n = -2.5;
+        sprintf(name, "G%dK%d log x^-2.5 on [1, 1e3]", (rules[r] - 1) / 2, rules[r]);
+        result = (NumericsGaussKronrod_IntegrateLog(polynomial, &n, &range, &tolerance, &integral) == TRUE) ? result : FALSE;
+        result = (TestCommon_CheckValue(name, integral.Value, (1.0 - pow(1.0E+3, -1.5)) / 1.5, 1.0E-10) == TRUE) ? result : FALSE;
+
+        range.Upper = 1.0E+6;
+        range_y = range;
+        range_y.Upper = 1.0E+2;
+        tolerance.Relative = 1.0E-8;
+        sprintf(name, "G%dK%d 2D log 1 / (x y)", (rules[r] - 1) / 2, rules[r]);
+        result = (NumericsGaussKronrod_Integrate2dLog(inverseProduct, NULL, &range, &range_y, &tolerance, &integral) == TRUE) ? result : FALSE;
+        result = (TestCommon_CheckValue(name, integral.Value, log(1.0E+6) * log(1.0E+2), 1.0E-8) == TRUE) ? result : FALSE;
+    }
+
+    return result;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check the Gauss-Laguerre rules
+//! \remark     1) Gauss-Laguerre is exact for x^alpha e^(-x) times a
+//!                polynomial of degree < 2 x count.
+//!             2) The CMB rule against the closed form of the CMB flux,
+//!                2 zeta(3) / pi^2 (kT / hc)^3. The factor left to the nodes
+//!                is analytic, so 16 nodes reach about 1E-11 and 32 nodes
+//!                the rounding level.
+//! 
+//! \callgraph  
+//! 
+//! \param      None
+//! \return     TRUE if every check passes
+//******************************************************************************
+static BOOL testLaguerre(void)
+{
+    static const U32 cmb_count[] = { 16, 32, 256 };
+    static const F64 cmb_tolerance[] = { 1.0E-10, 1.0E-12, 1.0E-12 };
+    QUADRATURE_RULE rule;
+    F64 n, kT_hc, expected;
+    CHAR name[64];
+    U32 c;
+    BOOL result = TRUE;
+
+    result = (NumericsQuadrature_CreateLaguerre(&rule, 16, 2.0) == TRUE) ? result : FALSE;
+    n = 0.0;
+    result = (TestCommon_CheckValue("Gauss-Laguerre alpha 2, x^0", NumericsQuadrature_Integrate(polynomial, &n, &rule), 2.0, 1.0E-12) == TRUE) ? result : FALSE;
+    n = 3.0;
+    result = (TestCommon_CheckValue("Gauss-Laguerre alpha 2, x^3", NumericsQuadrature_Integrate(polynomial, &n, &rule), 120.0, 1.0E-12) == TRUE) ? result : FALSE;
+    n = 29.0;
+    result = (TestCommon_CheckValue("Gauss-Laguerre alpha 2, x^29", NumericsQuadrature_Integrate(polynomial, &n, &rule), tgamma(32.0), 1.0E-9) == TRUE) ? result : FALSE;
+    NumericsQuadrature_Release(&rule);
+
+    result = (NumericsQuadrature_CreateLaguerre(&rule, 16, 1.0) == TRUE) ? result : FALSE;
+    n = 5.0;
+    result = (TestCommon_CheckValue("Gauss-Laguerre alpha 1, x^5", NumericsQuadrature_Integrate(polynomial, &n, &rule), tgamma(7.0), 1.0E-12) == TRUE) ? result : FALSE;
+    NumericsQuadrature_Release(&rule);
+
+    result = (NumericsQuadrature_CreateLaguerre(&rule, 8, 0.0) == TRUE) ? result : FALSE;
+    n = 15.0;
+    result = (TestCommon_CheckValue("Gauss-Laguerre alpha 0, x^15", NumericsQuadrature_Integrate(polynomial, &n, &rule), tgamma(16.0), 1.0E-10) == TRUE) ? result : FALSE;
+    NumericsQuadrature_Release(&rule);
+
+    kT_hc = BOLTZMANN_CONST * PatriclesCmb_GetTemperature() / (PLANK_CONST * LIGHT_SPEED);
+    expected = 2.0 * TEST_RIEMANN_ZETA_3 / (MATH_PI * MATH_PI) * kT_hc * kT_hc * kT_hc;
+    for (c = 0; c < sizeof(cmb_count) / sizeof(cmb_count[0]); c++) {
+        sprintf(name, "CMB rule, %u nodes [cm^-3]", cmb_count[c]);
+        result = (PatriclesCmb_CreateQuadrature(&rule, cmb_count[c]) == TRUE) ? result : FALSE;
+        result = (TestCommon_CheckValue(name, NumericsQuadrature_Integrate(cmbFlux, NULL, &rule), expected, cmb_tolerance[c]) == TRUE) ? result : FALSE;
+        NumericsQuadrature_Release(&rule);
+    }
+
+    return result;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check the blocked 3D rule
+//! \remark     A separable integrand against its closed form, through the
+//!             quadrature rules and through the bare-pointer trapezoidal
+//!             wrapper. Both run in parallel, so they also check that the
+//!             blocks add up to the whole grid.
+//! 
+//! \callgraph  
+//! 
+//! \param      None
+//! \return     TRUE if every check passes
+//******************************************************************************
+static BOOL testTriple(void)
+{
+    INTEGRATION_RANGE range;
+    QUADRATURE_RULE rule_x, rule_y, rule_z;
+    F64 expected;
+    BOOL result = TRUE;
+
+    range.Lower = 0.0;
+    range.Upper = 1.0;
+    range.Iteration = 400;
+    expected = (exp(1.0) - 1.0) * (exp(2.0) - 1.0) / 2.0 * (exp(3.0) - 1.0) / 3.0;
+
+    result = (NumericsQuadrature_CreateLinear(&rule_x, &range) == TRUE) ? result : FALSE;
+    result = (NumericsQuadrature_CreateLinear(&rule_y, &range) == TRUE) ? result : FALSE;
+    result = (NumericsQuadrature_CreateLinear(&rule_z, &range) == TRUE) ? result : FALSE;
+    result = (TestCommon_CheckValue("3D rule exp(x + 2y + 3z) on [0, 1]^3",
+                                    NumericsQuadrature_Integrate3d(exponentialProduct, NULL, &rule_x, &rule_y, &rule_z), expected, 1.0E-5) == TRUE) ? result : FALSE;
+    NumericsQuadrature_Release(&rule_x);
+    NumericsQuadrature_Release(&rule_y);
+    NumericsQuadrature_Release(&rule_z);
+
+    result = (TestCommon_CheckValue("3D trapezoid exp(x + 2y + 3z) on [0, 1]^3",
+                                    NumericsTrapezoidal_Inetegrate3d(exponentialProductBare, &range, &range, &range), expected, 1.0E-5) == TRUE) ? result : FALSE;
+
+    return result;
+}
+
+
+
+//******************************************************************************
+//! \breif      Check the Nelder-Mead minimizer
+//! \remark     Rosenbrock function in 2 and 4 dimensions from the usual
+//!             start points.
+//! 
+//! \callgraph  
+//! 
+//! \param      None
+//! \return     TRUE if every check passes
+//******************************************************************************
+static BOOL testNelderMead(void)
+{
+    NELDER_MEAD_TOLERANCE tolerance;
+    NELDER_MEAD_RESULT minimum;
+    F64 x[4], step[4];
+    CHAR name[64];
+    U32 dimension, d;
+    BOOL result = TRUE;
+
+    tolerance.Value = 1.0E-14;
+    tolerance.Step = 1.0E-9;
+    tolerance.MaxEvaluations = 100000;
+
+    for (dimension = 2; dimension <= 4; dimension += 2) {
+        for (d = 0; d < dimension; d++) {
+            x[d] = ((d % 2) == 0) ? -1.2 : 1.0;
+            step[d] = 0.1;
+        }
+        snprintf(name, sizeof(name), "Nelder-Mead Rosenbrock %uD converges", dimension);
+        result = (TestCommon_CheckTrue(name, NumericsNelderMead_Minimize(rosenbrock, &dimension, dimension, x, step, &tolerance, &minimum)) == TRUE) ? result : FALSE;
+        for (d = 0; d < dimension; d++) {
+            snprintf(name, sizeof(name), "Nelder-Mead Rosenbrock %uD x[%u]", dimension, d);
+            result = (TestCommon_CheckValue(name, x[d], 1.0, 1.0E-5) == TRUE) ? result : FALSE;
+        }
+    }
+
+    return result;
+}
+
+
+
+
+
+//******************************************************************************
+// End of File
+//******************************************************************************